@@ -0,0 +1,46 @@
+#pragma once
+
+#include <iostream>
+#include "isometry.h"
+#include "vector3.h"
+
+namespace ekumen {
+namespace math {
+
+// Axis-aligned bounding box, the points p with min <= p <= max on every
+// axis. A default box is empty, with min above max, and grows with extend().
+struct Aabb {
+  Aabb();
+  Aabb(const Vector3& min, const Vector3& max);
+
+  bool empty() const;
+
+  // Grows the box to contain a point or another box.
+  void extend(const Vector3& point);
+  void extend(const Aabb& box);
+
+  Vector3 center() const;
+  // Half of the size along each axis.
+  Vector3 halfExtents() const;
+  // 0 for empty boxes.
+  double surfaceArea() const;
+
+  // Boxes touching at a face overlap.
+  bool overlaps(const Aabb& obj) const;
+  bool contains(const Vector3& point) const;
+
+  // Squared distance from a point to the box, 0 inside it.
+  double squaredDistance(const Vector3& point) const;
+
+  // Smallest box containing this box transformed by 'pose', from the absolute
+  // values of the rotation: half extents map to |R| * half extents.
+  Aabb transformed(const Isometry& pose) const;
+
+  friend std::ostream& operator<<(std::ostream& os, const Aabb& obj);
+
+  Vector3 min;
+  Vector3 max;
+};
+
+}  // namespace math
+}  // namespace ekumen
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace ekumen {
+namespace math {
+
+// Heap buffer aligned to kAlignment, as required by direct I/O and so that
+// the kernel copies whole pages. Move-only.
+class AlignedBuffer {
+ public:
+  static const std::size_t kAlignment = 4096;
+
+  AlignedBuffer();
+  // Throws std::bad_alloc when the memory cannot be allocated.
+  explicit AlignedBuffer(std::size_t size);
+  AlignedBuffer(const AlignedBuffer&) = delete;
+  AlignedBuffer(AlignedBuffer&& obj);
+  ~AlignedBuffer();
+
+  AlignedBuffer& operator=(const AlignedBuffer&) = delete;
+  AlignedBuffer& operator=(AlignedBuffer&& obj);
+
+  unsigned char* data();
+  const unsigned char* data() const;
+  std::size_t size() const;
+
+ private:
+  unsigned char* data_;
+  std::size_t size_;
+};
+
+// Implementations of AsyncIo:
+//   kIoUring: Linux io_uring, through its system calls.
+//   kThreads: a pool of threads issuing pread() and pwrite().
+//   kAuto:    io_uring when the kernel allows it, threads otherwise.
+enum class AsyncIoBackend {
+  kAuto,
+  kIoUring,
+  kThreads,
+};
+
+// Outcome of a request: its tag, and the number of bytes transferred or a
+// negated errno value.
+struct AsyncIoCompletion {
+  std::uint64_t tag;
+  std::int64_t result;
+};
+
+// Queue of asynchronous positional reads and writes on file descriptors.
+// Requests complete in any order and may transfer fewer bytes than asked,
+// like pread() and pwrite() do.
+//
+// An AsyncIo is driven from one thread. Buffers must stay alive until their
+// request completes, so pending requests must be waited for before the
+// queue is destroyed.
+class AsyncIo {
+ public:
+  // Throws std::runtime_error when the backend cannot be created, which for
+  // kIoUring includes kernels that do not allow it.
+  explicit AsyncIo(unsigned int queue_depth,
+                   AsyncIoBackend backend = AsyncIoBackend::kAuto);
+  AsyncIo(const AsyncIo&) = delete;
+  ~AsyncIo();
+
+  AsyncIo& operator=(const AsyncIo&) = delete;
+
+  // The backend in use, never kAuto.
+  AsyncIoBackend backend() const;
+
+  // Number of requests submitted and not returned by Wait() yet.
+  unsigned int pending() const;
+
+  // Submit requests. Throws std::length_error when 'queue_depth' requests
+  // are already pending, and std::runtime_error when the kernel rejects the
+  // submission, in which case the request is not pending and can be retried.
+  void SubmitRead(int fd, void* buffer, std::size_t size, std::uint64_t offset,
+                  std::uint64_t tag);
+  void SubmitWrite(int fd, const void* buffer, std::size_t size,
+                   std::uint64_t offset, std::uint64_t tag);
+
+  // Blocks until a request completes and returns it. Throws std::logic_error
+  // when nothing is pending.
+  AsyncIoCompletion Wait();
+
+  // Returns true when this system allows io_uring.
+  static bool IoUringAvailable();
+
+  // Implementation of a backend.
+  class Backend;
+
+ private:
+  std::unique_ptr<Backend> backend_;
+  AsyncIoBackend type_;
+  unsigned int queue_depth_;
+  unsigned int pending_;
+};
+
+}  // namespace math
+}  // namespace ekumen
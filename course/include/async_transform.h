@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include "async_io.h"
+#include "batch_transform.h"
+#include "isometry.h"
+
+namespace ekumen {
+namespace math {
+
+// Applies an isometry to a binary array file of points or poses and writes
+// the result to another file, through AsyncIo.
+//
+// The payload is processed in chunks that fit the buffers. Every buffer
+// cycles through read, transform and write on its own, so while one chunk
+// is transformed the reads and writes of the others are in flight. Chunks
+// are transformed in place on the raw little-endian doubles.
+class AsyncTransform {
+ public:
+  struct Options {
+    Options();
+
+    // Bytes per buffer, rounded down to whole elements.
+    std::size_t buffer_size;
+
+    // Buffers in flight.
+    unsigned int num_buffers;
+
+    // Threads that transform each chunk.
+    int num_threads;
+
+    AsyncIoBackend backend;
+  };
+
+  // Transforms 'input' into 'output', which is replaced. In the returned
+  // stats 'batches' counts chunks, 'read_seconds' and 'write_seconds' add
+  // up the latencies of the requests, which overlap, and 'stall_seconds' is
+  // the time spent waiting for them. Throws std::runtime_error when the
+  // files cannot be read or written, or 'input' is not a binary array of
+  // points or poses, and std::invalid_argument for invalid options.
+  static BatchTransformStats Run(const Isometry& pose,
+                                 const std::string& input,
+                                 const std::string& output,
+                                 const Options& options = Options());
+};
+
+}  // namespace math
+}  // namespace ekumen
@@ -0,0 +1,164 @@
+#pragma once
+
+#include <cmath>
+#include "isometry.h"
+#include "jet.h"
+#include "matrix.h"
+#include "vector3.h"
+
+namespace ekumen {
+namespace math {
+
+// Scalar-generic geometry kernels. They are instantiated with double for plain
+// evaluation and with Jet<N> to get derivatives. Matrices are 3x3 row-major
+// arrays, rotation vectors are axis times angle.
+
+// Maps a rotation vector to a rotation matrix (see SO3::Exp()).
+template <typename T>
+void RotationVectorToMatrix(const T omega[3], T rotation[9]) {
+  using std::cos;
+  using std::sin;
+  using std::sqrt;
+  const T theta_sq = omega[0] * omega[0] + omega[1] * omega[1] +
+                     omega[2] * omega[2];
+  T a;
+  T b;
+  if (theta_sq < 1e-4) {
+    // Taylor branch: differentiable at zero as no square root is taken.
+    a = 1. - theta_sq / 6. + theta_sq * theta_sq / 120.;
+    b = 0.5 - theta_sq / 24. + theta_sq * theta_sq / 720.;
+  } else {
+    const T theta = sqrt(theta_sq);
+    a = sin(theta) / theta;
+    b = (1. - cos(theta)) / theta_sq;
+  }
+  const T diagonal = 1. - b * theta_sq;
+  for (int i = 0; i < 3; ++i) {
+    for (int j = 0; j < 3; ++j) {
+      rotation[3 * i + j] = b * omega[i] * omega[j];
+    }
+    rotation[4 * i] += diagonal;
+  }
+  rotation[1] -= a * omega[2];
+  rotation[2] += a * omega[1];
+  rotation[3] += a * omega[2];
+  rotation[5] -= a * omega[0];
+  rotation[6] -= a * omega[1];
+  rotation[7] += a * omega[0];
+}
+
+// Maps a rotation matrix to a rotation vector (see SO3::Log()).
+template <typename T>
+void MatrixToRotationVector(const T rotation[9], T omega[3]) {
+  using std::atan2;
+  using std::sqrt;
+  const T* r = rotation;
+  T sin_axis[3] = {0.5 * (r[7] - r[5]), 0.5 * (r[2] - r[6]),
+                   0.5 * (r[3] - r[1])};
+  const T cos_theta = 0.5 * (r[0] + r[4] + r[8] - 1.);
+  const T sin_theta_sq = sin_axis[0] * sin_axis[0] +
+                         sin_axis[1] * sin_axis[1] +
+                         sin_axis[2] * sin_axis[2];
+  if (sin_theta_sq < 1e-4 && cos_theta > 0.) {
+    // theta / sin(theta) expanded in sin(theta)^2.
+    const T factor = 1. + sin_theta_sq / 6. + 3. * sin_theta_sq *
+                                                  sin_theta_sq / 40.;
+    for (int i = 0; i < 3; ++i) {
+      omega[i] = sin_axis[i] * factor;
+    }
+    return;
+  }
+  const T sin_theta = sqrt(sin_theta_sq);
+  const T theta = atan2(sin_theta, cos_theta);
+  if (cos_theta > -0.9) {
+    for (int i = 0; i < 3; ++i) {
+      omega[i] = sin_axis[i] * theta / sin_theta;
+    }
+    return;
+  }
+  // Near pi: use the symmetric part, cos(t) * I + (1 - cos(t)) * a * a^T.
+  int k = 0;
+  for (int i = 1; i < 3; ++i) {
+    if (r[4 * i] > r[4 * k]) {
+      k = i;
+    }
+  }
+  const T one_minus_cos = 1. - cos_theta;
+  T axis[3];
+  axis[k] = sqrt((r[4 * k] - cos_theta) / one_minus_cos);
+  for (int i = 0; i < 3; ++i) {
+    if (i != k) {
+      axis[i] = 0.5 * (r[3 * k + i] + r[3 * i + k]) / (one_minus_cos * axis[k]);
+    }
+  }
+  const T sign_test =
+      axis[0] * sin_axis[0] + axis[1] * sin_axis[1] + axis[2] * sin_axis[2];
+  const T norm =
+      sqrt(axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2]);
+  const T scale = sign_test < 0. ? -theta / norm : theta / norm;
+  for (int i = 0; i < 3; ++i) {
+    omega[i] = axis[i] * scale;
+  }
+}
+
+// Computes rotation * point + translation.
+template <typename T>
+void TransformPoint(const T rotation[9], const T translation[3],
+                    const T point[3], T res[3]) {
+  for (int i = 0; i < 3; ++i) {
+    res[i] = rotation[3 * i] * point[0] + rotation[3 * i + 1] * point[1] +
+             rotation[3 * i + 2] * point[2] + translation[i];
+  }
+}
+
+// Computes the composition a * b of two isometries.
+template <typename T>
+void ComposeTransforms(const T rotation_a[9], const T translation_a[3],
+                       const T rotation_b[9], const T translation_b[3],
+                       T rotation_res[9], T translation_res[3]) {
+  for (int i = 0; i < 3; ++i) {
+    for (int j = 0; j < 3; ++j) {
+      rotation_res[3 * i + j] = rotation_a[3 * i] * rotation_b[j] +
+                                rotation_a[3 * i + 1] * rotation_b[3 + j] +
+                                rotation_a[3 * i + 2] * rotation_b[6 + j];
+    }
+  }
+  TransformPoint(rotation_a, translation_a, translation_b, translation_res);
+}
+
+// Forward-mode automatic differentiation helpers.
+class AutoDiff {
+ public:
+  // Evaluates 'functor' at 'x' and its M x N row-major Jacobian. 'functor'
+  // must provide 'template <typename T> void operator()(const T* x, T* y)
+  // const' writing M outputs from N inputs.
+  template <int N, int M, typename Functor>
+  static void Evaluate(const Functor& functor, const double x[N],
+                       double value[M], double jacobian[M * N]) {
+    Jet<N> x_jet[N];
+    Jet<N> y_jet[M];
+    for (int i = 0; i < N; ++i) {
+      x_jet[i] = Jet<N>(x[i], i);
+    }
+    functor(x_jet, y_jet);
+    for (int i = 0; i < M; ++i) {
+      value[i] = y_jet[i].a;
+      for (int j = 0; j < N; ++j) {
+        jacobian[N * i + j] = y_jet[i].v[j];
+      }
+    }
+  }
+
+  // Computes the Jacobian of pose.transform(point) with respect to a local
+  // perturbation (dt, dw) of the pose, which moves it to (translation +
+  // rotation * dt, rotation * Exp(dw)).
+  static Matrix36 TransformJacobian(const Isometry& pose, const Vector3& point);
+
+  // Computes the Jacobians of a * b with respect to local perturbations of 'a'
+  // and 'b', using the same perturbation model for the result.
+  static void ComposeJacobians(const Isometry& a, const Isometry& b,
+                               Matrix6* jacobian_a, Matrix6* jacobian_b);
+};
+
+}  // namespace math
+}  // namespace ekumen
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include "isometry.h"
+
+namespace ekumen {
+namespace math {
+
+// Encodings of a stream of elements:
+//   kText:   one element per line in the operator<< format.
+//   kBinary: a binary array as written by BinaryWriter.
+enum class StreamFormat {
+  kText,
+  kBinary,
+};
+
+// Elements of a stream: points are Vector3 and poses are Isometry.
+enum class ElementKind {
+  kPoint,
+  kPose,
+};
+
+// Counters and timings of a BatchTransform::Run() call. Reads run on a
+// separate thread, so 'read_seconds' overlaps with the transform and write
+// times, and 'stall_seconds' is the part of it the other stages waited for.
+struct BatchTransformStats {
+  // Elements processed per second of wall time.
+  double throughput() const;
+
+  std::uint64_t elements;
+  std::uint64_t batches;
+  double read_seconds;
+  double transform_seconds;
+  double write_seconds;
+  double stall_seconds;
+  double total_seconds;
+};
+
+// Applies an isometry to a stream of points or poses. Points are transformed
+// and poses are composed on the left with the isometry.
+//
+// Elements are processed in batches with two buffers: while one batch is
+// transformed and written, the next one is read on a thread kept for the
+// whole run.
+class BatchTransform {
+ public:
+  struct Options {
+    Options();
+
+    StreamFormat input_format;
+    StreamFormat output_format;
+
+    // Kind of text input. Binary input takes it from its header.
+    ElementKind kind;
+
+    // Elements per batch.
+    std::size_t batch_size;
+
+    // Precision of text output, TextFormat::kRoundTrip by default.
+    int precision;
+
+    // Threads that transform each batch.
+    int num_threads;
+  };
+
+  // Reads 'is' until its end and writes the transformed elements to 'os'.
+  // Binary output of text input is only known in size at the end, so 'os'
+  // must be seekable to complete the header. Throws std::invalid_argument
+  // for malformed text, with its line number, std::runtime_error when the
+  // streams fail or binary input is malformed, and std::invalid_argument for
+  // invalid options.
+  static BatchTransformStats Run(const Isometry& pose, const Options& options,
+                                 std::istream* is, std::ostream* os);
+};
+
+}  // namespace math
+}  // namespace ekumen
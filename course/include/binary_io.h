@@ -0,0 +1,283 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "isometry.h"
+#include "matrix3.h"
+#include "vector3.h"
+
+namespace ekumen {
+namespace math {
+
+// Element types of a binary array file.
+enum class BinaryType : std::uint8_t {
+  kVector3 = 1,
+  kMatrix3 = 2,
+  kIsometry = 3,
+};
+
+// Header of a binary array file. On disk it takes kSize little-endian bytes:
+//   magic "EKMA" (4 bytes), version (uint16), type (uint8),
+//   scalar width in bytes (uint8), element count (uint64).
+// It is followed by 'count' elements of little-endian IEEE-754 doubles, so
+// the payload is 8-byte aligned in a mapped file:
+//   Vector3:  x, y, z.
+//   Matrix3:  9 elements in row-major order.
+//   Isometry: translation (3) followed by the rotation in row-major order (9).
+struct BinaryHeader {
+  static const std::size_t kSize = 16;
+  static const std::uint16_t kVersion = 1;
+
+  BinaryType type;
+  std::uint8_t scalar_width;
+  std::uint64_t count;
+};
+
+// Layout of each element type in a binary array file.
+template <typename T>
+struct BinaryTraits;
+
+template <>
+struct BinaryTraits<Vector3> {
+  static const BinaryType kType = BinaryType::kVector3;
+  static const int kScalars = 3;
+
+  static Vector3 Read(const double* data) {
+    return Vector3(data[0], data[1], data[2]);
+  }
+  static void Write(const Vector3& obj, double* data) {
+    for (int i = 0; i < 3; ++i) {
+      data[i] = obj[i];
+    }
+  }
+};
+
+template <>
+struct BinaryTraits<Matrix3> {
+  static const BinaryType kType = BinaryType::kMatrix3;
+  static const int kScalars = 9;
+
+  static Matrix3 Read(const double* data) {
+    return Matrix3(BinaryTraits<Vector3>::Read(data),
+                   BinaryTraits<Vector3>::Read(data + 3),
+                   BinaryTraits<Vector3>::Read(data + 6));
+  }
+  static void Write(const Matrix3& obj, double* data) {
+    for (int i = 0; i < 3; ++i) {
+      BinaryTraits<Vector3>::Write(obj[i], data + 3 * i);
+    }
+  }
+};
+
+template <>
+struct BinaryTraits<Isometry> {
+  static const BinaryType kType = BinaryType::kIsometry;
+  static const int kScalars = 12;
+
+  static Isometry Read(const double* data) {
+    return Isometry(BinaryTraits<Vector3>::Read(data),
+                    BinaryTraits<Matrix3>::Read(data + 3));
+  }
+  static void Write(const Isometry& obj, double* data) {
+    BinaryTraits<Vector3>::Write(obj.translation(), data);
+    BinaryTraits<Matrix3>::Write(obj.rotation(), data + 3);
+  }
+};
+
+// Read-only memory mapping of a whole file. Throws std::runtime_error when the
+// file cannot be opened or mapped.
+class MappedFile {
+ public:
+  explicit MappedFile(const std::string& path);
+  MappedFile(const MappedFile&) = delete;
+  MappedFile(MappedFile&& obj);
+  ~MappedFile();
+
+  MappedFile& operator=(const MappedFile&) = delete;
+  MappedFile& operator=(MappedFile&& obj);
+
+  const unsigned char* data() const;
+  std::size_t size() const;
+
+  // Hints the kernel that the mapping is read once from start to end, so
+  // that it reads ahead aggressively, and asks for transparent huge pages
+  // for large mappings where the file system supports them. Hints are best
+  // effort and never fail.
+  void adviseSequential() const;
+
+ private:
+  void unmap();
+
+  void* data_;
+  std::size_t size_;
+};
+
+// Zero-copy view of the elements of a binary array. Elements are decoded on
+// access from the underlying doubles, which must outlive the view.
+template <typename T>
+class BinaryView {
+ public:
+  BinaryView() : data_(nullptr), size_(0) {}
+  BinaryView(const double* data, std::size_t size)
+      : data_(data), size_(size) {}
+
+  // Number of elements.
+  std::size_t size() const { return size_; }
+  bool empty() const { return size_ == 0; }
+
+  // Raw scalars, BinaryTraits<T>::kScalars per element.
+  const double* data() const { return data_; }
+
+  // Unchecked element access.
+  T operator[](std::size_t index) const {
+    return BinaryTraits<T>::Read(data_ + BinaryTraits<T>::kScalars * index);
+  }
+
+  // Element access, throws std::out_of_range for invalid indices.
+  T at(std::size_t index) const {
+    if (index >= size_) {
+      throw std::out_of_range("Index to access an element is out of range.");
+    }
+    return (*this)[index];
+  }
+
+ private:
+  const double* data_;
+  std::size_t size_;
+};
+
+// A mapped binary array file. The header is validated on construction, which
+// throws std::runtime_error for truncated or malformed files.
+class BinaryFile {
+ public:
+  explicit BinaryFile(const std::string& path);
+
+  const BinaryHeader& header() const;
+
+  // Gets a view of the elements. Throws std::runtime_error when the file
+  // holds another element type.
+  template <typename T>
+  BinaryView<T> view() const {
+    if (header_.type != BinaryTraits<T>::kType) {
+      throw std::runtime_error("Binary file holds another element type.");
+    }
+    return BinaryView<T>(payload(), static_cast<std::size_t>(header_.count));
+  }
+
+ private:
+  const double* payload() const;
+
+  MappedFile file_;
+  BinaryHeader header_;
+};
+
+// Reads a binary array from a stream, for inputs that cannot be mapped such
+// as pipes. The header is read and validated on construction, which throws
+// std::runtime_error for malformed headers.
+class BinaryReader {
+ public:
+  explicit BinaryReader(std::istream* is);
+
+  const BinaryHeader& header() const;
+
+  // Reads up to 'max' elements into 'elements' and returns how many were
+  // read, 0 once all of them are. Throws std::runtime_error when the array
+  // holds another element type or the stream ends early.
+  template <typename T>
+  std::size_t Read(T* elements, std::size_t max) {
+    if (header_.type != BinaryTraits<T>::kType) {
+      throw std::runtime_error("Binary array holds another element type.");
+    }
+    const std::size_t count =
+        remaining_ < max ? static_cast<std::size_t>(remaining_) : max;
+    const std::size_t kChunk = 256;
+    double buffer[kChunk * BinaryTraits<T>::kScalars];
+    for (std::size_t begin = 0; begin < count; begin += kChunk) {
+      const std::size_t end = begin + kChunk < count ? begin + kChunk : count;
+      readScalars(buffer, BinaryTraits<T>::kScalars * (end - begin));
+      for (std::size_t i = begin; i < end; ++i) {
+        elements[i] = BinaryTraits<T>::Read(
+            buffer + BinaryTraits<T>::kScalars * (i - begin));
+      }
+    }
+    remaining_ -= count;
+    return count;
+  }
+
+ private:
+  void readScalars(double* data, std::size_t size);
+
+  std::istream* is_;
+  BinaryHeader header_;
+  std::uint64_t remaining_;
+};
+
+class BinaryWriter {
+ public:
+  // Writes the header and the elements of an array to a stream. Throws
+  // std::runtime_error when the stream fails.
+  template <typename T>
+  static void Write(const std::vector<T>& elements, std::ostream* os) {
+    Write(elements.data(), elements.size(), os);
+  }
+
+  template <typename T>
+  static void Write(const T* elements, std::size_t count, std::ostream* os) {
+    WriteHeader<T>(count, os);
+    WriteElements(elements, count, os);
+  }
+
+  // Writes the header of an array of 'count' elements, for arrays that are
+  // streamed in pieces with WriteElements().
+  template <typename T>
+  static void WriteHeader(std::uint64_t count, std::ostream* os) {
+    BinaryHeader header;
+    header.type = BinaryTraits<T>::kType;
+    header.scalar_width = sizeof(double);
+    header.count = count;
+    writeHeader(header, os);
+  }
+
+  // Writes elements without a header.
+  template <typename T>
+  static void WriteElements(const T* elements, std::size_t count,
+                            std::ostream* os) {
+    // Elements are encoded in chunks so that a single buffer is reused.
+    const std::size_t kChunk = 256;
+    double buffer[kChunk * BinaryTraits<T>::kScalars];
+    for (std::size_t begin = 0; begin < count; begin += kChunk) {
+      const std::size_t end = begin + kChunk < count ? begin + kChunk : count;
+      for (std::size_t i = begin; i < end; ++i) {
+        BinaryTraits<T>::Write(
+            elements[i], buffer + BinaryTraits<T>::kScalars * (i - begin));
+      }
+      writeScalars(buffer, BinaryTraits<T>::kScalars * (end - begin), os);
+    }
+  }
+
+  // Writes an array to a file, replacing its contents.
+  template <typename T>
+  static void Write(const std::vector<T>& elements, const std::string& path) {
+    std::ofstream os;
+    openFile(path, &os);
+    Write(elements, &os);
+    os.close();
+    if (!os) {
+      throw std::runtime_error("Cannot write binary file '" + path + "'.");
+    }
+  }
+
+ private:
+  static void writeHeader(const BinaryHeader& header, std::ostream* os);
+  static void writeScalars(const double* data, std::size_t size,
+                           std::ostream* os);
+  static void openFile(const std::string& path, std::ofstream* os);
+};
+
+}  // namespace math
+}  // namespace ekumen
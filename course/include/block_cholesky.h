@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cstddef>
+#include <utility>
+#include <vector>
+#include "matrix.h"
+
+namespace ekumen {
+namespace math {
+
+// Sparse Cholesky factorization of symmetric positive definite matrices made
+// of 6x6 blocks. Analyze() computes a fill-reducing ordering and the block
+// pattern of the factor once; Factorize() and Solve() can then be called any
+// number of times with new values on the same pattern.
+class BlockCholesky {
+ public:
+  static const int kBlockSize = 6;
+
+  typedef Matrix6 Block;
+
+  // Computes the ordering and the symbolic factorization of a matrix with
+  // 'num_blocks' block rows and non-zero off-diagonal blocks at the (i, j)
+  // pairs of 'off_diagonal'. Clears the numeric values.
+  void Analyze(int num_blocks,
+               const std::vector<std::pair<int, int>>& off_diagonal);
+
+  // Sets every numeric value to zero, keeping the pattern.
+  void SetZero();
+
+  // Adds 'block' to the diagonal block (i, i).
+  void AddToDiagonal(int i, const Block& block);
+
+  // Adds 'block' to the block (i, j) and its transpose to (j, i). The pair must
+  // be part of the analyzed pattern; throws std::out_of_range otherwise.
+  void AddToOffDiagonal(int i, int j, const Block& block);
+
+  // Replaces the values by their Cholesky factor. Returns false when the
+  // matrix is not positive definite.
+  bool Factorize();
+
+  // Solves A * x = rhs with the last factorization. Vectors have
+  // kBlockSize * numBlocks() entries in the original block order.
+  void Solve(const std::vector<double>& rhs, std::vector<double>* x) const;
+
+  int numBlocks() const;
+
+  // Number of off-diagonal blocks of the factor, fill-in included.
+  std::size_t numFactorBlocks() const;
+
+ private:
+  // Returns the index in 'values_' of block (row, col), both in elimination
+  // order, with row > col.
+  std::size_t slot(int row, int col) const;
+
+  // Elimination position of every block row.
+  std::vector<int> position_;
+
+  // Block row of every elimination position.
+  std::vector<int> order_;
+
+  // Rows of the off-diagonal blocks of every column of the factor, in
+  // elimination order. Column c spans [column_offsets_[c];
+  // column_offsets_[c + 1]).
+  std::vector<std::size_t> column_offsets_;
+  std::vector<int> column_rows_;
+
+  // Diagonal and off-diagonal blocks, in elimination order.
+  std::vector<Block> diagonal_;
+  std::vector<Block> values_;
+};
+
+}  // namespace math
+}  // namespace ekumen
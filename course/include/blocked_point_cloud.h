@@ -0,0 +1,86 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+#include "isometry.h"
+#include "point_cloud.h"
+#include "vector3.h"
+
+namespace ekumen {
+namespace math {
+
+// Point cloud in array-of-structures-of-arrays layout: points are grouped in
+// blocks of kBlockSize, each storing the x, y and z coordinates of its points
+// in three short arrays. A block spans three cache lines and its arrays fill
+// whole SIMD registers, so kernels that need all three coordinates of a
+// point read a single stream, unlike PointCloud, and still vectorize,
+// unlike arrays of Vector3.
+//
+// The lanes past the last point of the last block are padding. Kernels
+// process them along with the points, and their results there are dropped.
+class BlockedPointCloud {
+ public:
+  // Points per block, the doubles in a 512-bit register.
+  static const std::size_t kBlockSize = 8;
+
+  struct Block {
+    double x[kBlockSize];
+    double y[kBlockSize];
+    double z[kBlockSize];
+  };
+
+  BlockedPointCloud() = default;
+  explicit BlockedPointCloud(std::size_t size);
+  explicit BlockedPointCloud(const std::vector<Vector3>& points);
+  explicit BlockedPointCloud(const PointCloud& cloud);
+
+  std::size_t size() const;
+  bool empty() const;
+  void reserve(std::size_t capacity);
+  // New points are zero-filled.
+  void resize(std::size_t size);
+  void clear();
+
+  void push_back(const Vector3& point);
+
+  // Gets a point, throws std::out_of_range for invalid indices.
+  Vector3 point(std::size_t index) const;
+
+  // Sets a point, throws std::out_of_range for invalid indices.
+  void setPoint(std::size_t index, const Vector3& point);
+
+  std::size_t numBlocks() const;
+  const Block* blocks() const;
+  Block* blocks();
+
+  PointCloud toPointCloud() const;
+
+  // Transforms every point in place.
+  void transform(const Isometry& pose);
+
+  // Per-point dot products with the points of 'obj', into 'res'. Throws
+  // std::invalid_argument when the sizes differ.
+  void dot(const BlockedPointCloud& obj, std::vector<double>* res) const;
+
+  // Per-point cross products with the points of 'obj', into 'res', which
+  // may be this cloud or 'obj'. Throws std::invalid_argument when the sizes
+  // differ.
+  void cross(const BlockedPointCloud& obj, BlockedPointCloud* res) const;
+
+  // Per-point norms, into 'res'.
+  void norm(std::vector<double>* res) const;
+
+  // Compares two clouds point by point, with the tolerance of Vector3.
+  bool operator==(const BlockedPointCloud& rhs) const;
+  bool operator!=(const BlockedPointCloud& rhs) const;
+
+ private:
+  void assertValidAccessIndex(std::size_t index) const;
+  void assertSameSize(const BlockedPointCloud& obj) const;
+
+  std::vector<Block> blocks_;
+  std::size_t size_ = 0;
+};
+
+}  // namespace math
+}  // namespace ekumen
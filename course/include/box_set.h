@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "aabb.h"
+#include "obb.h"
+
+namespace ekumen {
+namespace math {
+
+// Axis-aligned boxes in struct of arrays layout, for broad-phase queries of
+// one box against many. Each query runs a branchless test over every box in
+// blocks, which vectorizes, and then gathers the indices of the overlapping
+// ones.
+class BoxSet {
+ public:
+  BoxSet() = default;
+  explicit BoxSet(const std::vector<Aabb>& boxes);
+
+  std::size_t size() const;
+  bool empty() const;
+  void reserve(std::size_t capacity);
+  void clear();
+
+  void push_back(const Aabb& box);
+
+  // Throws std::out_of_range when 'index' is not below size().
+  Aabb box(std::size_t index) const;
+  void setBox(std::size_t index, const Aabb& box);
+
+  // Sets 'res' to the indices of the boxes overlapping 'query', ascending,
+  // as Aabb::overlaps() would.
+  void overlapping(const Aabb& query, std::vector<std::uint32_t>* res) const;
+
+  // As above for an oriented query, as Obb::overlaps() would for the boxes
+  // as Obbs.
+  void overlapping(const Obb& query, std::vector<std::uint32_t>* res) const;
+
+ private:
+  void assertValidAccessIndex(std::size_t index) const;
+
+  // Bounds along each axis.
+  std::vector<double> min_[3];
+  std::vector<double> max_[3];
+};
+
+}  // namespace math
+}  // namespace ekumen
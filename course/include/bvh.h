@@ -0,0 +1,219 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "aabb.h"
+#include "parallel.h"
+#include "vector3.h"
+
+namespace ekumen {
+namespace math {
+
+// Node of a Bvh, 64 bytes so that a node is a cache line. Nodes are stored
+// in depth-first order: the children of an interior node are the next node
+// and node 'offset', while a leaf holds the primitives [offset; offset +
+// count) of Bvh::primitives().
+struct BvhNode {
+  bool isLeaf() const { return count != 0; }
+
+  double min[3];
+  double max[3];
+  std::uint32_t offset;
+  std::uint32_t count;
+  // Split axis of interior nodes, to visit first the child nearer to a ray.
+  std::uint32_t axis;
+  std::uint32_t padding;
+};
+
+static_assert(sizeof(BvhNode) == 64, "BvhNode must fill a cache line.");
+
+// Bounding volume hierarchy of primitives given by their boxes, e.g. the
+// triangles of a mesh or the objects of a scene, in a flat node array.
+//
+// The hierarchy is built top-down, splitting each node where the surface
+// area heuristic, evaluated on bins of primitive centroids, estimates the
+// cheapest queries. Queries are templates that call back for the primitives
+// of the leaves they reach, so that callers test their own primitives.
+class Bvh {
+ public:
+  // Nodes at this depth are leaves, which bounds the traversal stacks.
+  static const int kMaxDepth = 64;
+
+  Bvh() = default;
+
+  // Builds the hierarchy, the top levels on up to 'num_threads' threads.
+  // Throws std::invalid_argument when there are 2^32 primitives or more, or
+  // when a box has a NaN bound.
+  explicit Bvh(const std::vector<Aabb>& boxes,
+               int num_threads = DefaultNumThreads());
+
+  // Primitives in the hierarchy.
+  std::size_t size() const;
+  bool empty() const;
+
+  const std::vector<BvhNode>& nodes() const;
+
+  // Primitive indices in leaf order.
+  const std::vector<std::uint32_t>& primitives() const;
+
+  // Box of all the primitives.
+  Aabb bounds() const;
+
+  // Recomputes the node boxes from new boxes of the same primitives, e.g.
+  // the triangles of an animated mesh, keeping the hierarchy. It is much
+  // faster than a rebuild, but queries slow down as primitives move away
+  // from their original neighbours. Throws std::invalid_argument when the
+  // number of boxes differs or a box has a NaN bound.
+  void refit(const std::vector<Aabb>& boxes);
+
+  // Calls 'visit(primitive)' for the primitives of the leaves whose boxes
+  // overlap 'box'.
+  template <typename Visit>
+  void overlapping(const Aabb& box, Visit visit) const;
+
+  // Calls 'hit(primitive, &max_distance)' for the primitives of the leaves
+  // whose boxes the ray from 'origin' along 'direction' enters within
+  // 'max_distance', nearer children first. 'hit' may lower 'max_distance' to
+  // the distance of an intersection, which prunes farther nodes. Distances
+  // are in units of the length of 'direction'.
+  template <typename Hit>
+  void raycast(const Vector3& origin, const Vector3& direction,
+               double max_distance, Hit hit) const;
+
+  // Calls 'visit(primitive, &max_squared_distance)' for the primitives of
+  // the leaves whose boxes are within the square root of
+  // 'max_squared_distance' of 'point', nearer children first. 'visit' may
+  // lower the bound to the squared distance of a primitive found.
+  template <typename Visit>
+  void nearest(const Vector3& point, double max_squared_distance,
+               Visit visit) const;
+
+ private:
+  static bool overlaps(const BvhNode& node, const double* min,
+                       const double* max) {
+    return node.min[0] <= max[0] && node.max[0] >= min[0] &&
+           node.min[1] <= max[1] && node.max[1] >= min[1] &&
+           node.min[2] <= max[2] && node.max[2] >= min[2];
+  }
+
+  // Slab test of a ray, with the inverse of its direction.
+  static bool rayEnters(const BvhNode& node, const double* origin,
+                        const double* inverse, double max_distance) {
+    double enter = 0.;
+    double exit = max_distance;
+    for (int i = 0; i < 3; ++i) {
+      const double t0 = (node.min[i] - origin[i]) * inverse[i];
+      const double t1 = (node.max[i] - origin[i]) * inverse[i];
+      enter = t0 < t1 ? (t0 > enter ? t0 : enter) : (t1 > enter ? t1 : enter);
+      exit = t0 < t1 ? (t1 < exit ? t1 : exit) : (t0 < exit ? t0 : exit);
+    }
+    return enter <= exit;
+  }
+
+  static double squaredDistance(const BvhNode& node, const double* point) {
+    double res = 0.;
+    for (int i = 0; i < 3; ++i) {
+      const double below = node.min[i] - point[i];
+      const double above = point[i] - node.max[i];
+      const double gap = below > 0. ? below : (above > 0. ? above : 0.);
+      res += gap * gap;
+    }
+    return res;
+  }
+
+  std::vector<BvhNode> nodes_;
+  std::vector<std::uint32_t> primitives_;
+};
+
+template <typename Visit>
+void Bvh::overlapping(const Aabb& box, Visit visit) const {
+  if (nodes_.empty() || box.empty()) {
+    return;
+  }
+  const double min[3] = {box.min.x(), box.min.y(), box.min.z()};
+  const double max[3] = {box.max.x(), box.max.y(), box.max.z()};
+  std::uint32_t stack[kMaxDepth + 2];
+  int top = 0;
+  stack[top++] = 0;
+  while (top > 0) {
+    const std::uint32_t index = stack[--top];
+    const BvhNode& node = nodes_[index];
+    if (!overlaps(node, min, max)) {
+      continue;
+    }
+    if (node.isLeaf()) {
+      for (std::uint32_t i = 0; i < node.count; ++i) {
+        visit(primitives_[node.offset + i]);
+      }
+      continue;
+    }
+    stack[top++] = node.offset;
+    stack[top++] = index + 1;
+  }
+}
+
+template <typename Hit>
+void Bvh::raycast(const Vector3& origin, const Vector3& direction,
+                  double max_distance, Hit hit) const {
+  if (nodes_.empty()) {
+    return;
+  }
+  const double start[3] = {origin.x(), origin.y(), origin.z()};
+  const double inverse[3] = {1. / direction.x(), 1. / direction.y(),
+                             1. / direction.z()};
+  std::uint32_t stack[kMaxDepth + 2];
+  int top = 0;
+  stack[top++] = 0;
+  while (top > 0) {
+    const std::uint32_t index = stack[--top];
+    const BvhNode& node = nodes_[index];
+    if (!rayEnters(node, start, inverse, max_distance)) {
+      continue;
+    }
+    if (node.isLeaf()) {
+      for (std::uint32_t i = 0; i < node.count; ++i) {
+        hit(primitives_[node.offset + i], &max_distance);
+      }
+      continue;
+    }
+    // The child on the side the ray comes from is pushed last, so that it
+    // is visited first.
+    const bool backwards = inverse[node.axis] < 0.;
+    stack[top++] = backwards ? index + 1 : node.offset;
+    stack[top++] = backwards ? node.offset : index + 1;
+  }
+}
+
+template <typename Visit>
+void Bvh::nearest(const Vector3& point, double max_squared_distance,
+                  Visit visit) const {
+  if (nodes_.empty()) {
+    return;
+  }
+  const double query[3] = {point.x(), point.y(), point.z()};
+  std::uint32_t stack[kMaxDepth + 2];
+  int top = 0;
+  stack[top++] = 0;
+  while (top > 0) {
+    const std::uint32_t index = stack[--top];
+    const BvhNode& node = nodes_[index];
+    if (squaredDistance(node, query) > max_squared_distance) {
+      continue;
+    }
+    if (node.isLeaf()) {
+      for (std::uint32_t i = 0; i < node.count; ++i) {
+        visit(primitives_[node.offset + i], &max_squared_distance);
+      }
+      continue;
+    }
+    const bool second_nearer =
+        squaredDistance(nodes_[node.offset], query) <
+        squaredDistance(nodes_[index + 1], query);
+    stack[top++] = second_nearer ? index + 1 : node.offset;
+    stack[top++] = second_nearer ? node.offset : index + 1;
+  }
+}
+
+}  // namespace math
+}  // namespace ekumen
@@ -0,0 +1,19 @@
+#pragma once
+
+#include <cstddef>
+
+namespace ekumen {
+namespace math {
+
+// Conversions between doubles and text in the "C" locale, whatever the
+// global one is, so that the decimal separator is always '.'.
+
+// As std::strtod().
+double StrtodC(const char* text, char** end);
+
+// As std::snprintf() with the "%.*g" format.
+int FormatDoubleC(double value, int precision, char* buffer,
+                  std::size_t size);
+
+}  // namespace math
+}  // namespace ekumen
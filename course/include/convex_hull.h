@@ -0,0 +1,70 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "parallel.h"
+#include "vector3.h"
+
+namespace ekumen {
+namespace math {
+
+// Orientation of 'd' relative to the plane through 'a', 'b' and 'c':
+// positive when 'd' lies below it, seeing 'a', 'b' and 'c' counterclockwise
+// from above, negative when above and zero when coplanar. The value
+// approximates six times the signed volume of the tetrahedron, and its sign
+// is exact: a floating point evaluation is used when its error bound allows
+// it, and an exact one otherwise (after Shewchuk). Coordinates are assumed
+// far from overflow and underflow.
+double Orient3d(const Vector3& a, const Vector3& b, const Vector3& c,
+                const Vector3& d);
+
+// As above with points given as three coordinates each.
+double Orient3d(const double* a, const double* b, const double* c,
+                const double* d);
+
+// Convex hull of a set of points as a closed triangle mesh, with triangles
+// counterclockwise seen from outside. Built with Quickhull: all orientation
+// tests use Orient3d(), so that nearly coplanar points cannot break the
+// mesh, and faces, half-edges and the lists of points outside each face live
+// in a few arrays reused through the build rather than in per-face
+// allocations. Points on the hull which are not corners of it may or may not
+// be vertices.
+class ConvexHull {
+ public:
+  // Same layout as TriangleMesh::Triangle.
+  using Triangle = std::array<std::uint32_t, 3>;
+
+  // Builds the hull of 'points', assigning points to faces on up to
+  // 'num_threads' threads when many move at once, as they do in the first
+  // iterations. Throws std::invalid_argument when the points do not span a
+  // volume: fewer than four of them, or all coplanar.
+  explicit ConvexHull(const std::vector<Vector3>& points,
+                      int num_threads = DefaultNumThreads());
+
+  std::size_t numVertices() const;
+  std::size_t numTriangles() const;
+
+  // Throws std::out_of_range when 'index' is not below numVertices().
+  Vector3 vertex(std::size_t index) const;
+  std::vector<Vector3> vertices() const;
+  const std::vector<Triangle>& triangles() const;
+  // Index of each vertex in the points the hull was built from.
+  const std::vector<std::uint32_t>& indices() const;
+
+  // Whether 'point' is inside the hull or on its boundary.
+  bool contains(const Vector3& point) const;
+  double volume() const;
+
+ private:
+  void assertValidAccessIndex(std::size_t index) const;
+
+  // Coordinates of the vertices, three per vertex.
+  std::vector<double> vertices_;
+  std::vector<std::uint32_t> indices_;
+  std::vector<Triangle> triangles_;
+};
+
+}  // namespace math
+}  // namespace ekumen
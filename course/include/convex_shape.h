@@ -0,0 +1,84 @@
+#pragma once
+
+#include <cstddef>
+#include <iostream>
+#include <vector>
+#include "aabb.h"
+#include "vector3.h"
+
+namespace ekumen {
+namespace math {
+
+// Convex shape in its local frame, for the queries of gjk.h: a core, which
+// is a point, a segment, a box or the hull of points, grown by a radius.
+// Spheres and capsules are points and segments grown by their radius, so
+// their cores are polytopes on which GJK terminates exactly.
+class ConvexShape {
+ public:
+  enum class Type { kSphere, kBox, kCapsule, kHull };
+
+  // Unit sphere.
+  ConvexShape();
+
+  // Throw std::invalid_argument for negative or NaN sizes.
+  static ConvexShape Sphere(double radius);
+  static ConvexShape Box(const Vector3& half_extents);
+  // Segment from -half_length to half_length along the z axis, grown by
+  // 'radius'.
+  static ConvexShape Capsule(double half_length, double radius);
+
+  // Hull of 'vertices', which need not all be on it. Throws
+  // std::invalid_argument for no vertices.
+  static ConvexShape Hull(const std::vector<Vector3>& vertices);
+
+  Type type() const;
+  // Radius by which the core is grown, 0 for boxes and hulls.
+  double radius() const;
+
+  // Point of the core furthest along 'direction', in the local frame.
+  Vector3 support(const Vector3& direction) const;
+
+  // As above on raw doubles, for the inner loops of the queries.
+  void support(const double* direction, double* res) const {
+    switch (type_) {
+      case Type::kSphere:
+        res[0] = res[1] = res[2] = 0.;
+        return;
+      case Type::kBox:
+        for (int i = 0; i < 3; ++i) {
+          res[i] = direction[i] < 0. ? -half_[i] : half_[i];
+        }
+        return;
+      case Type::kCapsule:
+        res[0] = res[1] = 0.;
+        res[2] = direction[2] < 0. ? -half_[2] : half_[2];
+        return;
+      case Type::kHull:
+        hullSupport(direction, res);
+        return;
+    }
+  }
+
+  // Bounds of the shape, radius included, in the local frame.
+  Aabb bounds() const;
+
+  friend std::ostream& operator<<(std::ostream& os, const ConvexShape& obj);
+
+ private:
+  ConvexShape(Type type, const Vector3& half, double radius);
+
+  static void assertValidSize(double size);
+
+  // Vertex of the hull furthest along 'direction', by a scan of them all.
+  void hullSupport(const double* direction, double* res) const;
+
+  Type type_;
+  // Half extents of the box, or the half length of the capsule along z.
+  double half_[3];
+  double radius_;
+  // Hull vertices, three coordinates each.
+  std::vector<double> vertices_;
+};
+
+}  // namespace math
+}  // namespace ekumen
@@ -0,0 +1,20 @@
+#pragma once
+
+// Runtime dispatch for loops that only vectorize with AVX2, which the
+// default build flags lack. On x86 GCC and Clang EKUMEN_AVX2_DISPATCH is
+// defined and EKUMEN_TARGET_AVX2 compiles a function for AVX2; such a
+// function may only be called when CpuHasAvx2().
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define EKUMEN_AVX2_DISPATCH 1
+#define EKUMEN_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+namespace ekumen {
+namespace math {
+
+// Whether the CPU runs AVX2 code; always false without
+// EKUMEN_AVX2_DISPATCH.
+bool CpuHasAvx2();
+
+}  // namespace math
+}  // namespace ekumen
@@ -0,0 +1,62 @@
+#pragma once
+
+#include "convex_shape.h"
+#include "isometry.h"
+#include "vector3.h"
+
+namespace ekumen {
+namespace math {
+
+// Simplex of the last GJK run between two shapes, as the support points on
+// each core in the frame of its shape, which stay valid as the shapes move.
+// Passing the same cache to the next query between the same two shapes
+// starts GJK from that simplex, which for shapes that moved little takes an
+// iteration or two instead of several.
+struct GjkCache {
+  GjkCache();
+
+  // 0 before the first query.
+  int size;
+  double a[4][3];
+  double b[4][3];
+};
+
+// Contact between two shapes, in the world frame.
+struct ConvexContact {
+  // Distance between the surfaces, or minus the depth by which they
+  // overlap.
+  double distance;
+  // Nearest points of the surfaces when apart, or the deepest point of
+  // each shape inside the other when they overlap.
+  Vector3 point_a;
+  Vector3 point_b;
+  // Unit direction from 'a' to 'b': point_b - point_a is distance * normal,
+  // and moving 'b' by -distance along it makes the shapes touch.
+  Vector3 normal;
+  // GJK iterations, plus EPA ones when the cores overlap.
+  int iterations;
+};
+
+// The queries work in the frame of 'a', into which only the relative pose of
+// 'b' is moved: support points of each shape are found in its own frame,
+// with directions turned by the inverse rotation, so no vertex is ever
+// copied into the world frame. Hull supports scan every vertex, which suits
+// hulls of up to a few dozen vertices.
+
+// Distance between 'a' at 'pose_a' and 'b' at 'pose_b' with GJK, or 0 when
+// they overlap. When they are apart, sets 'contact', if not null, to the
+// nearest points; otherwise leaves it unchanged.
+double ConvexDistance(const ConvexShape& a, const Isometry& pose_a,
+                      const ConvexShape& b, const Isometry& pose_b,
+                      ConvexContact* contact = nullptr,
+                      GjkCache* cache = nullptr);
+
+// Contact between 'a' at 'pose_a' and 'b' at 'pose_b': as ConvexDistance()
+// when they are apart, and with the depth and direction of least
+// penetration when they overlap, by EPA on the cores when those overlap.
+ConvexContact ConvexPenetration(const ConvexShape& a, const Isometry& pose_a,
+                                const ConvexShape& b, const Isometry& pose_b,
+                                GjkCache* cache = nullptr);
+
+}  // namespace math
+}  // namespace ekumen
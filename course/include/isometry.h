@@ -1,5 +1,8 @@
 #pragma once
 
+#include <cstddef>
+#include <vector>
+#include "map_view.h"
 #include "matrix3.h"
 #include "vector3.h"
 
@@ -56,6 +59,41 @@ class Isometry {
   // by this object.
   Vector3 transform(const Vector3& obj) const;
 
+  // Transforms points of an external buffer in place.
+  void transform(const PointsView& points) const;
+
+  // Transforms 'input' into 'output', which may be the same buffer. Throws
+  // std::invalid_argument when their sizes differ.
+  void transform(const ConstPointsView& input,
+                 const PointsView& output) const;
+
+  // Indexed transforms of a subset of a point buffer, e.g. the points of a
+  // region. Points 'prefetch_distance' indices ahead are requested from
+  // memory while the current one is transformed, which hides the latency of
+  // random accesses; 0 disables it. All throw std::out_of_range for indices
+  // outside the indexed view, before touching any point.
+  static const std::size_t kPrefetchDistance = 32;
+
+  // Transforms the points of 'points' at 'indices' in place. Repeated
+  // indices are transformed repeatedly.
+  void transform(const PointsView& points,
+                 const std::vector<std::size_t>& indices,
+                 std::size_t prefetch_distance = kPrefetchDistance) const;
+
+  // Transforms input[indices[k]] into output[k]. Throws
+  // std::invalid_argument when 'indices' and 'output' sizes differ.
+  void transformGather(const ConstPointsView& input,
+                       const std::vector<std::size_t>& indices,
+                       const PointsView& output,
+                       std::size_t prefetch_distance = kPrefetchDistance) const;
+
+  // Transforms input[k] into output[indices[k]]. Throws
+  // std::invalid_argument when 'input' and 'indices' sizes differ.
+  void transformScatter(
+      const ConstPointsView& input, const std::vector<std::size_t>& indices,
+      const PointsView& output,
+      std::size_t prefetch_distance = kPrefetchDistance) const;
+
   // Composes two isometry transformations.
   Isometry compose(const Isometry& obj) const;
 
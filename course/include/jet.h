@@ -0,0 +1,206 @@
+#pragma once
+
+#include <cmath>
+#include <iostream>
+
+namespace ekumen {
+namespace math {
+
+// Dual number for forward-mode automatic differentiation. Holds a scalar value
+// 'a' and its N partial derivatives 'v' in a fixed-size array, so arithmetic
+// never allocates. Seed the independent variables with Jet(value, index) and
+// read the derivatives of any expression from its 'v' member.
+template <int N>
+struct Jet {
+  Jet() : a(0.) { setDerivatives(0.); }
+
+  // Builds a constant: all derivatives are zero.
+  Jet(const double& value) : a(value) { setDerivatives(0.); }
+
+  // Builds the independent variable number 'index'.
+  Jet(const double& value, const int& index) : a(value) {
+    setDerivatives(0.);
+    v[index] = 1.;
+  }
+
+  Jet& operator+=(const Jet& obj) { return *this = *this + obj; }
+  Jet& operator-=(const Jet& obj) { return *this = *this - obj; }
+  Jet& operator*=(const Jet& obj) { return *this = *this * obj; }
+  Jet& operator/=(const Jet& obj) { return *this = *this / obj; }
+
+  void setDerivatives(const double& value) {
+    for (int i = 0; i < N; ++i) {
+      v[i] = value;
+    }
+  }
+
+  // Scalar part.
+  double a;
+
+  // Partial derivatives of the scalar part.
+  double v[N];
+};
+
+// Builds a jet from a scalar part and the derivatives 'd' scaled by 'factor'.
+template <int N>
+Jet<N> ScaledJet(const double& value, const Jet<N>& d, const double& factor) {
+  Jet<N> res(value);
+  for (int i = 0; i < N; ++i) {
+    res.v[i] = d.v[i] * factor;
+  }
+  return res;
+}
+
+template <int N>
+Jet<N> operator-(const Jet<N>& obj) {
+  return ScaledJet(-obj.a, obj, -1.);
+}
+
+template <int N>
+Jet<N> operator+(const Jet<N>& lhs, const Jet<N>& rhs) {
+  Jet<N> res(lhs.a + rhs.a);
+  for (int i = 0; i < N; ++i) {
+    res.v[i] = lhs.v[i] + rhs.v[i];
+  }
+  return res;
+}
+
+template <int N>
+Jet<N> operator-(const Jet<N>& lhs, const Jet<N>& rhs) {
+  Jet<N> res(lhs.a - rhs.a);
+  for (int i = 0; i < N; ++i) {
+    res.v[i] = lhs.v[i] - rhs.v[i];
+  }
+  return res;
+}
+
+template <int N>
+Jet<N> operator*(const Jet<N>& lhs, const Jet<N>& rhs) {
+  Jet<N> res(lhs.a * rhs.a);
+  for (int i = 0; i < N; ++i) {
+    res.v[i] = lhs.a * rhs.v[i] + lhs.v[i] * rhs.a;
+  }
+  return res;
+}
+
+template <int N>
+Jet<N> operator/(const Jet<N>& lhs, const Jet<N>& rhs) {
+  const double inv = 1. / rhs.a;
+  const double value = lhs.a * inv;
+  Jet<N> res(value);
+  for (int i = 0; i < N; ++i) {
+    res.v[i] = (lhs.v[i] - value * rhs.v[i]) * inv;
+  }
+  return res;
+}
+
+template <int N>
+Jet<N> operator+(const Jet<N>& lhs, const double& rhs) {
+  return ScaledJet(lhs.a + rhs, lhs, 1.);
+}
+
+template <int N>
+Jet<N> operator+(const double& lhs, const Jet<N>& rhs) {
+  return ScaledJet(lhs + rhs.a, rhs, 1.);
+}
+
+template <int N>
+Jet<N> operator-(const Jet<N>& lhs, const double& rhs) {
+  return ScaledJet(lhs.a - rhs, lhs, 1.);
+}
+
+template <int N>
+Jet<N> operator-(const double& lhs, const Jet<N>& rhs) {
+  return ScaledJet(lhs - rhs.a, rhs, -1.);
+}
+
+template <int N>
+Jet<N> operator*(const Jet<N>& lhs, const double& rhs) {
+  return ScaledJet(lhs.a * rhs, lhs, rhs);
+}
+
+template <int N>
+Jet<N> operator*(const double& lhs, const Jet<N>& rhs) {
+  return ScaledJet(lhs * rhs.a, rhs, lhs);
+}
+
+template <int N>
+Jet<N> operator/(const Jet<N>& lhs, const double& rhs) {
+  return ScaledJet(lhs.a / rhs, lhs, 1. / rhs);
+}
+
+template <int N>
+Jet<N> operator/(const double& lhs, const Jet<N>& rhs) {
+  const double value = lhs / rhs.a;
+  return ScaledJet(value, rhs, -value / rhs.a);
+}
+
+// Comparisons only look at the scalar part, so that branches taken by generic
+// code match the ones taken with plain doubles.
+template <int N>
+bool operator<(const Jet<N>& lhs, const Jet<N>& rhs) {
+  return lhs.a < rhs.a;
+}
+
+template <int N>
+bool operator>(const Jet<N>& lhs, const Jet<N>& rhs) {
+  return lhs.a > rhs.a;
+}
+
+template <int N>
+bool operator<(const Jet<N>& lhs, const double& rhs) {
+  return lhs.a < rhs;
+}
+
+template <int N>
+bool operator>(const Jet<N>& lhs, const double& rhs) {
+  return lhs.a > rhs;
+}
+
+template <int N>
+std::ostream& operator<<(std::ostream& os, const Jet<N>& obj) {
+  os << "[" << obj.a << " ; ";
+  for (int i = 0; i < N; ++i) {
+    os << (i == 0 ? "" : ", ") << obj.v[i];
+  }
+  os << "]";
+  return os;
+}
+
+// Elementary functions. They live in the same namespace as Jet so that
+// unqualified calls in generic code resolve by argument-dependent lookup,
+// next to 'using std::sin;' for plain doubles.
+
+template <int N>
+Jet<N> sqrt(const Jet<N>& obj) {
+  const double value = std::sqrt(obj.a);
+  return ScaledJet(value, obj, 0.5 / value);
+}
+
+template <int N>
+Jet<N> sin(const Jet<N>& obj) {
+  return ScaledJet(std::sin(obj.a), obj, std::cos(obj.a));
+}
+
+template <int N>
+Jet<N> cos(const Jet<N>& obj) {
+  return ScaledJet(std::cos(obj.a), obj, -std::sin(obj.a));
+}
+
+template <int N>
+Jet<N> atan2(const Jet<N>& y, const Jet<N>& x) {
+  const double inv_norm_sq = 1. / (x.a * x.a + y.a * y.a);
+  Jet<N> res(std::atan2(y.a, x.a));
+  for (int i = 0; i < N; ++i) {
+    res.v[i] = (x.a * y.v[i] - y.a * x.v[i]) * inv_norm_sq;
+  }
+  return res;
+}
+
+template <int N>
+Jet<N> abs(const Jet<N>& obj) {
+  return obj.a < 0. ? -obj : obj;
+}
+
+}  // namespace math
+}  // namespace ekumen
@@ -0,0 +1,66 @@
+#pragma once
+
+#include "isometry.h"
+#include "matrix.h"
+#include "matrix3.h"
+#include "vector3.h"
+
+namespace ekumen {
+namespace math {
+
+// Exponential and logarithmic maps of the special orthogonal group SO(3).
+// Tangent vectors are rotation vectors: axis times angle in radians.
+class SO3 {
+ public:
+  // Returns the skew-symmetric matrix [omega]x such that [omega]x * v equals
+  // omega.cross(v).
+  static Matrix3 Hat(const Vector3& omega);
+
+  // Returns the vector of a skew-symmetric matrix, the inverse of Hat().
+  static Vector3 Vee(const Matrix3& skew);
+
+  // Maps a rotation vector to its rotation matrix (Rodrigues' formula).
+  static Matrix3 Exp(const Vector3& omega);
+
+  // Maps a rotation matrix to its rotation vector, with angle in [0; pi].
+  static Vector3 Log(const Matrix3& rotation);
+
+  // Left Jacobian: Exp(omega + d) ~= Exp(LeftJacobian(omega) * d) * Exp(omega).
+  static Matrix3 LeftJacobian(const Vector3& omega);
+
+  // Right Jacobian: Exp(omega + d) ~= Exp(omega) * Exp(RightJacobian(omega) *
+  // d).
+  static Matrix3 RightJacobian(const Vector3& omega);
+
+  // Inverse of LeftJacobian(omega).
+  static Matrix3 LeftJacobianInverse(const Vector3& omega);
+
+  // Inverse of RightJacobian(omega).
+  static Matrix3 RightJacobianInverse(const Vector3& omega);
+};
+
+// Exponential and logarithmic maps of the special Euclidean group SE(3). A
+// twist is split in its translational part 'rho' and its rotational part
+// 'omega'.
+class SE3 {
+ public:
+  // Maps a twist to its isometry transformation.
+  static Isometry Exp(const Vector3& rho, const Vector3& omega);
+
+  // Maps an isometry transformation to its twist.
+  static void Log(const Isometry& pose, Vector3* rho, Vector3* omega);
+
+  // Adjoint matrix of a pose, which maps twists (rho, omega) from its local
+  // frame to its reference frame: pose * Exp(xi) = Exp(Adjoint(pose) * xi) *
+  // pose.
+  static Matrix6 Adjoint(const Isometry& pose);
+
+  // Left Jacobian: Exp(xi + d) ~= Exp(LeftJacobian(xi) * d) * Exp(xi).
+  static Matrix6 LeftJacobian(const Vector3& rho, const Vector3& omega);
+
+  // Right Jacobian: Exp(xi + d) ~= Exp(xi) * Exp(RightJacobian(xi) * d).
+  static Matrix6 RightJacobian(const Vector3& rho, const Vector3& omega);
+};
+
+}  // namespace math
+}  // namespace ekumen
@@ -0,0 +1,257 @@
+#pragma once
+
+#include <cstddef>
+#include <iostream>
+#include <iterator>
+#include <stdexcept>
+#include <type_traits>
+#include "matrix3.h"
+#include "vector3.h"
+
+namespace ekumen {
+namespace math {
+
+// Non-owning Vector3 over three consecutive doubles of an external buffer,
+// e.g. sensor driver memory or a NumPy array, which must outlive the map.
+// 'T' is double for writable maps and const double for read-only ones.
+//
+// Maps convert to Vector3 implicitly, so they are accepted wherever a
+// Vector3 is, and offer the Vector3 operations, which return Vector3 values.
+// Copying a map makes another map of the same doubles, while assigning to a
+// map writes through to its doubles.
+template <typename T>
+class BasicVector3Map {
+ public:
+  explicit BasicVector3Map(T* data) : data_(data) {}
+  BasicVector3Map(const BasicVector3Map& obj) = default;
+  // Read-only maps of writable ones.
+  template <typename U, typename = typename std::enable_if<
+                            std::is_convertible<U*, T*>::value>::type>
+  BasicVector3Map(const BasicVector3Map<U>& obj) : data_(obj.data()) {}
+
+  BasicVector3Map& operator=(const BasicVector3Map& obj) {
+    return *this = Vector3(obj);
+  }
+  BasicVector3Map& operator=(const Vector3& obj) {
+    data_[0] = obj.x();
+    data_[1] = obj.y();
+    data_[2] = obj.z();
+    return *this;
+  }
+
+  operator Vector3() const { return Vector3(data_[0], data_[1], data_[2]); }
+
+  T* data() const { return data_; }
+
+  T& x() const { return data_[0]; }
+  T& y() const { return data_[1]; }
+  T& z() const { return data_[2]; }
+
+  // Access vector components, throws std::out_of_range for invalid indices.
+  T& operator[](int index) const {
+    if (index < 0 || index > 2) {
+      throw std::out_of_range(
+          "Index to access an element must be in range [0;2].");
+    }
+    return data_[index];
+  }
+
+  Vector3 operator+(const Vector3& obj) const { return Vector3(*this) + obj; }
+  Vector3 operator-(const Vector3& obj) const { return Vector3(*this) - obj; }
+  // Member to member product and division.
+  Vector3 operator*(const Vector3& obj) const { return Vector3(*this) * obj; }
+  Vector3 operator/(const Vector3& obj) const { return Vector3(*this) / obj; }
+  Vector3 operator*(const double& factor) const {
+    return Vector3(*this) * factor;
+  }
+  Vector3 operator/(const double& factor) const {
+    return Vector3(*this) / factor;
+  }
+  friend Vector3 operator*(const double& factor, const BasicVector3Map& obj) {
+    return obj * factor;
+  }
+
+  BasicVector3Map& operator+=(const Vector3& obj) {
+    return *this = *this + obj;
+  }
+  BasicVector3Map& operator-=(const Vector3& obj) {
+    return *this = *this - obj;
+  }
+  BasicVector3Map& operator*=(const double& factor) {
+    return *this = *this * factor;
+  }
+  BasicVector3Map& operator/=(const double& factor) {
+    return *this = *this / factor;
+  }
+
+  bool operator==(const Vector3& rhs) const { return Vector3(*this) == rhs; }
+  bool operator!=(const Vector3& rhs) const { return !(*this == rhs); }
+
+  friend std::ostream& operator<<(std::ostream& os,
+                                  const BasicVector3Map& obj) {
+    return os << Vector3(obj);
+  }
+
+  double norm() const { return Vector3(*this).norm(); }
+  double dot(const Vector3& obj) const { return Vector3(*this).dot(obj); }
+  Vector3 cross(const Vector3& obj) const { return Vector3(*this).cross(obj); }
+
+ private:
+  T* data_;
+};
+
+typedef BasicVector3Map<double> Vector3Map;
+typedef BasicVector3Map<const double> ConstVector3Map;
+
+// Non-owning Matrix3 over nine row-major doubles of an external buffer, with
+// the semantics of BasicVector3Map. Rows are maps too.
+template <typename T>
+class BasicMatrix3Map {
+ public:
+  explicit BasicMatrix3Map(T* data) : data_(data) {}
+  BasicMatrix3Map(const BasicMatrix3Map& obj) = default;
+  template <typename U, typename = typename std::enable_if<
+                            std::is_convertible<U*, T*>::value>::type>
+  BasicMatrix3Map(const BasicMatrix3Map<U>& obj) : data_(obj.data()) {}
+
+  BasicMatrix3Map& operator=(const BasicMatrix3Map& obj) {
+    return *this = Matrix3(obj);
+  }
+  BasicMatrix3Map& operator=(const Matrix3& obj) {
+    for (int i = 0; i < 3; ++i) {
+      row(i) = obj.row(i);
+    }
+    return *this;
+  }
+
+  operator Matrix3() const { return Matrix3(row(0), row(1), row(2)); }
+
+  T* data() const { return data_; }
+
+  // Gets a row, throws std::out_of_range for invalid indices.
+  BasicVector3Map<T> operator[](int index) const {
+    if (index < 0 || index > 2) {
+      throw std::out_of_range("Index to access a row must be in range [0;2].");
+    }
+    return row(index);
+  }
+  BasicVector3Map<T> row(int index) const {
+    return BasicVector3Map<T>(data_ + 3 * index);
+  }
+  Vector3 col(int index) const { return Matrix3(*this).col(index); }
+
+  Matrix3 operator+(const Matrix3& obj) const { return Matrix3(*this) + obj; }
+  Matrix3 operator-(const Matrix3& obj) const { return Matrix3(*this) - obj; }
+  // Member to member product and division.
+  Matrix3 operator*(const Matrix3& obj) const { return Matrix3(*this) * obj; }
+  Matrix3 operator/(const Matrix3& obj) const { return Matrix3(*this) / obj; }
+  Matrix3 operator*(const double& factor) const {
+    return Matrix3(*this) * factor;
+  }
+  friend Matrix3 operator*(const double& factor, const BasicMatrix3Map& obj) {
+    return obj * factor;
+  }
+
+  bool operator==(const Matrix3& rhs) const { return Matrix3(*this) == rhs; }
+
+  friend std::ostream& operator<<(std::ostream& os,
+                                  const BasicMatrix3Map& obj) {
+    return os << Matrix3(obj);
+  }
+
+  double det() const { return Matrix3(*this).det(); }
+  Matrix3 product(const Matrix3& obj) const {
+    return Matrix3(*this).product(obj);
+  }
+  Vector3 product(const Vector3& vector) const {
+    return Vector3(row(0).dot(vector), row(1).dot(vector), row(2).dot(vector));
+  }
+  Matrix3 inverse() const { return Matrix3(*this).inverse(); }
+  Matrix3 transpose() const { return Matrix3(*this).transpose(); }
+
+ private:
+  T* data_;
+};
+
+typedef BasicMatrix3Map<double> Matrix3Map;
+typedef BasicMatrix3Map<const double> ConstMatrix3Map;
+
+// Non-owning sequence of points in an external buffer, where point i starts
+// 'stride' doubles after point i - 1. Interleaved records such as xyzrgb
+// have a stride of 6, and their other fields are left untouched.
+template <typename T>
+class BasicPointsView {
+ public:
+  class Iterator {
+   public:
+    typedef std::forward_iterator_tag iterator_category;
+    typedef BasicVector3Map<T> value_type;
+    typedef std::ptrdiff_t difference_type;
+    typedef void pointer;
+    typedef BasicVector3Map<T> reference;
+
+    Iterator(T* data, std::size_t stride) : data_(data), stride_(stride) {}
+    BasicVector3Map<T> operator*() const { return BasicVector3Map<T>(data_); }
+    Iterator& operator++() {
+      data_ += stride_;
+      return *this;
+    }
+    Iterator operator++(int) {
+      const Iterator res = *this;
+      ++*this;
+      return res;
+    }
+    bool operator==(const Iterator& rhs) const { return data_ == rhs.data_; }
+    bool operator!=(const Iterator& rhs) const { return data_ != rhs.data_; }
+
+   private:
+    T* data_;
+    std::size_t stride_;
+  };
+
+  BasicPointsView() : data_(nullptr), size_(0), stride_(3) {}
+  // Throws std::invalid_argument when 'stride' is below 3.
+  BasicPointsView(T* data, std::size_t size, std::size_t stride = 3)
+      : data_(data), size_(size), stride_(stride) {
+    if (stride < 3) {
+      throw std::invalid_argument("Points need a stride of at least 3.");
+    }
+  }
+  template <typename U, typename = typename std::enable_if<
+                            std::is_convertible<U*, T*>::value>::type>
+  BasicPointsView(const BasicPointsView<U>& obj)
+      : data_(obj.data()), size_(obj.size()), stride_(obj.stride()) {}
+
+  std::size_t size() const { return size_; }
+  bool empty() const { return size_ == 0; }
+  // Doubles from a point to the next one.
+  std::size_t stride() const { return stride_; }
+  T* data() const { return data_; }
+
+  // Unchecked point access.
+  BasicVector3Map<T> operator[](std::size_t index) const {
+    return BasicVector3Map<T>(data_ + stride_ * index);
+  }
+
+  // Point access, throws std::out_of_range for invalid indices.
+  BasicVector3Map<T> at(std::size_t index) const {
+    if (index >= size_) {
+      throw std::out_of_range("Index to access a point is out of range.");
+    }
+    return (*this)[index];
+  }
+
+  Iterator begin() const { return Iterator(data_, stride_); }
+  Iterator end() const { return Iterator(data_ + stride_ * size_, stride_); }
+
+ private:
+  T* data_;
+  std::size_t size_;
+  std::size_t stride_;
+};
+
+typedef BasicPointsView<double> PointsView;
+typedef BasicPointsView<const double> ConstPointsView;
+
+}  // namespace math
+}  // namespace ekumen
@@ -0,0 +1,343 @@
+#pragma once
+
+#include <initializer_list>
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+#include "double_util.h"
+#include "matrix3.h"
+#include "vector3.h"
+
+namespace ekumen {
+namespace math {
+
+// Fixed-size R x C matrix with inline row-major storage. Sizes are known at
+// compile time, so loops have constant bounds and no operation allocates.
+// 'Scalar' may be any type with double-like arithmetic, such as Jet<N>.
+template <int R, int C, typename Scalar = double>
+class Matrix {
+ public:
+  static_assert(R > 0 && C > 0, "Matrix dimensions must be positive.");
+
+  static const int kRows = R;
+  static const int kCols = C;
+  static const int kSize = R * C;
+
+  // Builds a zero-filled matrix.
+  Matrix() {
+    for (int i = 0; i < kSize; ++i) {
+      data_[i] = Scalar(0.);
+    }
+  }
+
+  // Builds a matrix from its R * C elements in row-major order.
+  Matrix(std::initializer_list<Scalar> values) {
+    if (values.size() != static_cast<std::size_t>(kSize)) {
+      throw std::invalid_argument("Invalid matrix size.");
+    }
+    for (int i = 0; i < kSize; ++i) {
+      data_[i] = values.begin()[i];
+    }
+  }
+
+  static Matrix Zero() { return Matrix(); }
+
+  static Matrix Identity() {
+    Matrix res;
+    for (int i = 0; i < (R < C ? R : C); ++i) {
+      res(i, i) = Scalar(1.);
+    }
+    return res;
+  }
+
+  // Builds a matrix from a row-major array of R * C elements.
+  static Matrix FromData(const Scalar* data) {
+    Matrix res;
+    for (int i = 0; i < kSize; ++i) {
+      res.data_[i] = data[i];
+    }
+    return res;
+  }
+
+  // Unchecked element access.
+  const Scalar& operator()(int row, int col) const {
+    return data_[C * row + col];
+  }
+  Scalar& operator()(int row, int col) { return data_[C * row + col]; }
+
+  // Element access, throws std::out_of_range for invalid indices.
+  const Scalar& at(int row, int col) const {
+    assertValidAccessIndex(row, col);
+    return data_[C * row + col];
+  }
+  Scalar& at(int row, int col) {
+    assertValidAccessIndex(row, col);
+    return data_[C * row + col];
+  }
+
+  const Scalar* data() const { return data_; }
+  Scalar* data() { return data_; }
+
+  // Member to member addition.
+  Matrix operator+(const Matrix& obj) const {
+    Matrix res;
+    for (int i = 0; i < kSize; ++i) {
+      res.data_[i] = data_[i] + obj.data_[i];
+    }
+    return res;
+  }
+
+  // Member to member substraction.
+  Matrix operator-(const Matrix& obj) const {
+    Matrix res;
+    for (int i = 0; i < kSize; ++i) {
+      res.data_[i] = data_[i] - obj.data_[i];
+    }
+    return res;
+  }
+
+  Matrix operator-() const { return *this * Scalar(-1.); }
+
+  Matrix& operator+=(const Matrix& obj) {
+    for (int i = 0; i < kSize; ++i) {
+      data_[i] += obj.data_[i];
+    }
+    return *this;
+  }
+
+  Matrix& operator-=(const Matrix& obj) {
+    for (int i = 0; i < kSize; ++i) {
+      data_[i] -= obj.data_[i];
+    }
+    return *this;
+  }
+
+  // Scales the matrix by a factor.
+  Matrix operator*(const Scalar& factor) const {
+    Matrix res;
+    for (int i = 0; i < kSize; ++i) {
+      res.data_[i] = data_[i] * factor;
+    }
+    return res;
+  }
+
+  // Scales the matrix by a factor.
+  friend Matrix operator*(const Scalar& factor, const Matrix& obj) {
+    return obj * factor;
+  }
+
+  // Scales the matrix dividing it by a factor.
+  Matrix operator/(const Scalar& factor) const {
+    return *this * (Scalar(1.) / factor);
+  }
+
+  // Matrix product.
+  template <int K>
+  Matrix<R, K, Scalar> operator*(const Matrix<C, K, Scalar>& obj) const {
+    Matrix<R, K, Scalar> res;
+    multiply(*this, obj, &res);
+    return res;
+  }
+
+  bool operator==(const Matrix& rhs) const {
+    for (int i = 0; i < kSize; ++i) {
+      if (!DoubleUtil::compare(data_[i], rhs.data_[i], kComparisonUlps)) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  bool operator!=(const Matrix& rhs) const { return !(*this == rhs); }
+
+  // Serializes the matrix to a stream with the format: '[[a11, a12], [a21,
+  // a22]]'.
+  friend std::ostream& operator<<(std::ostream& os, const Matrix& obj) {
+    const std::streamsize precision = os.precision(9);
+    os << "[";
+    for (int i = 0; i < R; ++i) {
+      os << (i == 0 ? "[" : ", [");
+      for (int j = 0; j < C; ++j) {
+        os << (j == 0 ? "" : ", ") << obj(i, j);
+      }
+      os << "]";
+    }
+    os << "]";
+    os.precision(precision);
+    return os;
+  }
+
+  Matrix<C, R, Scalar> transpose() const {
+    Matrix<C, R, Scalar> res;
+    for (int i = 0; i < R; ++i) {
+      for (int j = 0; j < C; ++j) {
+        res(j, i) = (*this)(i, j);
+      }
+    }
+    return res;
+  }
+
+  // Gets the BR x BC block whose top-left element is (row, col).
+  template <int BR, int BC>
+  Matrix<BR, BC, Scalar> block(int row, int col) const {
+    static_assert(BR <= R && BC <= C, "Block larger than the matrix.");
+    assertValidBlock(row, col, BR, BC);
+    Matrix<BR, BC, Scalar> res;
+    for (int i = 0; i < BR; ++i) {
+      for (int j = 0; j < BC; ++j) {
+        res(i, j) = (*this)(row + i, col + j);
+      }
+    }
+    return res;
+  }
+
+  // Sets the block whose top-left element is (row, col).
+  template <int BR, int BC>
+  void setBlock(int row, int col, const Matrix<BR, BC, Scalar>& block) {
+    static_assert(BR <= R && BC <= C, "Block larger than the matrix.");
+    assertValidBlock(row, col, BR, BC);
+    for (int i = 0; i < BR; ++i) {
+      for (int j = 0; j < BC; ++j) {
+        (*this)(row + i, col + j) = block(i, j);
+      }
+    }
+  }
+
+  // Gets the 3x3 block whose top-left element is (row, col) as a Matrix3.
+  Matrix3 block3(int row, int col) const {
+    const Matrix<3, 3, Scalar> res = block<3, 3>(row, col);
+    return Matrix3({res(0, 0), res(0, 1), res(0, 2), res(1, 0), res(1, 1),
+                    res(1, 2), res(2, 0), res(2, 1), res(2, 2)});
+  }
+
+  // Sets the 3x3 block whose top-left element is (row, col) from a Matrix3.
+  void setBlock(int row, int col, const Matrix3& block) {
+    assertValidBlock(row, col, 3, 3);
+    for (int i = 0; i < 3; ++i) {
+      for (int j = 0; j < 3; ++j) {
+        (*this)(row + i, col + j) = block[i][j];
+      }
+    }
+  }
+
+  // Gets the 3-element column segment starting at (row, col) as a Vector3.
+  Vector3 segment3(int row, int col = 0) const {
+    assertValidBlock(row, col, 3, 1);
+    return Vector3((*this)(row, col), (*this)(row + 1, col),
+                   (*this)(row + 2, col));
+  }
+
+  // Sets the 3-element column segment starting at (row, col) from a Vector3.
+  void setSegment(int row, const Vector3& segment, int col = 0) {
+    assertValidBlock(row, col, 3, 1);
+    for (int i = 0; i < 3; ++i) {
+      (*this)(row + i, col) = segment[i];
+    }
+  }
+
+ private:
+  static const int kComparisonUlps = 5;
+
+  // Computes res = a * b. Rows of 'res' are accumulated as linear
+  // combinations of rows of 'b' (i-k-j order), which streams both operands
+  // with unit stride. Larger products are split in kBlock-wide panels of 'b'
+  // so that a panel stays in cache while every row of 'a' goes over it.
+  template <int K>
+  static void multiply(const Matrix& a, const Matrix<C, K, Scalar>& b,
+                       Matrix<R, K, Scalar>* res) {
+    const int kBlock = 16;
+    for (int k0 = 0; k0 < C; k0 += kBlock) {
+      const int k_end = k0 + kBlock < C ? k0 + kBlock : C;
+      for (int i = 0; i < R; ++i) {
+        for (int k = k0; k < k_end; ++k) {
+          const Scalar a_ik = a(i, k);
+          for (int j = 0; j < K; ++j) {
+            (*res)(i, j) += a_ik * b(k, j);
+          }
+        }
+      }
+    }
+  }
+
+  static void assertValidAccessIndex(int row, int col) {
+    if (row < 0 || row >= R || col < 0 || col >= C) {
+      throw std::out_of_range("Index to access an element is out of range.");
+    }
+  }
+
+  static void assertValidBlock(int row, int col, int rows, int cols) {
+    if (row < 0 || row + rows > R || col < 0 || col + cols > C) {
+      throw std::out_of_range("Block is out of the matrix range.");
+    }
+  }
+
+  Scalar data_[R * C];
+};
+
+template <int R, int C, typename Scalar>
+const int Matrix<R, C, Scalar>::kRows;
+template <int R, int C, typename Scalar>
+const int Matrix<R, C, Scalar>::kCols;
+template <int R, int C, typename Scalar>
+const int Matrix<R, C, Scalar>::kSize;
+template <int R, int C, typename Scalar>
+const int Matrix<R, C, Scalar>::kComparisonUlps;
+
+// The 3x3 products are written out: they are the hot path of every rotation
+// and of the 3x3 blocks of the larger matrices.
+template <>
+template <>
+inline void Matrix<3, 3, double>::multiply<3>(const Matrix<3, 3, double>& a,
+                                              const Matrix<3, 3, double>& b,
+                                              Matrix<3, 3, double>* res) {
+  for (int i = 0; i < 3; ++i) {
+    const double a0 = a(i, 0);
+    const double a1 = a(i, 1);
+    const double a2 = a(i, 2);
+    (*res)(i, 0) = a0 * b(0, 0) + a1 * b(1, 0) + a2 * b(2, 0);
+    (*res)(i, 1) = a0 * b(0, 1) + a1 * b(1, 1) + a2 * b(2, 1);
+    (*res)(i, 2) = a0 * b(0, 2) + a1 * b(1, 2) + a2 * b(2, 2);
+  }
+}
+
+template <>
+template <>
+inline void Matrix<3, 3, double>::multiply<1>(const Matrix<3, 3, double>& a,
+                                              const Matrix<3, 1, double>& b,
+                                              Matrix<3, 1, double>* res) {
+  for (int i = 0; i < 3; ++i) {
+    (*res)(i, 0) = a(i, 0) * b(0, 0) + a(i, 1) * b(1, 0) + a(i, 2) * b(2, 0);
+  }
+}
+
+typedef Matrix<3, 1> Vector3d;
+typedef Matrix<6, 1> Vector6;
+typedef Matrix<3, 3> Matrix3d;
+typedef Matrix<3, 6> Matrix36;
+typedef Matrix<6, 6> Matrix6;
+
+// Converts a Matrix3 to its fixed-size template counterpart.
+inline Matrix3d ToMatrix(const Matrix3& obj) {
+  Matrix3d res;
+  res.setBlock(0, 0, obj);
+  return res;
+}
+
+// Converts a Vector3 to its fixed-size template counterpart.
+inline Vector3d ToMatrix(const Vector3& obj) {
+  Vector3d res;
+  res.setSegment(0, obj);
+  return res;
+}
+
+// Stacks two Vector3 in a 6-vector, e.g. the translational and rotational
+// parts of a twist.
+inline Vector6 Stack(const Vector3& top, const Vector3& bottom) {
+  Vector6 res;
+  res.setSegment(0, top);
+  res.setSegment(3, bottom);
+  return res;
+}
+
+}  // namespace math
+}  // namespace ekumen
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <initializer_list>
 #include <vector>
 #include "vector3.h"
 
@@ -76,13 +77,16 @@ class Matrix3 {
   // Computes the inverse of a Matrix3.
   Matrix3 inverse() const;
 
+  // Computes the transpose of a Matrix3.
+  Matrix3 transpose() const;
+
  private:
   // Checks that the index to access the member rows is in range.
   void assertValidAccessIndex(int index) const;
 
   static const int comparison_ulps = 5;
 
-  std::vector<Vector3> rows_;
+  Vector3 rows_[3];
 };
 
 }  // namespace math
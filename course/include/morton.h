@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+#include "parallel.h"
+#include "point_cloud.h"
+#include "vector3.h"
+
+namespace ekumen {
+namespace math {
+
+// Bits per coordinate of a Morton code.
+constexpr int kMortonBits = 21;
+
+// Interleaves the low 21 bits of three cell coordinates into a 63-bit Morton
+// code, with x in bit 0, y in bit 1 and z in bit 2. Cells close in space get
+// close codes, so sorting by code lays out points along a Z-order curve.
+std::uint64_t MortonEncode(std::uint32_t x, std::uint32_t y, std::uint32_t z);
+
+// Inverse of MortonEncode().
+void MortonDecode(std::uint64_t code, std::uint32_t* x, std::uint32_t* y,
+                  std::uint32_t* z);
+
+// Computes the Morton codes of the points of 'cloud' into 'codes', each
+// axis of the box ['min'; 'max'] being split in 2^21 cells. Points outside
+// the box are clamped to it and NaN coordinates map to cell 0. The loop has
+// no branches, so that it vectorizes.
+void MortonCodes(const PointCloud& cloud, const Vector3& min,
+                 const Vector3& max, std::vector<std::uint64_t>* codes);
+
+// Sorts 'keys', of which only the low 'num_bits' bits may be set, with a
+// stable least-significant-digit radix sort on 'num_threads' threads, and
+// returns the permutation applied: the sorted key k was at index 'res[k]'.
+// Throws std::invalid_argument when 'num_bits' is not in [1; 64].
+std::vector<std::size_t> RadixSort(std::vector<std::uint64_t>* keys,
+                                   int num_bits = 64,
+                                   int num_threads = DefaultNumThreads());
+
+// Reorders 'cloud' by the Morton codes of its points in the bounding box of
+// their finite coordinates, so that points close in space become close in
+// memory; infinite coordinates go to the boundary cells. Returns the
+// permutation applied, to reorder attributes with ApplyPermutation().
+std::vector<std::size_t> MortonSort(PointCloud* cloud,
+                                    int num_threads = DefaultNumThreads());
+
+// Reorders 'values' so that the new element k is the old element
+// 'order[k]'. Throws std::invalid_argument when the sizes differ.
+template <typename T>
+void ApplyPermutation(const std::vector<std::size_t>& order,
+                      std::vector<T>* values) {
+  if (order.size() != values->size()) {
+    throw std::invalid_argument(
+        "Permutation and values must have the same size.");
+  }
+  std::vector<T> res;
+  res.reserve(values->size());
+  for (std::size_t index : order) {
+    res.push_back((*values)[index]);
+  }
+  values->swap(res);
+}
+
+}  // namespace math
+}  // namespace ekumen
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <iostream>
+#include "aabb.h"
+#include "isometry.h"
+#include "matrix3.h"
+#include "point_cloud.h"
+#include "vector3.h"
+
+namespace ekumen {
+namespace math {
+
+// Oriented bounding box, the points center + axes * u with |u_i| <=
+// half_extents_i, where the columns of 'axes' are orthonormal. A default box
+// is empty, with negative half extents.
+struct Obb {
+  Obb();
+  Obb(const Vector3& center, const Matrix3& axes, const Vector3& half_extents);
+
+  // Box 'box' placed at 'pose'.
+  static Obb FromAabb(const Aabb& box, const Isometry& pose = Isometry());
+
+  // Box of 'points' along the principal axes of their covariance, a tight
+  // fit for elongated sets. Throws std::invalid_argument for no points.
+  static Obb Fit(const PointCloud& points);
+
+  bool empty() const;
+
+  // 0 for empty boxes.
+  double volume() const;
+
+  // Box moved by 'pose'.
+  Obb transformed(const Isometry& pose) const;
+
+  // Smallest Aabb containing the box, from the absolute values of the axes.
+  Aabb bounds() const;
+
+  bool contains(const Vector3& point) const;
+
+  // Separating axis test over the 15 candidate axes. Boxes touching at a
+  // face overlap.
+  bool overlaps(const Obb& obj) const;
+
+  friend std::ostream& operator<<(std::ostream& os, const Obb& obj);
+
+  Vector3 center;
+  Matrix3 axes;
+  Vector3 half_extents;
+};
+
+}  // namespace math
+}  // namespace ekumen
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+
+namespace ekumen {
+namespace math {
+
+// Returns the number of threads to use by default: the hardware concurrency,
+// or 1 when it is unknown.
+int DefaultNumThreads();
+
+// Splits the range [0; size) in at most 'num_threads' contiguous chunks and
+// runs 'body(chunk, begin, end)' on each of them concurrently. Chunks are
+// numbered from 0 so that 'body' can write per-chunk partial results without
+// synchronization. The calling thread processes chunk 0. Ranges smaller than
+// 'min_chunk_size' per thread use fewer chunks.
+void ParallelFor(std::size_t size, int num_threads,
+                 const std::function<void(int, std::size_t, std::size_t)>& body,
+                 std::size_t min_chunk_size = 1024);
+
+// Returns the number of chunks ParallelFor() uses for the same arguments.
+int NumChunks(std::size_t size, int num_threads,
+              std::size_t min_chunk_size = 1024);
+
+}  // namespace math
+}  // namespace ekumen
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+#include "isometry.h"
+#include "vector3.h"
+
+namespace ekumen {
+namespace math {
+
+// Point cloud in structure-of-arrays layout: the x, y and z coordinates are
+// kept in three contiguous arrays, so that bulk operations stream each
+// coordinate with unit stride and vectorize.
+class PointCloud {
+ public:
+  PointCloud() = default;
+  explicit PointCloud(std::size_t size);
+  explicit PointCloud(const std::vector<Vector3>& points);
+
+  std::size_t size() const;
+  bool empty() const;
+  void reserve(std::size_t capacity);
+  void resize(std::size_t size);
+  void clear();
+
+  void push_back(const Vector3& point);
+
+  // Appends all the points of another cloud.
+  void append(const PointCloud& obj);
+
+  // Gets a point, throws std::out_of_range for invalid indices.
+  Vector3 point(std::size_t index) const;
+
+  // Sets a point, throws std::out_of_range for invalid indices.
+  void setPoint(std::size_t index, const Vector3& point);
+
+  const double* x() const;
+  const double* y() const;
+  const double* z() const;
+  double* x();
+  double* y();
+  double* z();
+
+  // Transforms every point in place.
+  void transform(const Isometry& pose);
+
+  // Compares two clouds point by point, with the tolerance of Vector3.
+  bool operator==(const PointCloud& rhs) const;
+  bool operator!=(const PointCloud& rhs) const;
+
+ private:
+  void assertValidAccessIndex(std::size_t index) const;
+
+  std::vector<double> x_;
+  std::vector<double> y_;
+  std::vector<double> z_;
+};
+
+}  // namespace math
+}  // namespace ekumen
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <string>
+#include "point_cloud.h"
+
+namespace ekumen {
+namespace math {
+
+// Encodings of the data section of a PLY file.
+enum class PlyFormat {
+  kAscii,
+  kBinaryLittleEndian,
+  kBinaryBigEndian,
+};
+
+// Readers and writers of point-cloud files. Files are memory mapped with
+// sequential read-ahead hints and decoded straight into a PointCloud. ASCII
+// data is split in chunks at line boundaries that are parsed concurrently.
+//
+// Supported formats:
+//   XYZ: one point per line as whitespace-separated x, y and z. Further
+//        columns are ignored, and blank lines and '#' comments are skipped.
+//   PLY: ASCII, binary little-endian and binary big-endian files whose first
+//        element is 'vertex', with x, y and z scalar properties of any PLY
+//        type. Other vertex properties and later elements are ignored.
+//
+// Malformed files throw std::runtime_error with the byte offset of the error.
+class PointCloudIo {
+ public:
+  struct Options {
+    Options();
+
+    // Number of threads used to decode the data.
+    int num_threads;
+  };
+
+  static PointCloud ReadXyz(const std::string& path,
+                            const Options& options = Options());
+  static PointCloud ReadPly(const std::string& path,
+                            const Options& options = Options());
+
+  // Decodes a file already in memory.
+  static PointCloud ParseXyz(const char* begin, const char* end,
+                             const Options& options = Options());
+  static PointCloud ParsePly(const char* begin, const char* end,
+                             const Options& options = Options());
+
+  // Writes coordinates with the fewest digits that read back exactly.
+  static void WriteXyz(const PointCloud& cloud, const std::string& path);
+
+  // Writes x, y and z as 'double' vertex properties.
+  static void WritePly(const PointCloud& cloud, const std::string& path,
+                       PlyFormat format = PlyFormat::kBinaryLittleEndian);
+};
+
+}  // namespace math
+}  // namespace ekumen
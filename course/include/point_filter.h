@@ -0,0 +1,144 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include "isometry.h"
+#include "point_cloud.h"
+#include "vector3.h"
+
+namespace ekumen {
+namespace math {
+
+// Predicates of FilterTransform, all of which a point must pass to be kept.
+// Every predicate is unbounded by default, so a default filter only drops
+// points with non-finite coordinates.
+struct PointFilter {
+  PointFilter();
+
+  // Axis-aligned box of the kept points, after the transform.
+  Vector3 box_min;
+  Vector3 box_max;
+
+  // Ball of the kept points, after the transform.
+  Vector3 sphere_center;
+  double sphere_radius;
+
+  // Interval of distances of the kept points to the origin of the input,
+  // usually the sensor, before the transform.
+  double min_range;
+  double max_range;
+
+  // One flag per input point, nonzero to keep it, or nullptr to keep all.
+  const std::uint8_t* mask;
+};
+
+// Transforms a cloud and stream-compacts the points that pass a filter in a
+// single pass over memory, instead of a transform pass followed by one pass
+// per predicate.
+class FilterTransform {
+ public:
+  // Writes the points of 'input' transformed by 'pose' that pass 'filter'
+  // to 'output', in their input order, and returns how many there are.
+  // 'output' may be 'input'. Uses AVX-512 compress-stores when the CPU has
+  // them. Throws std::invalid_argument for a null 'output' or an inverted
+  // or NaN filter.
+  static std::size_t Run(const Isometry& pose, const PointFilter& filter,
+                         const PointCloud& input, PointCloud* output);
+
+  // As above, additionally keeping only the transformed points for which
+  // 'predicate(x, y, z)' is true. 'predicate' is inlined into a portable
+  // branchless loop.
+  template <typename Predicate>
+  static std::size_t Run(const Isometry& pose, const PointFilter& filter,
+                         Predicate predicate, const PointCloud& input,
+                         PointCloud* output);
+
+ private:
+  // Scalars of a pose and a filter, hoisted out of the point loops.
+  struct Kernel {
+    // Throws std::invalid_argument for invalid filters.
+    Kernel(const Isometry& pose, const PointFilter& filter);
+
+    // Transforms a point into 'q' and returns whether it passes the box,
+    // the sphere and the range, without branches.
+    bool apply(double px, double py, double pz, double* q) const {
+      q[0] = r[0] * px + r[1] * py + r[2] * pz + t[0];
+      q[1] = r[3] * px + r[4] * py + r[5] * pz + t[1];
+      q[2] = r[6] * px + r[7] * py + r[8] * pz + t[2];
+      const double dx = q[0] - center[0];
+      const double dy = q[1] - center[1];
+      const double dz = q[2] - center[2];
+      const double distance2 = dx * dx + dy * dy + dz * dz;
+      const double range2 = px * px + py * py + pz * pz;
+      return (q[0] >= box_min[0]) & (q[0] <= box_max[0]) &
+             (q[1] >= box_min[1]) & (q[1] <= box_max[1]) &
+             (q[2] >= box_min[2]) & (q[2] <= box_max[2]) &
+             (distance2 <= radius2) & (range2 >= min_range2) &
+             (range2 <= max_range2);
+    }
+
+    double r[9];
+    double t[3];
+    double box_min[3];
+    double box_max[3];
+    double center[3];
+    double radius2;
+    double min_range2;
+    double max_range2;
+    const std::uint8_t* mask;
+  };
+
+  template <typename Predicate>
+  static std::size_t runPortable(const Kernel& kernel, Predicate predicate,
+                                 const PointCloud& input, PointCloud* output);
+
+  // Processes eight points per iteration with AVX-512 compress-stores, or
+  // falls back to runPortable() where they are not compiled in.
+  static std::size_t runAvx512(const Kernel& kernel, const PointCloud& input,
+                               PointCloud* output);
+};
+
+template <typename Predicate>
+std::size_t FilterTransform::Run(const Isometry& pose,
+                                 const PointFilter& filter,
+                                 Predicate predicate, const PointCloud& input,
+                                 PointCloud* output) {
+  if (output == nullptr) {
+    throw std::invalid_argument("Output cloud must not be null.");
+  }
+  return runPortable(Kernel(pose, filter), predicate, input, output);
+}
+
+template <typename Predicate>
+std::size_t FilterTransform::runPortable(const Kernel& kernel,
+                                         Predicate predicate,
+                                         const PointCloud& input,
+                                         PointCloud* output) {
+  const std::size_t size = input.size();
+  // Survivors are written at or before the point being read, so 'output'
+  // may alias 'input'.
+  output->resize(size);
+  const double* x = input.x();
+  const double* y = input.y();
+  const double* z = input.z();
+  double* out_x = output->x();
+  double* out_y = output->y();
+  double* out_z = output->z();
+  std::size_t count = 0;
+  for (std::size_t i = 0; i < size; ++i) {
+    double q[3];
+    const bool keep = kernel.apply(x[i], y[i], z[i], q) &
+                      (kernel.mask == nullptr || kernel.mask[i] != 0) &
+                      static_cast<bool>(predicate(q[0], q[1], q[2]));
+    out_x[count] = q[0];
+    out_y[count] = q[1];
+    out_z[count] = q[2];
+    count += keep;
+  }
+  output->resize(count);
+  return count;
+}
+
+}  // namespace math
+}  // namespace ekumen
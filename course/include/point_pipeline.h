@@ -0,0 +1,318 @@
+#pragma once
+
+#include <cstddef>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+#include "isometry.h"
+#include "map_view.h"
+#include "point_cloud.h"
+#include "vector3.h"
+
+namespace ekumen {
+namespace math {
+
+// Lazy pipelines over point sets, e.g.
+//
+//   const std::vector<Vector3> res =
+//       (points | transformed(pose) | filtered(predicate) | strided(2))
+//           .toVector();
+//
+// Stages only describe the work: nothing runs until a sink such as
+// toVector() or forEach() consumes the pipeline. Then every stage is fused
+// into a single loop over the source, in which points are passed from stage
+// to stage as three doubles, without intermediate containers or Vector3
+// copies. Consecutive transformed() stages are composed into one.
+//
+// Sources are std::vector<Vector3>, PointCloud and points views. Pipelines
+// keep a reference to vectors and clouds, which must outlive them.
+
+// Base of the stages, which can be appended to pipelines with operator|.
+struct PointStage {};
+
+template <typename T>
+struct IsPointStage : std::is_base_of<PointStage, T> {};
+
+// Transforms the points by an isometry.
+class TransformedStage : public PointStage {
+ public:
+  explicit TransformedStage(const Isometry& pose) : pose_(pose) {}
+
+  const Isometry& pose() const { return pose_; }
+
+  template <typename Sink>
+  class Bound {
+   public:
+    Bound(const Isometry& pose, const Sink& sink) : sink_(sink) {
+      for (int i = 0; i < 3; ++i) {
+        for (int j = 0; j < 3; ++j) {
+          r_[3 * i + j] = pose.rotation()[i][j];
+        }
+        t_[i] = pose.translation()[i];
+      }
+    }
+
+    void operator()(double x, double y, double z) {
+      sink_(r_[0] * x + r_[1] * y + r_[2] * z + t_[0],
+            r_[3] * x + r_[4] * y + r_[5] * z + t_[1],
+            r_[6] * x + r_[7] * y + r_[8] * z + t_[2]);
+    }
+
+   private:
+    double r_[9];
+    double t_[3];
+    Sink sink_;
+  };
+
+  template <typename Sink>
+  Bound<Sink> bind(const Sink& sink) const {
+    return Bound<Sink>(pose_, sink);
+  }
+
+ private:
+  Isometry pose_;
+};
+
+// Keeps the points for which 'predicate(x, y, z)' is true.
+template <typename Predicate>
+class FilteredStage : public PointStage {
+ public:
+  explicit FilteredStage(const Predicate& predicate) : predicate_(predicate) {}
+
+  template <typename Sink>
+  class Bound {
+   public:
+    Bound(const Predicate& predicate, const Sink& sink)
+        : predicate_(predicate), sink_(sink) {}
+
+    void operator()(double x, double y, double z) {
+      if (predicate_(x, y, z)) {
+        sink_(x, y, z);
+      }
+    }
+
+   private:
+    Predicate predicate_;
+    Sink sink_;
+  };
+
+  template <typename Sink>
+  Bound<Sink> bind(const Sink& sink) const {
+    return Bound<Sink>(predicate_, sink);
+  }
+
+ private:
+  Predicate predicate_;
+};
+
+// Keeps the first point that reaches the stage and then one of every
+// 'stride'.
+class StridedStage : public PointStage {
+ public:
+  // Throws std::invalid_argument for a zero 'stride'.
+  explicit StridedStage(std::size_t stride) : stride_(stride) {
+    if (stride == 0) {
+      throw std::invalid_argument("Stride must be positive.");
+    }
+  }
+
+  template <typename Sink>
+  class Bound {
+   public:
+    Bound(std::size_t stride, const Sink& sink)
+        : stride_(stride), skip_(0), sink_(sink) {}
+
+    void operator()(double x, double y, double z) {
+      if (skip_ == 0) {
+        sink_(x, y, z);
+        skip_ = stride_;
+      }
+      --skip_;
+    }
+
+   private:
+    std::size_t stride_;
+    std::size_t skip_;
+    Sink sink_;
+  };
+
+  template <typename Sink>
+  Bound<Sink> bind(const Sink& sink) const {
+    return Bound<Sink>(stride_, sink);
+  }
+
+ private:
+  std::size_t stride_;
+};
+
+inline TransformedStage transformed(const Isometry& pose) {
+  return TransformedStage(pose);
+}
+
+// Functions decay to pointers, as 'predicate' is taken by value.
+template <typename Predicate>
+FilteredStage<Predicate> filtered(Predicate predicate) {
+  return FilteredStage<Predicate>(predicate);
+}
+
+inline StridedStage strided(std::size_t stride) {
+  return StridedStage(stride);
+}
+
+// Sources, which feed their points to a sink in order.
+class VectorPointSource {
+ public:
+  explicit VectorPointSource(const std::vector<Vector3>& points)
+      : points_(&points) {}
+
+  template <typename Sink>
+  void forEach(Sink sink) const {
+    for (const Vector3& point : *points_) {
+      sink(point.x(), point.y(), point.z());
+    }
+  }
+
+ private:
+  const std::vector<Vector3>* points_;
+};
+
+class CloudPointSource {
+ public:
+  explicit CloudPointSource(const PointCloud& cloud) : cloud_(&cloud) {}
+
+  template <typename Sink>
+  void forEach(Sink sink) const {
+    const double* x = cloud_->x();
+    const double* y = cloud_->y();
+    const double* z = cloud_->z();
+    const std::size_t size = cloud_->size();
+    for (std::size_t i = 0; i < size; ++i) {
+      sink(x[i], y[i], z[i]);
+    }
+  }
+
+ private:
+  const PointCloud* cloud_;
+};
+
+class ViewPointSource {
+ public:
+  explicit ViewPointSource(const ConstPointsView& view) : view_(view) {}
+
+  template <typename Sink>
+  void forEach(Sink sink) const {
+    const double* data = view_.data();
+    const std::size_t stride = view_.stride();
+    const std::size_t size = view_.size();
+    for (std::size_t i = 0; i < size; ++i, data += stride) {
+      sink(data[0], data[1], data[2]);
+    }
+  }
+
+ private:
+  ConstPointsView view_;
+};
+
+inline VectorPointSource PointSource(const std::vector<Vector3>& points) {
+  return VectorPointSource(points);
+}
+
+inline CloudPointSource PointSource(const PointCloud& cloud) {
+  return CloudPointSource(cloud);
+}
+
+inline ViewPointSource PointSource(const ConstPointsView& view) {
+  return ViewPointSource(view);
+}
+
+// A source followed by stages, of which 'Stage' is the last one.
+template <typename Parent, typename Stage>
+class PointPipeline {
+ public:
+  PointPipeline(const Parent& parent, const Stage& stage)
+      : parent_(parent), stage_(stage) {}
+
+  const Parent& parent() const { return parent_; }
+  const Stage& stage() const { return stage_; }
+
+  // Runs the pipeline, calling 'sink(x, y, z)' with every resulting point.
+  template <typename Sink>
+  void forEach(Sink sink) const {
+    parent_.forEach(stage_.bind(sink));
+  }
+
+  std::vector<Vector3> toVector() const {
+    std::vector<Vector3> res;
+    forEach(VectorAppender(&res));
+    return res;
+  }
+
+  PointCloud toCloud() const {
+    PointCloud res;
+    forEach(CloudAppender(&res));
+    return res;
+  }
+
+  std::size_t count() const {
+    std::size_t res = 0;
+    forEach(Counter(&res));
+    return res;
+  }
+
+ private:
+  struct VectorAppender {
+    explicit VectorAppender(std::vector<Vector3>* points) : points(points) {}
+    void operator()(double x, double y, double z) {
+      points->emplace_back(x, y, z);
+    }
+    std::vector<Vector3>* points;
+  };
+
+  struct CloudAppender {
+    explicit CloudAppender(PointCloud* cloud) : cloud(cloud) {}
+    void operator()(double x, double y, double z) {
+      cloud->push_back(Vector3(x, y, z));
+    }
+    PointCloud* cloud;
+  };
+
+  struct Counter {
+    explicit Counter(std::size_t* count) : count(count) {}
+    void operator()(double, double, double) { ++*count; }
+    std::size_t* count;
+  };
+
+  Parent parent_;
+  Stage stage_;
+};
+
+// Starts a pipeline from a source.
+template <typename Points, typename Stage>
+auto operator|(const Points& points, const Stage& stage) ->
+    typename std::enable_if<
+        IsPointStage<Stage>::value,
+        PointPipeline<decltype(PointSource(points)), Stage>>::type {
+  return PointPipeline<decltype(PointSource(points)), Stage>(
+      PointSource(points), stage);
+}
+
+// Appends a stage to a pipeline.
+template <typename Parent, typename Last, typename Stage>
+typename std::enable_if<IsPointStage<Stage>::value,
+                        PointPipeline<PointPipeline<Parent, Last>, Stage>>::type
+operator|(const PointPipeline<Parent, Last>& pipeline, const Stage& stage) {
+  return PointPipeline<PointPipeline<Parent, Last>, Stage>(pipeline, stage);
+}
+
+// Composes consecutive transforms, so that points are transformed once.
+template <typename Parent>
+PointPipeline<Parent, TransformedStage> operator|(
+    const PointPipeline<Parent, TransformedStage>& pipeline,
+    const TransformedStage& stage) {
+  const Isometry pose = stage.pose() * pipeline.stage().pose();
+  return PointPipeline<Parent, TransformedStage>(pipeline.parent(),
+                                                 TransformedStage(pose));
+}
+
+}  // namespace math
+}  // namespace ekumen
@@ -0,0 +1,113 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+#include "block_cholesky.h"
+#include "isometry.h"
+#include "matrix.h"
+
+namespace ekumen {
+namespace math {
+
+// Pose-graph optimizer. Nodes are absolute poses and edges are relative pose
+// measurements between two nodes. Optimize() runs Gauss-Newton iterations:
+// edges are linearized in parallel and each normal equation is solved with a
+// sparse Cholesky factorization of the 6x6 block system. The ordering and the
+// symbolic factorization only depend on the graph topology, so they are
+// computed once and reused by every iteration and every Optimize() call until
+// the graph changes.
+//
+// Errors and updates are expressed in the local frame of the poses: a tangent
+// vector (dt, dw) moves a pose to (translation + rotation * dt, rotation *
+// Exp(dw)). The error of an edge i -> j with measurement Z is the tangent
+// vector of Z^-1 * Xi^-1 * Xj.
+class PoseGraph {
+ public:
+  // Information matrix over (dt, dw).
+  typedef Matrix6 Information;
+
+  struct Options {
+    Options();
+
+    // Maximum number of Gauss-Newton iterations.
+    int max_iterations;
+
+    // Stops when the relative decrease of the error is below this value.
+    double function_tolerance;
+
+    // Stops when no component of the update is larger than this value.
+    double parameter_tolerance;
+
+    // Number of threads used to linearize the edges and to assemble the
+    // normal equations.
+    int num_threads;
+  };
+
+  struct Summary {
+    int iterations;
+    double initial_error;
+    double final_error;
+  };
+
+  // Returns an information matrix with 'translation' and 'rotation' weights
+  // on its diagonal.
+  static Information DiagonalInformation(const double& translation,
+                                         const double& rotation);
+
+  // Adds a node and returns its index.
+  int AddNode(const Isometry& pose);
+
+  // Adds a measurement of the pose of node 'to' in the frame of node 'from'.
+  // Throws std::out_of_range when a node does not exist.
+  void AddEdge(int from, int to, const Isometry& measurement,
+               const Information& information);
+
+  // Keeps a node constant during the optimization. When no node is fixed the
+  // first one is, to remove the gauge freedom.
+  void SetFixed(int node, bool fixed);
+
+  const Isometry& node(int index) const;
+  int numNodes() const;
+  int numEdges() const;
+
+  // Computes the sum of the squared Mahalanobis errors of all the edges.
+  double error() const;
+
+  // Optimizes the node poses in place. Throws std::runtime_error when the
+  // normal equations are singular, e.g. when a connected component of the
+  // graph has no fixed node.
+  Summary Optimize(const Options& options = Options());
+
+ private:
+  struct Edge {
+    int from;
+    int to;
+    Isometry measurement;
+    Information information;
+  };
+
+  // Incidence of an edge on a node.
+  struct Incidence {
+    int edge;
+    int other;
+    bool is_from;
+  };
+
+  // Builds the node to edge adjacency and analyzes the block pattern of the
+  // normal equations over the free nodes.
+  void buildStructure();
+
+  std::vector<Isometry> nodes_;
+  std::vector<bool> fixed_;
+  std::vector<Edge> edges_;
+
+  // Block index of every node in the normal equations, -1 for fixed nodes.
+  std::vector<int> free_index_;
+  std::vector<std::size_t> incidence_offsets_;
+  std::vector<Incidence> incidences_;
+  BlockCholesky solver_;
+  bool structure_valid_ = false;
+};
+
+}  // namespace math
+}  // namespace ekumen
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+#include "aabb.h"
+#include "isometry.h"
+#include "point_cloud.h"
+#include "triangle_mesh.h"
+#include "vector3.h"
+
+namespace ekumen {
+namespace math {
+
+// Rays in struct of arrays layout, e.g. the beams of a LiDAR scan: the
+// origins and directions are PointClouds of the same size. Directions need
+// not be unit, and distances along a ray are in units of its direction.
+class RayBatch {
+ public:
+  RayBatch() = default;
+  explicit RayBatch(std::size_t size);
+
+  std::size_t size() const;
+  bool empty() const;
+  void reserve(std::size_t capacity);
+  void resize(std::size_t size);
+  void clear();
+
+  void push_back(const Vector3& origin, const Vector3& direction);
+
+  // Throw std::out_of_range when 'index' is not below size().
+  Vector3 origin(std::size_t index) const;
+  Vector3 direction(std::size_t index) const;
+  void setRay(std::size_t index, const Vector3& origin,
+              const Vector3& direction);
+
+  const PointCloud& origins() const;
+  const PointCloud& directions() const;
+  PointCloud& origins();
+  PointCloud& directions();
+
+  // Point at 'distance' along ray 'index'.
+  Vector3 pointAt(std::size_t index, double distance) const;
+
+  // Moves the rays by 'pose'.
+  void transform(const Isometry& pose);
+
+ private:
+  PointCloud origins_;
+  PointCloud directions_;
+};
+
+// Nearest hits of a batch of rays, one entry per ray: the distance to the
+// hit and the id of the surface hit, or kNoHit. The cast functions lower
+// the distances of the rays that hit nearer, so that casting a batch
+// against several surfaces leaves the nearest hit of each ray.
+struct RayHits {
+  static const std::uint32_t kNoHit = std::numeric_limits<std::uint32_t>::max();
+
+  // Hits of 'size' rays cast up to 'max_distance'.
+  explicit RayHits(std::size_t size = 0,
+                   double max_distance =
+                       std::numeric_limits<double>::infinity());
+
+  std::vector<double> distances;
+  std::vector<std::uint32_t> ids;
+};
+
+// The cast functions take surfaces in their local frame placed at 'pose',
+// and move each ray into that frame as they go, so that the batch is not
+// copied; a plane is moved into the world frame instead. They run
+// branchless loops over the rays, with AVX2 copies chosen at run time on
+// x86. Hits behind the origin of a ray are ignored. They throw
+// std::invalid_argument when 'hits' does not hold one entry per ray.
+
+// Casts the rays against the plane of the points p with normal.dot(p) ==
+// offset, both sides of it.
+void CastPlane(const Isometry& pose, const Vector3& normal, double offset,
+               std::uint32_t id, const RayBatch& rays, RayHits* hits);
+
+// Casts the rays against the faces of 'box'. Rays starting inside the box
+// hit it at distance 0.
+void CastBox(const Isometry& pose, const Aabb& box, std::uint32_t id,
+             const RayBatch& rays, RayHits* hits);
+
+// Casts the rays against every triangle of 'mesh', both sides of them, with
+// the Möller-Trumbore test. The ids of the hits are the triangle indices.
+// Packets of consecutive rays traverse the hierarchy of the mesh together
+// and test the triangles of the leaves any of them enters, so batches of
+// neighbouring rays, such as LiDAR scans, are cast fastest.
+void CastTriangles(const Isometry& pose, const TriangleMesh& mesh,
+                   const RayBatch& rays, RayHits* hits);
+
+}  // namespace math
+}  // namespace ekumen
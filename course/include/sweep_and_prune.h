@@ -0,0 +1,85 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+#include "aabb.h"
+#include "isometry.h"
+
+namespace ekumen {
+namespace math {
+
+// Broad phase for many rigid bodies, each a box in its local frame placed at
+// an Isometry. Pairs whose world bounds overlap are found by sorting the
+// bounds along one axis and sweeping them. The sorted endpoints are kept
+// between calls and resorted by insertion, which takes close to linear time
+// while bodies move little between frames.
+class SweepAndPrune {
+ public:
+  using Pair = std::pair<std::uint32_t, std::uint32_t>;
+
+  SweepAndPrune() = default;
+
+  std::size_t size() const;
+  bool empty() const;
+  void reserve(std::size_t capacity);
+  void clear();
+
+  // Adds a body with 'box' in its local frame at 'pose', returning its
+  // index. Throws std::invalid_argument, here and when setting poses, when
+  // the world bounds of a body that is not empty are not finite.
+  std::uint32_t add(const Aabb& box, const Isometry& pose);
+
+  // Throw std::out_of_range when 'body' is not below size().
+  void setPose(std::size_t body, const Isometry& pose);
+  // World bounds of a body, 'box' transformed by its pose.
+  Aabb bounds(std::size_t body) const;
+
+  // Poses of every body. Throws std::invalid_argument when 'poses' does not
+  // hold one per body.
+  void setPoses(const std::vector<Isometry>& poses);
+
+  // Axis along which the endpoints are sorted. It switches to the axis the
+  // bodies spread most along when that spread is clearly larger.
+  int axis() const;
+
+  // Sets 'pairs' to the pairs of bodies whose world bounds overlap, as
+  // Aabb::overlaps() would, each with the lower index first, in no
+  // particular order. Bodies with empty boxes overlap nothing. 'pairs' keeps
+  // its capacity, so reusing it between frames does not allocate.
+  void findPairs(std::vector<Pair>* pairs);
+
+ private:
+  // Bound of a body along the sort axis: 'id' is twice the body index, plus
+  // one for the upper bound.
+  struct Endpoint {
+    double value;
+    std::uint32_t id;
+  };
+
+  void assertValidAccessIndex(std::size_t index) const;
+  void chooseAxis();
+  void sortEndpoints();
+
+  std::vector<Aabb> boxes_;
+  // World bounds along each axis.
+  std::vector<double> min_[3];
+  std::vector<double> max_[3];
+  std::vector<Endpoint> endpoints_;
+  int axis_{0};
+  // Whether bodies were added or the axis switched, which a full sort
+  // handles faster than insertions.
+  bool needs_sort_{false};
+  // Bodies overlapping the sweep position, their bounds along the other
+  // axes, and the slot of each body in them.
+  std::vector<std::uint32_t> active_;
+  std::vector<double> active_min_[2];
+  std::vector<double> active_max_[2];
+  std::vector<std::uint32_t> slots_;
+  // Overlap flags of the active bodies.
+  std::vector<std::uint8_t> flags_;
+};
+
+}  // namespace math
+}  // namespace ekumen
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <cstddef>
+#include <iostream>
+#include <vector>
+#include "isometry.h"
+#include "matrix3.h"
+#include "vector3.h"
+
+namespace ekumen {
+namespace math {
+
+// Formats vectors, matrices and isometries into caller-provided buffers with
+// the same text format as their operator<<, without streams or allocations.
+// Scalars are written like std::ostream does in its default float format,
+// with 'precision' significant digits, or with kRoundTrip as the fewest
+// digits that parse back to the same double.
+//
+// Every Format() function returns the number of characters written, not
+// counting the terminating null character it appends, and throws
+// std::length_error when 'size' is too small. Buffers of the kMax*Size
+// constants always fit.
+class TextFormat {
+ public:
+  static const int kRoundTrip = -1;
+  static const int kMaxPrecision = 17;
+
+  // Precision of operator<< for Vector3 on a default stream.
+  static const int kStreamPrecision = 6;
+
+  // Precision of operator<< for Matrix3.
+  static const int kMatrixPrecision = 9;
+
+  static const std::size_t kMaxScalarSize = 25;
+  static const std::size_t kMaxVector3Size = 88;
+  static const std::size_t kMaxMatrix3Size = 241;
+  static const std::size_t kMaxIsometrySize = 337;
+
+  // Format: '(x: 1, y: 2, z: 3)'.
+  static std::size_t Format(const Vector3& obj, char* buffer, std::size_t size,
+                            int precision = kStreamPrecision);
+
+  // Format: '[[1, 0, 0], [0, 1, 0], [0, 0, 1]]'.
+  static std::size_t Format(const Matrix3& obj, char* buffer, std::size_t size,
+                            int precision = kMatrixPrecision);
+
+  // Format: '[T: (x: 1, y: 2, z: 3), R:[[1, 0, 0], [0, 1, 0], [0, 0, 1]]]'.
+  // The translation uses 'precision' and the rotation kMatrixPrecision, like
+  // operator<< does, unless 'precision' is kRoundTrip.
+  static std::size_t Format(const Isometry& obj, char* buffer, std::size_t size,
+                            int precision = kStreamPrecision);
+
+  // Formats a single scalar.
+  static std::size_t Format(const double& value, char* buffer,
+                            std::size_t size, int precision = kRoundTrip);
+
+  // Writes one element per line to 'os'. Lines are accumulated in a fixed
+  // buffer that is flushed with large writes. Throws std::runtime_error when
+  // the stream fails.
+  template <typename T>
+  static void WriteLines(const std::vector<T>& elements, int precision,
+                         std::ostream* os) {
+    WriteLines(elements.data(), elements.size(), precision, os);
+  }
+
+  template <typename T>
+  static void WriteLines(const T* elements, std::size_t count, int precision,
+                         std::ostream* os) {
+    char buffer[kLineBufferSize];
+    std::size_t used = 0;
+    for (std::size_t i = 0; i < count; ++i) {
+      if (kLineBufferSize - used < kMaxIsometrySize + 1) {
+        flush(buffer, used, os);
+        used = 0;
+      }
+      used += Format(elements[i], buffer + used, kLineBufferSize - used,
+                     precision);
+      buffer[used++] = '\n';
+    }
+    flush(buffer, used, os);
+  }
+
+  // Returns true when the flags, width and precision of 'os' make operator<<
+  // produce what Format() produces, so that it can take the fast path.
+  static bool UsesDefaultFormat(const std::ostream& os);
+
+ private:
+  static const std::size_t kLineBufferSize = 1 << 14;
+
+  static void flush(const char* buffer, std::size_t size, std::ostream* os);
+};
+
+}  // namespace math
+}  // namespace ekumen
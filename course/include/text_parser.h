@@ -0,0 +1,118 @@
+#pragma once
+
+#include <cstddef>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "isometry.h"
+#include "matrix3.h"
+#include "vector3.h"
+
+namespace ekumen {
+namespace math {
+
+// Outcome of a parse. On success 'offset' is the number of characters
+// consumed; on failure it is the offset of the offending character and
+// 'message' describes the error. Messages are static strings, so reporting an
+// error does not allocate.
+struct ParseStatus {
+  bool ok() const { return message == nullptr; }
+
+  std::size_t offset;
+  const char* message;
+};
+
+// Parses the text formats written by operator<< and TextFormat:
+//   Vector3:  '(x: 1, y: 2, z: 3)'
+//   Matrix3:  '[[1, 0, 0], [0, 1, 0], [0, 0, 1]]'
+//   Isometry: '[T: (x: 1, y: 2, z: 3), R:[[1, 0, 0], [0, 1, 0], [0, 0, 1]]]'
+// The layout must match exactly, including separators and spaces. Scalars are
+// decimal or scientific numbers, 'inf' or 'nan', optionally signed.
+//
+// The Parse() functions read the prefix of [begin, end) that holds one
+// object, never read past 'end' and do not allocate. 'res' is only written
+// on success.
+class TextParser {
+ public:
+  static ParseStatus Parse(const char* begin, const char* end, double* res);
+  static ParseStatus Parse(const char* begin, const char* end, Vector3* res);
+  static ParseStatus Parse(const char* begin, const char* end, Matrix3* res);
+  static ParseStatus Parse(const char* begin, const char* end, Isometry* res);
+
+  // Parses a whole string holding a single object. Throws
+  // std::invalid_argument with the error offset when it does not.
+  template <typename T>
+  static T Parse(const std::string& text) {
+    T res;
+    const char* end = text.data() + text.size();
+    ParseStatus status = Parse(text.data(), end, &res);
+    if (status.ok() && status.offset != text.size()) {
+      status.message = "Unexpected trailing characters.";
+    }
+    if (!status.ok()) {
+      throwError(status, 0);
+    }
+    return res;
+  }
+
+  // Parses one object per line from a stream until its end and appends them
+  // to 'res'. Empty lines are skipped. Throws std::invalid_argument with the
+  // line number and offset of the first malformed line.
+  template <typename T>
+  static void ParseLines(std::istream* is, std::vector<T>* res);
+
+ private:
+  static void throwError(const ParseStatus& status, std::size_t line);
+};
+
+// Splits a stream in lines through a reusable buffer. Lines are returned as
+// views into the buffer, without their '\n' or "\r\n" terminator, and stay
+// valid until the next call to Next(). The buffer only grows for lines
+// longer than its current size.
+class LineReader {
+ public:
+  explicit LineReader(std::istream* is, std::size_t buffer_size = 1 << 16);
+
+  // Gets the next line. Returns false when the stream is exhausted. Throws
+  // std::runtime_error when reading fails.
+  bool Next(const char** begin, const char** end);
+
+  // Number of lines returned so far.
+  std::size_t lineNumber() const;
+
+ private:
+  // Moves the pending bytes to the front of the buffer, grows it if it is
+  // full, and reads more. Sets 'eof_' at the end of the stream.
+  void refill();
+
+  std::istream* is_;
+  std::vector<char> buffer_;
+  std::size_t begin_;
+  std::size_t end_;
+  std::size_t line_number_;
+  bool eof_;
+};
+
+template <typename T>
+void TextParser::ParseLines(std::istream* is, std::vector<T>* res) {
+  LineReader reader(is);
+  const char* begin;
+  const char* end;
+  while (reader.Next(&begin, &end)) {
+    if (begin == end) {
+      continue;
+    }
+    T value;
+    ParseStatus status = Parse(begin, end, &value);
+    if (status.ok() && begin + status.offset != end) {
+      status.message = "Unexpected trailing characters.";
+    }
+    if (!status.ok()) {
+      throwError(status, reader.lineNumber());
+    }
+    res->push_back(value);
+  }
+}
+
+}  // namespace math
+}  // namespace ekumen
@@ -0,0 +1,178 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "isometry.h"
+#include "transform_tree.h"
+#include "vector3.h"
+
+namespace ekumen {
+namespace math {
+
+// Histogram of latencies in power-of-two buckets of nanoseconds: bucket i
+// counts latencies in [2^i, 2^(i+1)) ns, the first one also those below and
+// the last one also those above.
+class LatencyHistogram {
+ public:
+  static const int kNumBuckets = 40;
+
+  LatencyHistogram();
+
+  void record(double seconds);
+
+  std::uint64_t count() const;
+  std::uint64_t bucketCount(int bucket) const;
+
+  // Upper bound of a bucket, in seconds.
+  static double BucketLimit(int bucket);
+
+  // Upper bound of the bucket that holds the 'q'-quantile, e.g. 0.99, in
+  // seconds. Returns 0 when empty.
+  double quantile(double q) const;
+
+ private:
+  // Fills the buckets from the wire.
+  friend class TransformClient;
+
+  std::uint64_t buckets_[kNumBuckets];
+};
+
+// Unix domain socket service that answers "transform these points from
+// frame A to frame B at time t" from a TransformTree, so that other
+// processes and languages reuse it without reimplementing the math.
+//
+// Messages are a 32-bit payload size followed by the payload, all in native
+// byte order since both ends share the host. Requests start with a 32-bit
+// type, replies with a 32-bit status; strings are a 32-bit size and bytes.
+//   kTransformPoints: target, source, time (double), count (uint64) and
+//                     3 * count doubles. Replies count and the doubles.
+//   kSetTransform:    parent, child, static flag (uint32), time (double)
+//                     and the 12 doubles of the pose as in binary_io.h.
+//   kLatency:         no payload. Replies the kNumBuckets uint64 counts.
+// Failed requests reply the status and an error message. Requests may be
+// sent before reading the replies to earlier ones, which come in order: the
+// server handles all the complete requests it holds and writes their
+// replies at once, so batching requests amortizes the system calls. While
+// replies are not sent it holds at most one more large request, so clients
+// must read replies as they send. A client may shut down its writes and
+// still receive the replies to every complete request it sent.
+enum class TransformRequest : std::uint32_t {
+  kTransformPoints = 1,
+  kSetTransform = 2,
+  kLatency = 3,
+};
+
+enum class TransformStatus : std::uint32_t {
+  kOk = 0,
+  // Unknown or disconnected frames, or times without transforms.
+  kOutOfRange = 1,
+  // Rejected updates of the tree.
+  kInvalidArgument = 2,
+  // Malformed requests.
+  kBadRequest = 3,
+};
+
+// Serves a TransformTree on a Unix domain socket from a background thread,
+// which multiplexes all the clients.
+class TransformServer {
+ public:
+  // Largest payload accepted. Clients that send larger ones are dropped.
+  static const std::uint32_t kMaxPayloadSize = 64 << 20;
+
+  // Listens on 'path', replacing any socket file there, and starts serving.
+  // Throws std::runtime_error when the socket cannot be created, and
+  // std::invalid_argument for paths too long for a socket address.
+  explicit TransformServer(const std::string& path,
+                           double cache_seconds = 10.);
+  TransformServer(const TransformServer&) = delete;
+  // Stops serving, closes the connections and removes the socket file.
+  ~TransformServer();
+
+  TransformServer& operator=(const TransformServer&) = delete;
+
+  // Update the tree like TransformTree does, from any thread.
+  void set(const std::string& parent, const std::string& child, double time,
+           const Isometry& pose);
+  void setStatic(const std::string& parent, const std::string& child,
+                 const Isometry& pose);
+
+  // Time from receiving each request to having its reply ready.
+  LatencyHistogram latency() const;
+
+ private:
+  struct Connection;
+
+  void serve();
+  // Handles the complete requests of 'connection', replacing its output
+  // with their replies. Returns false when one is larger than
+  // kMaxPayloadSize.
+  bool handleRequests(Connection* connection);
+  // Handles the request in 'payload' and appends its reply to 'reply'.
+  void handle(const char* payload, std::size_t size, std::vector<char>* reply);
+
+  std::string path_;
+  int listen_fd_;
+  // Written to stop the thread.
+  int wake_fds_[2];
+  mutable std::mutex mutex_;
+  TransformTree tree_;
+  LatencyHistogram latency_;
+  std::thread thread_;
+};
+
+// Client of a TransformServer. Calls block until the replies arrive, and
+// throw the exception TransformTree would have thrown for failed requests:
+// std::out_of_range or std::invalid_argument, and std::runtime_error for
+// connection errors and malformed requests.
+class TransformClient {
+ public:
+  struct Query {
+    std::string target;
+    std::string source;
+    double time;
+    std::vector<Vector3> points;
+  };
+
+  // Throws std::runtime_error when it cannot connect.
+  explicit TransformClient(const std::string& path);
+  TransformClient(const TransformClient&) = delete;
+  ~TransformClient();
+
+  TransformClient& operator=(const TransformClient&) = delete;
+
+  // Transforms points from 'source' coordinates to 'target' coordinates.
+  std::vector<Vector3> transformPoints(const std::string& target,
+                                       const std::string& source, double time,
+                                       const std::vector<Vector3>& points);
+
+  // Sends all the queries at once, reading the replies as they arrive, and
+  // returns their results in order. When some fail, the exception of the
+  // first one is thrown after reading all the replies.
+  std::vector<std::vector<Vector3>> transformPoints(
+      const std::vector<Query>& queries);
+
+  void set(const std::string& parent, const std::string& child, double time,
+           const Isometry& pose);
+  void setStatic(const std::string& parent, const std::string& child,
+                 const Isometry& pose);
+
+  // Latency histogram of the server.
+  LatencyHistogram latency();
+
+ private:
+  // Sends a request and returns the payload of its reply, or throws its
+  // error.
+  std::vector<char> call(const std::vector<char>& request);
+  void send(const std::vector<char>& data);
+  // Reads a reply, returns its status and stores its payload.
+  TransformStatus receive(std::vector<char>* payload);
+
+  int fd_;
+};
+
+}  // namespace math
+}  // namespace ekumen
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include "isometry.h"
+
+namespace ekumen {
+namespace math {
+
+// A table of named isometries in POSIX shared memory, so that processes on
+// the same host share the current frames without any IPC round trip.
+//
+// One process owns the table through a TransformTableWriter, and any number
+// of processes map it with a TransformTableReader. Every entry is guarded by
+// a sequence lock: the writer makes the sequence odd while it updates the
+// entry, and readers retry until they see the same even sequence before and
+// after copying it. Reads are thus lock-free for readers, never block the
+// writer, and return consistent transforms.
+//
+// Frames are only ever appended, so the index of a frame stays valid for
+// the life of the table. Resolving a name once with find() and reading by
+// index afterwards avoids comparing names on every read.
+
+class TransformTableWriter {
+ public:
+  // Longest frame name, in bytes.
+  static const std::size_t kMaxNameSize = 63;
+
+  // Creates the shared memory object 'name', e.g. "/robot_frames", with room
+  // for 'capacity' frames. A previous object with the same name is replaced.
+  // Throws std::runtime_error when it cannot be created, and
+  // std::invalid_argument for a zero capacity.
+  TransformTableWriter(const std::string& name, std::size_t capacity);
+  TransformTableWriter(const TransformTableWriter&) = delete;
+  ~TransformTableWriter();
+
+  TransformTableWriter& operator=(const TransformTableWriter&) = delete;
+
+  // Publishes the transform of a frame, adding the frame on first use.
+  // Throws std::length_error when the table is full or the name is empty or
+  // longer than kMaxNameSize.
+  void set(const std::string& frame, const Isometry& pose);
+
+  // Number of frames.
+  std::size_t size() const;
+  std::size_t capacity() const;
+
+  // Removes a shared memory object from the system namespace. Processes that
+  // mapped it keep their mappings. Missing objects are ignored.
+  static void Unlink(const std::string& name);
+
+ private:
+  void* data_;
+  std::size_t size_;
+  std::unordered_map<std::string, std::size_t> indices_;
+};
+
+class TransformTableReader {
+ public:
+  // Maps the table 'name' read-only. Throws std::runtime_error when it does
+  // not exist or is not a transform table.
+  explicit TransformTableReader(const std::string& name);
+  TransformTableReader(const TransformTableReader&) = delete;
+  ~TransformTableReader();
+
+  TransformTableReader& operator=(const TransformTableReader&) = delete;
+
+  // Number of frames published so far, never above the capacity the table
+  // had on opening, whatever the writer stores.
+  std::size_t size() const;
+
+  // Looks a frame up. Returns false when it is not published yet.
+  bool find(const std::string& frame, std::size_t* index) const;
+
+  // Name of the frame at 'index'. Throws std::out_of_range for invalid
+  // indices.
+  std::string frameName(std::size_t index) const;
+
+  // Copies the transform at 'index' into 'pose' and returns the number of
+  // times it was set, which grows with every update. Throws
+  // std::out_of_range for invalid indices.
+  std::uint64_t read(std::size_t index, Isometry* pose) const;
+
+  // Reads the transform of a frame. Throws std::out_of_range for unknown
+  // frames.
+  Isometry get(const std::string& frame) const;
+
+ private:
+  void assertValidIndex(std::size_t index) const;
+
+  const void* data_;
+  std::size_t size_;
+  // Entries the mapping holds, checked once on opening: the header is
+  // shared, so it is not trusted afterwards.
+  std::size_t capacity_;
+};
+
+}  // namespace math
+}  // namespace ekumen
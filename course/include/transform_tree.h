@@ -0,0 +1,69 @@
+#pragma once
+
+#include <deque>
+#include <string>
+#include <unordered_map>
+#include "isometry.h"
+
+namespace ekumen {
+namespace math {
+
+// Tree of named frames linked by time-stamped transforms, which answers
+// "where is frame A in frame B at time t".
+//
+// Every frame but the roots has one parent, and keeps the history of its
+// pose in the parent frame. Lookups between two samples interpolate the
+// translation linearly and the rotation along the geodesic of SO(3). Static
+// transforms have a single pose, valid at any time. Samples older than the
+// cache duration behind the newest one of their frame are dropped.
+class TransformTree {
+ public:
+  // Throws std::invalid_argument when 'cache_seconds' is not positive.
+  explicit TransformTree(double cache_seconds = 10.);
+
+  // Adds a sample of the pose of 'child' in 'parent' at 'time'. Samples may
+  // arrive out of order, and a sample at the time of another replaces it.
+  // Throws std::invalid_argument when 'child' already has another parent or
+  // a static transform, when the link would close a loop, or for empty
+  // names or a non-finite time.
+  void set(const std::string& parent, const std::string& child, double time,
+           const Isometry& pose);
+
+  // Sets the static pose of 'child' in 'parent'. Throws
+  // std::invalid_argument like set() does, or when 'child' has samples.
+  void setStatic(const std::string& parent, const std::string& child,
+                 const Isometry& pose);
+
+  // Returns whether the frame is known, as a parent or as a child.
+  bool hasFrame(const std::string& frame) const;
+
+  // Returns the transform from 'source' coordinates to 'target' coordinates
+  // at 'time'. Throws std::out_of_range for unknown or disconnected frames,
+  // and when 'time' is outside the samples of a link on the path.
+  Isometry lookup(const std::string& target, const std::string& source,
+                  double time) const;
+
+ private:
+  struct Sample {
+    double time;
+    Isometry pose;
+  };
+
+  struct Frame {
+    // Empty for roots.
+    std::string parent;
+    bool is_static;
+    // Sorted by time.
+    std::deque<Sample> samples;
+  };
+
+  Frame* link(const std::string& parent, const std::string& child);
+  Isometry poseAt(const std::string& name, const Frame& frame,
+                  double time) const;
+
+  double cache_seconds_;
+  std::unordered_map<std::string, Frame> frames_;
+};
+
+}  // namespace math
+}  // namespace ekumen
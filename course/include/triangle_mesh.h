@@ -0,0 +1,84 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "aabb.h"
+#include "bvh.h"
+#include "isometry.h"
+#include "parallel.h"
+#include "vector3.h"
+
+namespace ekumen {
+namespace math {
+
+// Nearest intersection of a ray with a mesh, in the world frame. The normal
+// is the unit normal of the triangle on the side the ray comes from.
+struct RayHit {
+  double distance;
+  std::size_t triangle;
+  Vector3 point;
+  Vector3 normal;
+};
+
+// Point of a mesh nearest to a query point, in the world frame.
+struct MeshPoint {
+  double distance;
+  std::size_t triangle;
+  Vector3 point;
+};
+
+// Triangle mesh in its local frame with a Bvh of its triangles. Queries
+// take the pose of the mesh in the world and move the query into the local
+// frame, so that a mesh placed many times, or moving rigidly, needs no
+// rebuild.
+class TriangleMesh {
+ public:
+  using Triangle = std::array<std::uint32_t, 3>;
+
+  // Throws std::invalid_argument when a triangle indexes a vertex out of
+  // range or a vertex has a NaN coordinate.
+  TriangleMesh(const std::vector<Vector3>& vertices,
+               const std::vector<Triangle>& triangles,
+               int num_threads = DefaultNumThreads());
+
+  std::size_t numVertices() const;
+  std::size_t numTriangles() const;
+  Vector3 vertex(std::size_t index) const;
+  const Triangle& triangle(std::size_t index) const;
+  const Bvh& bvh() const;
+
+  // Moves the vertices of a deforming mesh and refits its Bvh. Throws
+  // std::invalid_argument when the number of vertices differs or a vertex
+  // has a NaN coordinate.
+  void setVertices(const std::vector<Vector3>& vertices);
+
+  // Finds the nearest triangle that the ray from 'origin' along 'direction'
+  // hits within 'max_distance', for the mesh at 'pose'. Returns whether
+  // there is one. Throws std::invalid_argument for a zero direction.
+  bool raycast(const Isometry& pose, const Vector3& origin,
+               const Vector3& direction, double max_distance,
+               RayHit* hit) const;
+
+  // Triangles of the mesh at 'pose' that overlap 'box', sorted.
+  std::vector<std::size_t> overlapping(const Isometry& pose,
+                                       const Aabb& box) const;
+
+  // Finds the point of the mesh at 'pose' nearest to 'point' within
+  // 'max_distance'. Returns whether there is one, which there is not for a
+  // negative or NaN 'max_distance'.
+  bool closestPoint(const Isometry& pose, const Vector3& point,
+                    double max_distance, MeshPoint* res) const;
+
+ private:
+  std::vector<Aabb> triangleBoxes() const;
+
+  // Coordinates of the vertices, three per vertex.
+  std::vector<double> vertices_;
+  std::vector<Triangle> triangles_;
+  Bvh bvh_;
+};
+
+}  // namespace math
+}  // namespace ekumen
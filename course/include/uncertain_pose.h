@@ -0,0 +1,56 @@
+#pragma once
+
+#include <iostream>
+#include <vector>
+#include "isometry.h"
+#include "matrix.h"
+
+namespace ekumen {
+namespace math {
+
+// An isometry paired with the covariance of its error. The error is a tangent
+// vector xi = (rho, omega) in the local frame of the pose, so the true pose is
+// pose * SE3::Exp(rho, omega) and 'covariance' is the 6x6 covariance of xi.
+//
+// Covariances are propagated to first order. Adjoint congruences are computed
+// block by block on the rotation and the translation, without building the
+// 6x6 adjoint matrices.
+class UncertainPose {
+ public:
+  explicit UncertainPose(const Isometry& pose = Isometry(),
+                         const Matrix6& covariance = Matrix6());
+
+  // Gets the mean pose.
+  const Isometry& pose() const;
+
+  // Gets the covariance over (rho, omega).
+  const Matrix6& covariance() const;
+
+  // Composes two uncertain poses whose errors are independent:
+  // cov = Ad(B^-1) * cov_A * Ad(B^-1)^T + cov_B.
+  UncertainPose operator*(const UncertainPose& obj) const;
+
+  // Serializes the uncertain pose to a stream with the format: "[P: <pose>,
+  // C: <covariance>]".
+  friend std::ostream& operator<<(std::ostream& os, const UncertainPose& obj);
+
+  // Composes two uncertain poses whose errors are independent.
+  UncertainPose compose(const UncertainPose& obj) const;
+
+  // Gets the inverse pose: cov = Ad(A) * cov_A * Ad(A)^T.
+  UncertainPose inverse() const;
+
+  // Chains the relative 'steps' of a trajectory starting at 'origin':
+  // (*res)[i] = origin * steps[0] * ... * steps[i]. 'res' is resized to the
+  // number of steps, and its storage is reused across calls.
+  static void ComposeTrajectory(const UncertainPose& origin,
+                                const std::vector<UncertainPose>& steps,
+                                std::vector<UncertainPose>* res);
+
+ private:
+  Isometry pose_;
+  Matrix6 covariance_;
+};
+
+}  // namespace math
+}  // namespace ekumen
@@ -90,7 +90,7 @@ class Vector3 {
   // Checks that the index to access the vector components is in range.
   void assertValidAccessIndex(int index) const;
 
-  double* elem_;
+  double elem_[3];
 };
 
 }  // namespace math
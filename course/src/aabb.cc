@@ -0,0 +1,102 @@
+#include "aabb.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <limits>
+#include "isometry.h"
+#include "matrix3.h"
+#include "vector3.h"
+
+namespace ekumen {
+namespace math {
+
+Aabb::Aabb()
+    : min(Vector3(std::numeric_limits<double>::infinity(),
+                  std::numeric_limits<double>::infinity(),
+                  std::numeric_limits<double>::infinity())),
+      max(-1. * min) {}
+
+Aabb::Aabb(const Vector3& min, const Vector3& max) : min(min), max(max) {}
+
+bool Aabb::empty() const {
+  return !(min.x() <= max.x() && min.y() <= max.y() && min.z() <= max.z());
+}
+
+void Aabb::extend(const Vector3& point) {
+  for (int i = 0; i < 3; ++i) {
+    min[i] = std::min(min[i], point[i]);
+    max[i] = std::max(max[i], point[i]);
+  }
+}
+
+void Aabb::extend(const Aabb& box) {
+  for (int i = 0; i < 3; ++i) {
+    min[i] = std::min(min[i], box.min[i]);
+    max[i] = std::max(max[i], box.max[i]);
+  }
+}
+
+Vector3 Aabb::center() const { return 0.5 * (min + max); }
+
+Vector3 Aabb::halfExtents() const { return 0.5 * (max - min); }
+
+double Aabb::surfaceArea() const {
+  if (empty()) {
+    return 0.;
+  }
+  const Vector3 size = max - min;
+  return 2. * (size.x() * size.y() + size.y() * size.z() +
+               size.z() * size.x());
+}
+
+bool Aabb::overlaps(const Aabb& obj) const {
+  for (int i = 0; i < 3; ++i) {
+    if (min[i] > obj.max[i] || obj.min[i] > max[i]) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool Aabb::contains(const Vector3& point) const {
+  for (int i = 0; i < 3; ++i) {
+    if (!(point[i] >= min[i] && point[i] <= max[i])) {
+      return false;
+    }
+  }
+  return true;
+}
+
+double Aabb::squaredDistance(const Vector3& point) const {
+  double res = 0.;
+  for (int i = 0; i < 3; ++i) {
+    const double below = min[i] - point[i];
+    const double above = point[i] - max[i];
+    const double gap = std::max(0., std::max(below, above));
+    res += gap * gap;
+  }
+  return res;
+}
+
+Aabb Aabb::transformed(const Isometry& pose) const {
+  if (empty()) {
+    return Aabb();
+  }
+  const Matrix3& r = pose.rotation();
+  const Vector3 center = pose * this->center();
+  const Vector3 half = halfExtents();
+  Vector3 extents;
+  for (int i = 0; i < 3; ++i) {
+    extents[i] = std::abs(r[i][0]) * half.x() + std::abs(r[i][1]) * half.y() +
+                 std::abs(r[i][2]) * half.z();
+  }
+  return Aabb(center - extents, center + extents);
+}
+
+std::ostream& operator<<(std::ostream& os, const Aabb& obj) {
+  return os << "[min: " << obj.min << ", max: " << obj.max << "]";
+}
+
+}  // namespace math
+}  // namespace ekumen
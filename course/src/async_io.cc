@@ -0,0 +1,397 @@
+#include "async_io.h"
+
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <condition_variable>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+// io_uring is used through its system calls, as liburing is not a
+// dependency. Builds without the kernel header only have the thread backend.
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#if defined(__NR_io_uring_setup) && defined(__NR_io_uring_enter)
+#define EKUMEN_MATH_HAVE_IO_URING
+#endif
+#endif
+#endif
+
+namespace ekumen {
+namespace math {
+
+class AsyncIo::Backend {
+ public:
+  virtual ~Backend() = default;
+  virtual void submit(bool write, int fd, void* buffer, std::size_t size,
+                      std::uint64_t offset, std::uint64_t tag) = 0;
+  virtual AsyncIoCompletion wait() = 0;
+};
+
+namespace {
+// Threads of the pread()/pwrite() backend.
+constexpr unsigned int kMaxIoThreads = 4;
+
+std::runtime_error systemError(const std::string& message) {
+  return std::runtime_error(message + ": " + std::strerror(errno));
+}
+
+class ThreadBackend : public AsyncIo::Backend {
+ public:
+  explicit ThreadBackend(unsigned int queue_depth) : stop_(false) {
+    const unsigned int num_threads = std::min(queue_depth, kMaxIoThreads);
+    for (unsigned int i = 0; i < num_threads; ++i) {
+      threads_.emplace_back(&ThreadBackend::run, this);
+    }
+  }
+
+  ~ThreadBackend() override {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stop_ = true;
+    }
+    request_ready_.notify_all();
+    for (std::thread& thread : threads_) {
+      thread.join();
+    }
+  }
+
+  void submit(bool write, int fd, void* buffer, std::size_t size,
+              std::uint64_t offset, std::uint64_t tag) override {
+    const Request request = {write, fd, buffer, size, offset, tag};
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      requests_.push_back(request);
+    }
+    request_ready_.notify_one();
+  }
+
+  AsyncIoCompletion wait() override {
+    std::unique_lock<std::mutex> lock(mutex_);
+    completion_ready_.wait(lock, [this]() { return !completions_.empty(); });
+    const AsyncIoCompletion res = completions_.front();
+    completions_.pop_front();
+    return res;
+  }
+
+ private:
+  struct Request {
+    bool write;
+    int fd;
+    void* buffer;
+    std::size_t size;
+    std::uint64_t offset;
+    std::uint64_t tag;
+  };
+
+  // Serves requests until stopped, finishing the queued ones first.
+  void run() {
+    for (;;) {
+      Request request;
+      {
+        std::unique_lock<std::mutex> lock(mutex_);
+        request_ready_.wait(
+            lock, [this]() { return stop_ || !requests_.empty(); });
+        if (requests_.empty()) {
+          return;
+        }
+        request = requests_.front();
+        requests_.pop_front();
+      }
+      ssize_t result;
+      do {
+        result = request.write
+                     ? ::pwrite(request.fd, request.buffer, request.size,
+                                static_cast<off_t>(request.offset))
+                     : ::pread(request.fd, request.buffer, request.size,
+                               static_cast<off_t>(request.offset));
+      } while (result < 0 && errno == EINTR);
+      const AsyncIoCompletion completion = {
+          request.tag, result < 0 ? -static_cast<std::int64_t>(errno)
+                                  : static_cast<std::int64_t>(result)};
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        completions_.push_back(completion);
+      }
+      completion_ready_.notify_one();
+    }
+  }
+
+  std::mutex mutex_;
+  std::condition_variable request_ready_;
+  std::condition_variable completion_ready_;
+  std::deque<Request> requests_;
+  std::deque<AsyncIoCompletion> completions_;
+  bool stop_;
+  std::vector<std::thread> threads_;
+};
+
+#ifdef EKUMEN_MATH_HAVE_IO_URING
+// Longest transfer of a single request. Longer ones complete short.
+constexpr std::size_t kMaxIoUringTransfer = 1 << 30;
+
+int ioUringSetup(unsigned int entries, io_uring_params* params) {
+  return static_cast<int>(::syscall(__NR_io_uring_setup, entries, params));
+}
+
+int ioUringEnter(int fd, unsigned int to_submit, unsigned int min_complete,
+                 unsigned int flags) {
+  return static_cast<int>(::syscall(__NR_io_uring_enter, fd, to_submit,
+                                    min_complete, flags, nullptr, 0));
+}
+
+// Maps a region of the ring, returns nullptr on failure.
+void* mapRing(int fd, std::size_t size, off_t offset) {
+  void* res = ::mmap(nullptr, size, PROT_READ | PROT_WRITE,
+                     MAP_SHARED | MAP_POPULATE, fd, offset);
+  return res == MAP_FAILED ? nullptr : res;
+}
+
+// The submission and completion rings are shared with the kernel: the
+// kernel advances the submission head and the completion tail, this process
+// the other two, with release stores that publish the entries before them.
+class IoUringBackend : public AsyncIo::Backend {
+ public:
+  explicit IoUringBackend(unsigned int entries)
+      : sq_ring_(nullptr), cq_ring_(nullptr), sqes_(nullptr) {
+    io_uring_params params;
+    std::memset(&params, 0, sizeof(params));
+    fd_ = ioUringSetup(entries, &params);
+    if (fd_ < 0) {
+      throw systemError("Cannot set up io_uring");
+    }
+    sq_ring_size_ =
+        params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    cq_ring_size_ =
+        params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    sqes_size_ = params.sq_entries * sizeof(io_uring_sqe);
+    // Recent kernels map both rings at once.
+    const bool single_mmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if (single_mmap) {
+      sq_ring_size_ = cq_ring_size_ = std::max(sq_ring_size_, cq_ring_size_);
+    }
+    sq_ring_ = mapRing(fd_, sq_ring_size_, IORING_OFF_SQ_RING);
+    cq_ring_ = single_mmap ? sq_ring_
+                           : mapRing(fd_, cq_ring_size_, IORING_OFF_CQ_RING);
+    sqes_ = static_cast<io_uring_sqe*>(
+        mapRing(fd_, sqes_size_, IORING_OFF_SQES));
+    if (sq_ring_ == nullptr || cq_ring_ == nullptr || sqes_ == nullptr) {
+      const std::runtime_error error = systemError("Cannot map io_uring");
+      release();
+      throw error;
+    }
+
+    unsigned char* sq = static_cast<unsigned char*>(sq_ring_);
+    sq_head_ = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+    sq_tail_ = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+    sq_mask_ = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+    sq_array_ = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+    unsigned char* cq = static_cast<unsigned char*>(cq_ring_);
+    cq_head_ = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+    cq_tail_ = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+    cq_mask_ = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+    cqes_ = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+  }
+
+  ~IoUringBackend() override { release(); }
+
+  void submit(bool write, int fd, void* buffer, std::size_t size,
+              std::uint64_t offset, std::uint64_t tag) override {
+    // AsyncIo bounds the pending requests by the ring size, so there is
+    // always a free entry.
+    const unsigned tail = *sq_tail_;
+    const unsigned index = tail & sq_mask_;
+    io_uring_sqe* sqe = &sqes_[index];
+    std::memset(sqe, 0, sizeof(*sqe));
+    sqe->opcode = write ? IORING_OP_WRITE : IORING_OP_READ;
+    sqe->fd = fd;
+    sqe->addr = reinterpret_cast<std::uint64_t>(buffer);
+    sqe->len = static_cast<unsigned>(std::min(size, kMaxIoUringTransfer));
+    sqe->off = offset;
+    sqe->user_data = tag;
+    sq_array_[index] = index;
+    __atomic_store_n(sq_tail_, tail + 1, __ATOMIC_RELEASE);
+    int result;
+    do {
+      result = ioUringEnter(fd_, 1, 0, 0);
+    } while (result < 0 && errno == EINTR);
+    // Without a polling thread the kernel only takes entries during the
+    // call, so one it did not take is withdrawn: otherwise the next submit
+    // would send it again, and its completion would not be counted.
+    if (__atomic_load_n(sq_head_, __ATOMIC_ACQUIRE) == tail) {
+      if (result >= 0) {
+        errno = EAGAIN;
+      }
+      __atomic_store_n(sq_tail_, tail, __ATOMIC_RELEASE);
+      throw systemError("Cannot submit to io_uring");
+    }
+  }
+
+  AsyncIoCompletion wait() override {
+    for (;;) {
+      const unsigned head = *cq_head_;
+      if (head != __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE)) {
+        const io_uring_cqe& cqe = cqes_[head & cq_mask_];
+        const AsyncIoCompletion res = {cqe.user_data, cqe.res};
+        __atomic_store_n(cq_head_, head + 1, __ATOMIC_RELEASE);
+        return res;
+      }
+      if (ioUringEnter(fd_, 0, 1, IORING_ENTER_GETEVENTS) < 0 &&
+          errno != EINTR) {
+        throw systemError("Cannot wait for io_uring");
+      }
+    }
+  }
+
+ private:
+  void release() {
+    if (sqes_ != nullptr) {
+      ::munmap(sqes_, sqes_size_);
+    }
+    if (cq_ring_ != nullptr && cq_ring_ != sq_ring_) {
+      ::munmap(cq_ring_, cq_ring_size_);
+    }
+    if (sq_ring_ != nullptr) {
+      ::munmap(sq_ring_, sq_ring_size_);
+    }
+    ::close(fd_);
+  }
+
+  int fd_;
+  void* sq_ring_;
+  void* cq_ring_;
+  io_uring_sqe* sqes_;
+  std::size_t sq_ring_size_;
+  std::size_t cq_ring_size_;
+  std::size_t sqes_size_;
+  unsigned* sq_head_;
+  unsigned* sq_tail_;
+  unsigned sq_mask_;
+  unsigned* sq_array_;
+  unsigned* cq_head_;
+  unsigned* cq_tail_;
+  unsigned cq_mask_;
+  io_uring_cqe* cqes_;
+};
+#endif
+}  // namespace
+
+const std::size_t AlignedBuffer::kAlignment;
+
+AlignedBuffer::AlignedBuffer() : data_(nullptr), size_(0) {}
+
+AlignedBuffer::AlignedBuffer(std::size_t size) : data_(nullptr), size_(size) {
+  void* data = nullptr;
+  if (size > 0 && ::posix_memalign(&data, kAlignment, size) != 0) {
+    throw std::bad_alloc();
+  }
+  data_ = static_cast<unsigned char*>(data);
+}
+
+AlignedBuffer::AlignedBuffer(AlignedBuffer&& obj)
+    : data_(obj.data_), size_(obj.size_) {
+  obj.data_ = nullptr;
+  obj.size_ = 0;
+}
+
+AlignedBuffer::~AlignedBuffer() { std::free(data_); }
+
+AlignedBuffer& AlignedBuffer::operator=(AlignedBuffer&& obj) {
+  if (this != &obj) {
+    std::free(data_);
+    data_ = obj.data_;
+    size_ = obj.size_;
+    obj.data_ = nullptr;
+    obj.size_ = 0;
+  }
+  return *this;
+}
+
+unsigned char* AlignedBuffer::data() { return data_; }
+
+const unsigned char* AlignedBuffer::data() const { return data_; }
+
+std::size_t AlignedBuffer::size() const { return size_; }
+
+AsyncIo::AsyncIo(unsigned int queue_depth, AsyncIoBackend backend)
+    : type_(backend), queue_depth_(queue_depth), pending_(0) {
+  if (queue_depth == 0) {
+    throw std::invalid_argument("The queue depth must be positive.");
+  }
+  if (type_ == AsyncIoBackend::kAuto) {
+    type_ = IoUringAvailable() ? AsyncIoBackend::kIoUring
+                               : AsyncIoBackend::kThreads;
+  }
+  if (type_ == AsyncIoBackend::kIoUring) {
+#ifdef EKUMEN_MATH_HAVE_IO_URING
+    backend_.reset(new IoUringBackend(queue_depth));
+#else
+    throw std::runtime_error("io_uring is not supported by this build.");
+#endif
+  } else {
+    backend_.reset(new ThreadBackend(queue_depth));
+  }
+}
+
+AsyncIo::~AsyncIo() = default;
+
+AsyncIoBackend AsyncIo::backend() const { return type_; }
+
+unsigned int AsyncIo::pending() const { return pending_; }
+
+void AsyncIo::SubmitRead(int fd, void* buffer, std::size_t size,
+                         std::uint64_t offset, std::uint64_t tag) {
+  if (pending_ == queue_depth_) {
+    throw std::length_error("Too many pending asynchronous requests.");
+  }
+  backend_->submit(false, fd, buffer, size, offset, tag);
+  ++pending_;
+}
+
+void AsyncIo::SubmitWrite(int fd, const void* buffer, std::size_t size,
+                          std::uint64_t offset, std::uint64_t tag) {
+  if (pending_ == queue_depth_) {
+    throw std::length_error("Too many pending asynchronous requests.");
+  }
+  backend_->submit(true, fd, const_cast<void*>(buffer), size, offset, tag);
+  ++pending_;
+}
+
+AsyncIoCompletion AsyncIo::Wait() {
+  if (pending_ == 0) {
+    throw std::logic_error("No asynchronous request is pending.");
+  }
+  const AsyncIoCompletion res = backend_->wait();
+  --pending_;
+  return res;
+}
+
+bool AsyncIo::IoUringAvailable() {
+#ifdef EKUMEN_MATH_HAVE_IO_URING
+  io_uring_params params;
+  std::memset(&params, 0, sizeof(params));
+  const int fd = ioUringSetup(1, &params);
+  if (fd < 0) {
+    return false;
+  }
+  ::close(fd);
+  // The READ and WRITE operations came with this feature, in Linux 5.6.
+  return (params.features & IORING_FEAT_RW_CUR_POS) != 0;
+#else
+  return false;
+#endif
+}
+
+}  // namespace math
+}  // namespace ekumen
@@ -0,0 +1,303 @@
+#include "async_transform.h"
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "async_io.h"
+#include "binary_io.h"
+#include "isometry.h"
+#include "matrix3.h"
+#include "parallel.h"
+#include "vector3.h"
+
+namespace ekumen {
+namespace math {
+namespace {
+using Clock = std::chrono::steady_clock;
+
+// Elements below which a chunk is transformed by a single thread.
+constexpr std::size_t kMinTransformChunkSize = 1 << 14;
+
+double secondsSince(const Clock::time_point& start) {
+  return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+bool isLittleEndian() {
+  const std::uint16_t value = 1;
+  unsigned char first;
+  std::memcpy(&first, &value, 1);
+  return first == 1;
+}
+
+// Closes a file descriptor when going out of scope.
+class FileDescriptor {
+ public:
+  FileDescriptor(int fd, const std::string& path) : fd_(fd) {
+    if (fd_ < 0) {
+      throw std::runtime_error("Cannot open '" + path +
+                               "': " + std::strerror(errno));
+    }
+  }
+  FileDescriptor(const FileDescriptor&) = delete;
+  ~FileDescriptor() {
+    if (fd_ >= 0) {
+      ::close(fd_);
+    }
+  }
+
+  FileDescriptor& operator=(const FileDescriptor&) = delete;
+
+  int get() const { return fd_; }
+
+  // Closes the descriptor, returns false on failure.
+  bool close() {
+    const int fd = fd_;
+    fd_ = -1;
+    return ::close(fd) == 0;
+  }
+
+ private:
+  int fd_;
+};
+
+// Transforms 'count' points stored as x, y, z doubles.
+void transformPoints(const Isometry& pose, int num_threads, double* data,
+                     std::size_t count) {
+  const Matrix3& r = pose.rotation();
+  const Vector3& t = pose.translation();
+  const double r00 = r[0][0], r01 = r[0][1], r02 = r[0][2];
+  const double r10 = r[1][0], r11 = r[1][1], r12 = r[1][2];
+  const double r20 = r[2][0], r21 = r[2][1], r22 = r[2][2];
+  const double tx = t.x(), ty = t.y(), tz = t.z();
+  ParallelFor(count, num_threads,
+              [&](int, std::size_t begin, std::size_t end) {
+                for (double* p = data + 3 * begin; p != data + 3 * end;
+                     p += 3) {
+                  const double px = p[0];
+                  const double py = p[1];
+                  const double pz = p[2];
+                  p[0] = r00 * px + r01 * py + r02 * pz + tx;
+                  p[1] = r10 * px + r11 * py + r12 * pz + ty;
+                  p[2] = r20 * px + r21 * py + r22 * pz + tz;
+                }
+              },
+              kMinTransformChunkSize);
+}
+
+// Composes 'count' poses stored in the BinaryTraits<Isometry> layout.
+void transformPoses(const Isometry& pose, int num_threads, double* data,
+                    std::size_t count) {
+  const int scalars = BinaryTraits<Isometry>::kScalars;
+  ParallelFor(count, num_threads,
+              [&](int, std::size_t begin, std::size_t end) {
+                for (std::size_t i = begin; i < end; ++i) {
+                  double* element = data + scalars * i;
+                  BinaryTraits<Isometry>::Write(
+                      pose * BinaryTraits<Isometry>::Read(element), element);
+                }
+              },
+              kMinTransformChunkSize);
+}
+
+// A buffer and the chunk it holds.
+struct Slot {
+  AlignedBuffer buffer;
+  std::uint64_t chunk;
+  // Bytes of the chunk, and bytes read or written so far.
+  std::size_t size;
+  std::size_t done;
+  bool writing;
+  Clock::time_point submitted;
+};
+}  // namespace
+
+AsyncTransform::Options::Options()
+    : buffer_size(4 << 20),
+      num_buffers(4),
+      num_threads(DefaultNumThreads()),
+      backend(AsyncIoBackend::kAuto) {}
+
+BatchTransformStats AsyncTransform::Run(const Isometry& pose,
+                                        const std::string& input,
+                                        const std::string& output,
+                                        const Options& options) {
+  if (options.buffer_size == 0 || options.num_buffers == 0 ||
+      options.num_threads < 1) {
+    throw std::invalid_argument(
+        "Buffer size, buffers and threads must be positive.");
+  }
+  if (!isLittleEndian()) {
+    throw std::runtime_error(
+        "Binary files can only be transformed on little-endian hosts.");
+  }
+  const Clock::time_point start = Clock::now();
+
+  BinaryHeader header;
+  {
+    std::ifstream is(input, std::ios::binary);
+    if (!is) {
+      throw std::runtime_error("Cannot open '" + input + "'.");
+    }
+    header = BinaryReader(&is).header();
+  }
+  if (header.type != BinaryType::kVector3 &&
+      header.type != BinaryType::kIsometry) {
+    throw std::runtime_error(
+        "Binary input must hold points or poses to transform.");
+  }
+  const bool points = header.type == BinaryType::kVector3;
+  const std::size_t element_size =
+      sizeof(double) * (points ? BinaryTraits<Vector3>::kScalars
+                               : BinaryTraits<Isometry>::kScalars);
+
+  FileDescriptor in(::open(input.c_str(), O_RDONLY | O_CLOEXEC), input);
+  struct stat status;
+  if (::fstat(in.get(), &status) != 0) {
+    throw std::runtime_error("Cannot stat '" + input + "'.");
+  }
+  const std::uint64_t payload_size =
+      static_cast<std::uint64_t>(status.st_size) - BinaryHeader::kSize;
+  if (header.count > payload_size / element_size ||
+      header.count * element_size != payload_size) {
+    throw std::runtime_error("Binary file size does not match its header.");
+  }
+  ::posix_fadvise(in.get(), 0, 0, POSIX_FADV_SEQUENTIAL);
+
+  FileDescriptor out(
+      ::open(output.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644),
+      output);
+  std::ostringstream header_bytes;
+  if (points) {
+    BinaryWriter::WriteHeader<Vector3>(header.count, &header_bytes);
+  } else {
+    BinaryWriter::WriteHeader<Isometry>(header.count, &header_bytes);
+  }
+  const std::string bytes = header_bytes.str();
+  if (::pwrite(out.get(), bytes.data(), bytes.size(), 0) !=
+      static_cast<ssize_t>(bytes.size())) {
+    throw std::runtime_error("Cannot write '" + output + "'.");
+  }
+
+  BatchTransformStats stats = {};
+  const std::uint64_t chunk_elements =
+      std::max<std::size_t>(1, options.buffer_size / element_size);
+  const std::uint64_t num_chunks =
+      (header.count + chunk_elements - 1) / chunk_elements;
+  std::vector<Slot> slots(static_cast<std::size_t>(
+      std::min<std::uint64_t>(options.num_buffers, num_chunks)));
+  for (Slot& slot : slots) {
+    slot.buffer = AlignedBuffer(chunk_elements * element_size);
+  }
+
+  if (!slots.empty()) {
+    // Every slot has at most one request pending.
+    AsyncIo io(static_cast<unsigned int>(slots.size()), options.backend);
+    std::string error;
+    // Submits the rest of the transfer of a slot. Failures are recorded, as
+    // pending requests must complete before their buffers are released.
+    auto submit = [&](std::size_t index) {
+      Slot& slot = slots[index];
+      const std::uint64_t offset =
+          BinaryHeader::kSize + slot.chunk * chunk_elements * element_size +
+          slot.done;
+      try {
+        if (slot.writing) {
+          io.SubmitWrite(out.get(), slot.buffer.data() + slot.done,
+                         slot.size - slot.done, offset, index);
+        } else {
+          io.SubmitRead(in.get(), slot.buffer.data() + slot.done,
+                        slot.size - slot.done, offset, index);
+        }
+      } catch (const std::exception& e) {
+        error = e.what();
+      }
+    };
+    std::uint64_t next_chunk = 0;
+    auto startRead = [&](std::size_t index) {
+      Slot& slot = slots[index];
+      slot.chunk = next_chunk++;
+      slot.size = static_cast<std::size_t>(
+          std::min(chunk_elements, header.count - slot.chunk * chunk_elements) *
+          element_size);
+      slot.done = 0;
+      slot.writing = false;
+      slot.submitted = Clock::now();
+      submit(index);
+    };
+    for (std::size_t i = 0; i < slots.size(); ++i) {
+      startRead(i);
+    }
+
+    while (io.pending() > 0) {
+      const Clock::time_point wait_start = Clock::now();
+      const AsyncIoCompletion completion = io.Wait();
+      stats.stall_seconds += secondsSince(wait_start);
+      if (!error.empty()) {
+        // Drains the pending requests.
+        continue;
+      }
+      const std::size_t index = static_cast<std::size_t>(completion.tag);
+      Slot& slot = slots[index];
+      if (completion.result <= 0) {
+        const std::string& path = slot.writing ? output : input;
+        error = completion.result == 0
+                    ? "Unexpected end of '" + path + "'."
+                    : "Cannot access '" + path +
+                          "': " + std::strerror(-completion.result);
+        continue;
+      }
+      slot.done += static_cast<std::size_t>(completion.result);
+      if (slot.done < slot.size) {
+        submit(index);
+        continue;
+      }
+
+      if (!slot.writing) {
+        stats.read_seconds += secondsSince(slot.submitted);
+        const Clock::time_point transform_start = Clock::now();
+        double* data = reinterpret_cast<double*>(slot.buffer.data());
+        const std::size_t count = slot.size / element_size;
+        if (points) {
+          transformPoints(pose, options.num_threads, data, count);
+        } else {
+          transformPoses(pose, options.num_threads, data, count);
+        }
+        stats.transform_seconds += secondsSince(transform_start);
+        slot.done = 0;
+        slot.writing = true;
+        slot.submitted = Clock::now();
+        submit(index);
+      } else {
+        stats.write_seconds += secondsSince(slot.submitted);
+        stats.elements += slot.size / element_size;
+        ++stats.batches;
+        if (next_chunk < num_chunks) {
+          startRead(index);
+        }
+      }
+    }
+    if (!error.empty()) {
+      throw std::runtime_error(error);
+    }
+  }
+
+  if (!out.close()) {
+    throw std::runtime_error("Cannot write '" + output + "'.");
+  }
+  stats.total_seconds = secondsSince(start);
+  return stats;
+}
+
+}  // namespace math
+}  // namespace ekumen
@@ -0,0 +1,136 @@
+#include "autodiff.h"
+#include "isometry.h"
+#include "vector3.h"
+
+namespace ekumen {
+namespace math {
+namespace {
+// Copies an isometry into row-major arrays.
+void toArrays(const Isometry& pose, double rotation[9], double translation[3]) {
+  for (auto i = 0; i < 3; ++i) {
+    for (auto j = 0; j < 3; ++j) {
+      rotation[3 * i + j] = pose.rotation()[i][j];
+    }
+    translation[i] = pose.translation()[i];
+  }
+}
+
+// Applies the local perturbation (dt, dw) to a pose given as arrays.
+template <typename T>
+void perturb(const double rotation[9], const double translation[3],
+             const T delta[6], T rotation_res[9], T translation_res[3]) {
+  T exp_dw[9];
+  RotationVectorToMatrix(delta + 3, exp_dw);
+  T rotation_t[9];
+  T zero[3] = {T(0.), T(0.), T(0.)};
+  T translation_t[3];
+  for (auto i = 0; i < 9; ++i) {
+    rotation_t[i] = T(rotation[i]);
+  }
+  for (auto i = 0; i < 3; ++i) {
+    translation_t[i] = T(translation[i]);
+  }
+  ComposeTransforms(rotation_t, translation_t, exp_dw, zero, rotation_res,
+                    translation_res);
+  T rotated_dt[3];
+  TransformPoint(rotation_t, zero, delta, rotated_dt);
+  for (auto i = 0; i < 3; ++i) {
+    translation_res[i] += rotated_dt[i];
+  }
+}
+
+// Transforms a fixed point by a perturbed pose.
+struct TransformFunctor {
+  template <typename T>
+  void operator()(const T* delta, T* res) const {
+    T rotation_res[9];
+    T translation_res[3];
+    perturb(rotation, translation, delta, rotation_res, translation_res);
+    const T point_t[3] = {T(point[0]), T(point[1]), T(point[2])};
+    TransformPoint(rotation_res, translation_res, point_t, res);
+  }
+
+  double rotation[9];
+  double translation[3];
+  double point[3];
+};
+
+// Composes two perturbed poses and expresses the result as a local
+// perturbation of the unperturbed composition.
+struct ComposeFunctor {
+  template <typename T>
+  void operator()(const T* delta, T* res) const {
+    T rotation_a_res[9];
+    T translation_a_res[3];
+    T rotation_b_res[9];
+    T translation_b_res[3];
+    perturb(rotation_a, translation_a, delta, rotation_a_res,
+            translation_a_res);
+    perturb(rotation_b, translation_b, delta + 6, rotation_b_res,
+            translation_b_res);
+    T rotation_c_res[9];
+    T translation_c_res[3];
+    ComposeTransforms(rotation_a_res, translation_a_res, rotation_b_res,
+                      translation_b_res, rotation_c_res, translation_c_res);
+
+    // Local difference: (Rc^T * (t' - tc), Log(Rc^T * R')).
+    T rotation_diff[9];
+    for (auto i = 0; i < 3; ++i) {
+      res[i] = T(0.);
+      for (auto k = 0; k < 3; ++k) {
+        res[i] += rotation_c[3 * k + i] *
+                  (translation_c_res[k] - translation_c[k]);
+      }
+      for (auto j = 0; j < 3; ++j) {
+        rotation_diff[3 * i + j] = T(0.);
+        for (auto k = 0; k < 3; ++k) {
+          rotation_diff[3 * i + j] +=
+              rotation_c[3 * k + i] * rotation_c_res[3 * k + j];
+        }
+      }
+    }
+    MatrixToRotationVector(rotation_diff, res + 3);
+  }
+
+  double rotation_a[9];
+  double translation_a[3];
+  double rotation_b[9];
+  double translation_b[3];
+  double rotation_c[9];
+  double translation_c[3];
+};
+}  // namespace
+
+Matrix36 AutoDiff::TransformJacobian(const Isometry& pose,
+                                     const Vector3& point) {
+  TransformFunctor functor;
+  toArrays(pose, functor.rotation, functor.translation);
+  for (auto i = 0; i < 3; ++i) {
+    functor.point[i] = point[i];
+  }
+  const double delta[6] = {0., 0., 0., 0., 0., 0.};
+  double value[3];
+  Matrix36 jacobian;
+  Evaluate<6, 3>(functor, delta, value, jacobian.data());
+  return jacobian;
+}
+
+void AutoDiff::ComposeJacobians(const Isometry& a, const Isometry& b,
+                                Matrix6* jacobian_a, Matrix6* jacobian_b) {
+  ComposeFunctor functor;
+  toArrays(a, functor.rotation_a, functor.translation_a);
+  toArrays(b, functor.rotation_b, functor.translation_b);
+  toArrays(a * b, functor.rotation_c, functor.translation_c);
+  double delta[12];
+  for (auto i = 0; i < 12; ++i) {
+    delta[i] = 0.;
+  }
+  double value[6];
+  Matrix<6, 12> jacobian;
+  Evaluate<12, 6>(functor, delta, value, jacobian.data());
+  *jacobian_a = jacobian.block<6, 6>(0, 0);
+  *jacobian_b = jacobian.block<6, 6>(0, 6);
+}
+
+}  // namespace math
+}  // namespace ekumen
@@ -0,0 +1,380 @@
+#include "batch_transform.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include "binary_io.h"
+#include "isometry.h"
+#include "parallel.h"
+#include "text_format.h"
+#include "text_parser.h"
+#include "vector3.h"
+
+namespace ekumen {
+namespace math {
+namespace {
+using Clock = std::chrono::steady_clock;
+
+// Elements below which a batch is transformed by a single thread.
+constexpr std::size_t kMinTransformChunkSize = 1 << 14;
+
+double secondsSince(const Clock::time_point& start) {
+  return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+// Source of elements. read() fills up to 'max' elements and returns how many
+// it did, 0 at the end of the input.
+template <typename T>
+class ElementReader {
+ public:
+  virtual ~ElementReader() = default;
+  virtual std::size_t read(T* elements, std::size_t max) = 0;
+};
+
+template <typename T>
+class TextElementReader : public ElementReader<T> {
+ public:
+  explicit TextElementReader(std::istream* is) : reader_(is) {}
+
+  std::size_t read(T* elements, std::size_t max) override {
+    std::size_t count = 0;
+    const char* begin;
+    const char* end;
+    while (count < max && reader_.Next(&begin, &end)) {
+      if (begin == end) {
+        continue;
+      }
+      ParseStatus status = TextParser::Parse(begin, end, &elements[count]);
+      if (status.ok() && begin + status.offset != end) {
+        status.message = "Unexpected trailing characters.";
+      }
+      if (!status.ok()) {
+        throw std::invalid_argument(
+            std::string(status.message) + " Line " +
+            std::to_string(reader_.lineNumber()) + ", offset " +
+            std::to_string(status.offset) + ".");
+      }
+      ++count;
+    }
+    return count;
+  }
+
+ private:
+  LineReader reader_;
+};
+
+template <typename T>
+class BinaryElementReader : public ElementReader<T> {
+ public:
+  explicit BinaryElementReader(BinaryReader* reader) : reader_(reader) {}
+
+  std::size_t read(T* elements, std::size_t max) override {
+    return reader_->Read(elements, max);
+  }
+
+ private:
+  BinaryReader* reader_;
+};
+
+// Sink of elements. finish() is called once after the last write().
+template <typename T>
+class ElementWriter {
+ public:
+  virtual ~ElementWriter() = default;
+  virtual void write(const T* elements, std::size_t count) = 0;
+  virtual void finish() = 0;
+};
+
+template <typename T>
+class TextElementWriter : public ElementWriter<T> {
+ public:
+  TextElementWriter(int precision, std::ostream* os)
+      : precision_(precision), os_(os) {}
+
+  void write(const T* elements, std::size_t count) override {
+    TextFormat::WriteLines(elements, count, precision_, os_);
+  }
+
+  void finish() override {
+    os_->flush();
+    if (!*os_) {
+      throw std::runtime_error("Cannot write the output stream.");
+    }
+  }
+
+ private:
+  int precision_;
+  std::ostream* os_;
+};
+
+// Writes a binary array. When the number of elements is not known upfront,
+// the header is rewritten with it at the end.
+template <typename T>
+class BinaryElementWriter : public ElementWriter<T> {
+ public:
+  BinaryElementWriter(bool known_count, std::uint64_t count, std::ostream* os)
+      : known_count_(known_count), written_(0), os_(os) {
+    if (!known_count_) {
+      header_position_ = os_->tellp();
+      if (header_position_ == std::streampos(-1)) {
+        throw std::invalid_argument(
+            "Binary output of text input needs a seekable stream.");
+      }
+    }
+    BinaryWriter::WriteHeader<T>(count, os_);
+  }
+
+  void write(const T* elements, std::size_t count) override {
+    BinaryWriter::WriteElements(elements, count, os_);
+    written_ += count;
+  }
+
+  void finish() override {
+    if (!known_count_) {
+      const std::streampos end = os_->tellp();
+      os_->seekp(header_position_);
+      BinaryWriter::WriteHeader<T>(written_, os_);
+      os_->seekp(end);
+    }
+    os_->flush();
+    if (!*os_) {
+      throw std::runtime_error("Cannot write the output stream.");
+    }
+  }
+
+ private:
+  bool known_count_;
+  std::uint64_t written_;
+  std::streampos header_position_;
+  std::ostream* os_;
+};
+
+template <typename T>
+void transformBatch(const Isometry& pose, int num_threads, T* elements,
+                    std::size_t count) {
+  ParallelFor(count, num_threads,
+              [&](int, std::size_t begin, std::size_t end) {
+                for (std::size_t i = begin; i < end; ++i) {
+                  elements[i] = pose * elements[i];
+                }
+              },
+              kMinTransformChunkSize);
+}
+
+// Fills buffers from a reader on one thread kept for the whole run. Read
+// exceptions are rethrown by wait().
+template <typename T>
+class Prefetcher {
+ public:
+  explicit Prefetcher(ElementReader<T>* reader)
+      : reader_(reader),
+        buffer_(nullptr),
+        max_(0),
+        count_(0),
+        seconds_(0.),
+        requested_(false),
+        done_(false),
+        stop_(false),
+        thread_(&Prefetcher::loop, this) {}
+  Prefetcher(const Prefetcher&) = delete;
+  // Waits for the read in progress, if any.
+  ~Prefetcher() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stop_ = true;
+    }
+    condition_.notify_all();
+    thread_.join();
+  }
+
+  Prefetcher& operator=(const Prefetcher&) = delete;
+
+  // Starts filling up to 'max' elements of 'buffer'.
+  void start(T* buffer, std::size_t max) {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      buffer_ = buffer;
+      max_ = max;
+      requested_ = true;
+    }
+    condition_.notify_all();
+  }
+
+  // Waits for the read started last and returns how many elements it read,
+  // adding its time to 'seconds'.
+  std::size_t wait(double* seconds) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    condition_.wait(lock, [this]() { return done_; });
+    done_ = false;
+    if (error_) {
+      std::exception_ptr error;
+      std::swap(error, error_);
+      std::rethrow_exception(error);
+    }
+    *seconds += seconds_;
+    return count_;
+  }
+
+ private:
+  void loop() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    for (;;) {
+      condition_.wait(lock, [this]() { return requested_ || stop_; });
+      if (stop_) {
+        return;
+      }
+      requested_ = false;
+      lock.unlock();
+      const Clock::time_point start = Clock::now();
+      std::size_t count = 0;
+      std::exception_ptr error;
+      try {
+        count = reader_->read(buffer_, max_);
+      } catch (...) {
+        error = std::current_exception();
+      }
+      const double seconds = secondsSince(start);
+      lock.lock();
+      count_ = count;
+      error_ = error;
+      seconds_ = seconds;
+      done_ = true;
+      condition_.notify_all();
+    }
+  }
+
+  ElementReader<T>* reader_;
+  T* buffer_;
+  std::size_t max_;
+  std::size_t count_;
+  std::exception_ptr error_;
+  double seconds_;
+  bool requested_;
+  bool done_;
+  bool stop_;
+  std::mutex mutex_;
+  std::condition_variable condition_;
+  // Last, so that it starts once the rest is initialized.
+  std::thread thread_;
+};
+
+// Runs the double-buffered loop: batch 'current' is transformed and written
+// while the other buffer is refilled by a reader thread.
+template <typename T>
+BatchTransformStats runPipeline(const Isometry& pose,
+                                const BatchTransform::Options& options,
+                                ElementReader<T>* reader,
+                                ElementWriter<T>* writer) {
+  const Clock::time_point start = Clock::now();
+  BatchTransformStats stats = {};
+  std::vector<T> buffers[2] = {std::vector<T>(options.batch_size),
+                               std::vector<T>(options.batch_size)};
+  std::size_t sizes[2] = {0, 0};
+
+  // Nothing overlaps with the first read.
+  sizes[0] = reader->read(buffers[0].data(), options.batch_size);
+  stats.read_seconds = stats.stall_seconds = secondsSince(start);
+
+  Prefetcher<T> prefetcher(reader);
+  int current = 0;
+  while (sizes[current] > 0) {
+    const int next = 1 - current;
+    prefetcher.start(buffers[next].data(), options.batch_size);
+
+    Clock::time_point stage_start = Clock::now();
+    transformBatch(pose, options.num_threads, buffers[current].data(),
+                   sizes[current]);
+    stats.transform_seconds += secondsSince(stage_start);
+    stage_start = Clock::now();
+    writer->write(buffers[current].data(), sizes[current]);
+    stats.write_seconds += secondsSince(stage_start);
+
+    const Clock::time_point wait_start = Clock::now();
+    sizes[next] = prefetcher.wait(&stats.read_seconds);
+    stats.stall_seconds += secondsSince(wait_start);
+    stats.elements += sizes[current];
+    ++stats.batches;
+    current = next;
+  }
+
+  const Clock::time_point finish_start = Clock::now();
+  writer->finish();
+  stats.write_seconds += secondsSince(finish_start);
+  stats.total_seconds = secondsSince(start);
+  return stats;
+}
+
+template <typename T>
+BatchTransformStats run(const Isometry& pose,
+                        const BatchTransform::Options& options,
+                        BinaryReader* binary_input, std::istream* is,
+                        std::ostream* os) {
+  std::unique_ptr<ElementReader<T>> reader;
+  if (binary_input != nullptr) {
+    reader.reset(new BinaryElementReader<T>(binary_input));
+  } else {
+    reader.reset(new TextElementReader<T>(is));
+  }
+
+  std::unique_ptr<ElementWriter<T>> writer;
+  if (options.output_format == StreamFormat::kText) {
+    writer.reset(new TextElementWriter<T>(options.precision, os));
+  } else {
+    const bool known_count = binary_input != nullptr;
+    writer.reset(new BinaryElementWriter<T>(
+        known_count, known_count ? binary_input->header().count : 0, os));
+  }
+  return runPipeline(pose, options, reader.get(), writer.get());
+}
+}  // namespace
+
+double BatchTransformStats::throughput() const {
+  return total_seconds > 0. ? elements / total_seconds : 0.;
+}
+
+BatchTransform::Options::Options()
+    : input_format(StreamFormat::kText),
+      output_format(StreamFormat::kText),
+      kind(ElementKind::kPoint),
+      batch_size(1 << 16),
+      precision(TextFormat::kRoundTrip),
+      num_threads(DefaultNumThreads()) {}
+
+BatchTransformStats BatchTransform::Run(const Isometry& pose,
+                                        const Options& options,
+                                        std::istream* is, std::ostream* os) {
+  if (options.batch_size == 0 || options.num_threads < 1) {
+    throw std::invalid_argument("Batch size and threads must be positive.");
+  }
+  if (options.precision < TextFormat::kRoundTrip ||
+      options.precision > TextFormat::kMaxPrecision) {
+    throw std::invalid_argument("Invalid text format precision.");
+  }
+
+  if (options.input_format == StreamFormat::kText) {
+    return options.kind == ElementKind::kPoint
+               ? run<Vector3>(pose, options, nullptr, is, os)
+               : run<Isometry>(pose, options, nullptr, is, os);
+  }
+  BinaryReader reader(is);
+  switch (reader.header().type) {
+    case BinaryType::kVector3:
+      return run<Vector3>(pose, options, &reader, is, os);
+    case BinaryType::kIsometry:
+      return run<Isometry>(pose, options, &reader, is, os);
+    default:
+      throw std::runtime_error(
+          "Binary input must hold points or poses to transform.");
+  }
+}
+
+}  // namespace math
+}  // namespace ekumen
@@ -0,0 +1,1097 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <iomanip>
+#include <ios>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <streambuf>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "aabb.h"
+#include "blocked_point_cloud.h"
+#include "box_set.h"
+#include "convex_hull.h"
+#include "convex_shape.h"
+#include "gjk.h"
+#include "isometry.h"
+#include "map_view.h"
+#include "matrix3.h"
+#include "morton.h"
+#include "obb.h"
+#include "point_cloud.h"
+#include "point_filter.h"
+#include "point_pipeline.h"
+#include "ray_batch.h"
+#include "sweep_and_prune.h"
+#include "text_format.h"
+#include "text_parser.h"
+#include "triangle_mesh.h"
+#include "vector3.h"
+
+namespace {
+using ekumen::math::Aabb;
+using ekumen::math::BlockedPointCloud;
+using ekumen::math::BoxSet;
+using ekumen::math::DefaultNumThreads;
+using ekumen::math::ConstPointsView;
+using ekumen::math::ConstVector3Map;
+using ekumen::math::ConvexContact;
+using ekumen::math::ConvexHull;
+using ekumen::math::ConvexShape;
+using ekumen::math::FilterTransform;
+using ekumen::math::GjkCache;
+using ekumen::math::Isometry;
+using ekumen::math::Matrix3;
+using ekumen::math::Obb;
+using ekumen::math::PointCloud;
+using ekumen::math::PointFilter;
+using ekumen::math::PointsView;
+using ekumen::math::RayBatch;
+using ekumen::math::RayHit;
+using ekumen::math::RayHits;
+using ekumen::math::SweepAndPrune;
+using ekumen::math::TextFormat;
+using ekumen::math::TextParser;
+using ekumen::math::TriangleMesh;
+using ekumen::math::Vector3;
+using ekumen::math::Vector3Map;
+
+// Exit codes.
+constexpr int kSuccess = 0;
+constexpr int kUsageError = 2;
+
+const char kUsage[] =
+    "Usage: benchmarks [options]\n"
+    "Times the point kernels of the library and prints nanoseconds per\n"
+    "point, the best of several repetitions, and megabytes per second for\n"
+    "text.\n"
+    "\n"
+    "  --points N         Points in the cloud (default 16777216).\n"
+    "  --indices N        Points selected by index lists (default 4194304).\n"
+    "  --repetitions N    Runs per case (default 5).\n"
+    "  -h, --help         Prints this help.\n";
+
+struct Options {
+  std::size_t points = 1 << 24;
+  std::size_t indices = 1 << 22;
+  int repetitions = 5;
+};
+
+// Returns the best time of 'options.repetitions' runs, in nanoseconds per
+// 'count' elements.
+double timeCase(const Options& options, std::size_t count,
+                const std::function<void()>& run) {
+  double best = 0.;
+  for (int i = 0; i < options.repetitions; ++i) {
+    const auto start = std::chrono::steady_clock::now();
+    run();
+    const double seconds = std::chrono::duration<double>(
+                               std::chrono::steady_clock::now() - start)
+                               .count();
+    best = i == 0 ? seconds : std::min(best, seconds);
+  }
+  return best * 1e9 / static_cast<double>(count);
+}
+
+void printCase(const std::string& name, double nanoseconds) {
+  std::cout << std::left << std::setw(44) << name << std::right
+            << std::setw(8) << std::fixed << std::setprecision(2)
+            << nanoseconds << " ns/point" << std::endl;
+}
+
+// As printCase(), adding the throughput for 'bytes' bytes per point.
+void printRate(const std::string& name, double nanoseconds, double bytes) {
+  std::cout << std::left << std::setw(44) << name << std::right
+            << std::setw(8) << std::fixed << std::setprecision(2)
+            << nanoseconds << " ns/point" << std::setw(10)
+            << bytes / nanoseconds * 1e3 << " MB/s" << std::endl;
+}
+
+// Indexed gathers and scatters over a cloud larger than the caches, with
+// random and sorted index lists, naive and with prefetching at several
+// distances.
+void benchmarkIndexed(const Options& options) {
+  const Isometry pose = Isometry::FromTranslation(Vector3(1., -2., 0.5)) *
+                        Isometry::RotateAround(Vector3(1., 2., 3.), 0.7);
+  std::vector<double> cloud(3 * options.points);
+  for (std::size_t i = 0; i < cloud.size(); ++i) {
+    cloud[i] = 1e-3 * static_cast<double>(i % 1000);
+  }
+  std::vector<double> selected(3 * options.indices);
+  std::mt19937_64 generator(42);
+  std::uniform_int_distribution<std::size_t> distribution(
+      0, options.points - 1);
+  std::vector<std::size_t> random(options.indices);
+  for (std::size_t& index : random) {
+    index = distribution(generator);
+  }
+  std::vector<std::size_t> sorted = random;
+  std::sort(sorted.begin(), sorted.end());
+
+  const ConstPointsView input(cloud.data(), options.points);
+  const PointsView output(selected.data(), options.indices);
+  const std::size_t kDistances[] = {0, 4, 8, 16, 32, 64};
+  for (const std::vector<std::size_t>* indices : {&random, &sorted}) {
+    const std::string pattern = indices == &random ? "random" : "sorted";
+    printCase("gather " + pattern + " naive",
+              timeCase(options, indices->size(), [&]() {
+                for (std::size_t k = 0; k < indices->size(); ++k) {
+                  Vector3Map(selected.data() + 3 * k) =
+                      pose * ConstVector3Map(cloud.data() +
+                                             3 * (*indices)[k]);
+                }
+              }));
+    for (std::size_t distance : kDistances) {
+      printCase("gather " + pattern + " prefetch " + std::to_string(distance),
+                timeCase(options, indices->size(), [&]() {
+                  pose.transformGather(input, *indices, output, distance);
+                }));
+    }
+    const PointsView cloud_view(cloud.data(), options.points);
+    for (std::size_t distance : kDistances) {
+      printCase("scatter " + pattern + " prefetch " + std::to_string(distance),
+                timeCase(options, indices->size(), [&]() {
+                  pose.transformScatter(output, *indices, cloud_view,
+                                        distance);
+                }));
+    }
+  }
+}
+
+// Keeps the points of 'cloud' for which 'keep(i)' is true, in order.
+template <typename Predicate>
+void compact(PointCloud* cloud, Predicate keep) {
+  std::size_t count = 0;
+  for (std::size_t i = 0; i < cloud->size(); ++i) {
+    if (keep(i)) {
+      cloud->x()[count] = cloud->x()[i];
+      cloud->y()[count] = cloud->y()[i];
+      cloud->z()[count] = cloud->z()[i];
+      ++count;
+    }
+  }
+  cloud->resize(count);
+}
+
+// A transform followed by a crop box pass and a range pass, against the
+// fused kernels.
+void benchmarkFilter(const Options& options) {
+  const Isometry pose = Isometry::FromTranslation(Vector3(1., -2., 0.5)) *
+                        Isometry::RotateAround(Vector3(1., 2., 3.), 0.7);
+  PointCloud input(options.points);
+  std::mt19937_64 generator(42);
+  std::uniform_real_distribution<double> distribution(-50., 50.);
+  for (std::size_t i = 0; i < input.size(); ++i) {
+    input.x()[i] = distribution(generator);
+    input.y()[i] = distribution(generator);
+    input.z()[i] = 0.1 * distribution(generator);
+  }
+  PointFilter filter;
+  filter.box_min = Vector3(-30., -30., -2.);
+  filter.box_max = Vector3(30., 30., 3.);
+  filter.min_range = 1.;
+  filter.max_range = 40.;
+  const Vector3 sensor = pose.translation();
+  PointCloud output;
+  printCase("filter separate passes", timeCase(options, input.size(), [&]() {
+              output = input;
+              output.transform(pose);
+              compact(&output, [&](std::size_t i) {
+                return output.x()[i] >= filter.box_min.x() &&
+                       output.x()[i] <= filter.box_max.x() &&
+                       output.y()[i] >= filter.box_min.y() &&
+                       output.y()[i] <= filter.box_max.y() &&
+                       output.z()[i] >= filter.box_min.z() &&
+                       output.z()[i] <= filter.box_max.z();
+              });
+              compact(&output, [&](std::size_t i) {
+                const double dx = output.x()[i] - sensor.x();
+                const double dy = output.y()[i] - sensor.y();
+                const double dz = output.z()[i] - sensor.z();
+                const double range = std::sqrt(dx * dx + dy * dy + dz * dz);
+                return range >= filter.min_range && range <= filter.max_range;
+              });
+            }));
+  printCase("filter fused portable", timeCase(options, input.size(), [&]() {
+              FilterTransform::Run(pose, filter,
+                                   [](double, double, double) { return true; },
+                                   input, &output);
+            }));
+  printCase("filter fused", timeCase(options, input.size(), [&]() {
+              FilterTransform::Run(pose, filter, input, &output);
+            }));
+}
+
+// Transform, filter and stride chains over 'options.indices' points, with a
+// vector per step against a lazy pipeline.
+void benchmarkPipeline(const Options& options) {
+  const Isometry pose = Isometry::FromTranslation(Vector3(1., -2., 0.5)) *
+                        Isometry::RotateAround(Vector3(1., 2., 3.), 0.7);
+  std::vector<Vector3> points;
+  points.reserve(options.indices);
+  for (std::size_t i = 0; i < options.indices; ++i) {
+    points.emplace_back(1e-3 * static_cast<double>(i % 1000), 0.5, -1.);
+  }
+  std::size_t count = 0;
+  printCase("pipeline eager vectors", timeCase(options, points.size(), [&]() {
+              std::vector<Vector3> moved;
+              for (const Vector3& point : points) {
+                moved.push_back(pose * point);
+              }
+              std::vector<Vector3> kept;
+              for (const Vector3& point : moved) {
+                if (point.x() > 1.) {
+                  kept.push_back(point);
+                }
+              }
+              std::vector<Vector3> res;
+              for (std::size_t i = 0; i < kept.size(); i += 2) {
+                res.push_back(kept[i]);
+              }
+              count = res.size();
+            }));
+  const auto keep = [](double x, double, double) { return x > 1.; };
+  printCase("pipeline lazy", timeCase(options, points.size(), [&]() {
+              count = (points | ekumen::math::transformed(pose) |
+                       ekumen::math::filtered(keep) |
+                       ekumen::math::strided(2))
+                          .toVector()
+                          .size();
+            }));
+  if (count == 0) {
+    std::cerr << "benchmarks: Empty pipeline." << std::endl;
+  }
+}
+
+// Transform, dot, cross and norm kernels on arrays of xyz points (AoS), on
+// PointCloud (SoA) and on BlockedPointCloud (AoSoA), for a laser scan, a
+// merged map and 'options.points' points. Small clouds are processed
+// repeatedly, so that every case touches the same number of points.
+void benchmarkLayouts(const Options& options) {
+  const Isometry pose = Isometry::FromTranslation(Vector3(1., -2., 0.5)) *
+                        Isometry::RotateAround(Vector3(1., 2., 3.), 0.7);
+  const std::size_t kSizes[] = {1 << 16, 1 << 20, options.points};
+  for (std::size_t size : kSizes) {
+    const std::size_t passes = std::max<std::size_t>(1, options.points / size);
+    PointCloud soa_a(size), soa_b(size), soa_c(size);
+    for (std::size_t i = 0; i < size; ++i) {
+      soa_a.setPoint(i, Vector3(1e-3 * static_cast<double>(i % 1000), 0.5,
+                                -1.));
+      soa_b.setPoint(i, Vector3(0.25, -1e-3 * static_cast<double>(i % 700),
+                                2.));
+    }
+    const BlockedPointCloud aosoa_b(soa_b);
+    BlockedPointCloud aosoa_a(soa_a), aosoa_c(size);
+    std::vector<double> aos_a(3 * size), aos_b(3 * size), aos_c(3 * size);
+    for (std::size_t i = 0; i < size; ++i) {
+      aos_a[3 * i] = soa_a.x()[i];
+      aos_a[3 * i + 1] = soa_a.y()[i];
+      aos_a[3 * i + 2] = soa_a.z()[i];
+      aos_b[3 * i] = soa_b.x()[i];
+      aos_b[3 * i + 1] = soa_b.y()[i];
+      aos_b[3 * i + 2] = soa_b.z()[i];
+    }
+    std::vector<double> scalars(size);
+    const auto run = [&](const std::string& name,
+                         const std::function<void()>& kernel) {
+      printCase(name + " " + std::to_string(size),
+                timeCase(options, size * passes, [&]() {
+                  for (std::size_t k = 0; k < passes; ++k) {
+                    kernel();
+                  }
+                }));
+    };
+
+    run("layout transform aos",
+        [&]() { pose.transform(PointsView(aos_a.data(), size)); });
+    run("layout transform soa", [&]() { soa_a.transform(pose); });
+    run("layout transform aosoa", [&]() { aosoa_a.transform(pose); });
+
+    run("layout dot aos", [&]() {
+      const double* a = aos_a.data();
+      const double* b = aos_b.data();
+      for (std::size_t i = 0; i < size; ++i, a += 3, b += 3) {
+        scalars[i] = a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+      }
+    });
+    run("layout dot soa", [&]() {
+      const double* ax = soa_a.x();
+      const double* ay = soa_a.y();
+      const double* az = soa_a.z();
+      const double* bx = soa_b.x();
+      const double* by = soa_b.y();
+      const double* bz = soa_b.z();
+      for (std::size_t i = 0; i < size; ++i) {
+        scalars[i] = ax[i] * bx[i] + ay[i] * by[i] + az[i] * bz[i];
+      }
+    });
+    run("layout dot aosoa", [&]() { aosoa_a.dot(aosoa_b, &scalars); });
+
+    run("layout cross aos", [&]() {
+      const double* a = aos_a.data();
+      const double* b = aos_b.data();
+      double* c = aos_c.data();
+      for (std::size_t i = 0; i < size; ++i, a += 3, b += 3, c += 3) {
+        c[0] = a[1] * b[2] - a[2] * b[1];
+        c[1] = a[2] * b[0] - a[0] * b[2];
+        c[2] = a[0] * b[1] - a[1] * b[0];
+      }
+    });
+    run("layout cross soa", [&]() {
+      const double* ax = soa_a.x();
+      const double* ay = soa_a.y();
+      const double* az = soa_a.z();
+      const double* bx = soa_b.x();
+      const double* by = soa_b.y();
+      const double* bz = soa_b.z();
+      double* cx = soa_c.x();
+      double* cy = soa_c.y();
+      double* cz = soa_c.z();
+      for (std::size_t i = 0; i < size; ++i) {
+        cx[i] = ay[i] * bz[i] - az[i] * by[i];
+        cy[i] = az[i] * bx[i] - ax[i] * bz[i];
+        cz[i] = ax[i] * by[i] - ay[i] * bx[i];
+      }
+    });
+    run("layout cross aosoa", [&]() { aosoa_a.cross(aosoa_b, &aosoa_c); });
+
+    run("layout norm aos", [&]() {
+      const double* a = aos_a.data();
+      for (std::size_t i = 0; i < size; ++i, a += 3) {
+        scalars[i] = std::sqrt(a[0] * a[0] + a[1] * a[1] + a[2] * a[2]);
+      }
+    });
+    run("layout norm soa", [&]() {
+      const double* ax = soa_a.x();
+      const double* ay = soa_a.y();
+      const double* az = soa_a.z();
+      for (std::size_t i = 0; i < size; ++i) {
+        scalars[i] = std::sqrt(ax[i] * ax[i] + ay[i] * ay[i] + az[i] * az[i]);
+      }
+    });
+    run("layout norm aosoa", [&]() { aosoa_a.norm(&scalars); });
+  }
+}
+
+// Morton codes and sorts of a cloud of 'options.points' points, against a
+// comparison sort of the same codes.
+void benchmarkMorton(const Options& options) {
+  PointCloud cloud(options.points);
+  std::mt19937_64 generator(42);
+  std::uniform_real_distribution<double> distribution(-50., 50.);
+  for (std::size_t i = 0; i < cloud.size(); ++i) {
+    cloud.x()[i] = distribution(generator);
+    cloud.y()[i] = distribution(generator);
+    cloud.z()[i] = 0.1 * distribution(generator);
+  }
+  const Vector3 min(-50., -50., -5.);
+  const Vector3 max(50., 50., 5.);
+  std::vector<std::uint64_t> codes;
+  printCase("morton codes", timeCase(options, cloud.size(), [&]() {
+              ekumen::math::MortonCodes(cloud, min, max, &codes);
+            }));
+  const std::vector<std::uint64_t> unsorted = codes;
+  printCase("morton std::sort of codes", timeCase(options, cloud.size(), [&]() {
+              codes = unsorted;
+              std::sort(codes.begin(), codes.end());
+            }));
+  printCase("morton radix sort of codes",
+            timeCase(options, cloud.size(), [&]() {
+              codes = unsorted;
+              ekumen::math::RadixSort(&codes, 3 * ekumen::math::kMortonBits);
+            }));
+  PointCloud sorted;
+  printCase("morton sort of cloud", timeCase(options, cloud.size(), [&]() {
+              sorted = cloud;
+              ekumen::math::MortonSort(&sorted);
+            }));
+}
+
+// Bvh build and refit of a terrain mesh of about 'options.points' / 8
+// triangles, and ray and closest point queries with the mesh at a pose,
+// timed per triangle and per query.
+void benchmarkBvh(const Options& options) {
+  const std::uint32_t side = std::max<std::uint32_t>(
+      16, static_cast<std::uint32_t>(std::sqrt(options.points / 16.)));
+  const auto heightAt = [](double x, double y, double phase) {
+    return std::sin(0.05 * x + phase) * std::cos(0.07 * y) * 5.;
+  };
+  const auto makeVertices = [&](double phase) {
+    std::vector<Vector3> res;
+    for (std::uint32_t j = 0; j <= side; ++j) {
+      for (std::uint32_t i = 0; i <= side; ++i) {
+        res.emplace_back(i, j, heightAt(i, j, phase));
+      }
+    }
+    return res;
+  };
+  std::vector<TriangleMesh::Triangle> triangles;
+  for (std::uint32_t j = 0; j < side; ++j) {
+    for (std::uint32_t i = 0; i < side; ++i) {
+      const std::uint32_t corner = j * (side + 1) + i;
+      triangles.push_back({{corner, corner + 1, corner + side + 2}});
+      triangles.push_back({{corner, corner + side + 2, corner + side + 1}});
+    }
+  }
+  const std::vector<Vector3> vertices = makeVertices(0.);
+  const std::vector<Vector3> moved = makeVertices(1.);
+  TriangleMesh mesh(vertices, triangles);
+  printCase("bvh build", timeCase(options, triangles.size(), [&]() {
+              mesh = TriangleMesh(vertices, triangles);
+            }));
+  printCase("bvh refit", timeCase(options, triangles.size(), [&]() {
+              mesh.setVertices(moved);
+            }));
+
+  const Isometry pose = Isometry::FromTranslation(Vector3(-3., 7., 1.)) *
+                        Isometry::RotateAround(Vector3(1., 2., 3.), 0.4);
+  const std::size_t num_queries =
+      std::min<std::size_t>(options.indices, 1 << 18);
+  std::mt19937_64 generator(42);
+  std::uniform_real_distribution<double> positions(0., side);
+  std::uniform_real_distribution<double> slopes(-0.5, 0.5);
+  std::vector<Vector3> origins;
+  std::vector<Vector3> directions;
+  for (std::size_t i = 0; i < num_queries; ++i) {
+    origins.push_back(
+        pose * Vector3(positions(generator), positions(generator), 20.));
+    directions.push_back(pose.rotation().product(
+        Vector3(slopes(generator), slopes(generator), -1.)));
+  }
+  std::size_t hits = 0;
+  printCase("bvh raycast", timeCase(options, num_queries, [&]() {
+              ekumen::math::RayHit hit;
+              for (std::size_t i = 0; i < num_queries; ++i) {
+                hits += mesh.raycast(pose, origins[i], directions[i], 100.,
+                                     &hit);
+              }
+            }));
+  // Points around the surface.
+  std::vector<Vector3> centers;
+  for (std::size_t i = 0; i < num_queries; ++i) {
+    centers.push_back(origins[i] + 20. * directions[i]);
+  }
+  printCase("bvh closest point", timeCase(options, num_queries, [&]() {
+              ekumen::math::MeshPoint nearest;
+              for (std::size_t i = 0; i < num_queries; ++i) {
+                hits += mesh.closestPoint(pose, centers[i], 50., &nearest);
+              }
+            }));
+  std::size_t overlaps = 0;
+  printCase("bvh overlapping", timeCase(options, num_queries, [&]() {
+              for (std::size_t i = 0; i < num_queries; ++i) {
+                overlaps += mesh.overlapping(
+                                    pose,
+                                    Aabb(centers[i] - Vector3(1., 1., 1.),
+                                         centers[i] + Vector3(1., 1., 1.)))
+                                .size();
+              }
+            }));
+  if (hits == 0 || overlaps == 0) {
+    std::cerr << "benchmarks: No mesh queries hit.\n";
+  }
+}
+
+// Broad-phase tests of every box of a scene of 4096 against all of them,
+// one at a time and batched, timed per box pair, and Aabb transforms with
+// the absolute rotation against transforming the 8 corners, per box.
+void benchmarkBoxes(const Options& options) {
+  constexpr std::size_t kNumBoxes = 4096;
+  std::mt19937_64 generator(42);
+  std::uniform_real_distribution<double> positions(-100., 100.);
+  std::uniform_real_distribution<double> sizes(0.5, 5.);
+  std::uniform_real_distribution<double> angles(-M_PI, M_PI);
+  std::vector<Aabb> boxes;
+  std::vector<Obb> oriented;
+  for (std::size_t i = 0; i < kNumBoxes; ++i) {
+    const Vector3 center(positions(generator), positions(generator),
+                         positions(generator));
+    const Vector3 half(sizes(generator), sizes(generator), sizes(generator));
+    boxes.emplace_back(center - half, center + half);
+    oriented.push_back(Obb::FromAabb(
+        Aabb(-1. * half, half),
+        Isometry::FromTranslation(center) *
+            Isometry::FromEulerAngles(angles(generator), angles(generator),
+                                      angles(generator))));
+  }
+  const BoxSet set(boxes);
+  const std::size_t num_pairs = kNumBoxes * kNumBoxes;
+  std::size_t overlaps = 0;
+  printCase("boxes aabb pairs one by one", timeCase(options, num_pairs, [&]() {
+              for (const Aabb& query : boxes) {
+                for (const Aabb& box : boxes) {
+                  overlaps += query.overlaps(box);
+                }
+              }
+            }));
+  std::vector<std::uint32_t> found;
+  printCase("boxes aabb pairs batched", timeCase(options, num_pairs, [&]() {
+              for (const Aabb& query : boxes) {
+                set.overlapping(query, &found);
+                overlaps += found.size();
+              }
+            }));
+  const std::size_t num_oriented = kNumBoxes * 256;
+  printCase("boxes obb pairs one by one",
+            timeCase(options, num_oriented, [&]() {
+              for (std::size_t i = 0; i < 256; ++i) {
+                for (const Obb& box : oriented) {
+                  overlaps += oriented[i].overlaps(box);
+                }
+              }
+            }));
+  const std::vector<Obb> aligned(oriented.begin(), oriented.begin() + 256);
+  printCase("boxes obb against aabbs batched",
+            timeCase(options, num_oriented, [&]() {
+              for (const Obb& query : aligned) {
+                set.overlapping(query, &found);
+                overlaps += found.size();
+              }
+            }));
+
+  const Isometry pose = Isometry::FromTranslation(Vector3(1., -2., 0.5)) *
+                        Isometry::RotateAround(Vector3(1., 2., 3.), 0.7);
+  std::vector<Aabb> moved(kNumBoxes);
+  printCase("boxes transform abs rotation",
+            timeCase(options, kNumBoxes, [&]() {
+              for (std::size_t i = 0; i < kNumBoxes; ++i) {
+                moved[i] = boxes[i].transformed(pose);
+              }
+            }));
+  printCase("boxes transform 8 corners", timeCase(options, kNumBoxes, [&]() {
+              for (std::size_t i = 0; i < kNumBoxes; ++i) {
+                Aabb res;
+                for (int corner = 0; corner < 8; ++corner) {
+                  res.extend(pose * Vector3(
+                      corner & 1 ? boxes[i].max.x() : boxes[i].min.x(),
+                      corner & 2 ? boxes[i].max.y() : boxes[i].min.y(),
+                      corner & 4 ? boxes[i].max.z() : boxes[i].min.z()));
+                }
+                moved[i] = res;
+              }
+            }));
+  if (overlaps == 0) {
+    std::cerr << "benchmarks: No boxes overlap.\n";
+  }
+}
+
+void benchmarkRays(const Options& options) {
+  // A LiDAR scan, cast at a pose against a box and a small mesh: beams from
+  // a sensor above the mesh, in scan order over a grid of directions.
+  constexpr std::size_t kNumRays = 1 << 16;
+  constexpr std::size_t kScanSide = 1 << 8;
+  constexpr std::uint32_t kSide = 8;
+  RayBatch rays;
+  for (std::size_t j = 0; j < kScanSide; ++j) {
+    for (std::size_t i = 0; i < kScanSide; ++i) {
+      rays.push_back(Vector3(0., 0., 10.),
+                     Vector3(2. * i / kScanSide - 1., 2. * j / kScanSide - 1.,
+                             -1.));
+    }
+  }
+  std::vector<Vector3> vertices;
+  for (std::uint32_t j = 0; j <= kSide; ++j) {
+    for (std::uint32_t i = 0; i <= kSide; ++i) {
+      vertices.emplace_back(i - 4., j - 4., 0.1 * ((i + j) % 3));
+    }
+  }
+  std::vector<TriangleMesh::Triangle> triangles;
+  for (std::uint32_t j = 0; j < kSide; ++j) {
+    for (std::uint32_t i = 0; i < kSide; ++i) {
+      const std::uint32_t corner = j * (kSide + 1) + i;
+      triangles.push_back({{corner, corner + 1, corner + kSide + 2}});
+      triangles.push_back({{corner, corner + kSide + 2, corner + kSide + 1}});
+    }
+  }
+  const TriangleMesh mesh(vertices, triangles);
+  const Aabb box(Vector3(-3., -3., -1.), Vector3(3., 3., 1.));
+  const Isometry pose = Isometry::FromTranslation(Vector3(0.5, -0.2, 1.)) *
+                        Isometry::RotateAround(Vector3(1., 2., 3.), 0.2);
+  RayHits hits(kNumRays);
+  double total = 0.;
+
+  printCase("rays plane one by one", timeCase(options, kNumRays, [&]() {
+              const Vector3 normal = pose.rotation().product(Vector3::kUnitZ);
+              const double offset = normal.dot(pose.translation());
+              for (std::size_t i = 0; i < kNumRays; ++i) {
+                const double t =
+                    (offset - normal.dot(rays.origin(i))) /
+                    normal.dot(rays.direction(i));
+                hits.distances[i] = t >= 0. ? t : hits.distances[i];
+              }
+            }));
+  printCase("rays plane batched", timeCase(options, kNumRays, [&]() {
+              hits = RayHits(kNumRays);
+              CastPlane(pose, Vector3::kUnitZ, 0., 0, rays, &hits);
+            }));
+  total += hits.distances[0];
+
+  printCase("rays box one by one", timeCase(options, kNumRays, [&]() {
+              const Isometry inverse = pose.inverse();
+              for (std::size_t i = 0; i < kNumRays; ++i) {
+                const Vector3 origin = inverse * rays.origin(i);
+                const Vector3 direction =
+                    inverse.rotation().product(rays.direction(i));
+                double enter = 0.;
+                double exit = hits.distances[i];
+                for (int k = 0; k < 3; ++k) {
+                  const double t0 = (box.min[k] - origin[k]) / direction[k];
+                  const double t1 = (box.max[k] - origin[k]) / direction[k];
+                  enter = std::max(enter, std::min(t0, t1));
+                  exit = std::min(exit, std::max(t0, t1));
+                }
+                hits.distances[i] = enter <= exit ? enter : hits.distances[i];
+              }
+            }));
+  printCase("rays box batched", timeCase(options, kNumRays, [&]() {
+              hits = RayHits(kNumRays);
+              CastBox(pose, box, 0, rays, &hits);
+            }));
+  total += hits.distances[0];
+
+  printCase("rays 128 triangles bvh", timeCase(options, kNumRays, [&]() {
+              RayHit hit;
+              for (std::size_t i = 0; i < kNumRays; ++i) {
+                if (mesh.raycast(pose, rays.origin(i), rays.direction(i),
+                                 100., &hit)) {
+                  total += hit.distance;
+                }
+              }
+            }));
+  printCase("rays 128 triangles batched", timeCase(options, kNumRays, [&]() {
+              hits = RayHits(kNumRays);
+              CastTriangles(pose, mesh, rays, &hits);
+            }));
+  total += hits.distances[0];
+  if (std::isnan(total)) {
+    std::cerr << "benchmarks: Ray distances are not numbers.\n";
+  }
+}
+
+void benchmarkSweepAndPrune(const Options& options) {
+  // Bodies drifting in a cube, timed per body and frame. The poses of every
+  // frame are computed upfront, and each case times setting them and finding
+  // the pairs: from a fresh structure, which sorts fully, and from the
+  // previous frame, which resorts by insertion.
+  constexpr std::size_t kNumBodies = 2000;
+  std::mt19937_64 generator(42);
+  std::uniform_real_distribution<double> positions(-50., 50.);
+  std::uniform_real_distribution<double> sizes(0.5, 3.);
+  std::uniform_real_distribution<double> steps(-0.05, 0.05);
+  std::vector<Aabb> boxes;
+  std::vector<std::vector<Isometry>> frames(options.repetitions + 1);
+  std::vector<Vector3> velocities;
+  for (std::size_t i = 0; i < kNumBodies; ++i) {
+    const Vector3 half(sizes(generator), sizes(generator), sizes(generator));
+    boxes.emplace_back(-1. * half, half);
+    frames[0].push_back(Isometry::FromTranslation(Vector3(
+        positions(generator), positions(generator), positions(generator))));
+    velocities.emplace_back(steps(generator), steps(generator),
+                            steps(generator));
+  }
+  const Isometry turn = Isometry::RotateAround(Vector3(1., 2., 3.), 0.01);
+  for (std::size_t frame = 1; frame < frames.size(); ++frame) {
+    for (std::size_t i = 0; i < kNumBodies; ++i) {
+      frames[frame].push_back(Isometry::FromTranslation(velocities[i]) *
+                              frames[frame - 1][i] * turn);
+    }
+  }
+  // Structures at the first frame, one per run of a case.
+  const auto makeStructures = [&]() {
+    std::vector<SweepAndPrune> res(options.repetitions);
+    for (SweepAndPrune& bodies : res) {
+      bodies.reserve(kNumBodies);
+      for (std::size_t i = 0; i < kNumBodies; ++i) {
+        bodies.add(boxes[i], frames[0][i]);
+      }
+    }
+    return res;
+  };
+  std::vector<SweepAndPrune::Pair> pairs;
+  std::size_t found = 0;
+  std::size_t run = 0;
+  std::vector<Aabb> world(kNumBodies);
+  printCase("sap all pairs one by one", timeCase(options, kNumBodies, [&]() {
+              const std::vector<Isometry>& poses = frames[++run];
+              for (std::size_t i = 0; i < kNumBodies; ++i) {
+                world[i] = boxes[i].transformed(poses[i]);
+              }
+              for (std::size_t i = 0; i < kNumBodies; ++i) {
+                for (std::size_t j = i + 1; j < kNumBodies; ++j) {
+                  found += world[i].overlaps(world[j]);
+                }
+              }
+            }));
+  std::vector<SweepAndPrune> fresh = makeStructures();
+  run = 0;
+  printCase("sap first frame", timeCase(options, kNumBodies, [&]() {
+              SweepAndPrune& bodies = fresh[run];
+              bodies.setPoses(frames[++run]);
+              bodies.findPairs(&pairs);
+              found += pairs.size();
+            }));
+  SweepAndPrune bodies = makeStructures().front();
+  bodies.findPairs(&pairs);
+  run = 0;
+  printCase("sap coherent frame", timeCase(options, kNumBodies, [&]() {
+              bodies.setPoses(frames[++run]);
+              bodies.findPairs(&pairs);
+              found += pairs.size();
+            }));
+  if (found == 0) {
+    std::cerr << "benchmarks: No bodies overlap.\n";
+  }
+}
+
+void benchmarkGjk(const Options& options) {
+  // Pairs of shapes moving a little each frame, timed per query.
+  constexpr std::size_t kNumPairs = 1024;
+  constexpr int kNumFrames = 16;
+  std::mt19937_64 generator(42);
+  std::uniform_real_distribution<double> unit(-1., 1.);
+  std::uniform_real_distribution<double> angles(-M_PI, M_PI);
+  std::vector<Vector3> vertices;
+  for (int i = 0; i < 32; ++i) {
+    vertices.emplace_back(unit(generator), unit(generator), unit(generator));
+  }
+  const ConvexShape hull = ConvexShape::Hull(vertices);
+  const ConvexShape box = ConvexShape::Box(Vector3(0.8, 0.5, 0.3));
+  const ConvexShape capsule = ConvexShape::Capsule(0.6, 0.3);
+  std::vector<Isometry> starts;
+  for (std::size_t i = 0; i < kNumPairs; ++i) {
+    starts.push_back(
+        Isometry::FromTranslation(Vector3(2. * unit(generator),
+                                          2. * unit(generator),
+                                          2. * unit(generator))) *
+        Isometry::FromEulerAngles(angles(generator), angles(generator),
+                                  angles(generator)));
+  }
+  const Isometry step = Isometry::FromTranslation(Vector3(0.01, 0., 0.)) *
+                        Isometry::RotateAround(Vector3(1., 2., 3.), 0.01);
+  std::vector<Isometry> frames;
+  for (std::size_t i = 0; i < kNumPairs; ++i) {
+    Isometry pose = starts[i];
+    for (int frame = 0; frame < kNumFrames; ++frame) {
+      frames.push_back(pose);
+      pose = step * pose;
+    }
+  }
+  const std::size_t num_queries = frames.size();
+  std::vector<GjkCache> caches(kNumPairs);
+  const Isometry origin;
+  double total = 0.;
+  const auto run = [&](const ConvexShape& a, const ConvexShape& b,
+                       bool penetration, bool warm) {
+    for (GjkCache& cache : caches) {
+      cache = GjkCache();
+    }
+    for (std::size_t i = 0; i < num_queries; ++i) {
+      GjkCache* cache = warm ? &caches[i / kNumFrames] : nullptr;
+      if (penetration) {
+        total += ConvexPenetration(a, origin, b, frames[i], cache).distance;
+      } else {
+        total += ConvexDistance(a, origin, b, frames[i], nullptr, cache);
+      }
+    }
+  };
+  printCase("gjk box capsule distance cold",
+            timeCase(options, num_queries,
+                     [&]() { run(box, capsule, false, false); }));
+  printCase("gjk box capsule distance warm",
+            timeCase(options, num_queries,
+                     [&]() { run(box, capsule, false, true); }));
+  printCase("gjk hull box distance cold",
+            timeCase(options, num_queries,
+                     [&]() { run(hull, box, false, false); }));
+  printCase("gjk hull box distance warm",
+            timeCase(options, num_queries,
+                     [&]() { run(hull, box, false, true); }));
+  printCase("gjk hull box penetration cold",
+            timeCase(options, num_queries,
+                     [&]() { run(hull, box, true, false); }));
+  printCase("gjk hull box penetration warm",
+            timeCase(options, num_queries,
+                     [&]() { run(hull, box, true, true); }));
+  if (std::isnan(total)) {
+    std::cerr << "benchmarks: Shape distances are not numbers.\n";
+  }
+}
+
+void benchmarkConvexHull(const Options& options) {
+  // Hulls of segments of 100k points, inside a ball, with few hull
+  // vertices, and on a sphere, all of them vertices.
+  constexpr std::size_t kNumPoints = 100000;
+  std::mt19937_64 generator(42);
+  std::normal_distribution<double> normal;
+  std::vector<Vector3> ball;
+  std::vector<Vector3> sphere;
+  for (std::size_t i = 0; i < kNumPoints; ++i) {
+    const Vector3 point(normal(generator), normal(generator),
+                        normal(generator));
+    ball.push_back(point);
+    sphere.push_back((1. / point.norm()) * point);
+  }
+  std::size_t vertices = 0;
+  const auto run = [&](const std::vector<Vector3>& points, int num_threads) {
+    vertices += ConvexHull(points, num_threads).numVertices();
+  };
+  printCase("hull ball", timeCase(options, kNumPoints, [&]() {
+              run(ball, 1);
+            }));
+  printCase("hull ball threads", timeCase(options, kNumPoints, [&]() {
+              run(ball, DefaultNumThreads());
+            }));
+  printCase("hull sphere", timeCase(options, kNumPoints, [&]() {
+              run(sphere, 1);
+            }));
+  printCase("hull sphere threads", timeCase(options, kNumPoints, [&]() {
+              run(sphere, DefaultNumThreads());
+            }));
+  if (vertices == 0) {
+    std::cerr << "benchmarks: Hulls have no vertices.\n";
+  }
+}
+
+// Stream buffer that counts and drops what is written.
+class CountingBuffer : public std::streambuf {
+ public:
+  std::size_t count = 0;
+
+ protected:
+  int_type overflow(int_type c) override {
+    ++count;
+    return traits_type::not_eof(c);
+  }
+
+  std::streamsize xsputn(const char*, std::streamsize size) override {
+    count += static_cast<std::size_t>(size);
+    return size;
+  }
+};
+
+// operator<< of Vector3, Matrix3 and Isometry before TextFormat, with
+// streams for every scalar and one ostringstream per matrix row.
+void writeStreams(const Vector3& obj, std::ostream& os) {
+  os << "(x: " << obj.x() << ", y: " << obj.y() << ", z: " << obj.z() << ")";
+}
+
+void writeStreams(const Isometry& obj, std::ostream& os) {
+  const auto row = [](const Vector3& values) {
+    std::ostringstream oss;
+    oss << std::setprecision(9) << "[" << values.x() << ", " << values.y()
+        << ", " << values.z() << "]";
+    return oss.str();
+  };
+  const Matrix3& rotation = obj.rotation();
+  std::ostringstream matrix;
+  matrix << std::setprecision(9) << "[" << row(rotation.row(0)) << ", "
+         << row(rotation.row(1)) << ", " << row(rotation.row(2)) << "]";
+  os << "[T: ";
+  writeStreams(obj.translation(), os);
+  os << ", R:" << matrix.str() << "]";
+}
+
+// Formats 'elements' one per line with the streams of writeStreams(), with
+// operator<< and with WriteLines().
+template <typename T>
+void benchmarkTextFormatOf(const Options& options, const std::string& name,
+                           const std::vector<T>& elements) {
+  CountingBuffer buffer;
+  std::ostream os(&buffer);
+  const auto rate = [&](const std::function<void()>& run) {
+    buffer.count = 0;
+    run();
+    const double bytes = static_cast<double>(buffer.count) / elements.size();
+    return std::make_pair(timeCase(options, elements.size(), run), bytes);
+  };
+  std::pair<double, double> res = rate([&]() {
+    for (const T& element : elements) {
+      writeStreams(element, os);
+      os << '\n';
+    }
+  });
+  printRate("format " + name + " streams", res.first, res.second);
+  res = rate([&]() {
+    for (const T& element : elements) {
+      os << element << '\n';
+    }
+  });
+  printRate("format " + name + " operator<<", res.first, res.second);
+  res = rate([&]() {
+    TextFormat::WriteLines(elements, TextFormat::kStreamPrecision, &os);
+  });
+  printRate("format " + name + " WriteLines", res.first, res.second);
+}
+
+void benchmarkTextFormat(const Options& options) {
+  // The same points and poses as benchmarkTextParser(), in the default
+  // operator<< format, written to a stream that drops them.
+  constexpr std::size_t kNumPoints = 1 << 20;
+  std::mt19937_64 generator(42);
+  std::uniform_real_distribution<double> positions(-50., 50.);
+  std::vector<Vector3> points;
+  std::vector<Isometry> poses;
+  for (std::size_t i = 0; i < kNumPoints; ++i) {
+    points.emplace_back(positions(generator), positions(generator),
+                        positions(generator));
+    if (i % 8 == 0) {
+      poses.push_back(Isometry::FromTranslation(points.back()) *
+                      Isometry::RotateAround(Vector3(1., 2., 3.), 1e-3 * i));
+    }
+  }
+  benchmarkTextFormatOf(options, "points", points);
+  benchmarkTextFormatOf(options, "poses", poses);
+}
+
+void benchmarkTextParser(const Options& options) {
+  // Text points and poses in the round-trip format cpp_course writes, and
+  // points with the 6 digits of operator<<.
+  constexpr std::size_t kNumPoints = 1 << 20;
+  std::mt19937_64 generator(42);
+  std::uniform_real_distribution<double> positions(-50., 50.);
+  std::vector<Vector3> points;
+  std::vector<Isometry> poses;
+  for (std::size_t i = 0; i < kNumPoints; ++i) {
+    points.emplace_back(positions(generator), positions(generator),
+                        positions(generator));
+    if (i % 8 == 0) {
+      poses.push_back(Isometry::FromTranslation(points.back()) *
+                      Isometry::RotateAround(Vector3(1., 2., 3.), 1e-3 * i));
+    }
+  }
+  std::ostringstream point_stream;
+  TextFormat::WriteLines(points, TextFormat::kRoundTrip, &point_stream);
+  const std::string point_text = point_stream.str();
+  std::ostringstream short_stream;
+  TextFormat::WriteLines(points, TextFormat::kStreamPrecision, &short_stream);
+  const std::string short_text = short_stream.str();
+  std::ostringstream pose_stream;
+  TextFormat::WriteLines(poses, TextFormat::kRoundTrip, &pose_stream);
+  const std::string pose_text = pose_stream.str();
+
+  // Calls 'parse(begin, end)' on each line of 'text'.
+  const auto forLines = [](const std::string& text,
+                           const std::function<void(const char*,
+                                                    const char*)>& parse) {
+    const char* begin = text.data();
+    const char* const end = begin + text.size();
+    while (begin != end) {
+      const char* line_end = static_cast<const char*>(
+          std::memchr(begin, '\n', end - begin));
+      parse(begin, line_end);
+      begin = line_end + 1;
+    }
+  };
+  double total = 0.;
+  Vector3 point;
+  Isometry pose;
+  printRate("parse points sscanf",
+            timeCase(options, kNumPoints, [&]() {
+              // sscanf() takes strings, so each line is copied into one.
+              char line[128];
+              forLines(point_text, [&](const char* begin, const char* end) {
+                const std::size_t length =
+                    std::min<std::size_t>(end - begin, sizeof(line) - 1);
+                std::memcpy(line, begin, length);
+                line[length] = '\0';
+                double x, y, z;
+                if (std::sscanf(line, "(x: %lf, y: %lf, z: %lf)", &x, &y,
+                                &z) == 3) {
+                  total += x;
+                }
+              });
+            }),
+            static_cast<double>(point_text.size()) / kNumPoints);
+  printRate("parse points TextParser",
+            timeCase(options, kNumPoints, [&]() {
+              forLines(point_text, [&](const char* begin, const char* end) {
+                if (TextParser::Parse(begin, end, &point).ok()) {
+                  total += point.x();
+                }
+              });
+            }),
+            static_cast<double>(point_text.size()) / kNumPoints);
+  printRate("parse points TextParser 6 digits",
+            timeCase(options, kNumPoints, [&]() {
+              forLines(short_text, [&](const char* begin, const char* end) {
+                if (TextParser::Parse(begin, end, &point).ok()) {
+                  total += point.x();
+                }
+              });
+            }),
+            static_cast<double>(short_text.size()) / kNumPoints);
+  printRate("parse poses TextParser",
+            timeCase(options, poses.size(), [&]() {
+              forLines(pose_text, [&](const char* begin, const char* end) {
+                if (TextParser::Parse(begin, end, &pose).ok()) {
+                  total += pose.translation().x();
+                }
+              });
+            }),
+            static_cast<double>(pose_text.size()) / poses.size());
+  if (std::isnan(total)) {
+    std::cerr << "benchmarks: Parsed numbers are not numbers.\n";
+  }
+}
+
+bool parseCount(const char* text, std::size_t* value) {
+  char* end = nullptr;
+  const long long res = std::strtoll(text, &end, 10);
+  if (*text == '\0' || *end != '\0' || res < 1) {
+    return false;
+  }
+  *value = static_cast<std::size_t>(res);
+  return true;
+}
+}  // namespace
+
+int main(int argc, char** argv) {
+  Options options;
+  for (int i = 1; i < argc; ++i) {
+    const std::string flag = argv[i];
+    if (flag == "-h" || flag == "--help") {
+      std::cout << kUsage;
+      return kSuccess;
+    }
+    std::size_t value = 0;
+    if (i + 1 >= argc || !parseCount(argv[++i], &value)) {
+      std::cerr << "benchmarks: Invalid option '" << flag << "'.\n\n"
+                << kUsage;
+      return kUsageError;
+    }
+    if (flag == "--points") {
+      options.points = value;
+    } else if (flag == "--indices") {
+      options.indices = value;
+    } else if (flag == "--repetitions") {
+      options.repetitions = static_cast<int>(value);
+    } else {
+      std::cerr << "benchmarks: Unknown option '" << flag << "'.\n\n"
+                << kUsage;
+      return kUsageError;
+    }
+  }
+
+  benchmarkIndexed(options);
+  benchmarkFilter(options);
+  benchmarkPipeline(options);
+  benchmarkLayouts(options);
+  benchmarkMorton(options);
+  benchmarkBvh(options);
+  benchmarkBoxes(options);
+  benchmarkRays(options);
+  benchmarkSweepAndPrune(options);
+  benchmarkGjk(options);
+  benchmarkConvexHull(options);
+  benchmarkTextFormat(options);
+  benchmarkTextParser(options);
+  return kSuccess;
+}
@@ -0,0 +1,252 @@
+#include "binary_io.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+namespace ekumen {
+namespace math {
+namespace {
+constexpr char kMagic[4] = {'E', 'K', 'M', 'A'};
+
+// Mappings smaller than a transparent huge page do not ask for them.
+constexpr std::size_t kHugePageSize = 2 << 20;
+
+bool isLittleEndian() {
+  const std::uint16_t value = 1;
+  unsigned char first;
+  std::memcpy(&first, &value, 1);
+  return first == 1;
+}
+
+// Encodes 'size' bytes of 'value' in little-endian order.
+void encode(std::uint64_t value, std::size_t size, unsigned char* bytes) {
+  for (std::size_t i = 0; i < size; ++i) {
+    bytes[i] = static_cast<unsigned char>(value >> (8 * i));
+  }
+}
+
+std::uint64_t decode(const unsigned char* bytes, std::size_t size) {
+  std::uint64_t value = 0;
+  for (std::size_t i = 0; i < size; ++i) {
+    value |= static_cast<std::uint64_t>(bytes[i]) << (8 * i);
+  }
+  return value;
+}
+
+std::runtime_error systemError(const std::string& message,
+                               const std::string& path) {
+  return std::runtime_error(message + " '" + path + "': " +
+                            std::strerror(errno));
+}
+
+int scalarsPerElement(BinaryType type) {
+  switch (type) {
+    case BinaryType::kVector3:
+      return BinaryTraits<Vector3>::kScalars;
+    case BinaryType::kMatrix3:
+      return BinaryTraits<Matrix3>::kScalars;
+    case BinaryType::kIsometry:
+      return BinaryTraits<Isometry>::kScalars;
+  }
+  throw std::runtime_error("Unknown binary element type.");
+}
+
+// Decodes and validates the BinaryHeader::kSize bytes of a header.
+BinaryHeader decodeHeader(const unsigned char* bytes) {
+  if (std::memcmp(bytes, kMagic, sizeof(kMagic)) != 0) {
+    throw std::runtime_error("Invalid binary file magic.");
+  }
+  if (decode(bytes + 4, 2) != BinaryHeader::kVersion) {
+    throw std::runtime_error("Unsupported binary file version.");
+  }
+  BinaryHeader header;
+  header.type = static_cast<BinaryType>(bytes[6]);
+  header.scalar_width = bytes[7];
+  header.count = decode(bytes + 8, 8);
+  if (header.scalar_width != sizeof(double)) {
+    throw std::runtime_error("Unsupported binary file scalar width.");
+  }
+  // Rejects unknown types.
+  scalarsPerElement(header.type);
+  return header;
+}
+}  // namespace
+
+const std::size_t BinaryHeader::kSize;
+const std::uint16_t BinaryHeader::kVersion;
+
+MappedFile::MappedFile(const std::string& path) : data_(nullptr), size_(0) {
+  const int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    throw systemError("Cannot open", path);
+  }
+  struct stat status;
+  if (::fstat(fd, &status) != 0) {
+    const std::runtime_error error = systemError("Cannot stat", path);
+    ::close(fd);
+    throw error;
+  }
+  size_ = static_cast<std::size_t>(status.st_size);
+  // Empty files cannot be mapped, and have no data to view anyway.
+  if (size_ > 0) {
+    void* data = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (data == MAP_FAILED) {
+      const std::runtime_error error = systemError("Cannot map", path);
+      ::close(fd);
+      throw error;
+    }
+    data_ = data;
+  }
+  // The mapping keeps its own reference to the file.
+  ::close(fd);
+}
+
+MappedFile::MappedFile(MappedFile&& obj) : data_(obj.data_), size_(obj.size_) {
+  obj.data_ = nullptr;
+  obj.size_ = 0;
+}
+
+MappedFile::~MappedFile() { unmap(); }
+
+MappedFile& MappedFile::operator=(MappedFile&& obj) {
+  if (this != &obj) {
+    unmap();
+    data_ = obj.data_;
+    size_ = obj.size_;
+    obj.data_ = nullptr;
+    obj.size_ = 0;
+  }
+  return *this;
+}
+
+const unsigned char* MappedFile::data() const {
+  return static_cast<const unsigned char*>(data_);
+}
+
+std::size_t MappedFile::size() const { return size_; }
+
+void MappedFile::adviseSequential() const {
+  if (data_ == nullptr) {
+    return;
+  }
+  ::madvise(data_, size_, MADV_SEQUENTIAL);
+  ::madvise(data_, size_, MADV_WILLNEED);
+#ifdef MADV_HUGEPAGE
+  if (size_ >= kHugePageSize) {
+    ::madvise(data_, size_, MADV_HUGEPAGE);
+  }
+#endif
+}
+
+void MappedFile::unmap() {
+  if (data_ != nullptr) {
+    ::munmap(data_, size_);
+    data_ = nullptr;
+    size_ = 0;
+  }
+}
+
+BinaryFile::BinaryFile(const std::string& path) : file_(path) {
+  if (!isLittleEndian()) {
+    throw std::runtime_error(
+        "Binary files can only be mapped on little-endian hosts.");
+  }
+  const unsigned char* bytes = file_.data();
+  if (file_.size() < BinaryHeader::kSize) {
+    throw std::runtime_error("Truncated binary file header.");
+  }
+  header_ = decodeHeader(bytes);
+
+  const std::uint64_t element_size =
+      scalarsPerElement(header_.type) * sizeof(double);
+  const std::uint64_t payload_size = file_.size() - BinaryHeader::kSize;
+  if (header_.count > payload_size / element_size ||
+      header_.count * element_size != payload_size) {
+    throw std::runtime_error("Binary file size does not match its header.");
+  }
+}
+
+const BinaryHeader& BinaryFile::header() const { return header_; }
+
+const double* BinaryFile::payload() const {
+  return reinterpret_cast<const double*>(file_.data() + BinaryHeader::kSize);
+}
+
+BinaryReader::BinaryReader(std::istream* is) : is_(is) {
+  unsigned char bytes[BinaryHeader::kSize];
+  is_->read(reinterpret_cast<char*>(bytes), sizeof(bytes));
+  if (is_->gcount() != static_cast<std::streamsize>(sizeof(bytes))) {
+    throw std::runtime_error("Truncated binary file header.");
+  }
+  header_ = decodeHeader(bytes);
+  remaining_ = header_.count;
+}
+
+const BinaryHeader& BinaryReader::header() const { return header_; }
+
+void BinaryReader::readScalars(double* data, std::size_t size) {
+  const std::streamsize bytes =
+      static_cast<std::streamsize>(size * sizeof(double));
+  is_->read(reinterpret_cast<char*>(data), bytes);
+  if (is_->gcount() != bytes) {
+    throw std::runtime_error("Truncated binary array payload.");
+  }
+  if (!isLittleEndian()) {
+    for (std::size_t i = 0; i < size; ++i) {
+      const std::uint64_t bits =
+          decode(reinterpret_cast<const unsigned char*>(data + i), 8);
+      std::memcpy(data + i, &bits, sizeof(bits));
+    }
+  }
+}
+
+void BinaryWriter::writeHeader(const BinaryHeader& header, std::ostream* os) {
+  unsigned char bytes[BinaryHeader::kSize];
+  std::memcpy(bytes, kMagic, sizeof(kMagic));
+  encode(BinaryHeader::kVersion, 2, bytes + 4);
+  bytes[6] = static_cast<unsigned char>(header.type);
+  bytes[7] = header.scalar_width;
+  encode(header.count, 8, bytes + 8);
+  os->write(reinterpret_cast<const char*>(bytes), sizeof(bytes));
+  if (!*os) {
+    throw std::runtime_error("Cannot write binary file header.");
+  }
+}
+
+void BinaryWriter::writeScalars(const double* data, std::size_t size,
+                                std::ostream* os) {
+  if (isLittleEndian()) {
+    os->write(reinterpret_cast<const char*>(data), size * sizeof(double));
+  } else {
+    for (std::size_t i = 0; i < size; ++i) {
+      std::uint64_t bits;
+      std::memcpy(&bits, data + i, sizeof(bits));
+      unsigned char bytes[sizeof(bits)];
+      encode(bits, sizeof(bits), bytes);
+      os->write(reinterpret_cast<const char*>(bytes), sizeof(bytes));
+    }
+  }
+  if (!*os) {
+    throw std::runtime_error("Cannot write binary file payload.");
+  }
+}
+
+void BinaryWriter::openFile(const std::string& path, std::ofstream* os) {
+  os->open(path, std::ios::binary | std::ios::trunc);
+  if (!*os) {
+    throw systemError("Cannot create", path);
+  }
+}
+
+}  // namespace math
+}  // namespace ekumen
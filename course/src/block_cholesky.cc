@@ -0,0 +1,281 @@
+#include "block_cholesky.h"
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <iterator>
+#include <queue>
+#include <stdexcept>
+
+namespace ekumen {
+namespace math {
+namespace {
+constexpr int kSize = BlockCholesky::kBlockSize;
+
+typedef BlockCholesky::Block Block;
+
+// Factorizes a symmetric positive definite block in place, leaving its lower
+// triangular Cholesky factor. Returns false when the block is not positive
+// definite.
+bool factorizeBlock(Block* block) {
+  double* a = block->data();
+  for (auto j = 0; j < kSize; ++j) {
+    double diagonal = a[kSize * j + j];
+    for (auto k = 0; k < j; ++k) {
+      diagonal -= a[kSize * j + k] * a[kSize * j + k];
+    }
+    if (!(diagonal > 0.)) {
+      return false;
+    }
+    const double l_jj = std::sqrt(diagonal);
+    a[kSize * j + j] = l_jj;
+    for (auto i = j + 1; i < kSize; ++i) {
+      double value = a[kSize * i + j];
+      for (auto k = 0; k < j; ++k) {
+        value -= a[kSize * i + k] * a[kSize * j + k];
+      }
+      a[kSize * i + j] = value / l_jj;
+      a[kSize * j + i] = 0.;
+    }
+  }
+  return true;
+}
+
+// Solves l * y = x in place, 'l' being lower triangular.
+void forwardSubstitution(const Block& block, double* x) {
+  const double* l = block.data();
+  for (auto i = 0; i < kSize; ++i) {
+    double value = x[i];
+    for (auto k = 0; k < i; ++k) {
+      value -= l[kSize * i + k] * x[k];
+    }
+    x[i] = value / l[kSize * i + i];
+  }
+}
+
+// Solves l^T * y = x in place, 'l' being lower triangular.
+void backwardSubstitution(const Block& block, double* x) {
+  const double* l = block.data();
+  for (auto i = kSize - 1; i >= 0; --i) {
+    double value = x[i];
+    for (auto k = i + 1; k < kSize; ++k) {
+      value -= l[kSize * k + i] * x[k];
+    }
+    x[i] = value / l[kSize * i + i];
+  }
+}
+
+// Computes a -= b * c^T.
+void subtractProductTransposed(const Block& b, const Block& c, Block* a) {
+  for (auto i = 0; i < kSize; ++i) {
+    for (auto j = 0; j < kSize; ++j) {
+      double value = 0.;
+      for (auto k = 0; k < kSize; ++k) {
+        value += b(i, k) * c(j, k);
+      }
+      (*a)(i, j) -= value;
+    }
+  }
+}
+}  // namespace
+
+const int BlockCholesky::kBlockSize;
+
+void BlockCholesky::Analyze(
+    int num_blocks, const std::vector<std::pair<int, int>>& off_diagonal) {
+  std::vector<std::vector<int>> adjacency(num_blocks);
+  for (const auto& pair : off_diagonal) {
+    if (pair.first < 0 || pair.first >= num_blocks || pair.second < 0 ||
+        pair.second >= num_blocks) {
+      throw std::out_of_range("Block index out of range.");
+    }
+    if (pair.first != pair.second) {
+      adjacency[pair.first].push_back(pair.second);
+      adjacency[pair.second].push_back(pair.first);
+    }
+  }
+  for (auto& neighbors : adjacency) {
+    std::sort(neighbors.begin(), neighbors.end());
+    neighbors.erase(std::unique(neighbors.begin(), neighbors.end()),
+                    neighbors.end());
+  }
+
+  // Greedy minimum degree ordering on the elimination graph. The neighbors of
+  // a block when it is eliminated are exactly the rows of its factor column.
+  typedef std::pair<std::size_t, int> DegreeEntry;
+  std::priority_queue<DegreeEntry, std::vector<DegreeEntry>,
+                      std::greater<DegreeEntry>>
+      queue;
+  for (auto i = 0; i < num_blocks; ++i) {
+    queue.push(DegreeEntry(adjacency[i].size(), i));
+  }
+  std::vector<bool> eliminated(num_blocks, false);
+  std::vector<std::vector<int>> patterns(num_blocks);
+  order_.clear();
+  order_.reserve(num_blocks);
+  std::vector<int> merged;
+  while (!queue.empty()) {
+    const DegreeEntry entry = queue.top();
+    queue.pop();
+    const int v = entry.second;
+    if (eliminated[v] || entry.first != adjacency[v].size()) {
+      continue;
+    }
+    eliminated[v] = true;
+    order_.push_back(v);
+    patterns[v].swap(adjacency[v]);
+    const std::vector<int>& clique = patterns[v];
+    for (const int u : clique) {
+      merged.clear();
+      std::set_union(adjacency[u].begin(), adjacency[u].end(), clique.begin(),
+                     clique.end(), std::back_inserter(merged));
+      adjacency[u].clear();
+      for (const int w : merged) {
+        if (w != u && w != v) {
+          adjacency[u].push_back(w);
+        }
+      }
+      queue.push(DegreeEntry(adjacency[u].size(), u));
+    }
+  }
+
+  position_.assign(num_blocks, 0);
+  for (auto k = 0; k < num_blocks; ++k) {
+    position_[order_[k]] = k;
+  }
+  column_offsets_.assign(num_blocks + 1, 0);
+  column_rows_.clear();
+  for (auto k = 0; k < num_blocks; ++k) {
+    const std::size_t begin = column_rows_.size();
+    for (const int u : patterns[order_[k]]) {
+      column_rows_.push_back(position_[u]);
+    }
+    std::sort(column_rows_.begin() + begin, column_rows_.end());
+    column_offsets_[k + 1] = column_rows_.size();
+  }
+  diagonal_.resize(num_blocks);
+  values_.resize(column_rows_.size());
+  SetZero();
+}
+
+void BlockCholesky::SetZero() {
+  for (auto& block : diagonal_) {
+    block = Block::Zero();
+  }
+  for (auto& block : values_) {
+    block = Block::Zero();
+  }
+}
+
+void BlockCholesky::AddToDiagonal(int i, const Block& block) {
+  diagonal_[position_.at(i)] += block;
+}
+
+void BlockCholesky::AddToOffDiagonal(int i, int j, const Block& block) {
+  const int p = position_.at(i);
+  const int q = position_.at(j);
+  if (p > q) {
+    values_[slot(p, q)] += block;
+  } else {
+    values_[slot(q, p)] += block.transpose();
+  }
+}
+
+bool BlockCholesky::Factorize() {
+  const int n = numBlocks();
+  for (auto c = 0; c < n; ++c) {
+    if (!factorizeBlock(&diagonal_[c])) {
+      return false;
+    }
+    const Block& l_cc = diagonal_[c];
+    const std::size_t begin = column_offsets_[c];
+    const std::size_t end = column_offsets_[c + 1];
+
+    // L_rc = A_rc * L_cc^-T, row by row.
+    for (auto s = begin; s < end; ++s) {
+      for (auto r = 0; r < kSize; ++r) {
+        forwardSubstitution(l_cc, values_[s].data() + kSize * r);
+      }
+    }
+
+    // Updates the trailing matrix: A_ab -= L_ac * L_bc^T for every pair of
+    // rows a >= b of the column. Rows are sorted, so the target blocks of a
+    // fixed b are found by walking column b forward.
+    for (auto b = begin; b < end; ++b) {
+      const int row_b = column_rows_[b];
+      subtractProductTransposed(values_[b], values_[b], &diagonal_[row_b]);
+      std::size_t target = column_offsets_[row_b];
+      for (auto a = b + 1; a < end; ++a) {
+        const int row_a = column_rows_[a];
+        while (column_rows_[target] != row_a) {
+          ++target;
+        }
+        subtractProductTransposed(values_[a], values_[b], &values_[target]);
+      }
+    }
+  }
+  return true;
+}
+
+void BlockCholesky::Solve(const std::vector<double>& rhs,
+                          std::vector<double>* x) const {
+  const int n = numBlocks();
+  std::vector<double> work(kSize * n);
+  for (auto k = 0; k < n; ++k) {
+    std::copy(rhs.begin() + kSize * order_[k],
+              rhs.begin() + kSize * (order_[k] + 1),
+              work.begin() + kSize * k);
+  }
+
+  // L * y = rhs.
+  for (auto c = 0; c < n; ++c) {
+    double* w_c = work.data() + kSize * c;
+    forwardSubstitution(diagonal_[c], w_c);
+    for (auto s = column_offsets_[c]; s < column_offsets_[c + 1]; ++s) {
+      double* w_r = work.data() + kSize * column_rows_[s];
+      const Block& l = values_[s];
+      for (auto i = 0; i < kSize; ++i) {
+        for (auto j = 0; j < kSize; ++j) {
+          w_r[i] -= l(i, j) * w_c[j];
+        }
+      }
+    }
+  }
+
+  // L^T * x = y.
+  for (auto c = n - 1; c >= 0; --c) {
+    double* w_c = work.data() + kSize * c;
+    for (auto s = column_offsets_[c]; s < column_offsets_[c + 1]; ++s) {
+      const double* w_r = work.data() + kSize * column_rows_[s];
+      const Block& l = values_[s];
+      for (auto i = 0; i < kSize; ++i) {
+        for (auto j = 0; j < kSize; ++j) {
+          w_c[j] -= l(i, j) * w_r[i];
+        }
+      }
+    }
+    backwardSubstitution(diagonal_[c], w_c);
+  }
+
+  x->resize(kSize * n);
+  for (auto k = 0; k < n; ++k) {
+    std::copy(work.begin() + kSize * k, work.begin() + kSize * (k + 1),
+              x->begin() + kSize * order_[k]);
+  }
+}
+
+int BlockCholesky::numBlocks() const { return static_cast<int>(order_.size()); }
+
+std::size_t BlockCholesky::numFactorBlocks() const { return values_.size(); }
+
+std::size_t BlockCholesky::slot(int row, int col) const {
+  const auto begin = column_rows_.begin() + column_offsets_[col];
+  const auto end = column_rows_.begin() + column_offsets_[col + 1];
+  const auto it = std::lower_bound(begin, end, row);
+  if (it == end || *it != row) {
+    throw std::out_of_range("Block is not part of the analyzed pattern.");
+  }
+  return it - column_rows_.begin();
+}
+
+}  // namespace math
+}  // namespace ekumen
@@ -0,0 +1,205 @@
+#include "blocked_point_cloud.h"
+
+#include <cmath>
+#include <stdexcept>
+#include <vector>
+#include "isometry.h"
+#include "matrix3.h"
+#include "point_cloud.h"
+#include "vector3.h"
+
+namespace ekumen {
+namespace math {
+namespace {
+constexpr std::size_t kBlockSize = BlockedPointCloud::kBlockSize;
+
+std::size_t blocksFor(std::size_t size) {
+  return (size + kBlockSize - 1) / kBlockSize;
+}
+}  // namespace
+
+const std::size_t BlockedPointCloud::kBlockSize;
+
+BlockedPointCloud::BlockedPointCloud(std::size_t size) { resize(size); }
+
+BlockedPointCloud::BlockedPointCloud(const std::vector<Vector3>& points) {
+  resize(points.size());
+  for (std::size_t i = 0; i < points.size(); ++i) {
+    setPoint(i, points[i]);
+  }
+}
+
+BlockedPointCloud::BlockedPointCloud(const PointCloud& cloud) {
+  resize(cloud.size());
+  for (std::size_t i = 0; i < cloud.size(); ++i) {
+    Block& block = blocks_[i / kBlockSize];
+    block.x[i % kBlockSize] = cloud.x()[i];
+    block.y[i % kBlockSize] = cloud.y()[i];
+    block.z[i % kBlockSize] = cloud.z()[i];
+  }
+}
+
+std::size_t BlockedPointCloud::size() const { return size_; }
+
+bool BlockedPointCloud::empty() const { return size_ == 0; }
+
+void BlockedPointCloud::reserve(std::size_t capacity) {
+  blocks_.reserve(blocksFor(capacity));
+}
+
+void BlockedPointCloud::resize(std::size_t size) {
+  // Padding lanes of the last block may hold kernel results, so they are
+  // cleared before they become points.
+  const std::size_t old_lanes = blocks_.size() * kBlockSize;
+  blocks_.resize(blocksFor(size), Block{{0.}, {0.}, {0.}});
+  for (std::size_t i = size_; i < size && i < old_lanes; ++i) {
+    Block& block = blocks_[i / kBlockSize];
+    block.x[i % kBlockSize] = 0.;
+    block.y[i % kBlockSize] = 0.;
+    block.z[i % kBlockSize] = 0.;
+  }
+  size_ = size;
+}
+
+void BlockedPointCloud::clear() { resize(0); }
+
+void BlockedPointCloud::push_back(const Vector3& point) {
+  resize(size_ + 1);
+  setPoint(size_ - 1, point);
+}
+
+Vector3 BlockedPointCloud::point(std::size_t index) const {
+  assertValidAccessIndex(index);
+  const Block& block = blocks_[index / kBlockSize];
+  const std::size_t lane = index % kBlockSize;
+  return Vector3(block.x[lane], block.y[lane], block.z[lane]);
+}
+
+void BlockedPointCloud::setPoint(std::size_t index, const Vector3& point) {
+  assertValidAccessIndex(index);
+  Block& block = blocks_[index / kBlockSize];
+  const std::size_t lane = index % kBlockSize;
+  block.x[lane] = point.x();
+  block.y[lane] = point.y();
+  block.z[lane] = point.z();
+}
+
+std::size_t BlockedPointCloud::numBlocks() const { return blocks_.size(); }
+
+const BlockedPointCloud::Block* BlockedPointCloud::blocks() const {
+  return blocks_.data();
+}
+
+BlockedPointCloud::Block* BlockedPointCloud::blocks() {
+  return blocks_.data();
+}
+
+PointCloud BlockedPointCloud::toPointCloud() const {
+  PointCloud res(size_);
+  for (std::size_t i = 0; i < size_; ++i) {
+    const Block& block = blocks_[i / kBlockSize];
+    res.x()[i] = block.x[i % kBlockSize];
+    res.y()[i] = block.y[i % kBlockSize];
+    res.z()[i] = block.z[i % kBlockSize];
+  }
+  return res;
+}
+
+// The kernels loop over whole blocks, with inner loops of a fixed length
+// that the compiler unrolls into SIMD instructions.
+void BlockedPointCloud::transform(const Isometry& pose) {
+  const Matrix3& r = pose.rotation();
+  const Vector3& t = pose.translation();
+  const double r00 = r[0][0], r01 = r[0][1], r02 = r[0][2];
+  const double r10 = r[1][0], r11 = r[1][1], r12 = r[1][2];
+  const double r20 = r[2][0], r21 = r[2][1], r22 = r[2][2];
+  const double tx = t.x(), ty = t.y(), tz = t.z();
+  for (Block& block : blocks_) {
+    for (std::size_t i = 0; i < kBlockSize; ++i) {
+      const double px = block.x[i];
+      const double py = block.y[i];
+      const double pz = block.z[i];
+      block.x[i] = r00 * px + r01 * py + r02 * pz + tx;
+      block.y[i] = r10 * px + r11 * py + r12 * pz + ty;
+      block.z[i] = r20 * px + r21 * py + r22 * pz + tz;
+    }
+  }
+}
+
+void BlockedPointCloud::dot(const BlockedPointCloud& obj,
+                            std::vector<double>* res) const {
+  assertSameSize(obj);
+  res->resize(blocks_.size() * kBlockSize);
+  double* out = res->data();
+  for (std::size_t b = 0; b < blocks_.size(); ++b, out += kBlockSize) {
+    const Block& lhs = blocks_[b];
+    const Block& rhs = obj.blocks_[b];
+    for (std::size_t i = 0; i < kBlockSize; ++i) {
+      out[i] = lhs.x[i] * rhs.x[i] + lhs.y[i] * rhs.y[i] + lhs.z[i] * rhs.z[i];
+    }
+  }
+  res->resize(size_);
+}
+
+void BlockedPointCloud::cross(const BlockedPointCloud& obj,
+                              BlockedPointCloud* res) const {
+  assertSameSize(obj);
+  res->resize(size_);
+  for (std::size_t b = 0; b < blocks_.size(); ++b) {
+    const Block& lhs = blocks_[b];
+    const Block& rhs = obj.blocks_[b];
+    Block& out = res->blocks_[b];
+    // Copies, as 'out' may alias an operand.
+    Block c;
+    for (std::size_t i = 0; i < kBlockSize; ++i) {
+      c.x[i] = lhs.y[i] * rhs.z[i] - lhs.z[i] * rhs.y[i];
+      c.y[i] = lhs.z[i] * rhs.x[i] - lhs.x[i] * rhs.z[i];
+      c.z[i] = lhs.x[i] * rhs.y[i] - lhs.y[i] * rhs.x[i];
+    }
+    out = c;
+  }
+}
+
+void BlockedPointCloud::norm(std::vector<double>* res) const {
+  res->resize(blocks_.size() * kBlockSize);
+  double* out = res->data();
+  for (std::size_t b = 0; b < blocks_.size(); ++b, out += kBlockSize) {
+    const Block& block = blocks_[b];
+    for (std::size_t i = 0; i < kBlockSize; ++i) {
+      out[i] = std::sqrt(block.x[i] * block.x[i] + block.y[i] * block.y[i] +
+                         block.z[i] * block.z[i]);
+    }
+  }
+  res->resize(size_);
+}
+
+bool BlockedPointCloud::operator==(const BlockedPointCloud& rhs) const {
+  if (size() != rhs.size()) {
+    return false;
+  }
+  for (std::size_t i = 0; i < size(); ++i) {
+    if (point(i) != rhs.point(i)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool BlockedPointCloud::operator!=(const BlockedPointCloud& rhs) const {
+  return !(*this == rhs);
+}
+
+void BlockedPointCloud::assertValidAccessIndex(std::size_t index) const {
+  if (index >= size_) {
+    throw std::out_of_range("Index to access a point is out of range.");
+  }
+}
+
+void BlockedPointCloud::assertSameSize(const BlockedPointCloud& obj) const {
+  if (obj.size_ != size_) {
+    throw std::invalid_argument("Point clouds must have the same size.");
+  }
+}
+
+}  // namespace math
+}  // namespace ekumen
@@ -0,0 +1,265 @@
+#include "box_set.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+#include "aabb.h"
+#include "cpu_features.h"
+#include "obb.h"
+#include "vector3.h"
+
+namespace ekumen {
+namespace math {
+namespace {
+// Boxes tested before their indices are gathered, so that the flags stay
+// in the L1 cache.
+constexpr std::size_t kBlockSize = 512;
+
+// Same tolerance as Obb::overlaps().
+constexpr double kParallelTolerance = 1e-12;
+
+// Bounds of the boxes of a set.
+struct Columns {
+  const double* min[3];
+  const double* max[3];
+};
+
+// Query box as its center, half extents and axes, the columns of 'axes'.
+struct OrientedQuery {
+  double center[3];
+  double half[3];
+  double axes[3][3];
+};
+
+// Flags the boxes in [begin; end) that overlap the box [low; high]. The
+// bounds are read into locals, which the flags cannot alias.
+inline void aabbLoop(const Columns& boxes, const double* low,
+                     const double* high, std::size_t begin, std::size_t end,
+                     std::uint8_t* flags) {
+  const double* min_x = boxes.min[0];
+  const double* min_y = boxes.min[1];
+  const double* min_z = boxes.min[2];
+  const double* max_x = boxes.max[0];
+  const double* max_y = boxes.max[1];
+  const double* max_z = boxes.max[2];
+  const double low_x = low[0];
+  const double low_y = low[1];
+  const double low_z = low[2];
+  const double high_x = high[0];
+  const double high_y = high[1];
+  const double high_z = high[2];
+  for (std::size_t i = begin; i < end; ++i) {
+    flags[i - begin] = !(min_x[i] > high_x) & !(low_x > max_x[i]) &
+                       !(min_y[i] > high_y) & !(low_y > max_y[i]) &
+                       !(min_z[i] > high_z) & !(low_z > max_z[i]);
+  }
+}
+
+// Flags the boxes in [begin; end) that overlap 'query', with the tests of
+// Obb::overlaps() for a second box with identity axes: the rotation terms
+// are the query axes, the same for every box.
+inline void obbLoop(const Columns& boxes, const OrientedQuery& query,
+                    std::size_t begin, std::size_t end, std::uint8_t* flags) {
+  double r[3][3];
+  double abs_r[3][3];
+  for (int i = 0; i < 3; ++i) {
+    for (int j = 0; j < 3; ++j) {
+      r[i][j] = query.axes[j][i];
+      abs_r[i][j] = std::abs(r[i][j]) + kParallelTolerance;
+    }
+  }
+  const double a[3] = {query.half[0], query.half[1], query.half[2]};
+  const double center[3] = {query.center[0], query.center[1],
+                            query.center[2]};
+  const double* min_x = boxes.min[0];
+  const double* min_y = boxes.min[1];
+  const double* min_z = boxes.min[2];
+  const double* max_x = boxes.max[0];
+  const double* max_y = boxes.max[1];
+  const double* max_z = boxes.max[2];
+  for (std::size_t k = begin; k < end; ++k) {
+    const double b[3] = {0.5 * (max_x[k] - min_x[k]),
+                         0.5 * (max_y[k] - min_y[k]),
+                         0.5 * (max_z[k] - min_z[k])};
+    const double offset[3] = {0.5 * (min_x[k] + max_x[k]) - center[0],
+                              0.5 * (min_y[k] + max_y[k]) - center[1],
+                              0.5 * (min_z[k] + max_z[k]) - center[2]};
+    // Offset in the frame of the query.
+    double t[3];
+    for (int i = 0; i < 3; ++i) {
+      t[i] = r[i][0] * offset[0] + r[i][1] * offset[1] + r[i][2] * offset[2];
+    }
+    bool overlap = (b[0] >= 0.) & (b[1] >= 0.) & (b[2] >= 0.);
+    for (int i = 0; i < 3; ++i) {
+      overlap &= !(std::abs(t[i]) > a[i] + b[0] * abs_r[i][0] +
+                                        b[1] * abs_r[i][1] +
+                                        b[2] * abs_r[i][2]);
+    }
+    for (int j = 0; j < 3; ++j) {
+      overlap &=
+          !(std::abs(t[0] * r[0][j] + t[1] * r[1][j] + t[2] * r[2][j]) >
+            a[0] * abs_r[0][j] + a[1] * abs_r[1][j] + a[2] * abs_r[2][j] +
+                b[j]);
+    }
+    for (int i = 0; i < 3; ++i) {
+      const int i1 = (i + 1) % 3;
+      const int i2 = (i + 2) % 3;
+      for (int j = 0; j < 3; ++j) {
+        const int j1 = (j + 1) % 3;
+        const int j2 = (j + 2) % 3;
+        overlap &= !(std::abs(t[i2] * r[i1][j] - t[i1] * r[i2][j]) >
+                     a[i1] * abs_r[i2][j] + a[i2] * abs_r[i1][j] +
+                         b[j1] * abs_r[i][j2] + b[j2] * abs_r[i][j1]);
+      }
+    }
+    flags[k - begin] = overlap;
+  }
+}
+
+#ifdef EKUMEN_AVX2_DISPATCH
+EKUMEN_TARGET_AVX2 void aabbLoopAvx2(
+    const Columns& boxes, const double* low, const double* high,
+    std::size_t begin, std::size_t end, std::uint8_t* flags) {
+  aabbLoop(boxes, low, high, begin, end, flags);
+}
+
+EKUMEN_TARGET_AVX2 void obbLoopAvx2(
+    const Columns& boxes, const OrientedQuery& query, std::size_t begin,
+    std::size_t end, std::uint8_t* flags) {
+  obbLoop(boxes, query, begin, end, flags);
+}
+#endif
+
+// Runs 'test(begin, end, flags)' over blocks of 'size' boxes and sets 'res'
+// to the indices flagged, without branches on the flags.
+template <typename Test>
+void gather(std::size_t size, Test test, std::vector<std::uint32_t>* res) {
+  res->resize(size);
+  std::uint32_t* out = res->data();
+  std::uint8_t flags[kBlockSize];
+  std::size_t count = 0;
+  for (std::size_t begin = 0; begin < size; begin += kBlockSize) {
+    const std::size_t end = std::min(size, begin + kBlockSize);
+    test(begin, end, flags);
+    for (std::size_t i = begin; i < end; ++i) {
+      out[count] = static_cast<std::uint32_t>(i);
+      count += flags[i - begin];
+    }
+  }
+  res->resize(count);
+}
+}  // namespace
+
+BoxSet::BoxSet(const std::vector<Aabb>& boxes) {
+  reserve(boxes.size());
+  for (const Aabb& box : boxes) {
+    push_back(box);
+  }
+}
+
+std::size_t BoxSet::size() const { return min_[0].size(); }
+
+bool BoxSet::empty() const { return min_[0].empty(); }
+
+void BoxSet::reserve(std::size_t capacity) {
+  for (int i = 0; i < 3; ++i) {
+    min_[i].reserve(capacity);
+    max_[i].reserve(capacity);
+  }
+}
+
+void BoxSet::clear() {
+  for (int i = 0; i < 3; ++i) {
+    min_[i].clear();
+    max_[i].clear();
+  }
+}
+
+void BoxSet::push_back(const Aabb& box) {
+  for (int i = 0; i < 3; ++i) {
+    min_[i].push_back(box.min[i]);
+    max_[i].push_back(box.max[i]);
+  }
+}
+
+Aabb BoxSet::box(std::size_t index) const {
+  assertValidAccessIndex(index);
+  return Aabb(Vector3(min_[0][index], min_[1][index], min_[2][index]),
+              Vector3(max_[0][index], max_[1][index], max_[2][index]));
+}
+
+void BoxSet::setBox(std::size_t index, const Aabb& box) {
+  assertValidAccessIndex(index);
+  for (int i = 0; i < 3; ++i) {
+    min_[i][index] = box.min[i];
+    max_[i][index] = box.max[i];
+  }
+}
+
+void BoxSet::overlapping(const Aabb& query,
+                         std::vector<std::uint32_t>* res) const {
+  const Columns boxes = {{min_[0].data(), min_[1].data(), min_[2].data()},
+                         {max_[0].data(), max_[1].data(), max_[2].data()}};
+  const double low[3] = {query.min.x(), query.min.y(), query.min.z()};
+  const double high[3] = {query.max.x(), query.max.y(), query.max.z()};
+#ifdef EKUMEN_AVX2_DISPATCH
+  if (CpuHasAvx2()) {
+    gather(size(),
+           [&](std::size_t begin, std::size_t end, std::uint8_t* flags) {
+             aabbLoopAvx2(boxes, low, high, begin, end, flags);
+           },
+           res);
+    return;
+  }
+#endif
+  gather(size(),
+         [&](std::size_t begin, std::size_t end, std::uint8_t* flags) {
+           aabbLoop(boxes, low, high, begin, end, flags);
+         },
+         res);
+}
+
+void BoxSet::overlapping(const Obb& query,
+                         std::vector<std::uint32_t>* res) const {
+  if (query.empty()) {
+    res->clear();
+    return;
+  }
+  const Columns boxes = {{min_[0].data(), min_[1].data(), min_[2].data()},
+                         {max_[0].data(), max_[1].data(), max_[2].data()}};
+  OrientedQuery oriented;
+  for (int i = 0; i < 3; ++i) {
+    oriented.center[i] = query.center[i];
+    oriented.half[i] = query.half_extents[i];
+    for (int j = 0; j < 3; ++j) {
+      oriented.axes[i][j] = query.axes[i][j];
+    }
+  }
+#ifdef EKUMEN_AVX2_DISPATCH
+  if (CpuHasAvx2()) {
+    gather(size(),
+           [&](std::size_t begin, std::size_t end, std::uint8_t* flags) {
+             obbLoopAvx2(boxes, oriented, begin, end, flags);
+           },
+           res);
+    return;
+  }
+#endif
+  gather(size(),
+         [&](std::size_t begin, std::size_t end, std::uint8_t* flags) {
+           obbLoop(boxes, oriented, begin, end, flags);
+         },
+         res);
+}
+
+void BoxSet::assertValidAccessIndex(std::size_t index) const {
+  if (index >= size()) {
+    throw std::out_of_range("Index to access a box is out of range.");
+  }
+}
+
+}  // namespace math
+}  // namespace ekumen
@@ -0,0 +1,381 @@
+#include "bvh.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+#include "aabb.h"
+#include "vector3.h"
+
+namespace ekumen {
+namespace math {
+namespace {
+// Bins of centroids on which split costs are evaluated.
+constexpr int kNumBins = 16;
+
+// Primitives below which nodes may be leaves, when no split is cheaper.
+constexpr std::size_t kMaxLeafSize = 4;
+
+// Cost of visiting a node, relative to testing a primitive.
+constexpr double kTraversalCost = 1.;
+
+// Primitives below which a subtree is built by a single thread.
+constexpr std::size_t kMinParallelSize = 1 << 14;
+
+// Box as raw doubles, to build without Vector3 accessors.
+struct Bounds {
+  Bounds() {
+    for (int i = 0; i < 3; ++i) {
+      min[i] = std::numeric_limits<double>::infinity();
+      max[i] = -std::numeric_limits<double>::infinity();
+    }
+  }
+
+  void extend(const Bounds& obj) {
+    for (int i = 0; i < 3; ++i) {
+      min[i] = std::min(min[i], obj.min[i]);
+      max[i] = std::max(max[i], obj.max[i]);
+    }
+  }
+
+  double surfaceArea() const {
+    const double x = max[0] - min[0];
+    const double y = max[1] - min[1];
+    const double z = max[2] - min[2];
+    return x < 0. ? 0. : 2. * (x * y + y * z + z * x);
+  }
+
+  double min[3];
+  double max[3];
+};
+
+Bounds toBounds(const Aabb& box) {
+  Bounds res;
+  for (int i = 0; i < 3; ++i) {
+    res.min[i] = box.min[i];
+    res.max[i] = box.max[i];
+  }
+  return res;
+}
+
+void setBounds(const Bounds& bounds, BvhNode* node) {
+  for (int i = 0; i < 3; ++i) {
+    node->min[i] = bounds.min[i];
+    node->max[i] = bounds.max[i];
+  }
+}
+
+void assertNoNan(const std::vector<Aabb>& boxes) {
+  for (const Aabb& box : boxes) {
+    for (int i = 0; i < 3; ++i) {
+      if (std::isnan(box.min[i]) || std::isnan(box.max[i])) {
+        throw std::invalid_argument("Bvh boxes must not have NaN bounds.");
+      }
+    }
+  }
+}
+
+// Primitive being sorted into the hierarchy. Builds partition these rather
+// than indices, so that every pass reads them in order.
+struct Item {
+  Bounds bounds;
+  std::uint32_t primitive;
+};
+
+// Items [begin; end), with the bounds of their boxes and of their centroids
+// scaled by 2, which bin the same.
+struct Range {
+  std::size_t begin;
+  std::size_t end;
+  Bounds bounds;
+  Bounds centroids;
+};
+
+// Top-down builder. Subtrees partition disjoint ranges of the items, so
+// they can be built concurrently. Splits take the bounds of both halves
+// from their bins, so that each level reads the items twice: to bin them
+// and to partition them.
+class Builder {
+ public:
+  explicit Builder(const std::vector<Aabb>& boxes) : items_(boxes.size()) {
+    for (std::size_t i = 0; i < boxes.size(); ++i) {
+      items_[i].bounds = toBounds(boxes[i]);
+      items_[i].primitive = static_cast<std::uint32_t>(i);
+    }
+  }
+
+  // Range of all the items.
+  Range all() const {
+    Range res;
+    res.begin = 0;
+    res.end = items_.size();
+    measure(&res);
+    return res;
+  }
+
+  // Primitive indices in leaf order, once built.
+  void primitives(std::vector<std::uint32_t>* res) const {
+    res->resize(items_.size());
+    for (std::size_t i = 0; i < items_.size(); ++i) {
+      (*res)[i] = items_[i].primitive;
+    }
+  }
+
+  // Builds the subtree of 'range' with its root at 'nodes->size()'.
+  void build(const Range& range, int depth, std::vector<BvhNode>* nodes) {
+    const std::size_t index = nodes->size();
+    nodes->push_back(BvhNode());
+    Range first;
+    Range second;
+    if (!split(range, depth, &(*nodes)[index], &first, &second)) {
+      return;
+    }
+    build(first, depth + 1, nodes);
+    (*nodes)[index].offset = static_cast<std::uint32_t>(nodes->size());
+    build(second, depth + 1, nodes);
+  }
+
+  // As build(), splitting the top levels among threads. Each half builds
+  // its nodes apart, and they are concatenated after the root.
+  std::vector<BvhNode> buildParallel(const Range& range, int depth,
+                                     int num_threads) {
+    std::vector<BvhNode> res;
+    if (num_threads <= 1 || range.end - range.begin < kMinParallelSize) {
+      build(range, depth, &res);
+      return res;
+    }
+    BvhNode root;
+    Range first;
+    Range second;
+    if (!split(range, depth, &root, &first, &second)) {
+      res.push_back(root);
+      return res;
+    }
+    std::vector<BvhNode> second_nodes;
+    std::thread worker([&]() {
+      second_nodes =
+          buildParallel(second, depth + 1, num_threads - num_threads / 2);
+    });
+    const std::vector<BvhNode> first_nodes =
+        buildParallel(first, depth + 1, num_threads / 2);
+    worker.join();
+
+    root.offset = static_cast<std::uint32_t>(1 + first_nodes.size());
+    res.reserve(1 + first_nodes.size() + second_nodes.size());
+    res.push_back(root);
+    append(first_nodes, 1, &res);
+    append(second_nodes, root.offset, &res);
+    return res;
+  }
+
+ private:
+  // Appends nodes built apart, moving their child links by 'shift'.
+  static void append(const std::vector<BvhNode>& nodes, std::uint32_t shift,
+                     std::vector<BvhNode>* res) {
+    for (BvhNode node : nodes) {
+      if (!node.isLeaf()) {
+        node.offset += shift;
+      }
+      res->push_back(node);
+    }
+  }
+
+  static void extendCentroid(const Bounds& box, Bounds* centroids) {
+    for (int i = 0; i < 3; ++i) {
+      const double centroid = box.min[i] + box.max[i];
+      centroids->min[i] = std::min(centroids->min[i], centroid);
+      centroids->max[i] = std::max(centroids->max[i], centroid);
+    }
+  }
+
+  // Sets the bounds of 'range' from its items.
+  void measure(Range* range) const {
+    range->bounds = Bounds();
+    range->centroids = Bounds();
+    for (std::size_t i = range->begin; i < range->end; ++i) {
+      range->bounds.extend(items_[i].bounds);
+      extendCentroid(items_[i].bounds, &range->centroids);
+    }
+  }
+
+  // Makes 'node' the node of 'range'. Returns true after partitioning the
+  // range at its cheapest split into 'first' and 'second', or false when
+  // 'node' is better a leaf.
+  bool split(const Range& range, int depth, BvhNode* node, Range* first,
+             Range* second) {
+    const std::size_t size = range.end - range.begin;
+    setBounds(range.bounds, node);
+    node->offset = static_cast<std::uint32_t>(range.begin);
+    node->count = static_cast<std::uint32_t>(size);
+    node->axis = 0;
+    node->padding = 0;
+    if (size == 1 || depth >= Bvh::kMaxDepth) {
+      return false;
+    }
+
+    const Bounds& centroids = range.centroids;
+    int axis = 0;
+    for (int i = 1; i < 3; ++i) {
+      if (centroids.max[i] - centroids.min[i] >
+          centroids.max[axis] - centroids.min[axis]) {
+        axis = i;
+      }
+    }
+    const double low = centroids.min[axis];
+    const double extent = centroids.max[axis] - low;
+    first->begin = range.begin;
+    second->end = range.end;
+    if (!(extent > 0.)) {
+      // Coincident centroids: halves, unless few enough for a leaf.
+      if (size <= kMaxLeafSize) {
+        return false;
+      }
+      first->end = second->begin = range.begin + size / 2;
+      measure(first);
+      measure(second);
+      node->count = 0;
+      return true;
+    }
+
+    // Primitive counts and bounds per bin, and then the cost of splitting
+    // after each bin. Small ranges take fewer bins, which are cheaper to
+    // evaluate and still separate them.
+    const int num_bins =
+        static_cast<int>(std::min<std::size_t>(kNumBins, 2 * size));
+    const double scale = num_bins / extent;
+    // Clamped before the conversion, which is undefined out of range, and
+    // with NaN, from empty boxes, in bin 0.
+    const auto binOf = [&](const Item& item) {
+      const double bin =
+          (item.bounds.min[axis] + item.bounds.max[axis] - low) * scale;
+      return bin > 0. ? static_cast<int>(std::min<double>(bin, num_bins - 1))
+                      : 0;
+    };
+    std::size_t counts[kNumBins] = {0};
+    Bounds bins[kNumBins];
+    Bounds bin_centroids[kNumBins];
+    for (std::size_t i = range.begin; i < range.end; ++i) {
+      const int bin = binOf(items_[i]);
+      ++counts[bin];
+      bins[bin].extend(items_[i].bounds);
+      extendCentroid(items_[i].bounds, &bin_centroids[bin]);
+    }
+    double costs[kNumBins - 1];
+    Bounds below;
+    std::size_t count_below = 0;
+    for (int i = 0; i < num_bins - 1; ++i) {
+      below.extend(bins[i]);
+      count_below += counts[i];
+      costs[i] = below.surfaceArea() * count_below;
+    }
+    Bounds above;
+    std::size_t count_above = 0;
+    for (int i = num_bins - 1; i > 0; --i) {
+      above.extend(bins[i]);
+      count_above += counts[i];
+      costs[i - 1] += above.surfaceArea() * count_above;
+    }
+    const double area = range.bounds.surfaceArea();
+    int best = -1;
+    double best_cost = std::numeric_limits<double>::infinity();
+    count_below = 0;
+    for (int i = 0; i < num_bins - 1; ++i) {
+      count_below += counts[i];
+      if (count_below == 0 || count_below == size) {
+        continue;
+      }
+      const double cost =
+          kTraversalCost + (area > 0. ? costs[i] / area : 0.);
+      if (cost < best_cost) {
+        best_cost = cost;
+        best = i;
+      }
+    }
+    if (best < 0 || (size <= kMaxLeafSize && best_cost >= size)) {
+      return false;
+    }
+
+    const auto middle =
+        std::partition(items_.begin() + range.begin,
+                       items_.begin() + range.end,
+                       [&](const Item& item) { return binOf(item) <= best; });
+    first->end = second->begin = middle - items_.begin();
+    for (int i = 0; i < num_bins; ++i) {
+      Range& half = i <= best ? *first : *second;
+      half.bounds.extend(bins[i]);
+      half.centroids.extend(bin_centroids[i]);
+    }
+    node->count = 0;
+    node->axis = static_cast<std::uint32_t>(axis);
+    return true;
+  }
+
+  std::vector<Item> items_;
+};
+}  // namespace
+
+const int Bvh::kMaxDepth;
+
+Bvh::Bvh(const std::vector<Aabb>& boxes, int num_threads) {
+  if (boxes.size() >= std::numeric_limits<std::uint32_t>::max()) {
+    throw std::invalid_argument("Bvh primitives must be fewer than 2^32.");
+  }
+  assertNoNan(boxes);
+  if (boxes.empty()) {
+    return;
+  }
+  Builder builder(boxes);
+  nodes_ = builder.buildParallel(builder.all(), 0, num_threads);
+  builder.primitives(&primitives_);
+}
+
+std::size_t Bvh::size() const { return primitives_.size(); }
+
+bool Bvh::empty() const { return primitives_.empty(); }
+
+const std::vector<BvhNode>& Bvh::nodes() const { return nodes_; }
+
+const std::vector<std::uint32_t>& Bvh::primitives() const {
+  return primitives_;
+}
+
+Aabb Bvh::bounds() const {
+  if (nodes_.empty()) {
+    return Aabb();
+  }
+  const BvhNode& root = nodes_.front();
+  return Aabb(Vector3(root.min[0], root.min[1], root.min[2]),
+              Vector3(root.max[0], root.max[1], root.max[2]));
+}
+
+void Bvh::refit(const std::vector<Aabb>& boxes) {
+  if (boxes.size() != primitives_.size()) {
+    throw std::invalid_argument(
+        "Refit boxes must match the primitives of the Bvh.");
+  }
+  assertNoNan(boxes);
+  // Children follow their parents, so a reverse sweep visits them first.
+  for (std::size_t i = nodes_.size(); i-- > 0;) {
+    BvhNode& node = nodes_[i];
+    Bounds bounds;
+    if (node.isLeaf()) {
+      for (std::uint32_t j = 0; j < node.count; ++j) {
+        bounds.extend(toBounds(boxes[primitives_[node.offset + j]]));
+      }
+    } else {
+      for (const BvhNode* child : {&nodes_[i + 1], &nodes_[node.offset]}) {
+        for (int j = 0; j < 3; ++j) {
+          bounds.min[j] = std::min(bounds.min[j], child->min[j]);
+          bounds.max[j] = std::max(bounds.max[j], child->max[j]);
+        }
+      }
+    }
+    setBounds(bounds, &node);
+  }
+}
+
+}  // namespace math
+}  // namespace ekumen
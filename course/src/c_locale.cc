@@ -0,0 +1,31 @@
+#include "c_locale.h"
+
+#include <locale.h>
+#include <stdlib.h>
+
+#include <cstdio>
+
+namespace ekumen {
+namespace math {
+namespace {
+locale_t cLocale() {
+  static const locale_t res = ::newlocale(LC_ALL_MASK, "C", locale_t(0));
+  return res;
+}
+}  // namespace
+
+double StrtodC(const char* text, char** end) {
+  return ::strtod_l(text, end, cLocale());
+}
+
+int FormatDoubleC(double value, int precision, char* buffer,
+                  std::size_t size) {
+  // snprintf() has no locale argument, so the thread switches locale.
+  const locale_t previous = ::uselocale(cLocale());
+  const int res = std::snprintf(buffer, size, "%.*g", precision, value);
+  ::uselocale(previous);
+  return res;
+}
+
+}  // namespace math
+}  // namespace ekumen
@@ -0,0 +1,607 @@
+#include "convex_hull.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+#include "parallel.h"
+#include "vector3.h"
+
+namespace ekumen {
+namespace math {
+namespace {
+constexpr std::uint32_t kNone = std::numeric_limits<std::uint32_t>::max();
+// Points given to each thread when assigning points to new faces; fewer
+// are assigned on the calling thread alone.
+constexpr std::size_t kMinAssignChunkSize = 4096;
+// Relative error bound of the floating point orientation (Shewchuk's
+// o3derrboundA), for an epsilon of half an ulp of 1.
+constexpr double kEpsilon = 1.1102230246251565e-16;
+constexpr double kOrientErrorBound = (7. + 56. * kEpsilon) * kEpsilon;
+// Terms of the exact orientation: 24 products of three coordinates, of
+// four terms each.
+constexpr int kMaxExpansionSize = 96;
+
+// Sets 'sum' and 'error' so that sum + error is a + b exactly.
+void twoSum(double a, double b, double* sum, double* error) {
+  *sum = a + b;
+  const double b_virtual = *sum - a;
+  const double a_virtual = *sum - b_virtual;
+  *error = (a - a_virtual) + (b - b_virtual);
+}
+
+// Adds 'value' to the 'size' nonoverlapping terms of increasing magnitude
+// in 'terms', keeping them so and dropping zeros. Returns the new size.
+int growExpansion(double value, double* terms, int size) {
+  int res = 0;
+  for (int i = 0; i < size; ++i) {
+    double error;
+    twoSum(value, terms[i], &value, &error);
+    if (error != 0.) {
+      terms[res++] = error;
+    }
+  }
+  if (value != 0.) {
+    terms[res++] = value;
+  }
+  return res;
+}
+
+// Adds sign * a * b * c exactly to the expansion in 'terms', with 'sign'
+// 1 or -1.
+int addProduct(double sign, double a, double b, double c, double* terms,
+               int size) {
+  const double ab = sign * a * b;
+  const double ab_error = std::fma(sign * a, b, -ab);
+  const double abc = ab * c;
+  const double error_c = ab_error * c;
+  size = growExpansion(std::fma(ab_error, c, -error_c), terms, size);
+  size = growExpansion(std::fma(ab, c, -abc), terms, size);
+  size = growExpansion(error_c, terms, size);
+  return growExpansion(abc, terms, size);
+}
+
+// Adds sign * det[p; q; r] exactly to the expansion in 'terms'.
+int addDeterminant(double sign, const double* p, const double* q,
+                   const double* r, double* terms, int size) {
+  size = addProduct(sign, p[0], q[1], r[2], terms, size);
+  size = addProduct(-sign, p[0], q[2], r[1], terms, size);
+  size = addProduct(-sign, p[1], q[0], r[2], terms, size);
+  size = addProduct(sign, p[1], q[2], r[0], terms, size);
+  size = addProduct(sign, p[2], q[0], r[1], terms, size);
+  return addProduct(-sign, p[2], q[1], r[0], terms, size);
+}
+
+// Orientation from the raw coordinates, which the differences of the
+// floating point evaluation would round: the determinant of the rows
+// (a, 1), (b, 1), (c, 1) and (d, 1), expanded along its last column. The
+// largest term of the expansion has the sign of the sum.
+double exactOrientation(const double* a, const double* b, const double* c,
+                        const double* d) {
+  double terms[kMaxExpansionSize];
+  int size = addDeterminant(1., a, b, c, terms, 0);
+  size = addDeterminant(-1., a, b, d, terms, size);
+  size = addDeterminant(1., a, c, d, terms, size);
+  size = addDeterminant(-1., b, c, d, terms, size);
+  return size == 0 ? 0. : terms[size - 1];
+}
+
+inline double orientation(const double* a, const double* b, const double* c,
+                          const double* d) {
+  const double adx = a[0] - d[0];
+  const double ady = a[1] - d[1];
+  const double adz = a[2] - d[2];
+  const double bdx = b[0] - d[0];
+  const double bdy = b[1] - d[1];
+  const double bdz = b[2] - d[2];
+  const double cdx = c[0] - d[0];
+  const double cdy = c[1] - d[1];
+  const double cdz = c[2] - d[2];
+  const double bdxcdy = bdx * cdy;
+  const double cdxbdy = cdx * bdy;
+  const double cdxady = cdx * ady;
+  const double adxcdy = adx * cdy;
+  const double adxbdy = adx * bdy;
+  const double bdxady = bdx * ady;
+  const double res = adz * (bdxcdy - cdxbdy) + bdz * (cdxady - adxcdy) +
+                     cdz * (adxbdy - bdxady);
+  const double permanent =
+      (std::abs(bdxcdy) + std::abs(cdxbdy)) * std::abs(adz) +
+      (std::abs(cdxady) + std::abs(adxcdy)) * std::abs(bdz) +
+      (std::abs(adxbdy) + std::abs(bdxady)) * std::abs(cdz);
+  const double bound = kOrientErrorBound * permanent;
+  if (res > bound || -res > bound) {
+    return res;
+  }
+  return exactOrientation(a, b, c, d);
+}
+
+// Quickhull state. Face f owns the half-edges 3 * f to 3 * f + 2, the k-th
+// going from its k-th corner to the next one, so only their start vertices
+// and twins are stored, and dead faces are recycled. The points outside
+// each face are a range of 'pool_', copied with their coordinates so that
+// moving them to new faces reads memory in order. Ranges of dead faces stay
+// in the pool until it fills up, and then the live ones are compacted.
+class HullBuilder {
+ public:
+  HullBuilder(const std::vector<Vector3>& points, int num_threads);
+
+  void build();
+  void extract(std::vector<double>* vertices,
+               std::vector<std::uint32_t>* indices,
+               std::vector<ConvexHull::Triangle>* triangles);
+
+ private:
+  struct Edge {
+    std::uint32_t from;
+    std::uint32_t to;
+    std::uint32_t twin;
+  };
+
+  struct Outside {
+    double point[3];
+    std::uint32_t index;
+  };
+
+  static std::uint32_t next(std::uint32_t edge) {
+    return edge - edge % 3 + (edge % 3 + 1) % 3;
+  }
+
+  const double* point(std::uint32_t index) const {
+    return &coordinates_[3 * index];
+  }
+
+  // Positive when 'p' is outside 'face', growing with its distance.
+  double height(std::uint32_t face, const double* p) const {
+    return -orientation(point(vertex_[3 * face]), point(vertex_[3 * face + 1]),
+                        point(vertex_[3 * face + 2]), p);
+  }
+
+  void link(std::uint32_t edge, std::uint32_t twin) {
+    twin_[edge] = twin;
+    twin_[twin] = edge;
+  }
+
+  void initialSimplex();
+  std::uint32_t newFace(std::uint32_t a, std::uint32_t b, std::uint32_t c);
+  void assign(const std::vector<Outside>& points,
+              const std::vector<std::uint32_t>& faces);
+  void compact();
+  void addPoint(std::uint32_t face);
+
+  int num_threads_;
+  std::size_t num_points_;
+  std::vector<double> coordinates_;
+
+  // Per half-edge.
+  std::vector<std::uint32_t> vertex_;
+  std::vector<std::uint32_t> twin_;
+  // Per face.
+  std::vector<bool> alive_;
+  std::vector<std::size_t> outside_begin_;
+  std::vector<std::size_t> outside_end_;
+  std::vector<std::uint32_t> farthest_;
+  std::vector<double> farthest_height_;
+  std::vector<std::uint32_t> visit_;
+  std::vector<bool> visible_;
+  std::vector<std::uint32_t> free_;
+  // Per point.
+  std::vector<std::uint32_t> start_face_;
+  std::vector<Outside> pool_;
+  std::vector<Outside> spare_pool_;
+
+  // Scratch of addPoint() and assign().
+  std::uint32_t stamp_;
+  std::vector<std::uint32_t> pending_;
+  std::vector<std::uint32_t> visible_faces_;
+  std::vector<Edge> horizon_;
+  std::vector<Outside> orphans_;
+  std::vector<std::uint32_t> new_faces_;
+  std::vector<double> corners_;
+  std::vector<std::uint32_t> owner_;
+  std::vector<double> owner_height_;
+  std::vector<std::size_t> counts_;
+};
+
+HullBuilder::HullBuilder(const std::vector<Vector3>& points, int num_threads)
+    : num_threads_(num_threads),
+      num_points_(points.size()),
+      start_face_(points.size(), kNone),
+      stamp_(0) {
+  coordinates_.reserve(3 * points.size());
+  for (const Vector3& point : points) {
+    coordinates_.push_back(point.x());
+    coordinates_.push_back(point.y());
+    coordinates_.push_back(point.z());
+  }
+  // Live ranges never hold more than all the points, so the pool is never
+  // reallocated.
+  pool_.reserve(2 * points.size());
+  spare_pool_.reserve(2 * points.size());
+}
+
+void HullBuilder::build() {
+  if (num_points_ < 4) {
+    throw std::invalid_argument("A convex hull needs at least four points.");
+  }
+  initialSimplex();
+  while (!pending_.empty()) {
+    const std::uint32_t face = pending_.back();
+    pending_.pop_back();
+    if (alive_[face] && outside_end_[face] > outside_begin_[face]) {
+      addPoint(face);
+    }
+  }
+}
+
+void HullBuilder::extract(std::vector<double>* vertices,
+                          std::vector<std::uint32_t>* indices,
+                          std::vector<ConvexHull::Triangle>* triangles) {
+  // Reuses 'start_face_' as the vertex index of each point.
+  std::vector<std::uint32_t>& vertex_of = start_face_;
+  vertex_of.assign(num_points_, kNone);
+  for (std::uint32_t face = 0; face < alive_.size(); ++face) {
+    if (!alive_[face]) {
+      continue;
+    }
+    ConvexHull::Triangle triangle;
+    for (int k = 0; k < 3; ++k) {
+      const std::uint32_t index = vertex_[3 * face + k];
+      if (vertex_of[index] == kNone) {
+        vertex_of[index] = static_cast<std::uint32_t>(indices->size());
+        indices->push_back(index);
+        vertices->insert(vertices->end(), point(index), point(index) + 3);
+      }
+      triangle[k] = vertex_of[index];
+    }
+    triangles->push_back(triangle);
+  }
+}
+
+void HullBuilder::initialSimplex() {
+  // The two furthest apart of the extreme points along each axis.
+  std::uint32_t extremes[6] = {0, 0, 0, 0, 0, 0};
+  for (std::uint32_t i = 1; i < num_points_; ++i) {
+    for (int axis = 0; axis < 3; ++axis) {
+      if (point(i)[axis] < point(extremes[2 * axis])[axis]) {
+        extremes[2 * axis] = i;
+      }
+      if (point(i)[axis] > point(extremes[2 * axis + 1])[axis]) {
+        extremes[2 * axis + 1] = i;
+      }
+    }
+  }
+  std::uint32_t corners[4] = {0, 0, 0, 0};
+  double best = 0.;
+  for (int i = 0; i < 6; ++i) {
+    for (int j = i + 1; j < 6; ++j) {
+      const double* p = point(extremes[i]);
+      const double* q = point(extremes[j]);
+      const double dx = q[0] - p[0];
+      const double dy = q[1] - p[1];
+      const double dz = q[2] - p[2];
+      const double squared = dx * dx + dy * dy + dz * dz;
+      if (squared > best) {
+        best = squared;
+        corners[0] = extremes[i];
+        corners[1] = extremes[j];
+      }
+    }
+  }
+  // The furthest from their line, and then from the plane of the three.
+  const double* a = point(corners[0]);
+  const double* b = point(corners[1]);
+  const double ab[3] = {b[0] - a[0], b[1] - a[1], b[2] - a[2]};
+  best = 0.;
+  for (std::uint32_t i = 0; i < num_points_; ++i) {
+    const double* p = point(i);
+    const double ap[3] = {p[0] - a[0], p[1] - a[1], p[2] - a[2]};
+    const double cx = ab[1] * ap[2] - ab[2] * ap[1];
+    const double cy = ab[2] * ap[0] - ab[0] * ap[2];
+    const double cz = ab[0] * ap[1] - ab[1] * ap[0];
+    const double squared = cx * cx + cy * cy + cz * cz;
+    if (squared > best) {
+      best = squared;
+      corners[2] = i;
+    }
+  }
+  const double* c = point(corners[2]);
+  best = 0.;
+  for (std::uint32_t i = 0; i < num_points_; ++i) {
+    const double volume = std::abs(orientation(a, b, c, point(i)));
+    if (volume > best) {
+      best = volume;
+      corners[3] = i;
+    }
+  }
+  if (best == 0.) {
+    throw std::invalid_argument("A convex hull needs points not coplanar.");
+  }
+  // Faces seen counterclockwise from outside, with the last corner below
+  // the first face.
+  if (orientation(a, b, c, point(corners[3])) < 0.) {
+    std::swap(corners[1], corners[2]);
+  }
+  new_faces_.clear();
+  new_faces_.push_back(newFace(corners[0], corners[1], corners[2]));
+  new_faces_.push_back(newFace(corners[0], corners[2], corners[3]));
+  new_faces_.push_back(newFace(corners[0], corners[3], corners[1]));
+  new_faces_.push_back(newFace(corners[1], corners[3], corners[2]));
+  for (std::uint32_t edge = 0; edge < 12; ++edge) {
+    for (std::uint32_t other = 0; other < 12; ++other) {
+      if (vertex_[other] == vertex_[next(edge)] &&
+          vertex_[next(other)] == vertex_[edge]) {
+        twin_[edge] = other;
+      }
+    }
+  }
+  orphans_.clear();
+  orphans_.reserve(num_points_);
+  for (std::uint32_t i = 0; i < num_points_; ++i) {
+    if (i != corners[0] && i != corners[1] && i != corners[2] &&
+        i != corners[3]) {
+      const double* p = point(i);
+      orphans_.push_back(Outside{{p[0], p[1], p[2]}, i});
+    }
+  }
+  assign(orphans_, new_faces_);
+}
+
+std::uint32_t HullBuilder::newFace(std::uint32_t a, std::uint32_t b,
+                                   std::uint32_t c) {
+  std::uint32_t face;
+  if (free_.empty()) {
+    face = static_cast<std::uint32_t>(alive_.size());
+    vertex_.resize(vertex_.size() + 3);
+    twin_.resize(twin_.size() + 3, kNone);
+    alive_.push_back(true);
+    outside_begin_.push_back(0);
+    outside_end_.push_back(0);
+    farthest_.push_back(kNone);
+    farthest_height_.push_back(0.);
+    visit_.push_back(0);
+    visible_.push_back(false);
+  } else {
+    face = free_.back();
+    free_.pop_back();
+    alive_[face] = true;
+    outside_begin_[face] = 0;
+    outside_end_[face] = 0;
+    farthest_[face] = kNone;
+  }
+  vertex_[3 * face] = a;
+  vertex_[3 * face + 1] = b;
+  vertex_[3 * face + 2] = c;
+  return face;
+}
+
+void HullBuilder::assign(const std::vector<Outside>& points,
+                         const std::vector<std::uint32_t>& faces) {
+  // Finds the first face each point is outside of on several threads, and
+  // then groups the points of each face in the pool in order, so that the
+  // hull does not depend on the number of threads.
+  corners_.resize(9 * faces.size());
+  for (std::size_t k = 0; k < faces.size(); ++k) {
+    for (int corner = 0; corner < 3; ++corner) {
+      const double* p = point(vertex_[3 * faces[k] + corner]);
+      std::copy(p, p + 3, &corners_[9 * k + 3 * corner]);
+    }
+  }
+  owner_.resize(points.size());
+  owner_height_.resize(points.size());
+  ParallelFor(
+      points.size(), num_threads_,
+      [this, &points, &faces](int, std::size_t begin, std::size_t end) {
+        const double* corners = corners_.data();
+        for (std::size_t i = begin; i < end; ++i) {
+          owner_[i] = kNone;
+          for (std::size_t k = 0; k < faces.size(); ++k) {
+            const double* face = corners + 9 * k;
+            const double value =
+                -orientation(face, face + 3, face + 6, points[i].point);
+            if (value > 0.) {
+              owner_[i] = static_cast<std::uint32_t>(k);
+              owner_height_[i] = value;
+              break;
+            }
+          }
+        }
+      },
+      kMinAssignChunkSize);
+  counts_.assign(faces.size(), 0);
+  std::size_t assigned = 0;
+  for (std::size_t i = 0; i < points.size(); ++i) {
+    if (owner_[i] != kNone) {
+      ++counts_[owner_[i]];
+      ++assigned;
+    }
+  }
+  if (pool_.size() + assigned > pool_.capacity()) {
+    compact();
+  }
+  std::size_t end = pool_.size();
+  for (std::size_t k = 0; k < faces.size(); ++k) {
+    outside_begin_[faces[k]] = end;
+    outside_end_[faces[k]] = end;
+    end += counts_[k];
+    if (counts_[k] > 0) {
+      pending_.push_back(faces[k]);
+    }
+  }
+  pool_.resize(end);
+  for (std::size_t i = 0; i < points.size(); ++i) {
+    if (owner_[i] == kNone) {
+      continue;
+    }
+    const std::uint32_t face = faces[owner_[i]];
+    pool_[outside_end_[face]++] = points[i];
+    if (farthest_[face] == kNone ||
+        owner_height_[i] > farthest_height_[face]) {
+      farthest_[face] = points[i].index;
+      farthest_height_[face] = owner_height_[i];
+    }
+  }
+}
+
+void HullBuilder::compact() {
+  spare_pool_.clear();
+  for (std::uint32_t face = 0; face < alive_.size(); ++face) {
+    if (!alive_[face]) {
+      continue;
+    }
+    const std::size_t begin = spare_pool_.size();
+    spare_pool_.insert(spare_pool_.end(),
+                       pool_.begin() + outside_begin_[face],
+                       pool_.begin() + outside_end_[face]);
+    outside_begin_[face] = begin;
+    outside_end_[face] = spare_pool_.size();
+  }
+  pool_.swap(spare_pool_);
+}
+
+void HullBuilder::addPoint(std::uint32_t face) {
+  const std::uint32_t eye = farthest_[face];
+  const double* eye_point = point(eye);
+  // Faces seen from the eye, which are connected.
+  ++stamp_;
+  visible_faces_.clear();
+  visible_faces_.push_back(face);
+  visit_[face] = stamp_;
+  visible_[face] = true;
+  for (std::size_t i = 0; i < visible_faces_.size(); ++i) {
+    const std::uint32_t current = visible_faces_[i];
+    for (std::uint32_t edge = 3 * current; edge < 3 * current + 3; ++edge) {
+      const std::uint32_t neighbor = twin_[edge] / 3;
+      if (visit_[neighbor] != stamp_) {
+        visit_[neighbor] = stamp_;
+        visible_[neighbor] = height(neighbor, eye_point) > 0.;
+        if (visible_[neighbor]) {
+          visible_faces_.push_back(neighbor);
+        }
+      }
+    }
+  }
+  // Edges between seen and unseen faces, and the points of the seen ones.
+  horizon_.clear();
+  orphans_.clear();
+  for (const std::uint32_t current : visible_faces_) {
+    for (std::uint32_t edge = 3 * current; edge < 3 * current + 3; ++edge) {
+      if (!visible_[twin_[edge] / 3]) {
+        horizon_.push_back(Edge{vertex_[edge], vertex_[next(edge)],
+                                twin_[edge]});
+      }
+    }
+    for (std::size_t i = outside_begin_[current]; i < outside_end_[current];
+         ++i) {
+      if (pool_[i].index != eye) {
+        orphans_.push_back(pool_[i]);
+      }
+    }
+    alive_[current] = false;
+    free_.push_back(current);
+  }
+  // A cone of faces from the horizon to the eye.
+  new_faces_.clear();
+  for (const Edge& edge : horizon_) {
+    const std::uint32_t cone = newFace(edge.from, edge.to, eye);
+    link(3 * cone, edge.twin);
+    start_face_[edge.from] = cone;
+    new_faces_.push_back(cone);
+  }
+  for (const std::uint32_t cone : new_faces_) {
+    const std::uint32_t following = start_face_[vertex_[3 * cone + 1]];
+    link(3 * cone + 1, 3 * following + 2);
+  }
+  assign(orphans_, new_faces_);
+}
+}  // namespace
+
+double Orient3d(const Vector3& a, const Vector3& b, const Vector3& c,
+                const Vector3& d) {
+  const double p[4][3] = {{a.x(), a.y(), a.z()},
+                          {b.x(), b.y(), b.z()},
+                          {c.x(), c.y(), c.z()},
+                          {d.x(), d.y(), d.z()}};
+  return orientation(p[0], p[1], p[2], p[3]);
+}
+
+double Orient3d(const double* a, const double* b, const double* c,
+                const double* d) {
+  return orientation(a, b, c, d);
+}
+
+ConvexHull::ConvexHull(const std::vector<Vector3>& points, int num_threads) {
+  HullBuilder builder(points, num_threads);
+  builder.build();
+  builder.extract(&vertices_, &indices_, &triangles_);
+}
+
+std::size_t ConvexHull::numVertices() const { return indices_.size(); }
+
+std::size_t ConvexHull::numTriangles() const { return triangles_.size(); }
+
+Vector3 ConvexHull::vertex(std::size_t index) const {
+  assertValidAccessIndex(index);
+  return Vector3(vertices_[3 * index], vertices_[3 * index + 1],
+                 vertices_[3 * index + 2]);
+}
+
+std::vector<Vector3> ConvexHull::vertices() const {
+  std::vector<Vector3> res;
+  res.reserve(numVertices());
+  for (std::size_t i = 0; i < vertices_.size(); i += 3) {
+    res.emplace_back(vertices_[i], vertices_[i + 1], vertices_[i + 2]);
+  }
+  return res;
+}
+
+const std::vector<ConvexHull::Triangle>& ConvexHull::triangles() const {
+  return triangles_;
+}
+
+const std::vector<std::uint32_t>& ConvexHull::indices() const {
+  return indices_;
+}
+
+bool ConvexHull::contains(const Vector3& point) const {
+  const double p[3] = {point.x(), point.y(), point.z()};
+  const double* vertices = vertices_.data();
+  for (const Triangle& triangle : triangles_) {
+    if (orientation(vertices + 3 * triangle[0], vertices + 3 * triangle[1],
+                    vertices + 3 * triangle[2], p) < 0.) {
+      return false;
+    }
+  }
+  return true;
+}
+
+double ConvexHull::volume() const {
+  // Tetrahedra from the first vertex to each triangle.
+  const double* o = vertices_.data();
+  double res = 0.;
+  for (const Triangle& triangle : triangles_) {
+    const double* a = vertices_.data() + 3 * triangle[0];
+    const double* b = vertices_.data() + 3 * triangle[1];
+    const double* c = vertices_.data() + 3 * triangle[2];
+    const double u[3] = {a[0] - o[0], a[1] - o[1], a[2] - o[2]};
+    const double v[3] = {b[0] - o[0], b[1] - o[1], b[2] - o[2]};
+    const double w[3] = {c[0] - o[0], c[1] - o[1], c[2] - o[2]};
+    res += u[0] * (v[1] * w[2] - v[2] * w[1]) +
+           u[1] * (v[2] * w[0] - v[0] * w[2]) +
+           u[2] * (v[0] * w[1] - v[1] * w[0]);
+  }
+  return res / 6.;
+}
+
+void ConvexHull::assertValidAccessIndex(std::size_t index) const {
+  if (index >= numVertices()) {
+    throw std::out_of_range("Index to access a hull vertex is out of range.");
+  }
+}
+
+}  // namespace math
+}  // namespace ekumen
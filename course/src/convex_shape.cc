@@ -0,0 +1,117 @@
+#include "convex_shape.h"
+
+#include <cstddef>
+#include <iostream>
+#include <stdexcept>
+#include <vector>
+#include "aabb.h"
+#include "vector3.h"
+
+namespace ekumen {
+namespace math {
+
+ConvexShape::ConvexShape() : ConvexShape(Type::kSphere, Vector3::kZero, 1.) {}
+
+ConvexShape::ConvexShape(Type type, const Vector3& half, double radius)
+    : type_(type), half_{half.x(), half.y(), half.z()}, radius_(radius) {}
+
+ConvexShape ConvexShape::Sphere(double radius) {
+  assertValidSize(radius);
+  return ConvexShape(Type::kSphere, Vector3::kZero, radius);
+}
+
+ConvexShape ConvexShape::Box(const Vector3& half_extents) {
+  for (int i = 0; i < 3; ++i) {
+    assertValidSize(half_extents[i]);
+  }
+  return ConvexShape(Type::kBox, half_extents, 0.);
+}
+
+ConvexShape ConvexShape::Capsule(double half_length, double radius) {
+  assertValidSize(half_length);
+  assertValidSize(radius);
+  return ConvexShape(Type::kCapsule, Vector3(0., 0., half_length), radius);
+}
+
+ConvexShape ConvexShape::Hull(const std::vector<Vector3>& vertices) {
+  if (vertices.empty()) {
+    throw std::invalid_argument("A hull needs at least one vertex.");
+  }
+  ConvexShape res(Type::kHull, Vector3::kZero, 0.);
+  res.vertices_.reserve(3 * vertices.size());
+  for (const Vector3& vertex : vertices) {
+    res.vertices_.push_back(vertex.x());
+    res.vertices_.push_back(vertex.y());
+    res.vertices_.push_back(vertex.z());
+  }
+  return res;
+}
+
+ConvexShape::Type ConvexShape::type() const { return type_; }
+
+double ConvexShape::radius() const { return radius_; }
+
+Vector3 ConvexShape::support(const Vector3& direction) const {
+  const double d[3] = {direction.x(), direction.y(), direction.z()};
+  double res[3];
+  support(d, res);
+  return Vector3(res[0], res[1], res[2]);
+}
+
+Aabb ConvexShape::bounds() const {
+  Aabb res;
+  if (type_ == Type::kHull) {
+    for (std::size_t i = 0; i < vertices_.size(); i += 3) {
+      res.extend(Vector3(vertices_[i], vertices_[i + 1], vertices_[i + 2]));
+    }
+  } else {
+    const Vector3 half(half_[0], half_[1], half_[2]);
+    res = Aabb(-1. * half, half);
+  }
+  const Vector3 grow(radius_, radius_, radius_);
+  return Aabb(res.min - grow, res.max + grow);
+}
+
+std::ostream& operator<<(std::ostream& os, const ConvexShape& obj) {
+  const Vector3 half(obj.half_[0], obj.half_[1], obj.half_[2]);
+  switch (obj.type_) {
+    case ConvexShape::Type::kSphere:
+      return os << "Sphere(radius: " << obj.radius_ << ")";
+    case ConvexShape::Type::kBox:
+      return os << "Box(half_extents: " << half << ")";
+    case ConvexShape::Type::kCapsule:
+      return os << "Capsule(half_length: " << obj.half_[2]
+                << ", radius: " << obj.radius_ << ")";
+    case ConvexShape::Type::kHull:
+      return os << "Hull(vertices: " << obj.vertices_.size() / 3 << ")";
+  }
+  return os;
+}
+
+void ConvexShape::assertValidSize(double size) {
+  if (!(size >= 0.)) {
+    throw std::invalid_argument("Shape sizes must not be negative or NaN.");
+  }
+}
+
+void ConvexShape::hullSupport(const double* direction, double* res) const {
+  const double* vertices = vertices_.data();
+  std::size_t best = 0;
+  double best_dot = direction[0] * vertices[0] + direction[1] * vertices[1] +
+                    direction[2] * vertices[2];
+  for (std::size_t i = 3; i < vertices_.size(); i += 3) {
+    const double dot = direction[0] * vertices[i] +
+                       direction[1] * vertices[i + 1] +
+                       direction[2] * vertices[i + 2];
+    if (dot > best_dot) {
+      best_dot = dot;
+      best = i;
+    }
+  }
+  res[0] = vertices[best];
+  res[1] = vertices[best + 1];
+  res[2] = vertices[best + 2];
+}
+
+}  // namespace math
+}  // namespace ekumen
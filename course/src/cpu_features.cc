@@ -0,0 +1,16 @@
+#include "cpu_features.h"
+
+namespace ekumen {
+namespace math {
+
+bool CpuHasAvx2() {
+#ifdef EKUMEN_AVX2_DISPATCH
+  static const bool res = __builtin_cpu_supports("avx2");
+  return res;
+#else
+  return false;
+#endif
+}
+
+}  // namespace math
+}  // namespace ekumen
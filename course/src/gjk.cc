@@ -0,0 +1,659 @@
+#include "gjk.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <utility>
+#include <vector>
+#include "convex_shape.h"
+#include "isometry.h"
+#include "matrix3.h"
+#include "vector3.h"
+
+namespace ekumen {
+namespace math {
+namespace {
+constexpr int kMaxGjkIterations = 64;
+constexpr int kMaxEpaIterations = 64;
+
+// GJK stops when a support point brings the squared distance closer by
+// less than this fraction of it.
+constexpr double kGjkTolerance = 1e-12;
+
+// EPA stops when a support point is this much further than the nearest
+// face, relative to the size of the polytope.
+constexpr double kEpaTolerance = 1e-10;
+
+// Below this times the size of the simplex, the origin is taken to be on
+// it, so the cores overlap.
+constexpr double kOverlapTolerance = 1e-12;
+
+// Point with inline arithmetic, for the simplex updates.
+struct Point3 {
+  Point3 operator+(const Point3& obj) const {
+    return Point3{x + obj.x, y + obj.y, z + obj.z};
+  }
+  Point3 operator-(const Point3& obj) const {
+    return Point3{x - obj.x, y - obj.y, z - obj.z};
+  }
+  Point3 operator*(double scale) const {
+    return Point3{x * scale, y * scale, z * scale};
+  }
+  double dot(const Point3& obj) const {
+    return x * obj.x + y * obj.y + z * obj.z;
+  }
+  Point3 cross(const Point3& obj) const {
+    return Point3{y * obj.z - z * obj.y, z * obj.x - x * obj.z,
+                  x * obj.y - y * obj.x};
+  }
+
+  double x;
+  double y;
+  double z;
+};
+
+Vector3 toVector(const Point3& point) {
+  return Vector3(point.x, point.y, point.z);
+}
+
+// Support point of the Minkowski difference A - B, with the points of each
+// core in the frame of its shape and their difference in the frame of A.
+struct Vertex {
+  Point3 a;
+  Point3 b;
+  Point3 w;
+};
+
+// Up to four vertices and the barycentric coordinates of the point of their
+// hull nearest to the origin.
+struct Simplex {
+  Vertex vertices[4];
+  double weights[4];
+  int size;
+};
+
+// Cores of two shapes with B placed in the frame of A by 'r' and 't'.
+class Difference {
+ public:
+  Difference(const ConvexShape& a, const Isometry& pose_a,
+             const ConvexShape& b, const Isometry& pose_b)
+      : a_(a), b_(b) {
+    // r = Ra^T Rb and t = Ra^T (tb - ta), from the poses read once, as
+    // their accessors are out of line.
+    const Matrix3& rotation_a = pose_a.rotation();
+    const Matrix3& rotation_b = pose_b.rotation();
+    const Vector3& translation_a = pose_a.translation();
+    const Vector3& translation_b = pose_b.translation();
+    double ra[3][3];
+    double rb[3][3];
+    double offset[3];
+    for (int i = 0; i < 3; ++i) {
+      const Vector3& row_a = rotation_a[i];
+      const Vector3& row_b = rotation_b[i];
+      for (int j = 0; j < 3; ++j) {
+        ra[i][j] = row_a[j];
+        rb[i][j] = row_b[j];
+      }
+      offset[i] = translation_b[i] - translation_a[i];
+    }
+    double t[3];
+    for (int i = 0; i < 3; ++i) {
+      t[i] = ra[0][i] * offset[0] + ra[1][i] * offset[1] +
+             ra[2][i] * offset[2];
+      for (int j = 0; j < 3; ++j) {
+        r_[i][j] = ra[0][i] * rb[0][j] + ra[1][i] * rb[1][j] +
+                   ra[2][i] * rb[2][j];
+      }
+    }
+    t_ = Point3{t[0], t[1], t[2]};
+  }
+
+  // Position of B in the frame of A.
+  const Point3& offset() const { return t_; }
+
+  // Point of B in the frame of A.
+  Point3 placeB(const Point3& p) const {
+    return Point3{r_[0][0] * p.x + r_[0][1] * p.y + r_[0][2] * p.z + t_.x,
+                  r_[1][0] * p.x + r_[1][1] * p.y + r_[1][2] * p.z + t_.y,
+                  r_[2][0] * p.x + r_[2][1] * p.y + r_[2][2] * p.z + t_.z};
+  }
+
+  Vertex vertex(const Point3& a, const Point3& b) const {
+    return Vertex{a, b, a - placeB(b)};
+  }
+
+  // Vertex furthest along 'direction', in the frame of A. B is searched
+  // along the opposite direction turned into its frame by r^T.
+  Vertex support(const Point3& direction) const {
+    const double along_a[3] = {direction.x, direction.y, direction.z};
+    const double along_b[3] = {
+        -(r_[0][0] * direction.x + r_[1][0] * direction.y +
+          r_[2][0] * direction.z),
+        -(r_[0][1] * direction.x + r_[1][1] * direction.y +
+          r_[2][1] * direction.z),
+        -(r_[0][2] * direction.x + r_[1][2] * direction.y +
+          r_[2][2] * direction.z)};
+    double a[3];
+    double b[3];
+    a_.support(along_a, a);
+    b_.support(along_b, b);
+    return vertex(Point3{a[0], a[1], a[2]}, Point3{b[0], b[1], b[2]});
+  }
+
+ private:
+  const ConvexShape& a_;
+  const ConvexShape& b_;
+  double r_[3][3];
+  Point3 t_;
+};
+
+void setPoint(const Vertex& v, Simplex* res) {
+  res->vertices[0] = v;
+  res->weights[0] = 1.;
+  res->size = 1;
+}
+
+void setSegment(const Vertex& p, const Vertex& q, double t, Simplex* res) {
+  res->vertices[0] = p;
+  res->vertices[1] = q;
+  res->weights[0] = 1. - t;
+  res->weights[1] = t;
+  res->size = 2;
+}
+
+// Sets 'res' to the vertices of segment pq nearest to the origin.
+void closestOnSegment(const Vertex& p, const Vertex& q, Simplex* res) {
+  const Point3 pq = q.w - p.w;
+  const double t = -p.w.dot(pq);
+  const double length2 = pq.dot(pq);
+  if (t <= 0. || length2 == 0.) {
+    setPoint(p, res);
+  } else if (t >= length2) {
+    setPoint(q, res);
+  } else {
+    setSegment(p, q, t / length2, res);
+  }
+}
+
+// Weighted sum of the differences of the vertices of 'simplex'.
+Point3 pointOf(const Simplex& simplex) {
+  Point3 res{0., 0., 0.};
+  for (int i = 0; i < simplex.size; ++i) {
+    res = res + simplex.vertices[i].w * simplex.weights[i];
+  }
+  return res;
+}
+
+// Sets 'res' to the vertices of triangle abc nearest to the origin, from
+// the Voronoi region of the origin (Ericson, Real-Time Collision Detection
+// 5.1.5).
+void closestOnTriangle(const Vertex& a, const Vertex& b, const Vertex& c,
+                       Simplex* res) {
+  const Point3 ab = b.w - a.w;
+  const Point3 ac = c.w - a.w;
+  const double d1 = -ab.dot(a.w);
+  const double d2 = -ac.dot(a.w);
+  if (d1 <= 0. && d2 <= 0.) {
+    setPoint(a, res);
+    return;
+  }
+  const double d3 = -ab.dot(b.w);
+  const double d4 = -ac.dot(b.w);
+  if (d3 >= 0. && d4 <= d3) {
+    setPoint(b, res);
+    return;
+  }
+  const double vc = d1 * d4 - d3 * d2;
+  if (vc <= 0. && d1 >= 0. && d3 <= 0.) {
+    setSegment(a, b, d1 / (d1 - d3), res);
+    return;
+  }
+  const double d5 = -ab.dot(c.w);
+  const double d6 = -ac.dot(c.w);
+  if (d6 >= 0. && d5 <= d6) {
+    setPoint(c, res);
+    return;
+  }
+  const double vb = d5 * d2 - d1 * d6;
+  if (vb <= 0. && d2 >= 0. && d6 <= 0.) {
+    setSegment(a, c, d2 / (d2 - d6), res);
+    return;
+  }
+  const double va = d3 * d6 - d5 * d4;
+  if (va <= 0. && d4 - d3 >= 0. && d5 - d6 >= 0.) {
+    setSegment(b, c, (d4 - d3) / ((d4 - d3) + (d5 - d6)), res);
+    return;
+  }
+  const double area = va + vb + vc;
+  if (!(area > 0.)) {
+    // Degenerate triangle: the nearest of its edges.
+    Simplex edge = Simplex();
+    closestOnSegment(a, b, res);
+    double best = pointOf(*res).dot(pointOf(*res));
+    for (const auto& pair : {std::make_pair(&a, &c), std::make_pair(&b, &c)}) {
+      closestOnSegment(*pair.first, *pair.second, &edge);
+      const double distance2 = pointOf(edge).dot(pointOf(edge));
+      if (distance2 < best) {
+        best = distance2;
+        *res = edge;
+      }
+    }
+    return;
+  }
+  res->vertices[0] = a;
+  res->vertices[1] = b;
+  res->vertices[2] = c;
+  res->weights[1] = vb / area;
+  res->weights[2] = vc / area;
+  res->weights[0] = 1. - res->weights[1] - res->weights[2];
+  res->size = 3;
+}
+
+// Reduces 'simplex' to the face holding the point of its hull nearest to
+// the origin and returns whether the origin is inside a tetrahedron.
+bool reduce(Simplex* simplex) {
+  const Vertex* v = simplex->vertices;
+  switch (simplex->size) {
+    case 1:
+      simplex->weights[0] = 1.;
+      return false;
+    case 2: {
+      const Vertex p = v[0];
+      const Vertex q = v[1];
+      closestOnSegment(p, q, simplex);
+      return false;
+    }
+    case 3: {
+      const Vertex a = v[0];
+      const Vertex b = v[1];
+      const Vertex c = v[2];
+      closestOnTriangle(a, b, c, simplex);
+      return false;
+    }
+    default:
+      break;
+  }
+  // Faces with the origin on the other side from the fourth vertex, or any
+  // face of a flat tetrahedron.
+  static const int kFaces[4][4] = {
+      {0, 1, 2, 3}, {0, 1, 3, 2}, {0, 2, 3, 1}, {1, 2, 3, 0}};
+  const Simplex tetrahedron = *simplex;
+  const Vertex* t = tetrahedron.vertices;
+  bool inside = true;
+  double best = std::numeric_limits<double>::infinity();
+  Simplex face;
+  for (const auto& indices : kFaces) {
+    const Point3& p = t[indices[0]].w;
+    const Point3 normal = (t[indices[1]].w - p).cross(t[indices[2]].w - p);
+    const double origin_side = -normal.dot(p);
+    const double other_side = normal.dot(t[indices[3]].w - p);
+    if (origin_side * other_side > 0. ||
+        (origin_side == 0. && other_side != 0.)) {
+      continue;
+    }
+    inside = false;
+    closestOnTriangle(t[indices[0]], t[indices[1]], t[indices[2]], &face);
+    const Point3 nearest = pointOf(face);
+    if (nearest.dot(nearest) < best) {
+      best = nearest.dot(nearest);
+      *simplex = face;
+    }
+  }
+  if (inside) {
+    *simplex = tetrahedron;
+  }
+  return inside;
+}
+
+// Largest squared norm of the vertices of 'simplex', the scale of the
+// tolerances.
+double scaleOf(const Simplex& simplex) {
+  double res = 0.;
+  for (int i = 0; i < simplex.size; ++i) {
+    res = std::max(res, simplex.vertices[i].w.dot(simplex.vertices[i].w));
+  }
+  return res;
+}
+
+// Runs GJK on the cores from 'simplex', leaving in it the face nearest to
+// the origin, or a simplex holding the origin. Returns whether the cores
+// overlap and adds the iterations to 'iterations'.
+bool gjk(const Difference& difference, Simplex* simplex, int* iterations) {
+  for (int i = 0; i < kMaxGjkIterations; ++i) {
+    ++*iterations;
+    if (reduce(simplex)) {
+      return true;
+    }
+    const Point3 v = pointOf(*simplex);
+    const double v2 = v.dot(v);
+    if (v2 <= kOverlapTolerance * kOverlapTolerance * scaleOf(*simplex)) {
+      return true;
+    }
+    const Vertex w = difference.support(v * -1.);
+    if (v2 - v.dot(w.w) <= kGjkTolerance * v2) {
+      return false;
+    }
+    for (int k = 0; k < simplex->size; ++k) {
+      const Point3 d = simplex->vertices[k].w - w.w;
+      if (d.dot(d) == 0.) {
+        return false;
+      }
+    }
+    simplex->vertices[simplex->size++] = w;
+  }
+  return reduce(simplex);
+}
+
+// Starting simplex, from 'cache' when it holds one.
+Simplex startSimplex(const Difference& difference, const GjkCache* cache) {
+  Simplex res;
+  if (cache != nullptr && cache->size > 0) {
+    res.size = cache->size;
+    for (int i = 0; i < res.size; ++i) {
+      res.vertices[i] = difference.vertex(
+          Point3{cache->a[i][0], cache->a[i][1], cache->a[i][2]},
+          Point3{cache->b[i][0], cache->b[i][1], cache->b[i][2]});
+    }
+    return res;
+  }
+  // Along the offset between the shapes, the likely separating direction.
+  Point3 direction = difference.offset() * -1.;
+  if (direction.dot(direction) == 0.) {
+    direction = Point3{1., 0., 0.};
+  }
+  res.vertices[0] = difference.support(direction);
+  res.size = 1;
+  return res;
+}
+
+void store(const Simplex& simplex, GjkCache* cache) {
+  if (cache == nullptr) {
+    return;
+  }
+  cache->size = simplex.size;
+  for (int i = 0; i < simplex.size; ++i) {
+    const Vertex& v = simplex.vertices[i];
+    cache->a[i][0] = v.a.x;
+    cache->a[i][1] = v.a.y;
+    cache->a[i][2] = v.a.z;
+    cache->b[i][0] = v.b.x;
+    cache->b[i][1] = v.b.y;
+    cache->b[i][2] = v.b.z;
+  }
+}
+
+// Nearest points of the cores from a simplex and its weights, in the frame
+// of A.
+void corePoints(const Difference& difference, const Simplex& simplex,
+                Point3* a, Point3* b) {
+  *a = Point3{0., 0., 0.};
+  *b = Point3{0., 0., 0.};
+  for (int i = 0; i < simplex.size; ++i) {
+    *a = *a + simplex.vertices[i].a * simplex.weights[i];
+    *b = *b + difference.placeB(simplex.vertices[i].b) * simplex.weights[i];
+  }
+}
+
+// Unit vector perpendicular to 'v'.
+Point3 perpendicular(const Point3& v) {
+  const Point3 axis = std::abs(v.x) < std::abs(v.y)
+                          ? (std::abs(v.x) < std::abs(v.z)
+                                 ? Point3{1., 0., 0.}
+                                 : Point3{0., 0., 1.})
+                          : (std::abs(v.y) < std::abs(v.z)
+                                 ? Point3{0., 1., 0.}
+                                 : Point3{0., 0., 1.});
+  const Point3 res = v.cross(axis);
+  return res * (1. / std::sqrt(res.dot(res)));
+}
+
+// Grows a simplex holding the origin into a tetrahedron holding it, with
+// support points off its span. Returns false when the difference is flat,
+// setting 'normal' to a unit vector perpendicular to it.
+bool growToTetrahedron(const Difference& difference, Simplex* simplex,
+                       Point3* normal) {
+  const double tolerance =
+      kEpaTolerance * std::sqrt(std::max(scaleOf(*simplex), 1.));
+  // Candidate directions off the span of the simplex, both ways.
+  while (simplex->size < 4) {
+    const Vertex* v = simplex->vertices;
+    Point3 directions[4];
+    int num_directions = 0;
+    if (simplex->size == 1) {
+      directions[0] = Point3{1., 0., 0.};
+      directions[1] = Point3{0., 1., 0.};
+      directions[2] = Point3{0., 0., 1.};
+      num_directions = 3;
+    } else if (simplex->size == 2) {
+      const Point3 line = v[1].w - v[0].w;
+      directions[0] = perpendicular(line);
+      directions[1] = line.cross(directions[0]);
+      num_directions = 2;
+    } else {
+      directions[0] = (v[1].w - v[0].w).cross(v[2].w - v[0].w);
+      num_directions = 1;
+    }
+    bool grown = false;
+    for (int i = 0; i < num_directions && !grown; ++i) {
+      const Point3 unit =
+          directions[i] * (1. / std::sqrt(directions[i].dot(directions[i])));
+      for (const double sign : {1., -1.}) {
+        const Vertex w = difference.support(unit * sign);
+        if (std::abs(unit.dot(w.w - v[0].w)) > tolerance) {
+          simplex->vertices[simplex->size++] = w;
+          grown = true;
+          break;
+        }
+      }
+      if (!grown && simplex->size == 3) {
+        *normal = unit;
+      }
+    }
+    if (!grown) {
+      if (simplex->size == 1) {
+        *normal = Point3{0., 0., 1.};
+      } else if (simplex->size == 2) {
+        *normal = directions[0];
+      }
+      return false;
+    }
+  }
+  return true;
+}
+
+// Triangle of the EPA polytope with its outward unit normal and distance
+// from the origin.
+struct Face {
+  int v[3];
+  Point3 normal;
+  double distance;
+  bool live;
+};
+
+// Depth of the overlap of the cores by EPA from a tetrahedron holding the
+// origin. Sets 'a' and 'b' to the deepest points of the cores in the frame
+// of A and 'normal' to the direction from A to B, and returns the depth.
+// Returns a negative value when the tetrahedron is flat.
+double epa(const Difference& difference, const Simplex& tetrahedron,
+           Point3* a, Point3* b, Point3* normal, int* iterations) {
+  std::vector<Vertex> vertices(tetrahedron.vertices,
+                               tetrahedron.vertices + 4);
+  std::vector<Face> faces;
+  const auto addFace = [&](int i, int j, int k) {
+    const Point3& p = vertices[i].w;
+    const Point3 n = (vertices[j].w - p).cross(vertices[k].w - p);
+    const double length = std::sqrt(n.dot(n));
+    if (!(length > 0.)) {
+      return false;
+    }
+    const Point3 unit = n * (1. / length);
+    faces.push_back(Face{{i, j, k}, unit, unit.dot(p), true});
+    return true;
+  };
+  static const int kFaces[4][4] = {
+      {0, 1, 2, 3}, {0, 1, 3, 2}, {0, 2, 3, 1}, {1, 2, 3, 0}};
+  for (const auto& f : kFaces) {
+    const Point3& p = vertices[f[0]].w;
+    const Point3 n = (vertices[f[1]].w - p).cross(vertices[f[2]].w - p);
+    // Outward, away from the fourth vertex.
+    const bool flip = n.dot(vertices[f[3]].w - p) > 0.;
+    if (!addFace(f[0], flip ? f[2] : f[1], flip ? f[1] : f[2])) {
+      return -1.;
+    }
+  }
+  const double scale = std::sqrt(std::max(scaleOf(tetrahedron), 1.));
+  std::vector<std::pair<int, int>> horizon;
+  std::size_t nearest = 0;
+  for (int iteration = 0; iteration < kMaxEpaIterations; ++iteration) {
+    ++*iterations;
+    double best = std::numeric_limits<double>::infinity();
+    for (std::size_t i = 0; i < faces.size(); ++i) {
+      if (faces[i].live && faces[i].distance < best) {
+        best = faces[i].distance;
+        nearest = i;
+      }
+    }
+    const Face face = faces[nearest];
+    const Vertex w = difference.support(face.normal);
+    if (face.normal.dot(w.w) - face.distance <= kEpaTolerance * scale) {
+      break;
+    }
+    // Faces that see the new vertex are removed, and the edges of their
+    // hole joined to it.
+    const int index = static_cast<int>(vertices.size());
+    vertices.push_back(w);
+    horizon.clear();
+    for (Face& f : faces) {
+      if (!f.live || f.normal.dot(w.w - vertices[f.v[0]].w) <= 0.) {
+        continue;
+      }
+      f.live = false;
+      for (int e = 0; e < 3; ++e) {
+        const std::pair<int, int> edge(f.v[e], f.v[(e + 1) % 3]);
+        const auto twin = std::find(horizon.begin(), horizon.end(),
+                                    std::make_pair(edge.second, edge.first));
+        if (twin != horizon.end()) {
+          horizon.erase(twin);
+        } else {
+          horizon.push_back(edge);
+        }
+      }
+    }
+    if (horizon.empty()) {
+      break;
+    }
+    for (const std::pair<int, int>& edge : horizon) {
+      addFace(edge.first, edge.second, index);
+    }
+  }
+  // Barycentric coordinates of the projection of the origin on the face.
+  const Face& face = faces[nearest];
+  const Vertex& p = vertices[face.v[0]];
+  const Vertex& q = vertices[face.v[1]];
+  const Vertex& r = vertices[face.v[2]];
+  const Point3 projection = face.normal * face.distance;
+  const Point3 n = (q.w - p.w).cross(r.w - p.w);
+  const double area = n.dot(n);
+  Simplex weights;
+  weights.size = 3;
+  weights.vertices[0] = p;
+  weights.vertices[1] = q;
+  weights.vertices[2] = r;
+  weights.weights[1] = (projection - p.w).cross(r.w - p.w).dot(n) / area;
+  weights.weights[2] = (q.w - p.w).cross(projection - p.w).dot(n) / area;
+  weights.weights[0] = 1. - weights.weights[1] - weights.weights[2];
+  corePoints(difference, weights, a, b);
+  *normal = face.normal;
+  return std::max(face.distance, 0.);
+}
+
+// Contact of the cores in the frame of A turned into the world frame, with
+// the radii of the shapes.
+ConvexContact makeContact(const Isometry& pose_a, double core_distance,
+                          const Point3& a, const Point3& b,
+                          const Point3& normal, double radius_a,
+                          double radius_b, int iterations) {
+  ConvexContact res;
+  res.distance = core_distance - radius_a - radius_b;
+  res.point_a = pose_a * toVector(a + normal * radius_a);
+  res.point_b = pose_a * toVector(b - normal * radius_b);
+  res.normal = pose_a.rotation().product(toVector(normal));
+  res.iterations = iterations;
+  return res;
+}
+}  // namespace
+
+GjkCache::GjkCache() : size(0) {}
+
+double ConvexDistance(const ConvexShape& a, const Isometry& pose_a,
+                      const ConvexShape& b, const Isometry& pose_b,
+                      ConvexContact* contact, GjkCache* cache) {
+  const Difference difference(a, pose_a, b, pose_b);
+  Simplex simplex = startSimplex(difference, cache);
+  int iterations = 0;
+  const bool overlap = gjk(difference, &simplex, &iterations);
+  store(simplex, cache);
+  if (overlap) {
+    return 0.;
+  }
+  const Point3 v = pointOf(simplex);
+  const double core_distance = std::sqrt(v.dot(v));
+  const double res = core_distance - a.radius() - b.radius();
+  if (res <= 0.) {
+    return 0.;
+  }
+  if (contact != nullptr) {
+    Point3 point_a;
+    Point3 point_b;
+    corePoints(difference, simplex, &point_a, &point_b);
+    *contact = makeContact(pose_a, core_distance, point_a, point_b,
+                           v * (-1. / core_distance), a.radius(),
+                           b.radius(), iterations);
+  }
+  return res;
+}
+
+ConvexContact ConvexPenetration(const ConvexShape& a, const Isometry& pose_a,
+                                const ConvexShape& b, const Isometry& pose_b,
+                                GjkCache* cache) {
+  const Difference difference(a, pose_a, b, pose_b);
+  Simplex simplex = startSimplex(difference, cache);
+  int iterations = 0;
+  const bool overlap = gjk(difference, &simplex, &iterations);
+  store(simplex, cache);
+  Point3 point_a;
+  Point3 point_b;
+  if (!overlap) {
+    const Point3 v = pointOf(simplex);
+    const double core_distance = std::sqrt(v.dot(v));
+    corePoints(difference, simplex, &point_a, &point_b);
+    return makeContact(pose_a, core_distance, point_a, point_b,
+                       v * (-1. / core_distance), a.radius(), b.radius(),
+                       iterations);
+  }
+  // The cores overlap. When their difference is flat, they only touch
+  // across it, at depth 0 along its normal.
+  corePoints(difference, simplex, &point_a, &point_b);
+  Point3 normal{0., 0., 1.};
+  double depth = 0.;
+  if (growToTetrahedron(difference, &simplex, &normal)) {
+    Point3 deep_a;
+    Point3 deep_b;
+    Point3 deep_normal;
+    depth = epa(difference, simplex, &deep_a, &deep_b, &deep_normal,
+                &iterations);
+    if (depth >= 0.) {
+      point_a = deep_a;
+      point_b = deep_b;
+      normal = deep_normal;
+    } else {
+      depth = 0.;
+    }
+  }
+  return makeContact(pose_a, -depth, point_a, point_b, normal, a.radius(),
+                     b.radius(), iterations);
+}
+
+}  // namespace math
+}  // namespace ekumen
@@ -1,14 +1,71 @@
 #include "isometry.h"
 #include <cmath>
+#include <cstddef>
+#include <stdexcept>
+#include <vector>
 #include "matrix3.h"
+#include "text_format.h"
 #include "vector3.h"
 
 namespace ekumen {
 namespace math {
 namespace {
 constexpr int kMatrix3RowSize = 3;
+
+// Kinds of access of prefetchPoint().
+constexpr int kRead = 0;
+constexpr int kWrite = 1;
+
+// Pose as plain scalars, so that loops over buffers do not go through
+// Vector3 copies.
+struct PointTransform {
+  explicit PointTransform(const Isometry& pose) {
+    for (int i = 0; i < 3; ++i) {
+      for (int j = 0; j < 3; ++j) {
+        r[i][j] = pose.rotation()[i][j];
+      }
+      t[i] = pose.translation()[i];
+    }
+  }
+
+  // 'in' and 'out' may be the same point.
+  void apply(const double* in, double* out) const {
+    const double x = in[0];
+    const double y = in[1];
+    const double z = in[2];
+    out[0] = r[0][0] * x + r[0][1] * y + r[0][2] * z + t[0];
+    out[1] = r[1][0] * x + r[1][1] * y + r[1][2] * z + t[1];
+    out[2] = r[2][0] * x + r[2][1] * y + r[2][2] * z + t[2];
+  }
+
+  double r[3][3];
+  double t[3];
+};
+
+// Asks the cache for a point ahead of its use. A point may straddle two
+// cache lines, so both ends are fetched.
+template <int kAccess>
+void prefetchPoint(const double* point) {
+#if defined(__GNUC__)
+  __builtin_prefetch(point, kAccess, 3);
+  __builtin_prefetch(point + 2, kAccess, 3);
+#else
+  static_cast<void>(point);
+#endif
+}
+
+void assertValidIndices(const std::vector<std::size_t>& indices,
+                        std::size_t size) {
+  for (std::size_t index : indices) {
+    if (index >= size) {
+      throw std::out_of_range("Index to access a point is out of range.");
+    }
+  }
+}
 }  // namespace.
 
+const std::size_t Isometry::kPrefetchDistance;
+
 Isometry::Isometry(const Vector3& translation, const Matrix3& rotation)
     : translation_(translation), rotation_(rotation) {}
 
@@ -103,12 +160,95 @@ bool Isometry::operator==(const Isometry& rhs) const {
 bool Isometry::operator!=(const Isometry& rhs) const { return !(*this == rhs); }
 
 std::ostream& operator<<(std::ostream& os, const Isometry& obj) {
+  if (TextFormat::UsesDefaultFormat(os)) {
+    char buffer[TextFormat::kMaxIsometrySize];
+    os.write(buffer, TextFormat::Format(obj, buffer, sizeof(buffer),
+                                        static_cast<int>(os.precision())));
+    return os;
+  }
   os << "[T: " << obj.translation() << ", R:" << obj.rotation() << "]";
   return os;
 }
 
 Vector3 Isometry::transform(const Vector3& obj) const { return *this * obj; }
 
+void Isometry::transform(const PointsView& points) const {
+  transform(points, points);
+}
+
+void Isometry::transform(const ConstPointsView& input,
+                         const PointsView& output) const {
+  if (input.size() != output.size()) {
+    throw std::invalid_argument("Input and output sizes differ.");
+  }
+  const PointTransform pose(*this);
+  const double* in = input.data();
+  double* out = output.data();
+  for (std::size_t k = 0; k < input.size(); ++k) {
+    pose.apply(in, out);
+    in += input.stride();
+    out += output.stride();
+  }
+}
+
+void Isometry::transform(const PointsView& points,
+                         const std::vector<std::size_t>& indices,
+                         std::size_t prefetch_distance) const {
+  assertValidIndices(indices, points.size());
+  const PointTransform pose(*this);
+  const std::size_t stride = points.stride();
+  double* data = points.data();
+  for (std::size_t k = 0; k < indices.size(); ++k) {
+    if (prefetch_distance != 0 && k + prefetch_distance < indices.size()) {
+      prefetchPoint<kWrite>(data + stride * indices[k + prefetch_distance]);
+    }
+    double* point = data + stride * indices[k];
+    pose.apply(point, point);
+  }
+}
+
+void Isometry::transformGather(const ConstPointsView& input,
+                               const std::vector<std::size_t>& indices,
+                               const PointsView& output,
+                               std::size_t prefetch_distance) const {
+  if (indices.size() != output.size()) {
+    throw std::invalid_argument("Index and output sizes differ.");
+  }
+  assertValidIndices(indices, input.size());
+  const PointTransform pose(*this);
+  const std::size_t stride = input.stride();
+  const double* in = input.data();
+  double* out = output.data();
+  for (std::size_t k = 0; k < indices.size(); ++k) {
+    if (prefetch_distance != 0 && k + prefetch_distance < indices.size()) {
+      prefetchPoint<kRead>(in + stride * indices[k + prefetch_distance]);
+    }
+    pose.apply(in + stride * indices[k], out);
+    out += output.stride();
+  }
+}
+
+void Isometry::transformScatter(const ConstPointsView& input,
+                                const std::vector<std::size_t>& indices,
+                                const PointsView& output,
+                                std::size_t prefetch_distance) const {
+  if (indices.size() != input.size()) {
+    throw std::invalid_argument("Index and input sizes differ.");
+  }
+  assertValidIndices(indices, output.size());
+  const PointTransform pose(*this);
+  const std::size_t stride = output.stride();
+  const double* in = input.data();
+  double* out = output.data();
+  for (std::size_t k = 0; k < indices.size(); ++k) {
+    if (prefetch_distance != 0 && k + prefetch_distance < indices.size()) {
+      prefetchPoint<kWrite>(out + stride * indices[k + prefetch_distance]);
+    }
+    pose.apply(in, out + stride * indices[k]);
+    in += input.stride();
+  }
+}
+
 Isometry Isometry::compose(const Isometry& obj) const { return *this * obj; }
 
 Isometry Isometry::inverse() const {
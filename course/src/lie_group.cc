@@ -0,0 +1,217 @@
+#include "lie_group.h"
+#include <algorithm>
+#include <cmath>
+#include "isometry.h"
+#include "matrix.h"
+#include "matrix3.h"
+#include "vector3.h"
+
+namespace ekumen {
+namespace math {
+namespace {
+// Below this squared angle the closed-form coefficients lose precision to
+// cancellation and are replaced by their Taylor expansions.
+constexpr double kTaylorThreshold = 1e-4;
+
+// Below this cosine the rotation angle is close to pi and the axis is
+// extracted from the symmetric part of the rotation matrix instead.
+constexpr double kNearPiCosine = -0.9;
+
+// Coefficients of the series expansions of SO(3) maps for a given angle.
+struct Coefficients {
+  // sin(t) / t
+  double a;
+  // (1 - cos(t)) / t^2
+  double b;
+  // (t - sin(t)) / t^3
+  double c;
+};
+
+Coefficients computeCoefficients(const double& theta_sq) {
+  Coefficients res;
+  if (theta_sq < kTaylorThreshold) {
+    const double theta_4 = theta_sq * theta_sq;
+    res.a = 1. - theta_sq / 6. + theta_4 / 120.;
+    res.b = 0.5 - theta_sq / 24. + theta_4 / 720.;
+    res.c = 1. / 6. - theta_sq / 120. + theta_4 / 5040.;
+  } else {
+    const double theta = std::sqrt(theta_sq);
+    const double sin_theta = std::sin(theta);
+    const double cos_theta = std::cos(theta);
+    res.a = sin_theta / theta;
+    res.b = (1. - cos_theta) / theta_sq;
+    res.c = (theta - sin_theta) / (theta_sq * theta);
+  }
+  return res;
+}
+
+// Computes I + a * [w]x + b * [w]x^2 without building the intermediate
+// matrices, using [w]x^2 = w * w^T - |w|^2 * I.
+Matrix3 skewPolynomial(const Vector3& w, const double& a, const double& b) {
+  const double x = w.x();
+  const double y = w.y();
+  const double z = w.z();
+  const double diagonal = 1. - b * (x * x + y * y + z * z);
+  return Matrix3({diagonal + b * x * x, b * x * y - a * z, b * x * z + a * y,
+                  b * y * x + a * z, diagonal + b * y * y, b * y * z - a * x,
+                  b * z * x - a * y, b * z * y + a * x, diagonal + b * z * z});
+}
+
+// Returns the coefficient of [w]x^2 in the inverse of the SO(3) Jacobians:
+// 1 / t^2 - (1 + cos(t)) / (2 * t * sin(t)).
+double inverseJacobianCoefficient(const double& theta_sq) {
+  if (theta_sq < kTaylorThreshold) {
+    return 1. / 12. + theta_sq / 720. + theta_sq * theta_sq / 30240.;
+  }
+  const double theta = std::sqrt(theta_sq);
+  return 1. / theta_sq -
+         (1. + std::cos(theta)) / (2. * theta * std::sin(theta));
+}
+
+// Computes the coupling block Q(rho, omega) of the SE(3) left Jacobian
+// (Barfoot, "State Estimation for Robotics", eq. 7.86).
+Matrix3 couplingBlock(const Vector3& rho, const Vector3& omega) {
+  const double theta_sq = omega.dot(omega);
+  // c1 = (t - sin(t)) / t^3, c2 = (t^2 + 2 * cos(t) - 2) / (2 * t^4) and
+  // c3 = (2 * t - 3 * sin(t) + t * cos(t)) / (2 * t^5). The last two cancel
+  // badly, so their series are used up to a larger angle.
+  double c1;
+  double c2;
+  double c3;
+  if (theta_sq < 1e-2) {
+    const double t2 = theta_sq;
+    const double t4 = t2 * t2;
+    const double t6 = t4 * t2;
+    c1 = 1. / 6. - t2 / 120. + t4 / 5040. - t6 / 362880.;
+    c2 = 1. / 24. - t2 / 720. + t4 / 40320. - t6 / 3628800.;
+    c3 = 1. / 120. - t2 / 2520. + t4 / 120960. - t6 / 9979200.;
+  } else {
+    const double theta = std::sqrt(theta_sq);
+    const double sin_theta = std::sin(theta);
+    const double cos_theta = std::cos(theta);
+    c1 = (theta - sin_theta) / (theta_sq * theta);
+    c2 = (0.5 * theta_sq + cos_theta - 1.) / (theta_sq * theta_sq);
+    c3 = (2. * theta - 3. * sin_theta + theta * cos_theta) /
+         (2. * theta_sq * theta_sq * theta);
+  }
+  const Matrix3 w = SO3::Hat(omega);
+  const Matrix3 r = SO3::Hat(rho);
+  const Matrix3 wr = w.product(r);
+  const Matrix3 rw = r.product(w);
+  const Matrix3 wrw = wr.product(w);
+  return r * 0.5 + (wr + rw + wrw) * c1 +
+         (w.product(wr) + rw.product(w) - wrw * 3.) * c2 +
+         (wrw.product(w) + w.product(wrw)) * c3;
+}
+}  // namespace
+
+Matrix3 SO3::Hat(const Vector3& omega) {
+  return Matrix3({0., -omega.z(), omega.y(), omega.z(), 0., -omega.x(),
+                  -omega.y(), omega.x(), 0.});
+}
+
+Vector3 SO3::Vee(const Matrix3& skew) {
+  return Vector3(skew[2][1], skew[0][2], skew[1][0]);
+}
+
+Matrix3 SO3::Exp(const Vector3& omega) {
+  const Coefficients coeffs = computeCoefficients(omega.dot(omega));
+  return skewPolynomial(omega, coeffs.a, coeffs.b);
+}
+
+Vector3 SO3::Log(const Matrix3& rotation) {
+  const Matrix3& r = rotation;
+  // Half the vee of the antisymmetric part equals sin(t) * axis.
+  const Vector3 sin_axis(0.5 * (r[2][1] - r[1][2]), 0.5 * (r[0][2] - r[2][0]),
+                         0.5 * (r[1][0] - r[0][1]));
+  const double cos_theta =
+      std::max(-1., std::min(1., 0.5 * (r[0][0] + r[1][1] + r[2][2] - 1.)));
+  const double sin_theta = sin_axis.norm();
+  const double theta = std::atan2(sin_theta, cos_theta);
+
+  if (cos_theta > kNearPiCosine) {
+    const double theta_sq = theta * theta;
+    const double factor =
+        theta_sq < kTaylorThreshold
+            ? 1. + theta_sq / 6. + 7. * theta_sq * theta_sq / 360.
+            : theta / sin_theta;
+    return sin_axis * factor;
+  }
+
+  // Near pi: the symmetric part is cos(t) * I + (1 - cos(t)) * axis * axis^T.
+  // The largest diagonal entry gives the best conditioned axis component.
+  int k = 0;
+  for (auto i = 1; i < 3; ++i) {
+    if (r[i][i] > r[k][k]) {
+      k = i;
+    }
+  }
+  const double one_minus_cos = 1. - cos_theta;
+  Vector3 axis;
+  axis[k] = std::sqrt(std::max(0., (r[k][k] - cos_theta) / one_minus_cos));
+  for (auto i = 0; i < 3; ++i) {
+    if (i != k) {
+      axis[i] = 0.5 * (r[k][i] + r[i][k]) / (one_minus_cos * axis[k]);
+    }
+  }
+  if (axis.dot(sin_axis) < 0.) {
+    axis = axis * (-1.);
+  }
+  return axis * (theta / axis.norm());
+}
+
+Matrix3 SO3::LeftJacobian(const Vector3& omega) {
+  const Coefficients coeffs = computeCoefficients(omega.dot(omega));
+  return skewPolynomial(omega, coeffs.b, coeffs.c);
+}
+
+Matrix3 SO3::RightJacobian(const Vector3& omega) {
+  const Coefficients coeffs = computeCoefficients(omega.dot(omega));
+  return skewPolynomial(omega, -coeffs.b, coeffs.c);
+}
+
+Matrix3 SO3::LeftJacobianInverse(const Vector3& omega) {
+  return skewPolynomial(omega, -0.5,
+                        inverseJacobianCoefficient(omega.dot(omega)));
+}
+
+Matrix3 SO3::RightJacobianInverse(const Vector3& omega) {
+  return skewPolynomial(omega, 0.5,
+                        inverseJacobianCoefficient(omega.dot(omega)));
+}
+
+Isometry SE3::Exp(const Vector3& rho, const Vector3& omega) {
+  const Coefficients coeffs = computeCoefficients(omega.dot(omega));
+  return Isometry(skewPolynomial(omega, coeffs.b, coeffs.c).product(rho),
+                  skewPolynomial(omega, coeffs.a, coeffs.b));
+}
+
+void SE3::Log(const Isometry& pose, Vector3* rho, Vector3* omega) {
+  *omega = SO3::Log(pose.rotation());
+  *rho = SO3::LeftJacobianInverse(*omega).product(pose.translation());
+}
+
+Matrix6 SE3::Adjoint(const Isometry& pose) {
+  const Matrix3& rotation = pose.rotation();
+  Matrix6 res;
+  res.setBlock(0, 0, rotation);
+  res.setBlock(0, 3, SO3::Hat(pose.translation()).product(rotation));
+  res.setBlock(3, 3, rotation);
+  return res;
+}
+
+Matrix6 SE3::LeftJacobian(const Vector3& rho, const Vector3& omega) {
+  const Matrix3 jacobian = SO3::LeftJacobian(omega);
+  Matrix6 res;
+  res.setBlock(0, 0, jacobian);
+  res.setBlock(0, 3, couplingBlock(rho, omega));
+  res.setBlock(3, 3, jacobian);
+  return res;
+}
+
+Matrix6 SE3::RightJacobian(const Vector3& rho, const Vector3& omega) {
+  return LeftJacobian(rho * (-1.), omega * (-1.));
+}
+
+}  // namespace math
+}  // namespace ekumen
@@ -1,17 +1,352 @@
+#include <sys/stat.h>
+
+#include <cerrno>
+#include <cstdlib>
+#include <fstream>
 #include <iostream>
+#include <stdexcept>
+#include <string>
 #include <vector>
 
+#include "async_io.h"
+#include "async_transform.h"
+#include "batch_transform.h"
+#include "isometry.h"
+#include "text_format.h"
+#include "text_parser.h"
 #include "vector3.h"
 
-int main(int argc, char **argv) {
-  (void)argc;
-  (void)argv;
+namespace {
+using ekumen::math::AsyncIoBackend;
+using ekumen::math::AsyncTransform;
+using ekumen::math::BatchTransform;
+using ekumen::math::BatchTransformStats;
+using ekumen::math::ElementKind;
+using ekumen::math::Isometry;
+using ekumen::math::StreamFormat;
+using ekumen::math::TextFormat;
+using ekumen::math::TextParser;
+using ekumen::math::Vector3;
+
+// Exit codes.
+constexpr int kSuccess = 0;
+constexpr int kFailure = 1;
+constexpr int kUsageError = 2;
+
+// Size of the stream buffers of input and output files.
+constexpr std::size_t kFileBufferSize = 1 << 20;
+
+const char kUsage[] =
+    "Usage: cpp_course [options]\n"
+    "Applies an isometry to a stream of points or poses. Points are\n"
+    "transformed and poses are composed on the left with the isometry.\n"
+    "\n"
+    "  -i, --input PATH         Input file, '-' for stdin (default).\n"
+    "  -o, --output PATH        Output file, '-' for stdout (default).\n"
+    "  --input-format FORMAT    'text' (default) or 'binary'.\n"
+    "  --output-format FORMAT   Defaults to the input format.\n"
+    "  --poses                  Text input holds poses instead of points.\n"
+    "  --translation X,Y,Z      Translation of the isometry.\n"
+    "  --euler PSI,THETA,PHI    Rotation as x-y-z Euler angles in radians.\n"
+    "  --axis X,Y,Z             Rotation axis, used with --angle.\n"
+    "  --angle RADIANS          Rotation angle around --axis.\n"
+    "  --batch-size N           Elements per batch (default 65536).\n"
+    "  --threads N              Threads that transform each batch.\n"
+    "  --precision N            Significant digits of text output, -1 for\n"
+    "                           the shortest exact form (default).\n"
+    "  --io-backend BACKEND     'auto' (default), 'io_uring' or 'threads'.\n"
+    "  --stats                  Prints throughput statistics to stderr.\n"
+    "  -h, --help               Prints this help.\n"
+    "\n"
+    "Text streams hold one element per line in the operator<< format, and\n"
+    "binary streams a binary array. Binary output of text input must go to\n"
+    "a file. Binary files are transformed with asynchronous I/O, which\n"
+    "takes neither --batch-size nor --precision.\n";
+
+// Command line errors.
+class UsageError : public std::runtime_error {
+ public:
+  explicit UsageError(const std::string& message)
+      : std::runtime_error(message) {}
+};
+
+double parseScalar(const std::string& text, const std::string& flag) {
+  try {
+    return TextParser::Parse<double>(text);
+  } catch (const std::invalid_argument&) {
+    throw UsageError("Invalid number '" + text + "' for " + flag + ".");
+  }
+}
+
+long parseInteger(const std::string& text, const std::string& flag) {
+  char* end = nullptr;
+  errno = 0;
+  const long value = std::strtol(text.c_str(), &end, 10);
+  if (text.empty() || *end != '\0' || errno == ERANGE) {
+    throw UsageError("Invalid integer '" + text + "' for " + flag + ".");
+  }
+  return value;
+}
+
+// Parses 'X,Y,Z'.
+Vector3 parseVector(const std::string& text, const std::string& flag) {
+  std::vector<double> values;
+  std::size_t begin = 0;
+  for (;;) {
+    const std::size_t comma = text.find(',', begin);
+    values.push_back(parseScalar(text.substr(begin, comma - begin), flag));
+    if (comma == std::string::npos) {
+      break;
+    }
+    begin = comma + 1;
+  }
+  if (values.size() != 3) {
+    throw UsageError(flag + " takes three comma-separated numbers.");
+  }
+  return Vector3(values[0], values[1], values[2]);
+}
+
+StreamFormat parseFormat(const std::string& text, const std::string& flag) {
+  if (text == "text") {
+    return StreamFormat::kText;
+  }
+  if (text == "binary") {
+    return StreamFormat::kBinary;
+  }
+  throw UsageError("Invalid format '" + text + "' for " + flag + ".");
+}
+
+AsyncIoBackend parseBackend(const std::string& text, const std::string& flag) {
+  if (text == "auto") {
+    return AsyncIoBackend::kAuto;
+  }
+  if (text == "io_uring") {
+    return AsyncIoBackend::kIoUring;
+  }
+  if (text == "threads") {
+    return AsyncIoBackend::kThreads;
+  }
+  throw UsageError("Invalid backend '" + text + "' for " + flag + ".");
+}
+
+struct Arguments {
+  std::string input;
+  std::string output;
+  BatchTransform::Options options;
+  AsyncIoBackend backend;
+  // Whether binary files are transformed with AsyncTransform.
+  bool async;
+  Isometry pose;
+  bool stats;
+  bool help;
+};
+
+Arguments parseArguments(int argc, char** argv) {
+  Arguments res;
+  res.input = "-";
+  res.output = "-";
+  res.backend = AsyncIoBackend::kAuto;
+  res.stats = false;
+  res.help = false;
+  bool has_output_format = false;
+  bool has_batch_size = false;
+  bool has_precision = false;
+  bool has_euler = false;
+  bool has_axis = false;
+  bool has_angle = false;
+  Vector3 translation;
+  Vector3 euler;
+  Vector3 axis;
+  double angle = 0.;
+
+  for (int i = 1; i < argc; ++i) {
+    const std::string flag = argv[i];
+    // Gets the value of flags that take one.
+    auto value = [&]() -> std::string {
+      if (i + 1 >= argc) {
+        throw UsageError(flag + " needs a value.");
+      }
+      return argv[++i];
+    };
+    if (flag == "-h" || flag == "--help") {
+      res.help = true;
+    } else if (flag == "-i" || flag == "--input") {
+      res.input = value();
+    } else if (flag == "-o" || flag == "--output") {
+      res.output = value();
+    } else if (flag == "--input-format") {
+      res.options.input_format = parseFormat(value(), flag);
+    } else if (flag == "--output-format") {
+      res.options.output_format = parseFormat(value(), flag);
+      has_output_format = true;
+    } else if (flag == "--poses") {
+      res.options.kind = ElementKind::kPose;
+    } else if (flag == "--translation") {
+      translation = parseVector(value(), flag);
+    } else if (flag == "--euler") {
+      euler = parseVector(value(), flag);
+      has_euler = true;
+    } else if (flag == "--axis") {
+      axis = parseVector(value(), flag);
+      has_axis = true;
+    } else if (flag == "--angle") {
+      angle = parseScalar(value(), flag);
+      has_angle = true;
+    } else if (flag == "--batch-size") {
+      const long size = parseInteger(value(), flag);
+      if (size < 1) {
+        throw UsageError("--batch-size must be positive.");
+      }
+      res.options.batch_size = static_cast<std::size_t>(size);
+      has_batch_size = true;
+    } else if (flag == "--threads") {
+      const long threads = parseInteger(value(), flag);
+      if (threads < 1 || threads > 1024) {
+        throw UsageError("--threads must be in [1, 1024].");
+      }
+      res.options.num_threads = static_cast<int>(threads);
+    } else if (flag == "--precision") {
+      const long precision = parseInteger(value(), flag);
+      if (precision < TextFormat::kRoundTrip ||
+          precision > TextFormat::kMaxPrecision) {
+        throw UsageError("--precision must be in [" +
+                         std::to_string(TextFormat::kRoundTrip) + ", " +
+                         std::to_string(TextFormat::kMaxPrecision) + "].");
+      }
+      res.options.precision = static_cast<int>(precision);
+      has_precision = true;
+    } else if (flag == "--io-backend") {
+      res.backend = parseBackend(value(), flag);
+    } else if (flag == "--stats") {
+      res.stats = true;
+    } else {
+      throw UsageError("Unknown option '" + flag + "'.");
+    }
+  }
+
+  if (!has_output_format) {
+    res.options.output_format = res.options.input_format;
+  }
+  // Binary files take the asynchronous path, everything else streams.
+  res.async = res.input != "-" && res.output != "-" &&
+              res.options.input_format == StreamFormat::kBinary &&
+              res.options.output_format == StreamFormat::kBinary;
+  if (res.async && (has_batch_size || has_precision)) {
+    throw UsageError(
+        "--batch-size and --precision do not apply to binary files.");
+  }
+  if (has_axis != has_angle) {
+    throw UsageError("--axis and --angle go together.");
+  }
+  if (has_axis && has_euler) {
+    throw UsageError("--euler and --axis are exclusive.");
+  }
+  if (has_axis && axis.norm() == 0.) {
+    throw UsageError("--axis must not be zero.");
+  }
+  Isometry rotation;
+  if (has_euler) {
+    rotation = Isometry::FromEulerAngles(euler.x(), euler.y(), euler.z());
+  } else if (has_axis) {
+    rotation = Isometry::RotateAround(axis, angle);
+  }
+  res.pose = Isometry::FromTranslation(translation) * rotation;
+  return res;
+}
+
+// Whether both paths name the same existing file, which opening the output
+// would truncate before the input is read.
+bool isSameFile(const std::string& a, const std::string& b) {
+  struct stat a_stat;
+  struct stat b_stat;
+  return a != "-" && b != "-" && ::stat(a.c_str(), &a_stat) == 0 &&
+         ::stat(b.c_str(), &b_stat) == 0 && a_stat.st_dev == b_stat.st_dev &&
+         a_stat.st_ino == b_stat.st_ino;
+}
+
+void printStats(const BatchTransformStats& stats) {
+  std::cerr << "elements: " << stats.elements << "\n"
+            << "batches: " << stats.batches << "\n"
+            << "total seconds: " << stats.total_seconds << "\n"
+            << "read seconds: " << stats.read_seconds << "\n"
+            << "transform seconds: " << stats.transform_seconds << "\n"
+            << "write seconds: " << stats.write_seconds << "\n"
+            << "stall seconds: " << stats.stall_seconds << "\n"
+            << "elements per second: " << stats.throughput() << std::endl;
+}
+}  // namespace
+
+int main(int argc, char** argv) {
+  // Standard streams are only used through C++ streams.
+  std::ios::sync_with_stdio(false);
+
+  Arguments arguments;
+  try {
+    arguments = parseArguments(argc, argv);
+  } catch (const UsageError& e) {
+    std::cerr << "cpp_course: " << e.what() << "\n\n" << kUsage;
+    return kUsageError;
+  }
+  if (arguments.help) {
+    std::cout << kUsage;
+    return kSuccess;
+  }
 
-  const ekumen::math::Vector3 p(1, 2, 3);
-  ekumen::math::Vector3 q;
-  q = p;
+  try {
+    if (isSameFile(arguments.input, arguments.output)) {
+      throw std::runtime_error("'" + arguments.input +
+                               "' is both the input and the output.");
+    }
+    if (arguments.async) {
+      AsyncTransform::Options options;
+      options.num_threads = arguments.options.num_threads;
+      options.backend = arguments.backend;
+      const BatchTransformStats stats = AsyncTransform::Run(
+          arguments.pose, arguments.input, arguments.output, options);
+      if (arguments.stats) {
+        printStats(stats);
+      }
+      return kSuccess;
+    }
 
-  std::cout << "Hello world." << std::endl;
+    std::vector<char> input_buffer(kFileBufferSize);
+    std::vector<char> output_buffer(kFileBufferSize);
+    std::ifstream input_file;
+    std::ofstream output_file;
+    std::istream* is = &std::cin;
+    std::ostream* os = &std::cout;
+    if (arguments.input != "-") {
+      input_file.rdbuf()->pubsetbuf(input_buffer.data(), input_buffer.size());
+      input_file.open(arguments.input, std::ios::binary);
+      if (!input_file) {
+        throw std::runtime_error("Cannot open '" + arguments.input + "'.");
+      }
+      is = &input_file;
+    }
+    if (arguments.output != "-") {
+      output_file.rdbuf()->pubsetbuf(output_buffer.data(),
+                                     output_buffer.size());
+      output_file.open(arguments.output, std::ios::binary | std::ios::trunc);
+      if (!output_file) {
+        throw std::runtime_error("Cannot create '" + arguments.output + "'.");
+      }
+      os = &output_file;
+    }
 
-  return 0;
+    const BatchTransformStats stats =
+        BatchTransform::Run(arguments.pose, arguments.options, is, os);
+    if (output_file.is_open()) {
+      output_file.close();
+      if (!output_file) {
+        throw std::runtime_error("Cannot write '" + arguments.output + "'.");
+      }
+    }
+    if (arguments.stats) {
+      printStats(stats);
+    }
+  } catch (const std::exception& e) {
+    std::cerr << "cpp_course: " << e.what() << std::endl;
+    return kFailure;
+  }
+  return kSuccess;
 }
@@ -1,32 +1,16 @@
 #include "matrix3.h"
+#include "text_format.h"
 #include "vector3.h"
 
 #include <initializer_list>
-#include <iomanip>
 #include <iostream>
-#include <sstream>
 #include <stdexcept>
-#include <string>
 
 namespace ekumen {
 namespace math {
 namespace {
 constexpr int kMatrix3ElementSize = 9;
 constexpr int kMatrix3RowSize = 3;
-
-// Returns a stringstream with the format: '[first, second, third]'.
-template <class T>
-std::ostringstream formatStr(const T& first, const T& second, const T& third) {
-  std::ostringstream oss;
-  oss << std::setprecision(9) << "[" << first << ", " << second << ", " << third
-      << "]";
-  return oss;
-}
-
-// Formats a string from a Vector3 object with the format: '[x, y, z]'.
-std::string formatRow(const Vector3& obj) {
-  return formatStr<double>(obj.x(), obj.y(), obj.z()).str();
-}
 }  // namespace
 
 const Matrix3 Matrix3::kIdentity = Matrix3({1, 0, 0}, {0, 1, 0}, {0, 0, 1});
@@ -41,31 +25,28 @@ Matrix3::Matrix3(const Vector3& row0, const Vector3& row1, const Vector3& row2)
 Matrix3::Matrix3(const Matrix3& obj)
     : Matrix3(obj.row(0), obj.row(1), obj.row(2)) {}
 
-Matrix3::Matrix3(Matrix3&& obj) : rows_(std::move(obj.rows_)) {}
+Matrix3::Matrix3(Matrix3&& obj)
+    : Matrix3(obj.row(0), obj.row(1), obj.row(2)) {}
 
 Matrix3::Matrix3(std::initializer_list<double> matrix) {
   if (matrix.size() != kMatrix3ElementSize) {
     throw std::invalid_argument("Invalid matrix size.");
   }
-  for (auto i = 0; i < kMatrix3ElementSize; i += 3) {
-    Vector3 row(*(matrix.begin() + i), *(matrix.begin() + i + 1),
-                *(matrix.begin() + i + 2));
-    rows_.push_back(row);
+  for (auto i = 0; i < kMatrix3RowSize; ++i) {
+    rows_[i] = Vector3(matrix.begin()[3 * i], matrix.begin()[3 * i + 1],
+                       matrix.begin()[3 * i + 2]);
   }
 }
 
 Matrix3& Matrix3::operator=(const Matrix3& obj) {
-  rows_ = obj.rows_;
+  for (auto i = 0; i < kMatrix3RowSize; ++i) {
+    rows_[i] = obj.rows_[i];
+  }
   return *this;
 }
 
 Matrix3& Matrix3::operator=(Matrix3&& obj) {
-  if (this == &obj) {
-    return *this;
-  }
-
-  rows_ = std::move(obj.rows_);
-  return *this;
+  return *this = static_cast<const Matrix3&>(obj);
 }
 
 Matrix3 Matrix3::operator+(const Matrix3& obj) const {
@@ -107,9 +88,9 @@ Vector3& Matrix3::operator[](int index) {
 }
 
 std::ostream& operator<<(std::ostream& os, const Matrix3& obj) {
-  os << formatStr<std::string>(formatRow(obj.row(0)), formatRow(obj.row(1)),
-                               formatRow(obj.row(2)))
-            .str();
+  char buffer[TextFormat::kMaxMatrix3Size];
+  TextFormat::Format(obj, buffer, sizeof(buffer));
+  os << buffer;
   return os;
 }
 
@@ -168,6 +149,8 @@ Matrix3 Matrix3::inverse() const {
   return Matrix3(row1, row2, row3) * factor;
 }
 
+Matrix3 Matrix3::transpose() const { return Matrix3(col(0), col(1), col(2)); }
+
 void Matrix3::assertValidAccessIndex(int index) const {
   if (index < 0 || index > 2) {
     throw std::out_of_range("Index to access a row must be in range [0;2].");
@@ -0,0 +1,239 @@
+#include "morton.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <numeric>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+#include "cpu_features.h"
+#include "parallel.h"
+#include "point_cloud.h"
+#include "vector3.h"
+
+namespace ekumen {
+namespace math {
+namespace {
+// Bits sorted per radix pass: six passes cover a Morton code, and the
+// histogram of a chunk fits in the L1 cache.
+constexpr int kRadixBits = 11;
+constexpr std::size_t kRadixSize = std::size_t{1} << kRadixBits;
+
+// Keys below which a chunk is sorted by a single thread.
+constexpr std::size_t kMinSortChunkSize = 1 << 16;
+
+constexpr std::uint32_t kMaxCell = (std::uint32_t{1} << kMortonBits) - 1;
+
+// Spreads the low 21 bits of 'value' to every third bit.
+inline std::uint64_t spreadBits(std::uint64_t value) {
+  value &= kMaxCell;
+  value = (value | value << 32) & 0x1f00000000ffffull;
+  value = (value | value << 16) & 0x1f0000ff0000ffull;
+  value = (value | value << 8) & 0x100f00f00f00f00full;
+  value = (value | value << 4) & 0x10c30c30c30c30c3ull;
+  value = (value | value << 2) & 0x1249249249249249ull;
+  return value;
+}
+
+// Inverse of spreadBits().
+inline std::uint32_t compactBits(std::uint64_t value) {
+  value &= 0x1249249249249249ull;
+  value = (value ^ (value >> 2)) & 0x10c30c30c30c30c3ull;
+  value = (value ^ (value >> 4)) & 0x100f00f00f00f00full;
+  value = (value ^ (value >> 8)) & 0x1f0000ff0000ffull;
+  value = (value ^ (value >> 16)) & 0x1f00000000ffffull;
+  value = (value ^ (value >> 32)) & kMaxCell;
+  return static_cast<std::uint32_t>(value);
+}
+
+// Cell of a coordinate already offset and scaled. The conversion goes
+// through int32, which AVX2 vectorizes, unlike conversions to int64.
+inline std::uint64_t cellOf(double value) {
+  value = value > 0. ? value : 0.;
+  value = value < kMaxCell ? value : kMaxCell;
+  return static_cast<std::uint64_t>(static_cast<std::int32_t>(value));
+}
+
+// Codes of the points in [begin; end), with coordinates offset and scaled
+// into cells.
+inline void codesLoop(const double* x, const double* y, const double* z,
+                      const double* offset, const double* scale,
+                      std::size_t begin, std::size_t end,
+                      std::uint64_t* codes) {
+  for (std::size_t i = begin; i < end; ++i) {
+    codes[i] = spreadBits(cellOf((x[i] - offset[0]) * scale[0])) |
+               spreadBits(cellOf((y[i] - offset[1]) * scale[1])) << 1 |
+               spreadBits(cellOf((z[i] - offset[2]) * scale[2])) << 2;
+  }
+}
+
+#ifdef EKUMEN_AVX2_DISPATCH
+EKUMEN_TARGET_AVX2 void codesLoopAvx2(
+    const double* x, const double* y, const double* z, const double* offset,
+    const double* scale, std::size_t begin, std::size_t end,
+    std::uint64_t* codes) {
+  codesLoop(x, y, z, offset, scale, begin, end, codes);
+}
+#endif
+
+// Computes the codes of the points in [begin; end).
+void computeCodes(const PointCloud& cloud, const Vector3& min,
+                  const Vector3& max, std::size_t begin, std::size_t end,
+                  std::uint64_t* codes) {
+  double offset[3];
+  double scale[3];
+  for (int i = 0; i < 3; ++i) {
+    const double extent = max[i] - min[i];
+    offset[i] = min[i];
+    scale[i] = extent > 0. ? (kMaxCell + 1.) / extent : 0.;
+  }
+#ifdef EKUMEN_AVX2_DISPATCH
+  if (CpuHasAvx2()) {
+    codesLoopAvx2(cloud.x(), cloud.y(), cloud.z(), offset, scale, begin, end,
+                  codes);
+    return;
+  }
+#endif
+  codesLoop(cloud.x(), cloud.y(), cloud.z(), offset, scale, begin, end,
+            codes);
+}
+}  // namespace
+
+std::uint64_t MortonEncode(std::uint32_t x, std::uint32_t y,
+                           std::uint32_t z) {
+  return spreadBits(x) | spreadBits(y) << 1 | spreadBits(z) << 2;
+}
+
+void MortonDecode(std::uint64_t code, std::uint32_t* x, std::uint32_t* y,
+                  std::uint32_t* z) {
+  *x = compactBits(code);
+  *y = compactBits(code >> 1);
+  *z = compactBits(code >> 2);
+}
+
+void MortonCodes(const PointCloud& cloud, const Vector3& min,
+                 const Vector3& max, std::vector<std::uint64_t>* codes) {
+  for (int i = 0; i < 3; ++i) {
+    if (!(min[i] <= max[i])) {
+      throw std::invalid_argument("Morton box must not be inverted or NaN.");
+    }
+  }
+  codes->resize(cloud.size());
+  computeCodes(cloud, min, max, 0, cloud.size(), codes->data());
+}
+
+std::vector<std::size_t> RadixSort(std::vector<std::uint64_t>* keys,
+                                   int num_bits, int num_threads) {
+  if (num_bits < 1 || num_bits > 64) {
+    throw std::invalid_argument("Radix sort keys must have 1 to 64 bits.");
+  }
+  const std::size_t size = keys->size();
+  std::vector<std::size_t> order(size);
+  std::iota(order.begin(), order.end(), std::size_t{0});
+  const int chunks = NumChunks(size, num_threads, kMinSortChunkSize);
+  if (chunks == 0) {
+    return order;
+  }
+  std::vector<std::uint64_t> sorted_keys(size);
+  std::vector<std::size_t> sorted_order(size);
+  // counts[chunk * kRadixSize + digit] holds the keys of a chunk with a
+  // digit, and then the position of the next of them in the sorted output.
+  std::vector<std::size_t> counts(chunks * kRadixSize);
+  for (int shift = 0; shift < num_bits; shift += kRadixBits) {
+    std::fill(counts.begin(), counts.end(), 0);
+    const std::uint64_t* in_keys = keys->data();
+    ParallelFor(size, chunks,
+                [&](int chunk, std::size_t begin, std::size_t end) {
+                  std::size_t* chunk_counts = &counts[chunk * kRadixSize];
+                  for (std::size_t i = begin; i < end; ++i) {
+                    ++chunk_counts[(in_keys[i] >> shift) & (kRadixSize - 1)];
+                  }
+                },
+                kMinSortChunkSize);
+
+    // Keys with a smaller digit go first, and among equal digits, keys of
+    // earlier chunks, which keeps the sort stable.
+    bool shared_digit = false;
+    std::size_t position = 0;
+    for (std::size_t digit = 0; digit < kRadixSize; ++digit) {
+      const std::size_t digit_begin = position;
+      for (int chunk = 0; chunk < chunks; ++chunk) {
+        std::size_t& count = counts[chunk * kRadixSize + digit];
+        const std::size_t chunk_count = count;
+        count = position;
+        position += chunk_count;
+      }
+      shared_digit = shared_digit || position - digit_begin == size;
+    }
+    if (shared_digit) {
+      continue;
+    }
+
+    const std::size_t* in_order = order.data();
+    ParallelFor(size, chunks,
+                [&](int chunk, std::size_t begin, std::size_t end) {
+                  std::size_t* next = &counts[chunk * kRadixSize];
+                  for (std::size_t i = begin; i < end; ++i) {
+                    const std::size_t target =
+                        next[(in_keys[i] >> shift) & (kRadixSize - 1)]++;
+                    sorted_keys[target] = in_keys[i];
+                    sorted_order[target] = in_order[i];
+                  }
+                },
+                kMinSortChunkSize);
+    keys->swap(sorted_keys);
+    order.swap(sorted_order);
+  }
+  return order;
+}
+
+std::vector<std::size_t> MortonSort(PointCloud* cloud, int num_threads) {
+  const std::size_t size = cloud->size();
+  // Bounding box of the finite coordinates. The others are clamped to the
+  // boundary cells, or cell 0 for NaN, when computing the codes.
+  Vector3 min(std::numeric_limits<double>::infinity(),
+              std::numeric_limits<double>::infinity(),
+              std::numeric_limits<double>::infinity());
+  Vector3 max = -1. * min;
+  const double* coordinates[3] = {cloud->x(), cloud->y(), cloud->z()};
+  for (int axis = 0; axis < 3; ++axis) {
+    double lowest = min[axis];
+    double highest = max[axis];
+    for (std::size_t i = 0; i < size; ++i) {
+      const double value = coordinates[axis][i];
+      const bool finite = std::isfinite(value);
+      lowest = finite && value < lowest ? value : lowest;
+      highest = finite && value > highest ? value : highest;
+    }
+    // Axes without finite coordinates get an empty box.
+    min[axis] = lowest <= highest ? lowest : 0.;
+    max[axis] = lowest <= highest ? highest : 0.;
+  }
+
+  std::vector<std::uint64_t> codes(size);
+  ParallelFor(size, num_threads,
+              [&](int, std::size_t begin, std::size_t end) {
+                computeCodes(*cloud, min, max, begin, end, codes.data());
+              },
+              kMinSortChunkSize);
+  const std::vector<std::size_t> order =
+      RadixSort(&codes, 3 * kMortonBits, num_threads);
+
+  PointCloud sorted(size);
+  ParallelFor(size, num_threads,
+              [&](int, std::size_t begin, std::size_t end) {
+                for (std::size_t i = begin; i < end; ++i) {
+                  sorted.x()[i] = cloud->x()[order[i]];
+                  sorted.y()[i] = cloud->y()[order[i]];
+                  sorted.z()[i] = cloud->z()[order[i]];
+                }
+              },
+              kMinSortChunkSize);
+  *cloud = std::move(sorted);
+  return order;
+}
+
+}  // namespace math
+}  // namespace ekumen
@@ -0,0 +1,261 @@
+#include "obb.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <limits>
+#include <stdexcept>
+#include "aabb.h"
+#include "isometry.h"
+#include "matrix3.h"
+#include "point_cloud.h"
+#include "vector3.h"
+
+namespace ekumen {
+namespace math {
+namespace {
+// Added to the absolute rotation terms of the separating axis test, so that
+// cross products of near parallel edges do not separate overlapping boxes.
+constexpr double kParallelTolerance = 1e-12;
+
+// Jacobi sweeps after which the eigenvectors are taken as they are.
+constexpr int kMaxJacobiSweeps = 32;
+
+// Diagonalizes the symmetric matrix 'a' with Jacobi rotations, leaving the
+// eigenvalues on its diagonal and the eigenvectors in the columns of 'v'.
+void jacobiEigen(double a[3][3], double v[3][3]) {
+  for (int i = 0; i < 3; ++i) {
+    for (int j = 0; j < 3; ++j) {
+      v[i][j] = i == j ? 1. : 0.;
+    }
+  }
+  for (int sweep = 0; sweep < kMaxJacobiSweeps; ++sweep) {
+    const double off = a[0][1] * a[0][1] + a[0][2] * a[0][2] +
+                       a[1][2] * a[1][2];
+    const double diagonal = a[0][0] * a[0][0] + a[1][1] * a[1][1] +
+                            a[2][2] * a[2][2];
+    if (off <= std::numeric_limits<double>::epsilon() *
+                   std::numeric_limits<double>::epsilon() * diagonal) {
+      return;
+    }
+    for (int p = 0; p < 2; ++p) {
+      for (int q = p + 1; q < 3; ++q) {
+        if (a[p][q] == 0.) {
+          continue;
+        }
+        // Rotation in the (p, q) plane that zeroes a[p][q].
+        const double theta = (a[q][q] - a[p][p]) / (2. * a[p][q]);
+        const double t = (theta >= 0. ? 1. : -1.) /
+                         (std::abs(theta) + std::sqrt(theta * theta + 1.));
+        const double c = 1. / std::sqrt(t * t + 1.);
+        const double s = t * c;
+        for (int k = 0; k < 3; ++k) {
+          const double kp = a[k][p];
+          const double kq = a[k][q];
+          a[k][p] = c * kp - s * kq;
+          a[k][q] = s * kp + c * kq;
+        }
+        for (int k = 0; k < 3; ++k) {
+          const double pk = a[p][k];
+          const double qk = a[q][k];
+          a[p][k] = c * pk - s * qk;
+          a[q][k] = s * pk + c * qk;
+        }
+        for (int k = 0; k < 3; ++k) {
+          const double kp = v[k][p];
+          const double kq = v[k][q];
+          v[k][p] = c * kp - s * kq;
+          v[k][q] = s * kp + c * kq;
+        }
+      }
+    }
+  }
+}
+}  // namespace
+
+Obb::Obb()
+    : center(Vector3::kZero),
+      axes(Matrix3::kIdentity),
+      half_extents(Vector3(-1., -1., -1.)) {}
+
+Obb::Obb(const Vector3& center, const Matrix3& axes,
+         const Vector3& half_extents)
+    : center(center), axes(axes), half_extents(half_extents) {}
+
+Obb Obb::FromAabb(const Aabb& box, const Isometry& pose) {
+  if (box.empty()) {
+    return Obb();
+  }
+  return Obb(pose * box.center(), pose.rotation(), box.halfExtents());
+}
+
+Obb Obb::Fit(const PointCloud& points) {
+  if (points.empty()) {
+    throw std::invalid_argument("Cannot fit a box to no points.");
+  }
+  const std::size_t size = points.size();
+  const double* coordinates[3] = {points.x(), points.y(), points.z()};
+  double mean[3] = {0., 0., 0.};
+  for (int i = 0; i < 3; ++i) {
+    for (std::size_t k = 0; k < size; ++k) {
+      mean[i] += coordinates[i][k];
+    }
+    mean[i] /= size;
+  }
+  double covariance[3][3] = {{0.}};
+  for (std::size_t k = 0; k < size; ++k) {
+    const double d[3] = {coordinates[0][k] - mean[0],
+                         coordinates[1][k] - mean[1],
+                         coordinates[2][k] - mean[2]};
+    for (int i = 0; i < 3; ++i) {
+      for (int j = i; j < 3; ++j) {
+        covariance[i][j] += d[i] * d[j];
+      }
+    }
+  }
+  for (int i = 0; i < 3; ++i) {
+    for (int j = 0; j < i; ++j) {
+      covariance[i][j] = covariance[j][i];
+    }
+  }
+  double v[3][3];
+  jacobiEigen(covariance, v);
+  // Right-handed axes, so that they are a rotation.
+  const double det =
+      v[0][0] * (v[1][1] * v[2][2] - v[1][2] * v[2][1]) -
+      v[0][1] * (v[1][0] * v[2][2] - v[1][2] * v[2][0]) +
+      v[0][2] * (v[1][0] * v[2][1] - v[1][1] * v[2][0]);
+  if (det < 0.) {
+    for (int i = 0; i < 3; ++i) {
+      v[i][2] = -v[i][2];
+    }
+  }
+
+  double low[3];
+  double high[3];
+  for (int j = 0; j < 3; ++j) {
+    low[j] = std::numeric_limits<double>::infinity();
+    high[j] = -std::numeric_limits<double>::infinity();
+  }
+  for (std::size_t k = 0; k < size; ++k) {
+    for (int j = 0; j < 3; ++j) {
+      const double projection =
+          v[0][j] * (coordinates[0][k] - mean[0]) +
+          v[1][j] * (coordinates[1][k] - mean[1]) +
+          v[2][j] * (coordinates[2][k] - mean[2]);
+      low[j] = std::min(low[j], projection);
+      high[j] = std::max(high[j], projection);
+    }
+  }
+  Obb res;
+  for (int i = 0; i < 3; ++i) {
+    res.center[i] = mean[i];
+    for (int j = 0; j < 3; ++j) {
+      res.axes[i][j] = v[i][j];
+      res.center[i] += v[i][j] * 0.5 * (low[j] + high[j]);
+    }
+    res.half_extents[i] = 0.5 * (high[i] - low[i]);
+  }
+  return res;
+}
+
+bool Obb::empty() const {
+  return !(half_extents.x() >= 0. && half_extents.y() >= 0. &&
+           half_extents.z() >= 0.);
+}
+
+double Obb::volume() const {
+  if (empty()) {
+    return 0.;
+  }
+  return 8. * half_extents.x() * half_extents.y() * half_extents.z();
+}
+
+Obb Obb::transformed(const Isometry& pose) const {
+  return Obb(pose * center, pose.rotation().product(axes), half_extents);
+}
+
+Aabb Obb::bounds() const {
+  if (empty()) {
+    return Aabb();
+  }
+  Vector3 extents;
+  for (int i = 0; i < 3; ++i) {
+    extents[i] = std::abs(axes[i][0]) * half_extents.x() +
+                 std::abs(axes[i][1]) * half_extents.y() +
+                 std::abs(axes[i][2]) * half_extents.z();
+  }
+  return Aabb(center - extents, center + extents);
+}
+
+bool Obb::contains(const Vector3& point) const {
+  const Vector3 local = axes.transpose().product(point - center);
+  for (int i = 0; i < 3; ++i) {
+    if (!(std::abs(local[i]) <= half_extents[i])) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool Obb::overlaps(const Obb& obj) const {
+  if (empty() || obj.empty()) {
+    return false;
+  }
+  // Rotation and translation of 'obj' in the frame of this box.
+  double r[3][3];
+  double abs_r[3][3];
+  for (int i = 0; i < 3; ++i) {
+    for (int j = 0; j < 3; ++j) {
+      r[i][j] = axes[0][i] * obj.axes[0][j] + axes[1][i] * obj.axes[1][j] +
+                axes[2][i] * obj.axes[2][j];
+      abs_r[i][j] = std::abs(r[i][j]) + kParallelTolerance;
+    }
+  }
+  const Vector3 offset = obj.center - center;
+  double t[3];
+  for (int i = 0; i < 3; ++i) {
+    t[i] = axes[0][i] * offset.x() + axes[1][i] * offset.y() +
+           axes[2][i] * offset.z();
+  }
+  const double a[3] = {half_extents.x(), half_extents.y(), half_extents.z()};
+  const double b[3] = {obj.half_extents.x(), obj.half_extents.y(),
+                       obj.half_extents.z()};
+
+  // Axes of this box, then of 'obj'.
+  for (int i = 0; i < 3; ++i) {
+    if (std::abs(t[i]) >
+        a[i] + b[0] * abs_r[i][0] + b[1] * abs_r[i][1] + b[2] * abs_r[i][2]) {
+      return false;
+    }
+  }
+  for (int j = 0; j < 3; ++j) {
+    if (std::abs(t[0] * r[0][j] + t[1] * r[1][j] + t[2] * r[2][j]) >
+        a[0] * abs_r[0][j] + a[1] * abs_r[1][j] + a[2] * abs_r[2][j] + b[j]) {
+      return false;
+    }
+  }
+  // Cross products of an axis of each box.
+  for (int i = 0; i < 3; ++i) {
+    const int i1 = (i + 1) % 3;
+    const int i2 = (i + 2) % 3;
+    for (int j = 0; j < 3; ++j) {
+      const int j1 = (j + 1) % 3;
+      const int j2 = (j + 2) % 3;
+      if (std::abs(t[i2] * r[i1][j] - t[i1] * r[i2][j]) >
+          a[i1] * abs_r[i2][j] + a[i2] * abs_r[i1][j] +
+              b[j1] * abs_r[i][j2] + b[j2] * abs_r[i][j1]) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+std::ostream& operator<<(std::ostream& os, const Obb& obj) {
+  return os << "[center: " << obj.center << ", axes: " << obj.axes
+            << ", half extents: " << obj.half_extents << "]";
+}
+
+}  // namespace math
+}  // namespace ekumen
@@ -0,0 +1,47 @@
+#include "parallel.h"
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+namespace ekumen {
+namespace math {
+
+int DefaultNumThreads() {
+  const unsigned int hardware = std::thread::hardware_concurrency();
+  return hardware == 0 ? 1 : static_cast<int>(hardware);
+}
+
+int NumChunks(std::size_t size, int num_threads, std::size_t min_chunk_size) {
+  if (size == 0) {
+    return 0;
+  }
+  const std::size_t by_size =
+      (size + std::max<std::size_t>(min_chunk_size, 1) - 1) /
+      std::max<std::size_t>(min_chunk_size, 1);
+  return static_cast<int>(
+      std::max<std::size_t>(1, std::min<std::size_t>(num_threads, by_size)));
+}
+
+void ParallelFor(std::size_t size, int num_threads,
+                 const std::function<void(int, std::size_t, std::size_t)>& body,
+                 std::size_t min_chunk_size) {
+  const int chunks = NumChunks(size, num_threads, min_chunk_size);
+  if (chunks == 0) {
+    return;
+  }
+  const std::size_t chunk_size = (size + chunks - 1) / chunks;
+  std::vector<std::thread> workers;
+  workers.reserve(chunks - 1);
+  for (auto chunk = 1; chunk < chunks; ++chunk) {
+    const std::size_t begin = std::min(size, chunk * chunk_size);
+    const std::size_t end = std::min(size, begin + chunk_size);
+    workers.emplace_back(body, chunk, begin, end);
+  }
+  body(0, 0, std::min(size, chunk_size));
+  for (auto& worker : workers) {
+    worker.join();
+  }
+}
+
+}  // namespace math
+}  // namespace ekumen
@@ -0,0 +1,114 @@
+#include "point_cloud.h"
+#include <stdexcept>
+#include <vector>
+#include "isometry.h"
+#include "matrix3.h"
+#include "vector3.h"
+
+namespace ekumen {
+namespace math {
+
+PointCloud::PointCloud(std::size_t size) : x_(size), y_(size), z_(size) {}
+
+PointCloud::PointCloud(const std::vector<Vector3>& points) {
+  reserve(points.size());
+  for (const Vector3& point : points) {
+    push_back(point);
+  }
+}
+
+std::size_t PointCloud::size() const { return x_.size(); }
+
+bool PointCloud::empty() const { return x_.empty(); }
+
+void PointCloud::reserve(std::size_t capacity) {
+  x_.reserve(capacity);
+  y_.reserve(capacity);
+  z_.reserve(capacity);
+}
+
+void PointCloud::resize(std::size_t size) {
+  x_.resize(size);
+  y_.resize(size);
+  z_.resize(size);
+}
+
+void PointCloud::clear() { resize(0); }
+
+void PointCloud::push_back(const Vector3& point) {
+  x_.push_back(point.x());
+  y_.push_back(point.y());
+  z_.push_back(point.z());
+}
+
+void PointCloud::append(const PointCloud& obj) {
+  x_.insert(x_.end(), obj.x_.begin(), obj.x_.end());
+  y_.insert(y_.end(), obj.y_.begin(), obj.y_.end());
+  z_.insert(z_.end(), obj.z_.begin(), obj.z_.end());
+}
+
+Vector3 PointCloud::point(std::size_t index) const {
+  assertValidAccessIndex(index);
+  return Vector3(x_[index], y_[index], z_[index]);
+}
+
+void PointCloud::setPoint(std::size_t index, const Vector3& point) {
+  assertValidAccessIndex(index);
+  x_[index] = point.x();
+  y_[index] = point.y();
+  z_[index] = point.z();
+}
+
+const double* PointCloud::x() const { return x_.data(); }
+const double* PointCloud::y() const { return y_.data(); }
+const double* PointCloud::z() const { return z_.data(); }
+double* PointCloud::x() { return x_.data(); }
+double* PointCloud::y() { return y_.data(); }
+double* PointCloud::z() { return z_.data(); }
+
+void PointCloud::transform(const Isometry& pose) {
+  const Matrix3& r = pose.rotation();
+  const Vector3& t = pose.translation();
+  // Scalars are hoisted so that the loop only touches the three arrays.
+  const double r00 = r[0][0], r01 = r[0][1], r02 = r[0][2];
+  const double r10 = r[1][0], r11 = r[1][1], r12 = r[1][2];
+  const double r20 = r[2][0], r21 = r[2][1], r22 = r[2][2];
+  const double tx = t.x(), ty = t.y(), tz = t.z();
+  double* x = x_.data();
+  double* y = y_.data();
+  double* z = z_.data();
+  const std::size_t size = x_.size();
+  for (std::size_t i = 0; i < size; ++i) {
+    const double px = x[i];
+    const double py = y[i];
+    const double pz = z[i];
+    x[i] = r00 * px + r01 * py + r02 * pz + tx;
+    y[i] = r10 * px + r11 * py + r12 * pz + ty;
+    z[i] = r20 * px + r21 * py + r22 * pz + tz;
+  }
+}
+
+bool PointCloud::operator==(const PointCloud& rhs) const {
+  if (size() != rhs.size()) {
+    return false;
+  }
+  for (std::size_t i = 0; i < size(); ++i) {
+    if (point(i) != rhs.point(i)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool PointCloud::operator!=(const PointCloud& rhs) const {
+  return !(*this == rhs);
+}
+
+void PointCloud::assertValidAccessIndex(std::size_t index) const {
+  if (index >= size()) {
+    throw std::out_of_range("Index to access a point is out of range.");
+  }
+}
+
+}  // namespace math
+}  // namespace ekumen
@@ -0,0 +1,538 @@
+#include "point_cloud_io.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "binary_io.h"
+#include "parallel.h"
+#include "point_cloud.h"
+#include "text_format.h"
+#include "text_parser.h"
+
+namespace ekumen {
+namespace math {
+namespace {
+// Bytes of ASCII data or points of binary data below which a single thread
+// decodes everything.
+constexpr std::size_t kMinAsciiChunkSize = 1 << 20;
+constexpr std::size_t kMinBinaryChunkSize = 1 << 16;
+
+// Size of the buffers writers fill before each write.
+constexpr std::size_t kWriteBufferSize = 1 << 16;
+
+bool isBlank(char c) { return c == ' ' || c == '\t'; }
+
+bool isLineEnd(char c) { return c == '\n' || c == '\r'; }
+
+std::runtime_error formatError(const char* format, std::size_t offset,
+                               const char* message) {
+  return std::runtime_error(std::string("Malformed ") + format +
+                            " file at offset " + std::to_string(offset) +
+                            ": " + message);
+}
+
+// Columns holding the coordinates in an ASCII line.
+struct Columns {
+  int x;
+  int y;
+  int z;
+  // Skip blank and '#' lines instead of rejecting them.
+  bool skip_comments;
+};
+
+// Points parsed from one chunk, or the first error in it.
+struct AsciiChunk {
+  PointCloud cloud;
+  ParseStatus status;
+};
+
+// Parses one line starting at 'pos'. Returns the position after the line.
+const char* parseLine(const char* pos, const char* end, const Columns& columns,
+                      PointCloud* cloud, ParseStatus* status,
+                      const char* data) {
+  const char* line_end = static_cast<const char*>(
+      std::memchr(pos, '\n', end - pos));
+  if (line_end == nullptr) {
+    line_end = end;
+  }
+  const char* next = line_end == end ? end : line_end + 1;
+  while (pos != line_end && isBlank(*pos)) {
+    ++pos;
+  }
+  if (columns.skip_comments &&
+      (pos == line_end || *pos == '#' || *pos == '\r')) {
+    return next;
+  }
+
+  const int last = std::max(columns.x, std::max(columns.y, columns.z));
+  double values[3];
+  for (int column = 0; column <= last; ++column) {
+    while (pos != line_end && isBlank(*pos)) {
+      ++pos;
+    }
+    if (pos == line_end || isLineEnd(*pos)) {
+      status->offset = pos - data;
+      status->message = "Expected more columns.";
+      return nullptr;
+    }
+    double* target = column == columns.x
+                         ? &values[0]
+                         : column == columns.y
+                               ? &values[1]
+                               : column == columns.z ? &values[2] : nullptr;
+    if (target == nullptr) {
+      while (pos != line_end && !isBlank(*pos) && !isLineEnd(*pos)) {
+        ++pos;
+      }
+      continue;
+    }
+    const ParseStatus number = TextParser::Parse(pos, line_end, target);
+    pos += number.offset;
+    if (number.ok() && pos != line_end && !isBlank(*pos) && !isLineEnd(*pos)) {
+      status->offset = pos - data;
+      status->message = "Unexpected character.";
+      return nullptr;
+    }
+    if (!number.ok()) {
+      status->offset = pos - data;
+      status->message = number.message;
+      return nullptr;
+    }
+  }
+  cloud->push_back(Vector3(values[0], values[1], values[2]));
+  return next;
+}
+
+// Parses the lines of [data, end) concurrently. A chunk of bytes owns the
+// lines that start in it.
+PointCloud parseAscii(const char* data, const char* end,
+                      const Columns& columns, const char* format,
+                      const char* file_begin, int num_threads) {
+  const std::size_t size = end - data;
+  std::vector<AsciiChunk> chunks(
+      NumChunks(size, num_threads, kMinAsciiChunkSize));
+  ParallelFor(
+      size, num_threads,
+      [&](int chunk, std::size_t begin, std::size_t chunk_end) {
+        AsciiChunk& res = chunks[chunk];
+        res.status.offset = 0;
+        res.status.message = nullptr;
+        const char* pos = data + begin;
+        if (begin > 0) {
+          const char* newline = static_cast<const char*>(
+              std::memchr(pos - 1, '\n', end - pos + 1));
+          pos = newline == nullptr ? end : newline + 1;
+        }
+        while (pos < data + chunk_end && pos != end) {
+          pos = parseLine(pos, end, columns, &res.cloud, &res.status,
+                          file_begin);
+          if (pos == nullptr) {
+            return;
+          }
+        }
+      },
+      kMinAsciiChunkSize);
+
+  PointCloud res;
+  std::size_t total = 0;
+  for (const AsciiChunk& chunk : chunks) {
+    // Chunks are in file order, so the first error is the earliest one.
+    if (!chunk.status.ok()) {
+      throw formatError(format, chunk.status.offset, chunk.status.message);
+    }
+    total += chunk.cloud.size();
+  }
+  res.reserve(total);
+  for (const AsciiChunk& chunk : chunks) {
+    res.append(chunk.cloud);
+  }
+  return res;
+}
+
+// Scalar types of PLY properties.
+enum class PlyType { kInt8, kUint8, kInt16, kUint16, kInt32, kUint32, kFloat32,
+                     kFloat64 };
+
+bool parsePlyType(const std::string& name, PlyType* type, std::size_t* size) {
+  static const struct {
+    const char* names[2];
+    PlyType type;
+    std::size_t size;
+  } kTypes[] = {
+      {{"char", "int8"}, PlyType::kInt8, 1},
+      {{"uchar", "uint8"}, PlyType::kUint8, 1},
+      {{"short", "int16"}, PlyType::kInt16, 2},
+      {{"ushort", "uint16"}, PlyType::kUint16, 2},
+      {{"int", "int32"}, PlyType::kInt32, 4},
+      {{"uint", "uint32"}, PlyType::kUint32, 4},
+      {{"float", "float32"}, PlyType::kFloat32, 4},
+      {{"double", "float64"}, PlyType::kFloat64, 8},
+  };
+  for (const auto& entry : kTypes) {
+    if (name == entry.names[0] || name == entry.names[1]) {
+      *type = entry.type;
+      *size = entry.size;
+      return true;
+    }
+  }
+  return false;
+}
+
+// Layout of the vertex element of a PLY file.
+struct PlyHeader {
+  PlyFormat format;
+  std::uint64_t count;
+  // Offset of the data section.
+  std::size_t data_offset;
+  // Per-vertex size of binary data.
+  std::size_t stride;
+  // Column index, byte offset and type of each coordinate.
+  int columns[3];
+  std::size_t offsets[3];
+  PlyType types[3];
+};
+
+PlyHeader parsePlyHeader(const char* data, const char* end) {
+  static const char* const kCoordinates[3] = {"x", "y", "z"};
+  PlyHeader header;
+  std::fill(header.columns, header.columns + 3, -1);
+  header.count = 0;
+  header.stride = 0;
+  bool has_format = false;
+  int element = -1;
+  int column = 0;
+
+  // Empty files may map to a null 'data', which memchr() must not get.
+  if (data == end) {
+    throw formatError("PLY", 0, "Missing header.");
+  }
+  const char* pos = data;
+  int line_number = 0;
+  for (;;) {
+    const char* line_end =
+        static_cast<const char*>(std::memchr(pos, '\n', end - pos));
+    if (line_end == nullptr) {
+      throw formatError("PLY", pos - data, "Missing 'end_header'.");
+    }
+    std::string line(pos, line_end);
+    if (!line.empty() && line.back() == '\r') {
+      line.pop_back();
+    }
+    const std::size_t line_offset = pos - data;
+    pos = line_end + 1;
+    ++line_number;
+
+    std::istringstream tokens(line);
+    std::string keyword;
+    tokens >> keyword;
+    if (line_number == 1) {
+      if (keyword != "ply") {
+        throw formatError("PLY", line_offset, "Missing 'ply' magic.");
+      }
+      continue;
+    }
+    if (keyword == "end_header") {
+      break;
+    }
+    if (keyword == "comment" || keyword == "obj_info" || keyword.empty()) {
+      continue;
+    }
+    if (keyword == "format") {
+      std::string format;
+      std::string version;
+      tokens >> format >> version;
+      if (format == "ascii") {
+        header.format = PlyFormat::kAscii;
+      } else if (format == "binary_little_endian") {
+        header.format = PlyFormat::kBinaryLittleEndian;
+      } else if (format == "binary_big_endian") {
+        header.format = PlyFormat::kBinaryBigEndian;
+      } else {
+        throw formatError("PLY", line_offset, "Unknown format.");
+      }
+      has_format = true;
+    } else if (keyword == "element") {
+      std::string name;
+      std::uint64_t count;
+      tokens >> name >> count;
+      if (!tokens) {
+        throw formatError("PLY", line_offset, "Invalid element.");
+      }
+      ++element;
+      if (element == 0) {
+        if (name != "vertex") {
+          throw formatError("PLY", line_offset,
+                            "The first element must be 'vertex'.");
+        }
+        header.count = count;
+      }
+    } else if (keyword == "property") {
+      if (element != 0) {
+        // Properties of later elements are not read.
+        if (element < 0) {
+          throw formatError("PLY", line_offset, "Property before element.");
+        }
+        continue;
+      }
+      std::string type_name;
+      std::string name;
+      tokens >> type_name >> name;
+      PlyType type;
+      std::size_t size;
+      if (type_name == "list") {
+        throw formatError("PLY", line_offset,
+                          "List properties of vertices are not supported.");
+      }
+      if (!parsePlyType(type_name, &type, &size) || name.empty()) {
+        throw formatError("PLY", line_offset, "Invalid property.");
+      }
+      for (int i = 0; i < 3; ++i) {
+        if (name == kCoordinates[i]) {
+          header.columns[i] = column;
+          header.offsets[i] = header.stride;
+          header.types[i] = type;
+        }
+      }
+      header.stride += size;
+      ++column;
+    } else {
+      throw formatError("PLY", line_offset, "Unknown header keyword.");
+    }
+  }
+  if (!has_format || element < 0) {
+    throw formatError("PLY", 0, "Missing format or vertex element.");
+  }
+  if (header.columns[0] < 0 || header.columns[1] < 0 ||
+      header.columns[2] < 0) {
+    throw formatError("PLY", 0, "Vertices need x, y and z properties.");
+  }
+  header.data_offset = pos - data;
+  return header;
+}
+
+std::uint64_t loadBits(const unsigned char* bytes, std::size_t size,
+                       bool big_endian) {
+  std::uint64_t value = 0;
+  for (std::size_t i = 0; i < size; ++i) {
+    const std::size_t shift = 8 * (big_endian ? size - 1 - i : i);
+    value |= static_cast<std::uint64_t>(bytes[i]) << shift;
+  }
+  return value;
+}
+
+double loadScalar(const unsigned char* bytes, PlyType type, bool big_endian) {
+  switch (type) {
+    case PlyType::kInt8:
+      return static_cast<std::int8_t>(bytes[0]);
+    case PlyType::kUint8:
+      return bytes[0];
+    case PlyType::kInt16:
+      return static_cast<std::int16_t>(loadBits(bytes, 2, big_endian));
+    case PlyType::kUint16:
+      return static_cast<std::uint16_t>(loadBits(bytes, 2, big_endian));
+    case PlyType::kInt32:
+      return static_cast<std::int32_t>(loadBits(bytes, 4, big_endian));
+    case PlyType::kUint32:
+      return static_cast<std::uint32_t>(loadBits(bytes, 4, big_endian));
+    case PlyType::kFloat32: {
+      const std::uint32_t bits =
+          static_cast<std::uint32_t>(loadBits(bytes, 4, big_endian));
+      float value;
+      std::memcpy(&value, &bits, sizeof(value));
+      return value;
+    }
+    case PlyType::kFloat64: {
+      const std::uint64_t bits = loadBits(bytes, 8, big_endian);
+      double value;
+      std::memcpy(&value, &bits, sizeof(value));
+      return value;
+    }
+  }
+  return 0.;
+}
+
+PointCloud parsePlyBinary(const PlyHeader& header, const unsigned char* data,
+                          std::size_t size, int num_threads) {
+  if (header.stride == 0 || header.count > size / header.stride) {
+    throw formatError("PLY", header.data_offset + size,
+                      "Truncated vertex data.");
+  }
+  const bool big_endian = header.format == PlyFormat::kBinaryBigEndian;
+  PointCloud res(header.count);
+  double* coordinates[3] = {res.x(), res.y(), res.z()};
+  ParallelFor(header.count, num_threads,
+              [&](int, std::size_t begin, std::size_t end) {
+                for (int c = 0; c < 3; ++c) {
+                  const unsigned char* bytes =
+                      data + begin * header.stride + header.offsets[c];
+                  for (std::size_t i = begin; i < end; ++i) {
+                    coordinates[c][i] =
+                        loadScalar(bytes, header.types[c], big_endian);
+                    bytes += header.stride;
+                  }
+                }
+              },
+              kMinBinaryChunkSize);
+  return res;
+}
+
+// Buffers output and writes it to a file in large blocks.
+class FileWriter {
+ public:
+  explicit FileWriter(const std::string& path)
+      : path_(path), os_(path, std::ios::binary | std::ios::trunc), used_(0) {
+    if (!os_) {
+      throw std::runtime_error("Cannot create '" + path + "'.");
+    }
+  }
+
+  // Ensures 'size' contiguous bytes are available and returns them.
+  char* reserve(std::size_t size) {
+    if (kWriteBufferSize - used_ < size) {
+      flush();
+    }
+    return buffer_ + used_;
+  }
+
+  void commit(std::size_t size) { used_ += size; }
+
+  void write(const std::string& text) {
+    std::memcpy(reserve(text.size()), text.data(), text.size());
+    commit(text.size());
+  }
+
+  void close() {
+    flush();
+    os_.close();
+    if (!os_) {
+      throw std::runtime_error("Cannot write '" + path_ + "'.");
+    }
+  }
+
+ private:
+  void flush() {
+    os_.write(buffer_, used_);
+    used_ = 0;
+    if (!os_) {
+      throw std::runtime_error("Cannot write '" + path_ + "'.");
+    }
+  }
+
+  std::string path_;
+  std::ofstream os_;
+  char buffer_[kWriteBufferSize];
+  std::size_t used_;
+};
+
+// Writes "x y z\n" with round-trip precision.
+void writeAsciiPoint(const PointCloud& cloud, std::size_t index,
+                     FileWriter* writer) {
+  char* line = writer->reserve(3 * TextFormat::kMaxScalarSize);
+  const double values[3] = {cloud.x()[index], cloud.y()[index],
+                            cloud.z()[index]};
+  std::size_t length = 0;
+  for (int c = 0; c < 3; ++c) {
+    length += TextFormat::Format(values[c], line + length,
+                                 TextFormat::kMaxScalarSize);
+    line[length++] = c == 2 ? '\n' : ' ';
+  }
+  writer->commit(length);
+}
+}  // namespace
+
+PointCloudIo::Options::Options() : num_threads(DefaultNumThreads()) {}
+
+PointCloud PointCloudIo::ReadXyz(const std::string& path,
+                                 const Options& options) {
+  const MappedFile file(path);
+  file.adviseSequential();
+  const char* data = reinterpret_cast<const char*>(file.data());
+  return ParseXyz(data, data + file.size(), options);
+}
+
+PointCloud PointCloudIo::ReadPly(const std::string& path,
+                                 const Options& options) {
+  const MappedFile file(path);
+  file.adviseSequential();
+  const char* data = reinterpret_cast<const char*>(file.data());
+  return ParsePly(data, data + file.size(), options);
+}
+
+PointCloud PointCloudIo::ParseXyz(const char* begin, const char* end,
+                                  const Options& options) {
+  const Columns columns = {0, 1, 2, true};
+  return parseAscii(begin, end, columns, "XYZ", begin, options.num_threads);
+}
+
+PointCloud PointCloudIo::ParsePly(const char* begin, const char* end,
+                                  const Options& options) {
+  const PlyHeader header = parsePlyHeader(begin, end);
+  const char* data = begin + header.data_offset;
+  if (header.format != PlyFormat::kAscii) {
+    return parsePlyBinary(header, reinterpret_cast<const unsigned char*>(data),
+                          end - data, options.num_threads);
+  }
+
+  // The vertex lines end where the next element starts, which is only found
+  // by counting lines.
+  const char* vertices_end = data;
+  for (std::uint64_t i = 0; i < header.count; ++i) {
+    if (vertices_end == end) {
+      throw formatError("PLY", end - begin, "Truncated vertex data.");
+    }
+    const char* newline = static_cast<const char*>(
+        std::memchr(vertices_end, '\n', end - vertices_end));
+    vertices_end = newline == nullptr ? end : newline + 1;
+  }
+  const Columns columns = {header.columns[0], header.columns[1],
+                           header.columns[2], false};
+  return parseAscii(data, vertices_end, columns, "PLY", begin,
+                    options.num_threads);
+}
+
+void PointCloudIo::WriteXyz(const PointCloud& cloud, const std::string& path) {
+  FileWriter writer(path);
+  for (std::size_t i = 0; i < cloud.size(); ++i) {
+    writeAsciiPoint(cloud, i, &writer);
+  }
+  writer.close();
+}
+
+void PointCloudIo::WritePly(const PointCloud& cloud, const std::string& path,
+                            PlyFormat format) {
+  static const char* const kFormatNames[3] = {
+      "ascii", "binary_little_endian", "binary_big_endian"};
+  FileWriter writer(path);
+  writer.write(std::string("ply\nformat ") +
+               kFormatNames[static_cast<int>(format)] + " 1.0\nelement vertex " +
+               std::to_string(cloud.size()) +
+               "\nproperty double x\nproperty double y\nproperty double "
+               "z\nend_header\n");
+  const bool big_endian = format == PlyFormat::kBinaryBigEndian;
+  for (std::size_t i = 0; i < cloud.size(); ++i) {
+    if (format == PlyFormat::kAscii) {
+      writeAsciiPoint(cloud, i, &writer);
+      continue;
+    }
+    const double values[3] = {cloud.x()[i], cloud.y()[i], cloud.z()[i]};
+    char* bytes = writer.reserve(sizeof(values));
+    for (int c = 0; c < 3; ++c) {
+      std::uint64_t bits;
+      std::memcpy(&bits, &values[c], sizeof(bits));
+      for (int b = 0; b < 8; ++b) {
+        const int shift = 8 * (big_endian ? 7 - b : b);
+        bytes[8 * c + b] = static_cast<char>(bits >> shift);
+      }
+    }
+    writer.commit(sizeof(values));
+  }
+  writer.close();
+}
+
+}  // namespace math
+}  // namespace ekumen
@@ -0,0 +1,177 @@
+#include "point_filter.h"
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include "isometry.h"
+#include "matrix3.h"
+#include "point_cloud.h"
+#include "vector3.h"
+
+// The AVX-512 kernel is compiled for x86 GCC and Clang regardless of the
+// build flags, and chosen at run time by the CPU features.
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define POINT_FILTER_AVX512 1
+#include <immintrin.h>
+#endif
+
+namespace ekumen {
+namespace math {
+namespace {
+// Keeps every point, for the kernels without a custom predicate.
+struct KeepAll {
+  bool operator()(double, double, double) const { return true; }
+};
+
+bool cpuHasAvx512() {
+#ifdef POINT_FILTER_AVX512
+  static const bool res = __builtin_cpu_supports("avx512f");
+  return res;
+#else
+  return false;
+#endif
+}
+}  // namespace
+
+PointFilter::PointFilter()
+    : box_min(Vector3(-std::numeric_limits<double>::max(),
+                      -std::numeric_limits<double>::max(),
+                      -std::numeric_limits<double>::max())),
+      box_max(Vector3(std::numeric_limits<double>::max(),
+                      std::numeric_limits<double>::max(),
+                      std::numeric_limits<double>::max())),
+      sphere_center(Vector3::kZero),
+      sphere_radius(std::numeric_limits<double>::infinity()),
+      min_range(0.),
+      max_range(std::numeric_limits<double>::infinity()),
+      mask(nullptr) {}
+
+FilterTransform::Kernel::Kernel(const Isometry& pose,
+                                const PointFilter& filter)
+    : radius2(filter.sphere_radius * filter.sphere_radius),
+      min_range2(filter.min_range * filter.min_range),
+      max_range2(filter.max_range * filter.max_range),
+      mask(filter.mask) {
+  for (int i = 0; i < 3; ++i) {
+    for (int j = 0; j < 3; ++j) {
+      r[3 * i + j] = pose.rotation()[i][j];
+    }
+    t[i] = pose.translation()[i];
+    box_min[i] = filter.box_min[i];
+    box_max[i] = filter.box_max[i];
+    center[i] = filter.sphere_center[i];
+    // Negated comparisons reject NaN bounds too.
+    if (!(box_min[i] <= box_max[i]) || std::isnan(center[i])) {
+      throw std::invalid_argument("Filter box must not be inverted or NaN.");
+    }
+  }
+  if (!(filter.sphere_radius >= 0.)) {
+    throw std::invalid_argument("Filter sphere radius must not be negative.");
+  }
+  if (!(filter.min_range >= 0. && filter.min_range <= filter.max_range)) {
+    throw std::invalid_argument("Filter range must be in [0; max_range].");
+  }
+}
+
+std::size_t FilterTransform::Run(const Isometry& pose,
+                                 const PointFilter& filter,
+                                 const PointCloud& input, PointCloud* output) {
+  if (output == nullptr) {
+    throw std::invalid_argument("Output cloud must not be null.");
+  }
+  const Kernel kernel(pose, filter);
+  return cpuHasAvx512() ? runAvx512(kernel, input, output)
+                        : runPortable(kernel, KeepAll(), input, output);
+}
+
+#ifdef POINT_FILTER_AVX512
+__attribute__((target("avx512f"))) std::size_t FilterTransform::runAvx512(
+    const Kernel& kernel, const PointCloud& input, PointCloud* output) {
+  const std::size_t size = input.size();
+  output->resize(size);
+  const double* x = input.x();
+  const double* y = input.y();
+  const double* z = input.z();
+  double* out_x = output->x();
+  double* out_y = output->y();
+  double* out_z = output->z();
+  __m512d r[9];
+  for (int i = 0; i < 9; ++i) {
+    r[i] = _mm512_set1_pd(kernel.r[i]);
+  }
+  __m512d t[3], box_min[3], box_max[3], center[3];
+  for (int i = 0; i < 3; ++i) {
+    t[i] = _mm512_set1_pd(kernel.t[i]);
+    box_min[i] = _mm512_set1_pd(kernel.box_min[i]);
+    box_max[i] = _mm512_set1_pd(kernel.box_max[i]);
+    center[i] = _mm512_set1_pd(kernel.center[i]);
+  }
+  const __m512d radius2 = _mm512_set1_pd(kernel.radius2);
+  const __m512d min_range2 = _mm512_set1_pd(kernel.min_range2);
+  const __m512d max_range2 = _mm512_set1_pd(kernel.max_range2);
+
+  std::size_t count = 0;
+  std::size_t i = 0;
+  for (; i + 8 <= size; i += 8) {
+    const __m512d p[3] = {_mm512_loadu_pd(x + i), _mm512_loadu_pd(y + i),
+                          _mm512_loadu_pd(z + i)};
+    // Products and sums in the order of Kernel::apply(), and without fused
+    // multiply-adds since the file is built with -ffp-contract=off, so that
+    // both kernels keep the same points.
+    __m512d q[3];
+    __mmask8 keep = 0xff;
+    __m512d distance2 = _mm512_setzero_pd();
+    __m512d range2 = _mm512_setzero_pd();
+    for (int k = 0; k < 3; ++k) {
+      q[k] = _mm512_add_pd(
+          _mm512_add_pd(_mm512_add_pd(_mm512_mul_pd(r[3 * k], p[0]),
+                                      _mm512_mul_pd(r[3 * k + 1], p[1])),
+                        _mm512_mul_pd(r[3 * k + 2], p[2])),
+          t[k]);
+      keep &= _mm512_cmp_pd_mask(q[k], box_min[k], _CMP_GE_OQ) &
+              _mm512_cmp_pd_mask(q[k], box_max[k], _CMP_LE_OQ);
+      const __m512d d = _mm512_sub_pd(q[k], center[k]);
+      distance2 = _mm512_add_pd(distance2, _mm512_mul_pd(d, d));
+      range2 = _mm512_add_pd(range2, _mm512_mul_pd(p[k], p[k]));
+    }
+    keep &= _mm512_cmp_pd_mask(distance2, radius2, _CMP_LE_OQ) &
+            _mm512_cmp_pd_mask(range2, min_range2, _CMP_GE_OQ) &
+            _mm512_cmp_pd_mask(range2, max_range2, _CMP_LE_OQ);
+    if (kernel.mask != nullptr) {
+      // The zero-masked widening avoids an undefined source register.
+      const __m512i flags = _mm512_maskz_cvtepu8_epi64(
+          0xff, _mm_loadl_epi64(
+                    reinterpret_cast<const __m128i*>(kernel.mask + i)));
+      keep &= _mm512_test_epi64_mask(flags, flags);
+    }
+    // Compress-stores write only the kept lanes, contiguously, so they never
+    // reach points of 'input' not read yet.
+    _mm512_mask_compressstoreu_pd(out_x + count, keep, q[0]);
+    _mm512_mask_compressstoreu_pd(out_y + count, keep, q[1]);
+    _mm512_mask_compressstoreu_pd(out_z + count, keep, q[2]);
+    count += __builtin_popcount(keep);
+  }
+  for (; i < size; ++i) {
+    double q[3];
+    const bool keep = kernel.apply(x[i], y[i], z[i], q) &
+                      (kernel.mask == nullptr || kernel.mask[i] != 0);
+    out_x[count] = q[0];
+    out_y[count] = q[1];
+    out_z[count] = q[2];
+    count += keep;
+  }
+  output->resize(count);
+  return count;
+}
+#else
+std::size_t FilterTransform::runAvx512(const Kernel& kernel,
+                                       const PointCloud& input,
+                                       PointCloud* output) {
+  return runPortable(kernel, KeepAll(), input, output);
+}
+#endif
+
+}  // namespace math
+}  // namespace ekumen
@@ -0,0 +1,292 @@
+#include "pose_graph.h"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include "isometry.h"
+#include "lie_group.h"
+#include "matrix.h"
+#include "matrix3.h"
+#include "parallel.h"
+#include "vector3.h"
+
+namespace ekumen {
+namespace math {
+namespace {
+constexpr int kBlockSize = 6;
+
+// Nodes or edges processed per thread at least.
+constexpr std::size_t kMinChunkSize = 256;
+
+// Normal equation contributions of a single edge i -> j.
+struct Linearization {
+  Matrix6 h_ii;
+  Matrix6 h_ij;
+  Matrix6 h_jj;
+  Vector6 b_i;
+  Vector6 b_j;
+};
+
+// Computes the error of the edge, the tangent vector of Z^-1 * Xi^-1 * Xj,
+// and optionally the Jacobians with respect to local perturbations of Xi and
+// Xj.
+Vector6 computeError(const Isometry& xi, const Isometry& xj,
+                     const Isometry& z, Matrix6* jacobian_i,
+                     Matrix6* jacobian_j) {
+  const Matrix3 ri_t = xi.rotation().transpose();
+  const Matrix3 rz_t = z.rotation().transpose();
+  const Matrix3 relative_rotation = ri_t.product(xj.rotation());
+  const Vector3 relative_translation =
+      ri_t.product(xj.translation() - xi.translation());
+  const Matrix3 error_rotation = rz_t.product(relative_rotation);
+  const Vector3 error_translation =
+      rz_t.product(relative_translation - z.translation());
+  const Vector3 error_rotation_vector = SO3::Log(error_rotation);
+
+  const Vector6 error = Stack(error_translation, error_rotation_vector);
+  if (jacobian_i == nullptr) {
+    return error;
+  }
+
+  const Matrix3 jr_inv = SO3::RightJacobianInverse(error_rotation_vector);
+  *jacobian_i = Matrix6::Zero();
+  *jacobian_j = Matrix6::Zero();
+  jacobian_i->setBlock(0, 0, rz_t * (-1.));
+  jacobian_i->setBlock(0, 3, rz_t.product(SO3::Hat(relative_translation)));
+  jacobian_i->setBlock(
+      3, 3, jr_inv.product(relative_rotation.transpose()) * (-1.));
+  jacobian_j->setBlock(0, 0, error_rotation);
+  jacobian_j->setBlock(3, 3, jr_inv);
+  return error;
+}
+
+// Computes the normal equation blocks of an edge.
+void linearize(const Isometry& xi, const Isometry& xj, const Isometry& z,
+               const Matrix6& information, Linearization* res) {
+  Matrix6 jacobian_i;
+  Matrix6 jacobian_j;
+  const Vector6 error = computeError(xi, xj, z, &jacobian_i, &jacobian_j);
+  const Matrix6 weighted_i = jacobian_i.transpose() * information;
+  const Matrix6 weighted_j = jacobian_j.transpose() * information;
+  res->h_ii = weighted_i * jacobian_i;
+  res->h_ij = weighted_i * jacobian_j;
+  res->h_jj = weighted_j * jacobian_j;
+  res->b_i = weighted_i * error;
+  res->b_j = weighted_j * error;
+}
+
+}  // namespace
+
+PoseGraph::Options::Options()
+    : max_iterations(20),
+      function_tolerance(1e-9),
+      parameter_tolerance(1e-10),
+      num_threads(DefaultNumThreads()) {}
+
+PoseGraph::Information PoseGraph::DiagonalInformation(
+    const double& translation, const double& rotation) {
+  Information res;
+  for (auto i = 0; i < 3; ++i) {
+    res(i, i) = translation;
+    res(i + 3, i + 3) = rotation;
+  }
+  return res;
+}
+
+int PoseGraph::AddNode(const Isometry& pose) {
+  nodes_.push_back(pose);
+  fixed_.push_back(false);
+  structure_valid_ = false;
+  return static_cast<int>(nodes_.size()) - 1;
+}
+
+void PoseGraph::AddEdge(int from, int to, const Isometry& measurement,
+                        const Information& information) {
+  if (from < 0 || from >= numNodes() || to < 0 || to >= numNodes()) {
+    throw std::out_of_range("Edge references a node that does not exist.");
+  }
+  edges_.push_back(Edge{from, to, measurement, information});
+  structure_valid_ = false;
+}
+
+void PoseGraph::SetFixed(int node, bool fixed) {
+  if (node < 0 || node >= numNodes()) {
+    throw std::out_of_range("Node index out of range.");
+  }
+  fixed_[node] = fixed;
+  structure_valid_ = false;
+}
+
+const Isometry& PoseGraph::node(int index) const { return nodes_.at(index); }
+
+int PoseGraph::numNodes() const { return static_cast<int>(nodes_.size()); }
+
+int PoseGraph::numEdges() const { return static_cast<int>(edges_.size()); }
+
+double PoseGraph::error() const {
+  double res = 0.;
+  for (const Edge& edge : edges_) {
+    const Vector6 e = computeError(nodes_[edge.from], nodes_[edge.to],
+                                   edge.measurement, nullptr, nullptr);
+    res += (e.transpose() * edge.information * e)(0, 0);
+  }
+  return res;
+}
+
+void PoseGraph::buildStructure() {
+  std::vector<bool> fixed(fixed_);
+  if (!fixed.empty() &&
+      std::find(fixed.begin(), fixed.end(), true) == fixed.end()) {
+    fixed[0] = true;
+  }
+  free_index_.assign(nodes_.size(), -1);
+  int num_free = 0;
+  for (std::size_t n = 0; n < nodes_.size(); ++n) {
+    if (!fixed[n]) {
+      free_index_[n] = num_free++;
+    }
+  }
+
+  incidence_offsets_.assign(nodes_.size() + 1, 0);
+  std::vector<std::pair<int, int>> off_diagonal;
+  for (const Edge& edge : edges_) {
+    ++incidence_offsets_[edge.from + 1];
+    ++incidence_offsets_[edge.to + 1];
+    if (free_index_[edge.from] >= 0 && free_index_[edge.to] >= 0) {
+      off_diagonal.push_back(
+          std::make_pair(free_index_[edge.from], free_index_[edge.to]));
+    }
+  }
+  for (std::size_t i = 1; i < incidence_offsets_.size(); ++i) {
+    incidence_offsets_[i] += incidence_offsets_[i - 1];
+  }
+  incidences_.resize(incidence_offsets_.back());
+  std::vector<std::size_t> cursor(incidence_offsets_.begin(),
+                                  incidence_offsets_.end() - 1);
+  for (std::size_t e = 0; e < edges_.size(); ++e) {
+    const Edge& edge = edges_[e];
+    incidences_[cursor[edge.from]++] =
+        Incidence{static_cast<int>(e), edge.to, true};
+    incidences_[cursor[edge.to]++] =
+        Incidence{static_cast<int>(e), edge.from, false};
+  }
+
+  solver_.Analyze(num_free, off_diagonal);
+  structure_valid_ = true;
+}
+
+PoseGraph::Summary PoseGraph::Optimize(const Options& options) {
+  if (!structure_valid_) {
+    buildStructure();
+  }
+  const std::size_t num_nodes = nodes_.size();
+  const std::size_t num_edges = edges_.size();
+  const int num_threads = std::max(1, options.num_threads);
+
+  std::vector<Linearization> linearizations(num_edges);
+  std::vector<Matrix6> diagonal(num_nodes);
+  std::vector<double> gradient(kBlockSize * solver_.numBlocks());
+  std::vector<double> delta;
+
+  Summary summary;
+  summary.iterations = 0;
+  summary.initial_error = error();
+  double current_error = summary.initial_error;
+
+  for (auto iteration = 0; iteration < options.max_iterations; ++iteration) {
+    // Linearizes every edge independently.
+    ParallelFor(num_edges, num_threads,
+                [&](int, std::size_t begin, std::size_t end) {
+                  for (auto e = begin; e < end; ++e) {
+                    const Edge& edge = edges_[e];
+                    linearize(nodes_[edge.from], nodes_[edge.to],
+                              edge.measurement, edge.information,
+                              &linearizations[e]);
+                  }
+                },
+                kMinChunkSize);
+
+    // Reduces the edge contributions per node, so that each thread only writes
+    // the diagonal blocks and gradient entries of its own nodes.
+    ParallelFor(num_nodes, num_threads,
+                [&](int, std::size_t begin, std::size_t end) {
+                  for (auto n = begin; n < end; ++n) {
+                    const int index = free_index_[n];
+                    if (index < 0) {
+                      continue;
+                    }
+                    Matrix6& d = diagonal[n];
+                    d = Matrix6::Zero();
+                    Vector6 b;
+                    for (auto k = incidence_offsets_[n];
+                         k < incidence_offsets_[n + 1]; ++k) {
+                      const Incidence& inc = incidences_[k];
+                      const Linearization& lin = linearizations[inc.edge];
+                      d += inc.is_from ? lin.h_ii : lin.h_jj;
+                      b += inc.is_from ? lin.b_i : lin.b_j;
+                    }
+                    std::copy(b.data(), b.data() + kBlockSize,
+                              gradient.begin() + kBlockSize * index);
+                  }
+                },
+                kMinChunkSize);
+
+    solver_.SetZero();
+    for (std::size_t n = 0; n < num_nodes; ++n) {
+      if (free_index_[n] >= 0) {
+        solver_.AddToDiagonal(free_index_[n], diagonal[n]);
+      }
+    }
+    for (std::size_t e = 0; e < num_edges; ++e) {
+      const int i = free_index_[edges_[e].from];
+      const int j = free_index_[edges_[e].to];
+      if (i >= 0 && j >= 0) {
+        solver_.AddToOffDiagonal(i, j, linearizations[e].h_ij);
+      }
+    }
+    if (!solver_.Factorize()) {
+      throw std::runtime_error(
+          "Singular normal equations: every connected component of the graph "
+          "needs a fixed node.");
+    }
+    for (auto& value : gradient) {
+      value = -value;
+    }
+    solver_.Solve(gradient, &delta);
+
+    // Applies the update in the local frame of every free node.
+    ParallelFor(num_nodes, num_threads,
+                [&](int, std::size_t begin, std::size_t end) {
+                  for (auto n = begin; n < end; ++n) {
+                    if (free_index_[n] < 0) {
+                      continue;
+                    }
+                    const double* d = delta.data() + kBlockSize * free_index_[n];
+                    const Isometry& pose = nodes_[n];
+                    const Vector3 dt(d[0], d[1], d[2]);
+                    const Vector3 dw(d[3], d[4], d[5]);
+                    nodes_[n] = Isometry(
+                        pose.translation() + pose.rotation().product(dt),
+                        pose.rotation().product(SO3::Exp(dw)));
+                  }
+                },
+                kMinChunkSize);
+
+    ++summary.iterations;
+    const double next_error = error();
+    const double decrease = current_error - next_error;
+    current_error = next_error;
+    double max_step = 0.;
+    for (const double value : delta) {
+      max_step = std::max(max_step, std::fabs(value));
+    }
+    if (std::fabs(decrease) <= options.function_tolerance * next_error ||
+        max_step <= options.parameter_tolerance) {
+      break;
+    }
+  }
+  summary.final_error = current_error;
+  return summary;
+}
+
+}  // namespace math
+}  // namespace ekumen
@@ -0,0 +1,459 @@
+#include "ray_batch.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+#include "aabb.h"
+#include "bvh.h"
+#include "cpu_features.h"
+#include "isometry.h"
+#include "matrix3.h"
+#include "point_cloud.h"
+#include "triangle_mesh.h"
+#include "vector3.h"
+
+namespace ekumen {
+namespace math {
+namespace {
+// Rays moved into the frame of a mesh at once, small enough to stay in the
+// L1 cache.
+constexpr std::size_t kBlockSize = 256;
+
+// Rays of a block that traverse the hierarchy of a mesh together. A node is
+// visited when any of them enters it, so packets of neighbouring rays, e.g.
+// of a LiDAR scan, share most of their traversal.
+constexpr std::size_t kPacketSize = 8;
+
+// Inverse of a pose as raw doubles: local = r * (world - t).
+struct Frame {
+  explicit Frame(const Isometry& pose) {
+    for (int i = 0; i < 3; ++i) {
+      for (int j = 0; j < 3; ++j) {
+        r[3 * i + j] = pose.rotation()[j][i];
+      }
+      t[i] = pose.translation()[i];
+    }
+  }
+
+  double r[9];
+  double t[3];
+};
+
+// Arrays of a batch of rays and of their hits.
+struct Arrays {
+  Arrays(const RayBatch& rays, RayHits* hits)
+      : ox(rays.origins().x()),
+        oy(rays.origins().y()),
+        oz(rays.origins().z()),
+        dx(rays.directions().x()),
+        dy(rays.directions().y()),
+        dz(rays.directions().z()),
+        distances(hits->distances.data()),
+        ids(hits->ids.data()) {}
+
+  const double* ox;
+  const double* oy;
+  const double* oz;
+  const double* dx;
+  const double* dy;
+  const double* dz;
+  double* distances;
+  std::uint32_t* ids;
+};
+
+// Block of rays in the frame of a mesh.
+struct LocalRays {
+  double ox[kBlockSize];
+  double oy[kBlockSize];
+  double oz[kBlockSize];
+  double dx[kBlockSize];
+  double dy[kBlockSize];
+  double dz[kBlockSize];
+  // Inverses of the directions, for the slab tests of the nodes.
+  double ix[kBlockSize];
+  double iy[kBlockSize];
+  double iz[kBlockSize];
+};
+
+// Triangle as a corner and the edges from it.
+struct Triangle {
+  double a[3];
+  double e1[3];
+  double e2[3];
+};
+
+// Keeps a hit at 't' with 'id' when it is in front of the ray and nearer
+// than the current one, without branches.
+inline void keepNearer(double t, std::uint32_t id, bool valid,
+                       double* distance, std::uint32_t* current) {
+  const bool nearer = valid & (t >= 0.) & (t < *distance);
+  *distance = nearer ? t : *distance;
+  *current = nearer ? id : *current;
+}
+
+// Plane in the world frame, the points p with n . p == offset.
+inline void planeLoop(const Arrays& rays, const double* n, double offset,
+                      std::uint32_t id, std::size_t size) {
+  const double nx = n[0];
+  const double ny = n[1];
+  const double nz = n[2];
+  const double* ox = rays.ox;
+  const double* oy = rays.oy;
+  const double* oz = rays.oz;
+  const double* dx = rays.dx;
+  const double* dy = rays.dy;
+  const double* dz = rays.dz;
+  double* distances = rays.distances;
+  std::uint32_t* ids = rays.ids;
+  for (std::size_t i = 0; i < size; ++i) {
+    const double along = nx * dx[i] + ny * dy[i] + nz * dz[i];
+    const double height = offset - (nx * ox[i] + ny * oy[i] + nz * oz[i]);
+    keepNearer(height / along, id, along != 0., &distances[i], &ids[i]);
+  }
+}
+
+// Slab test of the rays, moved by 'frame', against the box [low; high].
+inline void boxLoop(const Arrays& rays, const Frame& frame, const double* low,
+                    const double* high, std::uint32_t id, std::size_t size) {
+  const double* r = frame.r;
+  const double* t = frame.t;
+  const double r0 = r[0], r1 = r[1], r2 = r[2], r3 = r[3], r4 = r[4];
+  const double r5 = r[5], r6 = r[6], r7 = r[7], r8 = r[8];
+  const double tx = t[0], ty = t[1], tz = t[2];
+  const double low_x = low[0], low_y = low[1], low_z = low[2];
+  const double high_x = high[0], high_y = high[1], high_z = high[2];
+  const double* ox = rays.ox;
+  const double* oy = rays.oy;
+  const double* oz = rays.oz;
+  const double* dx = rays.dx;
+  const double* dy = rays.dy;
+  const double* dz = rays.dz;
+  double* distances = rays.distances;
+  std::uint32_t* ids = rays.ids;
+  for (std::size_t i = 0; i < size; ++i) {
+    const double px = ox[i] - tx;
+    const double py = oy[i] - ty;
+    const double pz = oz[i] - tz;
+    const double o[3] = {r0 * px + r1 * py + r2 * pz,
+                         r3 * px + r4 * py + r5 * pz,
+                         r6 * px + r7 * py + r8 * pz};
+    const double d[3] = {r0 * dx[i] + r1 * dy[i] + r2 * dz[i],
+                         r3 * dx[i] + r4 * dy[i] + r5 * dz[i],
+                         r6 * dx[i] + r7 * dy[i] + r8 * dz[i]};
+    const double lows[3] = {low_x, low_y, low_z};
+    const double highs[3] = {high_x, high_y, high_z};
+    double enter = 0.;
+    double exit = distances[i];
+    for (int k = 0; k < 3; ++k) {
+      const double inverse = 1. / d[k];
+      const double t0 = (lows[k] - o[k]) * inverse;
+      const double t1 = (highs[k] - o[k]) * inverse;
+      const double near = t0 < t1 ? t0 : t1;
+      const double far = t0 < t1 ? t1 : t0;
+      enter = near > enter ? near : enter;
+      exit = far < exit ? far : exit;
+    }
+    keepNearer(enter, id, enter <= exit, &distances[i], &ids[i]);
+  }
+}
+
+// Moves rays [begin; begin + size) by 'frame' into 'local'.
+inline void toLocal(const Arrays& rays, const Frame& frame, std::size_t begin,
+                    std::size_t size, LocalRays* local) {
+  const double* r = frame.r;
+  for (std::size_t i = 0; i < size; ++i) {
+    const double px = rays.ox[begin + i] - frame.t[0];
+    const double py = rays.oy[begin + i] - frame.t[1];
+    const double pz = rays.oz[begin + i] - frame.t[2];
+    const double dx = rays.dx[begin + i];
+    const double dy = rays.dy[begin + i];
+    const double dz = rays.dz[begin + i];
+    local->ox[i] = r[0] * px + r[1] * py + r[2] * pz;
+    local->oy[i] = r[3] * px + r[4] * py + r[5] * pz;
+    local->oz[i] = r[6] * px + r[7] * py + r[8] * pz;
+    local->dx[i] = r[0] * dx + r[1] * dy + r[2] * dz;
+    local->dy[i] = r[3] * dx + r[4] * dy + r[5] * dz;
+    local->dz[i] = r[6] * dx + r[7] * dy + r[8] * dz;
+    local->ix[i] = 1. / local->dx[i];
+    local->iy[i] = 1. / local->dy[i];
+    local->iz[i] = 1. / local->dz[i];
+  }
+}
+
+// Möller-Trumbore test of rays [begin; end) of a block against a triangle.
+inline void triangleLoop(const LocalRays& rays, const Triangle& triangle,
+                         std::uint32_t id, std::size_t begin, std::size_t end,
+                         double* distances, std::uint32_t* ids) {
+  const double ax = triangle.a[0], ay = triangle.a[1], az = triangle.a[2];
+  const double e1x = triangle.e1[0], e1y = triangle.e1[1];
+  const double e1z = triangle.e1[2];
+  const double e2x = triangle.e2[0], e2y = triangle.e2[1];
+  const double e2z = triangle.e2[2];
+  for (std::size_t i = begin; i < end; ++i) {
+    const double dx = rays.dx[i];
+    const double dy = rays.dy[i];
+    const double dz = rays.dz[i];
+    const double px = dy * e2z - dz * e2y;
+    const double py = dz * e2x - dx * e2z;
+    const double pz = dx * e2y - dy * e2x;
+    const double determinant = e1x * px + e1y * py + e1z * pz;
+    const double inverse = 1. / determinant;
+    const double sx = rays.ox[i] - ax;
+    const double sy = rays.oy[i] - ay;
+    const double sz = rays.oz[i] - az;
+    const double u = (sx * px + sy * py + sz * pz) * inverse;
+    const double qx = sy * e1z - sz * e1y;
+    const double qy = sz * e1x - sx * e1z;
+    const double qz = sx * e1y - sy * e1x;
+    const double v = (dx * qx + dy * qy + dz * qz) * inverse;
+    const double t = (e2x * qx + e2y * qy + e2z * qz) * inverse;
+    const bool inside = (determinant != 0.) & (u >= 0.) & (v >= 0.) &
+                        (u + v <= 1.);
+    keepNearer(t, id, inside, &distances[i], &ids[i]);
+  }
+}
+
+// Whether any of rays [begin; end) of a block enters 'node' nearer than its
+// current hit, without branches.
+inline bool packetEnters(const LocalRays& rays, const BvhNode& node,
+                         std::size_t begin, std::size_t end,
+                         const double* distances) {
+  const double min_x = node.min[0], min_y = node.min[1];
+  const double min_z = node.min[2];
+  const double max_x = node.max[0], max_y = node.max[1];
+  const double max_z = node.max[2];
+  bool any = false;
+  for (std::size_t i = begin; i < end; ++i) {
+    const double x0 = (min_x - rays.ox[i]) * rays.ix[i];
+    const double x1 = (max_x - rays.ox[i]) * rays.ix[i];
+    const double y0 = (min_y - rays.oy[i]) * rays.iy[i];
+    const double y1 = (max_y - rays.oy[i]) * rays.iy[i];
+    const double z0 = (min_z - rays.oz[i]) * rays.iz[i];
+    const double z1 = (max_z - rays.oz[i]) * rays.iz[i];
+    double enter = 0.;
+    double exit = distances[i];
+    enter = std::max(enter, std::min(x0, x1));
+    exit = std::min(exit, std::max(x0, x1));
+    enter = std::max(enter, std::min(y0, y1));
+    exit = std::min(exit, std::max(y0, y1));
+    enter = std::max(enter, std::min(z0, z1));
+    exit = std::min(exit, std::max(z0, z1));
+    any |= enter <= exit;
+  }
+  return any;
+}
+
+// Traverses 'nodes' with the packets of a block of rays, and tests the rays
+// of a packet against the triangles of the leaves it enters. The triangles
+// are in leaf order, with the mesh indices in 'primitives'.
+inline void meshLoop(const LocalRays& rays, const std::vector<BvhNode>& nodes,
+                     const std::vector<Triangle>& triangles,
+                     const std::vector<std::uint32_t>& primitives,
+                     std::size_t size, double* distances,
+                     std::uint32_t* ids) {
+  std::uint32_t stack[Bvh::kMaxDepth + 2];
+  for (std::size_t begin = 0; begin < size; begin += kPacketSize) {
+    const std::size_t end = std::min(size, begin + kPacketSize);
+    // The children are ordered by the direction of the first ray.
+    const double inverse[3] = {rays.ix[begin], rays.iy[begin],
+                               rays.iz[begin]};
+    int top = 0;
+    stack[top++] = 0;
+    while (top > 0) {
+      const std::uint32_t index = stack[--top];
+      const BvhNode& node = nodes[index];
+      if (!packetEnters(rays, node, begin, end, distances)) {
+        continue;
+      }
+      if (node.isLeaf()) {
+        for (std::uint32_t i = node.offset; i < node.offset + node.count;
+             ++i) {
+          triangleLoop(rays, triangles[i], primitives[i], begin, end,
+                       distances, ids);
+        }
+        continue;
+      }
+      const bool backwards = inverse[node.axis] < 0.;
+      stack[top++] = backwards ? index + 1 : node.offset;
+      stack[top++] = backwards ? node.offset : index + 1;
+    }
+  }
+}
+
+#ifdef EKUMEN_AVX2_DISPATCH
+EKUMEN_TARGET_AVX2 void planeLoopAvx2(
+    const Arrays& rays, const double* n, double offset, std::uint32_t id,
+    std::size_t size) {
+  planeLoop(rays, n, offset, id, size);
+}
+
+EKUMEN_TARGET_AVX2 void boxLoopAvx2(
+    const Arrays& rays, const Frame& frame, const double* low,
+    const double* high, std::uint32_t id, std::size_t size) {
+  boxLoop(rays, frame, low, high, id, size);
+}
+
+EKUMEN_TARGET_AVX2 void meshLoopAvx2(
+    const LocalRays& rays, const std::vector<BvhNode>& nodes,
+    const std::vector<Triangle>& triangles,
+    const std::vector<std::uint32_t>& primitives, std::size_t size,
+    double* distances, std::uint32_t* ids) {
+  meshLoop(rays, nodes, triangles, primitives, size, distances, ids);
+}
+#endif
+
+void assertHitsFit(const RayBatch& rays, const RayHits* hits) {
+  if (hits == nullptr || hits->distances.size() != rays.size() ||
+      hits->ids.size() != rays.size()) {
+    throw std::invalid_argument("Ray hits must hold one entry per ray.");
+  }
+}
+}  // namespace
+
+const std::uint32_t RayHits::kNoHit;
+
+RayBatch::RayBatch(std::size_t size) : origins_(size), directions_(size) {}
+
+std::size_t RayBatch::size() const { return origins_.size(); }
+
+bool RayBatch::empty() const { return origins_.empty(); }
+
+void RayBatch::reserve(std::size_t capacity) {
+  origins_.reserve(capacity);
+  directions_.reserve(capacity);
+}
+
+void RayBatch::resize(std::size_t size) {
+  origins_.resize(size);
+  directions_.resize(size);
+}
+
+void RayBatch::clear() {
+  origins_.clear();
+  directions_.clear();
+}
+
+void RayBatch::push_back(const Vector3& origin, const Vector3& direction) {
+  origins_.push_back(origin);
+  directions_.push_back(direction);
+}
+
+Vector3 RayBatch::origin(std::size_t index) const {
+  return origins_.point(index);
+}
+
+Vector3 RayBatch::direction(std::size_t index) const {
+  return directions_.point(index);
+}
+
+void RayBatch::setRay(std::size_t index, const Vector3& origin,
+                      const Vector3& direction) {
+  origins_.setPoint(index, origin);
+  directions_.setPoint(index, direction);
+}
+
+const PointCloud& RayBatch::origins() const { return origins_; }
+
+const PointCloud& RayBatch::directions() const { return directions_; }
+
+PointCloud& RayBatch::origins() { return origins_; }
+
+PointCloud& RayBatch::directions() { return directions_; }
+
+Vector3 RayBatch::pointAt(std::size_t index, double distance) const {
+  return origin(index) + distance * direction(index);
+}
+
+void RayBatch::transform(const Isometry& pose) {
+  origins_.transform(pose);
+  directions_.transform(Isometry(pose.rotation()));
+}
+
+RayHits::RayHits(std::size_t size, double max_distance)
+    : distances(size, max_distance), ids(size, kNoHit) {}
+
+void CastPlane(const Isometry& pose, const Vector3& normal, double offset,
+               std::uint32_t id, const RayBatch& rays, RayHits* hits) {
+  assertHitsFit(rays, hits);
+  // The plane moves into the world frame, which is cheaper than moving
+  // every ray into its frame.
+  const Vector3 world_normal = pose.rotation().product(normal);
+  const double n[3] = {world_normal.x(), world_normal.y(), world_normal.z()};
+  const double world_offset = offset + world_normal.dot(pose.translation());
+  const Arrays arrays(rays, hits);
+#ifdef EKUMEN_AVX2_DISPATCH
+  if (CpuHasAvx2()) {
+    planeLoopAvx2(arrays, n, world_offset, id, rays.size());
+    return;
+  }
+#endif
+  planeLoop(arrays, n, world_offset, id, rays.size());
+}
+
+void CastBox(const Isometry& pose, const Aabb& box, std::uint32_t id,
+             const RayBatch& rays, RayHits* hits) {
+  assertHitsFit(rays, hits);
+  if (box.empty()) {
+    return;
+  }
+  const Frame frame(pose);
+  const double low[3] = {box.min.x(), box.min.y(), box.min.z()};
+  const double high[3] = {box.max.x(), box.max.y(), box.max.z()};
+  const Arrays arrays(rays, hits);
+#ifdef EKUMEN_AVX2_DISPATCH
+  if (CpuHasAvx2()) {
+    boxLoopAvx2(arrays, frame, low, high, id, rays.size());
+    return;
+  }
+#endif
+  boxLoop(arrays, frame, low, high, id, rays.size());
+}
+
+void CastTriangles(const Isometry& pose, const TriangleMesh& mesh,
+                   const RayBatch& rays, RayHits* hits) {
+  assertHitsFit(rays, hits);
+  const Bvh& bvh = mesh.bvh();
+  if (bvh.empty()) {
+    return;
+  }
+  // The triangles are copied in leaf order, so that the triangles of a leaf
+  // are contiguous.
+  const std::vector<std::uint32_t>& primitives = bvh.primitives();
+  std::vector<Triangle> triangles(primitives.size());
+  for (std::size_t i = 0; i < triangles.size(); ++i) {
+    const TriangleMesh::Triangle& triangle = mesh.triangle(primitives[i]);
+    const Vector3 a = mesh.vertex(triangle[0]);
+    const Vector3 b = mesh.vertex(triangle[1]);
+    const Vector3 c = mesh.vertex(triangle[2]);
+    for (int k = 0; k < 3; ++k) {
+      triangles[i].a[k] = a[k];
+      triangles[i].e1[k] = b[k] - a[k];
+      triangles[i].e2[k] = c[k] - a[k];
+    }
+  }
+  const Frame frame(pose);
+  const Arrays arrays(rays, hits);
+#ifdef EKUMEN_AVX2_DISPATCH
+  const bool avx2 = CpuHasAvx2();
+#endif
+  LocalRays local;
+  for (std::size_t begin = 0; begin < rays.size(); begin += kBlockSize) {
+    const std::size_t size = std::min(kBlockSize, rays.size() - begin);
+    toLocal(arrays, frame, begin, size, &local);
+    double* distances = arrays.distances + begin;
+    std::uint32_t* ids = arrays.ids + begin;
+#ifdef EKUMEN_AVX2_DISPATCH
+    if (avx2) {
+      meshLoopAvx2(local, bvh.nodes(), triangles, primitives, size, distances,
+                   ids);
+      continue;
+    }
+#endif
+    meshLoop(local, bvh.nodes(), triangles, primitives, size, distances, ids);
+  }
+}
+
+}  // namespace math
+}  // namespace ekumen
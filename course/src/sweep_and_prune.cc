@@ -0,0 +1,284 @@
+#include "sweep_and_prune.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+#include "aabb.h"
+#include "cpu_features.h"
+#include "isometry.h"
+#include "vector3.h"
+
+namespace ekumen {
+namespace math {
+namespace {
+// Slot of the bodies that are not in the active list.
+constexpr std::uint32_t kInactive = std::numeric_limits<std::uint32_t>::max();
+
+// The sort axis switches when the variance of the centers along another
+// axis is this many times larger, so that it does not flip between frames.
+constexpr double kAxisSwitchRatio = 2.;
+
+// World bounds of a box at 'pose', empty for empty boxes. Throws
+// std::invalid_argument when they are not finite, as NaN bounds would
+// break the order of the endpoints.
+Aabb worldBounds(const Aabb& box, const Isometry& pose) {
+  if (box.empty()) {
+    return Aabb();
+  }
+  const Aabb res = box.transformed(pose);
+  for (int i = 0; i < 3; ++i) {
+    if (!std::isfinite(res.min[i]) || !std::isfinite(res.max[i])) {
+      throw std::invalid_argument("Body bounds must be finite.");
+    }
+  }
+  return res;
+}
+
+// Order of the endpoints: lower bounds go first among equal values, so that
+// touching boxes overlap.
+template <typename Endpoint>
+bool before(const Endpoint& a, const Endpoint& b) {
+  return a.value < b.value ||
+         (a.value == b.value && (a.id & 1u) < (b.id & 1u));
+}
+
+// Bounds of the active bodies along the two axes other than the sort axis.
+struct ActiveBounds {
+  const double* min[2];
+  const double* max[2];
+};
+
+// Flags the first 'size' active bodies that overlap [low; high] along the
+// two other axes. The bounds are read into locals, which the flags cannot
+// alias.
+inline void overlapLoop(const ActiveBounds& active, const double* low,
+                        const double* high, std::size_t size,
+                        std::uint8_t* flags) {
+  const double* min1 = active.min[0];
+  const double* max1 = active.max[0];
+  const double* min2 = active.min[1];
+  const double* max2 = active.max[1];
+  const double low1 = low[0];
+  const double high1 = high[0];
+  const double low2 = low[1];
+  const double high2 = high[1];
+  for (std::size_t i = 0; i < size; ++i) {
+    flags[i] = !(min1[i] > high1) & !(low1 > max1[i]) & !(min2[i] > high2) &
+               !(low2 > max2[i]);
+  }
+}
+
+#ifdef EKUMEN_AVX2_DISPATCH
+EKUMEN_TARGET_AVX2 void overlapLoopAvx2(
+    const ActiveBounds& active, const double* low, const double* high,
+    std::size_t size, std::uint8_t* flags) {
+  overlapLoop(active, low, high, size, flags);
+}
+#endif
+
+void flagOverlaps(const ActiveBounds& active, const double* low,
+                  const double* high, std::size_t size, std::uint8_t* flags) {
+#ifdef EKUMEN_AVX2_DISPATCH
+  if (CpuHasAvx2()) {
+    overlapLoopAvx2(active, low, high, size, flags);
+    return;
+  }
+#endif
+  overlapLoop(active, low, high, size, flags);
+}
+}  // namespace
+
+std::size_t SweepAndPrune::size() const { return boxes_.size(); }
+
+bool SweepAndPrune::empty() const { return boxes_.empty(); }
+
+void SweepAndPrune::reserve(std::size_t capacity) {
+  boxes_.reserve(capacity);
+  for (int i = 0; i < 3; ++i) {
+    min_[i].reserve(capacity);
+    max_[i].reserve(capacity);
+  }
+  endpoints_.reserve(2 * capacity);
+}
+
+void SweepAndPrune::clear() {
+  boxes_.clear();
+  for (int i = 0; i < 3; ++i) {
+    min_[i].clear();
+    max_[i].clear();
+  }
+  endpoints_.clear();
+  needs_sort_ = false;
+}
+
+std::uint32_t SweepAndPrune::add(const Aabb& box, const Isometry& pose) {
+  const std::uint32_t body = static_cast<std::uint32_t>(boxes_.size());
+  const Aabb world = worldBounds(box, pose);
+  boxes_.push_back(box);
+  for (int i = 0; i < 3; ++i) {
+    min_[i].push_back(world.min[i]);
+    max_[i].push_back(world.max[i]);
+  }
+  // New endpoints go last and are sorted by the next findPairs().
+  endpoints_.push_back(Endpoint{world.min[axis_], 2 * body});
+  endpoints_.push_back(Endpoint{world.max[axis_], 2 * body + 1});
+  needs_sort_ = true;
+  return body;
+}
+
+void SweepAndPrune::setPose(std::size_t body, const Isometry& pose) {
+  assertValidAccessIndex(body);
+  const Aabb world = worldBounds(boxes_[body], pose);
+  for (int i = 0; i < 3; ++i) {
+    min_[i][body] = world.min[i];
+    max_[i][body] = world.max[i];
+  }
+}
+
+Aabb SweepAndPrune::bounds(std::size_t body) const {
+  assertValidAccessIndex(body);
+  return Aabb(Vector3(min_[0][body], min_[1][body], min_[2][body]),
+              Vector3(max_[0][body], max_[1][body], max_[2][body]));
+}
+
+void SweepAndPrune::setPoses(const std::vector<Isometry>& poses) {
+  if (poses.size() != size()) {
+    throw std::invalid_argument("There must be one pose per body.");
+  }
+  for (std::size_t i = 0; i < poses.size(); ++i) {
+    setPose(i, poses[i]);
+  }
+}
+
+int SweepAndPrune::axis() const { return axis_; }
+
+void SweepAndPrune::findPairs(std::vector<Pair>* pairs) {
+  pairs->clear();
+  chooseAxis();
+  sortEndpoints();
+  active_.clear();
+  slots_.assign(size(), kInactive);
+  for (int i = 0; i < 2; ++i) {
+    active_min_[i].clear();
+    active_max_[i].clear();
+  }
+  const int axes[2] = {(axis_ + 1) % 3, (axis_ + 2) % 3};
+  for (const Endpoint& endpoint : endpoints_) {
+    const std::uint32_t body = endpoint.id >> 1;
+    if (endpoint.id & 1u) {
+      // Leaves the active list, the last body taking its slot.
+      const std::uint32_t slot = slots_[body];
+      if (slot == kInactive) {
+        continue;
+      }
+      const std::uint32_t last = active_.back();
+      active_[slot] = last;
+      slots_[last] = slot;
+      active_.pop_back();
+      for (int i = 0; i < 2; ++i) {
+        active_min_[i][slot] = active_min_[i].back();
+        active_max_[i][slot] = active_max_[i].back();
+        active_min_[i].pop_back();
+        active_max_[i].pop_back();
+      }
+      slots_[body] = kInactive;
+      continue;
+    }
+    if (!(min_[axis_][body] <= max_[axis_][body]) ||
+        !(min_[axes[0]][body] <= max_[axes[0]][body]) ||
+        !(min_[axes[1]][body] <= max_[axes[1]][body])) {
+      continue;
+    }
+    // Every active body overlaps this one along the sort axis, so only the
+    // other axes are tested, over the bounds of the active bodies in a row.
+    const double low[2] = {min_[axes[0]][body], min_[axes[1]][body]};
+    const double high[2] = {max_[axes[0]][body], max_[axes[1]][body]};
+    const ActiveBounds bounds = {
+        {active_min_[0].data(), active_min_[1].data()},
+        {active_max_[0].data(), active_max_[1].data()}};
+    const std::size_t num_active = active_.size();
+    flags_.resize(num_active);
+    std::uint8_t* flags = flags_.data();
+    flagOverlaps(bounds, low, high, num_active, flags);
+    for (std::size_t i = 0; i < num_active; ++i) {
+      if (flags[i]) {
+        const std::uint32_t other = active_[i];
+        pairs->emplace_back(std::min(body, other), std::max(body, other));
+      }
+    }
+    slots_[body] = static_cast<std::uint32_t>(num_active);
+    active_.push_back(body);
+    for (int i = 0; i < 2; ++i) {
+      active_min_[i].push_back(low[i]);
+      active_max_[i].push_back(high[i]);
+    }
+  }
+}
+
+void SweepAndPrune::assertValidAccessIndex(std::size_t index) const {
+  if (index >= size()) {
+    throw std::out_of_range("Index to access a body is out of range.");
+  }
+}
+
+void SweepAndPrune::chooseAxis() {
+  double sum[3] = {0., 0., 0.};
+  double squares[3] = {0., 0., 0.};
+  std::size_t count = 0;
+  for (std::size_t body = 0; body < size(); ++body) {
+    if (!(min_[0][body] <= max_[0][body]) ||
+        !(min_[1][body] <= max_[1][body]) ||
+        !(min_[2][body] <= max_[2][body])) {
+      continue;
+    }
+    ++count;
+    for (int i = 0; i < 3; ++i) {
+      const double center = 0.5 * (min_[i][body] + max_[i][body]);
+      sum[i] += center;
+      squares[i] += center * center;
+    }
+  }
+  if (count < 2) {
+    return;
+  }
+  double variance[3];
+  for (int i = 0; i < 3; ++i) {
+    variance[i] = squares[i] - sum[i] * sum[i] / count;
+  }
+  const int best = static_cast<int>(
+      std::max_element(variance, variance + 3) - variance);
+  if (variance[best] > kAxisSwitchRatio * variance[axis_]) {
+    axis_ = best;
+    // The order along the old axis says nothing about the new one.
+    needs_sort_ = true;
+  }
+}
+
+void SweepAndPrune::sortEndpoints() {
+  const double* bounds[2] = {min_[axis_].data(), max_[axis_].data()};
+  for (Endpoint& endpoint : endpoints_) {
+    endpoint.value = bounds[endpoint.id & 1u][endpoint.id >> 1];
+  }
+  if (needs_sort_) {
+    std::sort(endpoints_.begin(), endpoints_.end(), before<Endpoint>);
+    needs_sort_ = false;
+    return;
+  }
+  // Insertion sort, which moves each endpoint past the few it crossed since
+  // the last call.
+  for (std::size_t i = 1; i < endpoints_.size(); ++i) {
+    const Endpoint endpoint = endpoints_[i];
+    std::size_t j = i;
+    for (; j > 0 && before(endpoint, endpoints_[j - 1]); --j) {
+      endpoints_[j] = endpoints_[j - 1];
+    }
+    endpoints_[j] = endpoint;
+  }
+}
+
+}  // namespace math
+}  // namespace ekumen
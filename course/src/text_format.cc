@@ -0,0 +1,398 @@
+#include "text_format.h"
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+#include "c_locale.h"
+#include "isometry.h"
+#include "matrix3.h"
+#include "vector3.h"
+
+namespace ekumen {
+namespace math {
+namespace {
+// Appends text to a fixed buffer, always leaving room for a null character.
+class BufferWriter {
+ public:
+  BufferWriter(char* buffer, std::size_t size)
+      : begin_(buffer), pos_(buffer), end_(buffer + size) {
+    if (size == 0) {
+      throw std::length_error("Text buffer is too small.");
+    }
+  }
+
+  template <std::size_t N>
+  void append(const char (&literal)[N]) {
+    const std::size_t length = N - 1;
+    if (static_cast<std::size_t>(end_ - pos_) <= length) {
+      throw std::length_error("Text buffer is too small.");
+    }
+    std::memcpy(pos_, literal, length);
+    pos_ += length;
+    *pos_ = '\0';
+  }
+
+  void append(const double& value, int precision) {
+    pos_ += TextFormat::Format(value, pos_, end_ - pos_, precision);
+  }
+
+  std::size_t length() const { return pos_ - begin_; }
+
+ private:
+  char* begin_;
+  char* pos_;
+  char* end_;
+};
+
+void appendRow(const Vector3& row, int precision, BufferWriter* writer) {
+  writer->append("[");
+  writer->append(row.x(), precision);
+  writer->append(", ");
+  writer->append(row.y(), precision);
+  writer->append(", ");
+  writer->append(row.z(), precision);
+  writer->append("]");
+}
+
+void appendVector(const Vector3& obj, int precision, BufferWriter* writer) {
+  writer->append("(x: ");
+  writer->append(obj.x(), precision);
+  writer->append(", y: ");
+  writer->append(obj.y(), precision);
+  writer->append(", z: ");
+  writer->append(obj.z(), precision);
+  writer->append(")");
+}
+
+void appendMatrix(const Matrix3& obj, int precision, BufferWriter* writer) {
+  writer->append("[");
+  appendRow(obj[0], precision, writer);
+  writer->append(", ");
+  appendRow(obj[1], precision, writer);
+  writer->append(", ");
+  appendRow(obj[2], precision, writer);
+  writer->append("]");
+}
+
+// Formats 'value' with '%.*g' into a buffer of at least kMaxScalarSize.
+int printScalar(const double& value, int precision, char* buffer) {
+  return FormatDoubleC(value, precision, buffer, TextFormat::kMaxScalarSize);
+}
+
+typedef unsigned __int128 uint128;
+
+constexpr std::uint64_t kPowersOf10[18] = {
+    1ull, 10ull, 100ull, 1000ull, 10000ull, 100000ull, 1000000ull, 10000000ull,
+    100000000ull, 1000000000ull, 10000000000ull, 100000000000ull,
+    1000000000000ull, 10000000000000ull, 100000000000000ull,
+    1000000000000000ull, 10000000000000000ull, 100000000000000000ull};
+
+// Scaled values are kept below this many bits, so that doubling or
+// quadrupling them cannot overflow.
+constexpr int kMaxScaledBits = 124;
+
+int bitLength(const uint128& x) {
+  const std::uint64_t high = static_cast<std::uint64_t>(x >> 64);
+  if (high != 0) {
+    return 128 - __builtin_clzll(high);
+  }
+  const std::uint64_t low = static_cast<std::uint64_t>(x);
+  return low == 0 ? 0 : 64 - __builtin_clzll(low);
+}
+
+constexpr int kMaxPowerOf5 = 48;
+
+// Returns 5^n for n in [0, kMaxPowerOf5].
+const uint128& powerOf5(int n) {
+  struct Table {
+    Table() {
+      values[0] = 1;
+      for (int i = 1; i <= kMaxPowerOf5; ++i) {
+        values[i] = values[i - 1] * 5;
+      }
+    }
+    uint128 values[kMaxPowerOf5 + 1];
+  };
+  static const Table table;
+  return table.values[n];
+}
+
+// A double rounded to a number of significant decimal digits:
+// digits * 10^(exponent - precision + 1), with digits in [10^(p-1), 10^p).
+struct Decimal {
+  std::uint64_t digits;
+  int exponent;
+  // True when the digits parse back to the original double.
+  bool round_trips;
+};
+
+// Computes the decimal rounding of a positive finite 'value' exactly, with
+// 128-bit integers, rounding ties to even like glibc's printf. Returns false
+// when the scaled value does not fit, which only happens for subnormals and
+// magnitudes far from 1; callers then fall back to printf.
+bool toDecimal(const double& value, int precision, Decimal* res) {
+  // value = mantissa * 2^binary_exponent, with a 53-bit mantissa.
+  std::uint64_t bits;
+  std::memcpy(&bits, &value, sizeof(bits));
+  const int biased_exponent = static_cast<int>(bits >> 52);
+  if (biased_exponent == 0) {
+    // Subnormal.
+    return false;
+  }
+  const std::uint64_t mantissa = (bits & ((1ull << 52) - 1)) | (1ull << 52);
+  const int binary_exponent = biased_exponent - 1075;
+
+  // 'value' is in [2^(e - 1), 2^e) with e = binary_exponent + 53, so its
+  // decimal exponent is floor((e - 1) * log10(2)) or one more.
+  int decimal_exponent = ((binary_exponent + 52) * 78913) >> 18;
+  for (int attempt = 0; attempt < 3; ++attempt) {
+    // value * 10^k = numerator / denominator, and unit / denominator is the
+    // scaled distance between 'value' and its neighbours.
+    const int k = precision - 1 - decimal_exponent;
+    if (k > kMaxPowerOf5 || k < -kMaxPowerOf5) {
+      return false;
+    }
+    const uint128& power_of_5 = powerOf5(k < 0 ? -k : k);
+    uint128 numerator = mantissa;
+    uint128 denominator = 1;
+    uint128 unit = 1;
+    if (k >= 0) {
+      if (bitLength(power_of_5) + 53 > kMaxScaledBits) {
+        return false;
+      }
+      numerator *= power_of_5;
+      unit = power_of_5;
+    } else {
+      denominator = power_of_5;
+    }
+    const int shift = binary_exponent + k;
+    if (shift >= 0) {
+      if (bitLength(numerator) + shift > kMaxScaledBits) {
+        return false;
+      }
+      numerator <<= shift;
+      unit <<= shift;
+    } else {
+      if (bitLength(denominator) - shift > kMaxScaledBits) {
+        return false;
+      }
+      denominator <<= -shift;
+    }
+
+    // The denominator is a power of two unless k < 0, which only happens
+    // for values with more integer digits than 'precision'.
+    uint128 floor;
+    uint128 remainder;
+    if (k >= 0) {
+      const int denominator_shift = shift >= 0 ? 0 : -shift;
+      floor = numerator >> denominator_shift;
+      remainder = numerator & (denominator - 1);
+    } else {
+      floor = numerator / denominator;
+      remainder = numerator % denominator;
+    }
+    if (floor >= kPowersOf10[precision]) {
+      ++decimal_exponent;
+      continue;
+    }
+    if (floor < kPowersOf10[precision - 1]) {
+      --decimal_exponent;
+      continue;
+    }
+    const uint128 twice = remainder << 1;
+    const bool round_up =
+        twice > denominator || (twice == denominator && (floor & 1) != 0);
+    const uint128 error = round_up ? denominator - remainder : remainder;
+
+    res->digits = static_cast<std::uint64_t>(floor) + (round_up ? 1 : 0);
+    res->exponent = decimal_exponent;
+    if (res->digits == kPowersOf10[precision]) {
+      res->digits = kPowersOf10[precision - 1];
+      ++res->exponent;
+    }
+    // Parsing rounds to the nearest double, ties to even. Below a power of
+    // two the gap to the previous double is half as large.
+    const bool even = (mantissa & 1) == 0;
+    if (!round_up && mantissa == (1ull << 52)) {
+      res->round_trips = 4 * error <= unit;
+    } else {
+      res->round_trips = 2 * error < unit || (2 * error == unit && even);
+    }
+    return true;
+  }
+  return false;
+}
+
+// Lays out a decimal like '%.*g' does, for a positive value. Returns the
+// number of characters written to 'buffer'.
+int layoutDecimal(const Decimal& decimal, int precision, char* buffer) {
+  char digits[17];
+  std::uint64_t value = decimal.digits;
+  for (int i = precision - 1; i >= 0; --i) {
+    digits[i] = static_cast<char>('0' + value % 10);
+    value /= 10;
+  }
+  // Trailing zeros are dropped, as '%g' does without the '#' flag.
+  int significant = precision;
+  while (significant > 1 && digits[significant - 1] == '0') {
+    --significant;
+  }
+
+  char* pos = buffer;
+  const int exponent = decimal.exponent;
+  if (exponent >= -4 && exponent < precision) {
+    if (exponent < 0) {
+      *pos++ = '0';
+      *pos++ = '.';
+      for (int i = 0; i < -exponent - 1; ++i) {
+        *pos++ = '0';
+      }
+      std::memcpy(pos, digits, significant);
+      pos += significant;
+    } else {
+      const int integer = exponent + 1;
+      const int copied = significant > integer ? significant : integer;
+      for (int i = 0; i < copied; ++i) {
+        if (i == integer) {
+          *pos++ = '.';
+        }
+        *pos++ = i < significant ? digits[i] : '0';
+      }
+    }
+  } else {
+    *pos++ = digits[0];
+    if (significant > 1) {
+      *pos++ = '.';
+      std::memcpy(pos, digits + 1, significant - 1);
+      pos += significant - 1;
+    }
+    *pos++ = 'e';
+    *pos++ = exponent < 0 ? '-' : '+';
+    const int magnitude = exponent < 0 ? -exponent : exponent;
+    if (magnitude >= 100) {
+      *pos++ = static_cast<char>('0' + magnitude / 100);
+    }
+    *pos++ = static_cast<char>('0' + magnitude / 10 % 10);
+    *pos++ = static_cast<char>('0' + magnitude % 10);
+  }
+  return static_cast<int>(pos - buffer);
+}
+
+// Formats 'value' like '%.*g', or with the shortest of 15 to 17 digits that
+// round-trips when 'precision' is kRoundTrip. Returns the length of the
+// null-terminated text in 'buffer', of at least kMaxScalarSize.
+int formatScalar(const double& value, int precision, char* buffer) {
+  if (std::isfinite(value) && value != 0.) {
+    char* pos = buffer;
+    if (value < 0.) {
+      *pos++ = '-';
+    }
+    const double magnitude = std::fabs(value);
+    Decimal decimal;
+    if (precision == TextFormat::kRoundTrip) {
+      for (int digits = 15; digits <= TextFormat::kMaxPrecision; ++digits) {
+        if (!toDecimal(magnitude, digits, &decimal)) {
+          break;
+        }
+        if (decimal.round_trips || digits == TextFormat::kMaxPrecision) {
+          pos += layoutDecimal(decimal, digits, pos);
+          *pos = '\0';
+          return static_cast<int>(pos - buffer);
+        }
+      }
+    } else {
+      const int digits = precision == 0 ? 1 : precision;
+      if (toDecimal(magnitude, digits, &decimal)) {
+        pos += layoutDecimal(decimal, digits, pos);
+        *pos = '\0';
+        return static_cast<int>(pos - buffer);
+      }
+    }
+  }
+
+  if (precision != TextFormat::kRoundTrip) {
+    return printScalar(value, precision, buffer);
+  }
+  // 15 digits round-trip most decimal inputs; 17 always do.
+  int length = 0;
+  for (int digits = 15; digits <= TextFormat::kMaxPrecision; ++digits) {
+    length = printScalar(value, digits, buffer);
+    if (StrtodC(buffer, nullptr) == value) {
+      break;
+    }
+  }
+  return length;
+}
+}  // namespace
+
+const int TextFormat::kRoundTrip;
+const int TextFormat::kMaxPrecision;
+const int TextFormat::kStreamPrecision;
+const int TextFormat::kMatrixPrecision;
+const std::size_t TextFormat::kMaxScalarSize;
+const std::size_t TextFormat::kMaxVector3Size;
+const std::size_t TextFormat::kMaxMatrix3Size;
+const std::size_t TextFormat::kMaxIsometrySize;
+const std::size_t TextFormat::kLineBufferSize;
+
+std::size_t TextFormat::Format(const Vector3& obj, char* buffer,
+                               std::size_t size, int precision) {
+  BufferWriter writer(buffer, size);
+  appendVector(obj, precision, &writer);
+  return writer.length();
+}
+
+std::size_t TextFormat::Format(const Matrix3& obj, char* buffer,
+                               std::size_t size, int precision) {
+  BufferWriter writer(buffer, size);
+  appendMatrix(obj, precision, &writer);
+  return writer.length();
+}
+
+std::size_t TextFormat::Format(const Isometry& obj, char* buffer,
+                               std::size_t size, int precision) {
+  BufferWriter writer(buffer, size);
+  writer.append("[T: ");
+  appendVector(obj.translation(), precision, &writer);
+  writer.append(", R:");
+  appendMatrix(obj.rotation(),
+               precision == kRoundTrip ? kRoundTrip : kMatrixPrecision,
+               &writer);
+  writer.append("]");
+  return writer.length();
+}
+
+std::size_t TextFormat::Format(const double& value, char* buffer,
+                               std::size_t size, int precision) {
+  if (precision < kRoundTrip || precision > kMaxPrecision) {
+    throw std::invalid_argument("Invalid text format precision.");
+  }
+  char scalar[kMaxScalarSize];
+  const int length = formatScalar(value, precision, scalar);
+  if (static_cast<std::size_t>(length) >= size) {
+    throw std::length_error("Text buffer is too small.");
+  }
+  std::memcpy(buffer, scalar, length + 1);
+  return length;
+}
+
+bool TextFormat::UsesDefaultFormat(const std::ostream& os) {
+  const std::ios_base::fmtflags flags =
+      std::ios_base::floatfield | std::ios_base::showpos |
+      std::ios_base::showpoint | std::ios_base::uppercase;
+  return (os.flags() & flags) == 0 && os.width() == 0 &&
+         os.precision() >= 0 && os.precision() <= kMaxPrecision;
+}
+
+void TextFormat::flush(const char* buffer, std::size_t size,
+                       std::ostream* os) {
+  os->write(buffer, size);
+  if (!*os) {
+    throw std::runtime_error("Cannot write formatted text.");
+  }
+}
+
+}  // namespace math
+}  // namespace ekumen
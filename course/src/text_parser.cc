@@ -0,0 +1,344 @@
+#include "text_parser.h"
+
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include "c_locale.h"
+#include "isometry.h"
+#include "matrix3.h"
+#include "vector3.h"
+
+namespace ekumen {
+namespace math {
+namespace {
+// Longest number handed to StrtodC(); longer ones are rejected.
+constexpr std::size_t kMaxNumberLength = 128;
+
+// Decimal mantissas are accumulated exactly up to this many digits.
+constexpr int kMaxMantissaDigits = 19;
+
+// Powers of ten that are exact doubles.
+constexpr double kExactPowersOf10[23] = {
+    1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+
+bool isDigit(char c) { return c >= '0' && c <= '9'; }
+
+// Walks [begin, end) keeping track of the first error.
+class Cursor {
+ public:
+  Cursor(const char* begin, const char* end)
+      : begin_(begin), pos_(begin), end_(end), message_(nullptr) {}
+
+  bool ok() const { return message_ == nullptr; }
+
+  // Consumes 'literal' or fails.
+  template <std::size_t N>
+  void expect(const char (&literal)[N]) {
+    if (!ok()) {
+      return;
+    }
+    const std::size_t length = N - 1;
+    for (std::size_t i = 0; i < length; ++i) {
+      if (pos_ + i == end_ || pos_[i] != literal[i]) {
+        fail(pos_ + i, "Unexpected character.");
+        return;
+      }
+    }
+    pos_ += length;
+  }
+
+  void number(double* res) {
+    if (!ok()) {
+      return;
+    }
+    const ParseStatus status = TextParser::Parse(pos_, end_, res);
+    if (!status.ok()) {
+      fail(pos_ + status.offset, status.message);
+      return;
+    }
+    pos_ += status.offset;
+  }
+
+  void vector(Vector3* res) {
+    expect("(x: ");
+    number(&res->x());
+    expect(", y: ");
+    number(&res->y());
+    expect(", z: ");
+    number(&res->z());
+    expect(")");
+  }
+
+  void row(Vector3* res) {
+    expect("[");
+    number(&res->x());
+    expect(", ");
+    number(&res->y());
+    expect(", ");
+    number(&res->z());
+    expect("]");
+  }
+
+  void matrix(Matrix3* res) {
+    expect("[");
+    row(&(*res)[0]);
+    expect(", ");
+    row(&(*res)[1]);
+    expect(", ");
+    row(&(*res)[2]);
+    expect("]");
+  }
+
+  ParseStatus status() const {
+    ParseStatus res;
+    res.offset = pos_ - begin_;
+    res.message = message_;
+    return res;
+  }
+
+ private:
+  void fail(const char* pos, const char* message) {
+    pos_ = pos;
+    message_ = message;
+  }
+
+  const char* begin_;
+  const char* pos_;
+  const char* end_;
+  const char* message_;
+};
+
+ParseStatus success(std::size_t offset) {
+  ParseStatus res;
+  res.offset = offset;
+  res.message = nullptr;
+  return res;
+}
+
+ParseStatus failure(std::size_t offset, const char* message) {
+  ParseStatus res;
+  res.offset = offset;
+  res.message = message;
+  return res;
+}
+
+// Matches a case-sensitive keyword at 'pos'.
+bool matches(const char* pos, const char* end, const char* keyword) {
+  const std::size_t length = std::strlen(keyword);
+  return static_cast<std::size_t>(end - pos) >= length &&
+         std::memcmp(pos, keyword, length) == 0;
+}
+}  // namespace
+
+ParseStatus TextParser::Parse(const char* begin, const char* end,
+                              double* res) {
+  const char* pos = begin;
+  bool negative = false;
+  if (pos != end && (*pos == '-' || *pos == '+')) {
+    negative = *pos == '-';
+    ++pos;
+  }
+  if (matches(pos, end, "inf")) {
+    *res = negative ? -std::numeric_limits<double>::infinity()
+                    : std::numeric_limits<double>::infinity();
+    return success(pos + 3 - begin);
+  }
+  if (matches(pos, end, "nan")) {
+    *res = std::numeric_limits<double>::quiet_NaN();
+    return success(pos + 3 - begin);
+  }
+
+  // Digits are accumulated in an integer mantissa and a decimal exponent.
+  std::uint64_t mantissa = 0;
+  int mantissa_digits = 0;
+  int exponent = 0;
+  bool truncated = false;
+  bool any_digit = false;
+  for (; pos != end && isDigit(*pos); ++pos) {
+    any_digit = true;
+    if (mantissa_digits < kMaxMantissaDigits) {
+      mantissa = 10 * mantissa + (*pos - '0');
+      mantissa_digits += mantissa != 0 ? 1 : 0;
+    } else {
+      ++exponent;
+      truncated = truncated || *pos != '0';
+    }
+  }
+  if (pos != end && *pos == '.') {
+    ++pos;
+    for (; pos != end && isDigit(*pos); ++pos) {
+      any_digit = true;
+      if (mantissa_digits < kMaxMantissaDigits) {
+        mantissa = 10 * mantissa + (*pos - '0');
+        mantissa_digits += mantissa != 0 ? 1 : 0;
+        --exponent;
+      } else {
+        truncated = truncated || *pos != '0';
+      }
+    }
+  }
+  if (!any_digit) {
+    return failure(pos - begin, "Expected a number.");
+  }
+  if (pos != end && (*pos == 'e' || *pos == 'E')) {
+    ++pos;
+    bool negative_exponent = false;
+    if (pos != end && (*pos == '-' || *pos == '+')) {
+      negative_exponent = *pos == '-';
+      ++pos;
+    }
+    if (pos == end || !isDigit(*pos)) {
+      return failure(pos - begin, "Expected an exponent.");
+    }
+    int explicit_exponent = 0;
+    for (; pos != end && isDigit(*pos); ++pos) {
+      // Saturates: anything this large overflows or underflows anyway.
+      if (explicit_exponent < 100000) {
+        explicit_exponent = 10 * explicit_exponent + (*pos - '0');
+      }
+    }
+    exponent += negative_exponent ? -explicit_exponent : explicit_exponent;
+  }
+  const std::size_t length = pos - begin;
+
+  // Exact mantissas and powers of ten give a correctly rounded product or
+  // quotient (Clinger's fast path).
+  if (!truncated && mantissa <= (1ull << 53) && exponent >= -22 &&
+      exponent <= 22) {
+    double value = static_cast<double>(mantissa);
+    value = exponent < 0 ? value / kExactPowersOf10[-exponent]
+                         : value * kExactPowersOf10[exponent];
+    *res = negative ? -value : value;
+    return success(length);
+  }
+  if (mantissa == 0 && !truncated) {
+    *res = negative ? -0. : 0.;
+    return success(length);
+  }
+  if (length >= kMaxNumberLength) {
+    return failure(0, "Number is too long.");
+  }
+  char number[kMaxNumberLength];
+  std::memcpy(number, begin, length);
+  number[length] = '\0';
+  char* number_end = nullptr;
+  const double value = StrtodC(number, &number_end);
+  if (number_end != number + length) {
+    return failure(number_end - number, "Expected a number.");
+  }
+  *res = value;
+  return success(length);
+}
+
+ParseStatus TextParser::Parse(const char* begin, const char* end,
+                              Vector3* res) {
+  Vector3 vector;
+  Cursor cursor(begin, end);
+  cursor.vector(&vector);
+  if (cursor.ok()) {
+    *res = vector;
+  }
+  return cursor.status();
+}
+
+ParseStatus TextParser::Parse(const char* begin, const char* end,
+                              Matrix3* res) {
+  Matrix3 matrix;
+  Cursor cursor(begin, end);
+  cursor.matrix(&matrix);
+  if (cursor.ok()) {
+    *res = matrix;
+  }
+  return cursor.status();
+}
+
+ParseStatus TextParser::Parse(const char* begin, const char* end,
+                              Isometry* res) {
+  Vector3 translation;
+  Matrix3 rotation;
+  Cursor cursor(begin, end);
+  cursor.expect("[T: ");
+  cursor.vector(&translation);
+  cursor.expect(", R:");
+  cursor.matrix(&rotation);
+  cursor.expect("]");
+  if (cursor.ok()) {
+    *res = Isometry(translation, rotation);
+  }
+  return cursor.status();
+}
+
+void TextParser::throwError(const ParseStatus& status, std::size_t line) {
+  std::string message = status.message;
+  if (line > 0) {
+    message += " Line " + std::to_string(line) + ",";
+  }
+  message += " offset " + std::to_string(status.offset) + ".";
+  throw std::invalid_argument(message);
+}
+
+LineReader::LineReader(std::istream* is, std::size_t buffer_size)
+    : is_(is),
+      buffer_(buffer_size > 0 ? buffer_size : 1),
+      begin_(0),
+      end_(0),
+      line_number_(0),
+      eof_(false) {
+  if (is == nullptr) {
+    throw std::invalid_argument("Null input stream.");
+  }
+}
+
+bool LineReader::Next(const char** begin, const char** end) {
+  std::size_t searched = begin_;
+  for (;;) {
+    const char* data = buffer_.data();
+    const void* newline = std::memchr(data + searched, '\n', end_ - searched);
+    if (newline != nullptr || (eof_ && begin_ != end_)) {
+      const char* line_end =
+          newline != nullptr ? static_cast<const char*>(newline) : data + end_;
+      *begin = data + begin_;
+      *end = line_end;
+      begin_ = newline != nullptr ? line_end - data + 1 : end_;
+      if (*end != *begin && *(*end - 1) == '\r') {
+        --*end;
+      }
+      ++line_number_;
+      return true;
+    }
+    if (eof_) {
+      return false;
+    }
+    searched = end_ - begin_;
+    refill();
+  }
+}
+
+std::size_t LineReader::lineNumber() const { return line_number_; }
+
+void LineReader::refill() {
+  const std::size_t pending = end_ - begin_;
+  if (begin_ > 0) {
+    std::memmove(buffer_.data(), buffer_.data() + begin_, pending);
+    begin_ = 0;
+    end_ = pending;
+  }
+  if (end_ == buffer_.size()) {
+    buffer_.resize(2 * buffer_.size());
+  }
+  is_->read(buffer_.data() + end_, buffer_.size() - end_);
+  const std::size_t read = static_cast<std::size_t>(is_->gcount());
+  end_ += read;
+  if (is_->bad()) {
+    throw std::runtime_error("Cannot read lines from the stream.");
+  }
+  if (read == 0 && !*is_) {
+    eof_ = true;
+  }
+}
+
+}  // namespace math
+}  // namespace ekumen
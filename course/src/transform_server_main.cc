@@ -0,0 +1,108 @@
+#include <signal.h>
+
+#include <cstdlib>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+#include "transform_service.h"
+
+namespace {
+using ekumen::math::LatencyHistogram;
+using ekumen::math::TransformServer;
+
+// Exit codes.
+constexpr int kSuccess = 0;
+constexpr int kFailure = 1;
+constexpr int kUsageError = 2;
+
+const char kUsage[] =
+    "Usage: transform_server --socket PATH [options]\n"
+    "Serves a transform tree on a Unix domain socket. Clients publish\n"
+    "transforms and query points in other frames with the protocol of\n"
+    "transform_service.h.\n"
+    "\n"
+    "  --socket PATH            Socket file, replaced when it exists.\n"
+    "  --cache-seconds SECONDS  History kept per frame (default 10).\n"
+    "  -h, --help               Prints this help.\n"
+    "\n"
+    "SIGUSR1 prints the latency histogram to stderr, and SIGINT and SIGTERM\n"
+    "print it and stop the server.\n";
+
+void printLatency(const LatencyHistogram& latency) {
+  std::cerr << "requests: " << latency.count() << "\n"
+            << "p50 seconds: " << latency.quantile(0.5) << "\n"
+            << "p99 seconds: " << latency.quantile(0.99) << "\n"
+            << "p99.9 seconds: " << latency.quantile(0.999) << "\n";
+  for (int i = 0; i < LatencyHistogram::kNumBuckets; ++i) {
+    if (latency.bucketCount(i) != 0) {
+      std::cerr << "< " << LatencyHistogram::BucketLimit(i)
+                << " seconds: " << latency.bucketCount(i) << "\n";
+    }
+  }
+  std::cerr << std::flush;
+}
+}  // namespace
+
+int main(int argc, char** argv) {
+  std::string path;
+  double cache_seconds = 10.;
+  for (int i = 1; i < argc; ++i) {
+    const std::string flag = argv[i];
+    if (flag == "-h" || flag == "--help") {
+      std::cout << kUsage;
+      return kSuccess;
+    }
+    if (i + 1 >= argc) {
+      std::cerr << "transform_server: Invalid option '" << flag << "'.\n\n"
+                << kUsage;
+      return kUsageError;
+    }
+    const std::string value = argv[++i];
+    if (flag == "--socket") {
+      path = value;
+    } else if (flag == "--cache-seconds") {
+      char* end = nullptr;
+      cache_seconds = std::strtod(value.c_str(), &end);
+      if (value.empty() || *end != '\0' || !(cache_seconds > 0.)) {
+        std::cerr << "transform_server: --cache-seconds must be a positive "
+                     "number.\n\n"
+                  << kUsage;
+        return kUsageError;
+      }
+    } else {
+      std::cerr << "transform_server: Unknown option '" << flag << "'.\n\n"
+                << kUsage;
+      return kUsageError;
+    }
+  }
+  if (path.empty()) {
+    std::cerr << "transform_server: --socket is required.\n\n" << kUsage;
+    return kUsageError;
+  }
+
+  // Signals are blocked before the server thread starts, so that it
+  // inherits the mask and only sigwait() receives them.
+  sigset_t signals;
+  sigemptyset(&signals);
+  sigaddset(&signals, SIGINT);
+  sigaddset(&signals, SIGTERM);
+  sigaddset(&signals, SIGUSR1);
+  pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+
+  try {
+    TransformServer server(path, cache_seconds);
+    for (;;) {
+      int signal = 0;
+      sigwait(&signals, &signal);
+      printLatency(server.latency());
+      if (signal != SIGUSR1) {
+        break;
+      }
+    }
+  } catch (const std::exception& e) {
+    std::cerr << "transform_server: " << e.what() << std::endl;
+    return kFailure;
+  }
+  return kSuccess;
+}
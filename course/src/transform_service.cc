@@ -0,0 +1,762 @@
+#include "transform_service.h"
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include "binary_io.h"
+#include "isometry.h"
+#include "vector3.h"
+
+namespace ekumen {
+namespace math {
+namespace {
+constexpr int kPoseScalars = BinaryTraits<Isometry>::kScalars;
+
+// Bytes requested from the socket per read.
+constexpr std::size_t kReadSize = 64 << 10;
+
+// Pause after errors that would make poll() return again at once, such as
+// accepting without file descriptors left.
+constexpr std::chrono::milliseconds kErrorBackoff(100);
+
+typedef std::chrono::steady_clock Clock;
+
+// Malformed message.
+class BadRequest : public std::runtime_error {
+ public:
+  explicit BadRequest(const std::string& message)
+      : std::runtime_error(message) {}
+};
+
+std::runtime_error systemError(const std::string& message) {
+  return std::runtime_error(message + ": " + std::strerror(errno));
+}
+
+template <typename T>
+void append(const T& value, std::vector<char>* out) {
+  const char* bytes = reinterpret_cast<const char*>(&value);
+  out->insert(out->end(), bytes, bytes + sizeof(T));
+}
+
+void appendString(const std::string& value, std::vector<char>* out) {
+  append(static_cast<std::uint32_t>(value.size()), out);
+  out->insert(out->end(), value.begin(), value.end());
+}
+
+void appendPose(const Isometry& pose, std::vector<char>* out) {
+  double values[kPoseScalars];
+  BinaryTraits<Isometry>::Write(pose, values);
+  for (double value : values) {
+    append(value, out);
+  }
+}
+
+// Appends the size of a message, patched by endMessage() once the payload
+// follows. Returns its offset.
+std::size_t beginMessage(std::vector<char>* out) {
+  const std::size_t res = out->size();
+  append(std::uint32_t{0}, out);
+  return res;
+}
+
+void endMessage(std::size_t begin, std::vector<char>* out) {
+  const std::uint32_t size =
+      static_cast<std::uint32_t>(out->size() - begin - sizeof(size));
+  std::memcpy(out->data() + begin, &size, sizeof(size));
+}
+
+// Decodes a payload, throwing BadRequest when it is too short.
+class PayloadReader {
+ public:
+  PayloadReader(const char* data, std::size_t size)
+      : data_(data), remaining_(size) {}
+
+  template <typename T>
+  T read() {
+    T res;
+    std::memcpy(&res, bytes(sizeof(T)), sizeof(T));
+    return res;
+  }
+
+  std::string readString() {
+    const std::uint32_t size = read<std::uint32_t>();
+    return std::string(bytes(size), size);
+  }
+
+  Isometry readPose() {
+    double values[kPoseScalars];
+    std::memcpy(values, bytes(sizeof(values)), sizeof(values));
+    return BinaryTraits<Isometry>::Read(values);
+  }
+
+  const char* bytes(std::size_t size) {
+    if (size > remaining_) {
+      throw BadRequest("Truncated message.");
+    }
+    const char* res = data_;
+    data_ += size;
+    remaining_ -= size;
+    return res;
+  }
+
+  std::size_t remaining() const { return remaining_; }
+
+ private:
+  const char* data_;
+  std::size_t remaining_;
+};
+
+void appendTransformRequest(const std::string& parent,
+                            const std::string& child, bool is_static,
+                            double time, const Isometry& pose,
+                            std::vector<char>* out) {
+  const std::size_t begin = beginMessage(out);
+  append(TransformRequest::kSetTransform, out);
+  appendString(parent, out);
+  appendString(child, out);
+  append(static_cast<std::uint32_t>(is_static), out);
+  append(time, out);
+  appendPose(pose, out);
+  endMessage(begin, out);
+}
+
+void appendPointsRequest(const std::string& target, const std::string& source,
+                         double time, const std::vector<Vector3>& points,
+                         std::vector<char>* out) {
+  const std::size_t begin = beginMessage(out);
+  append(TransformRequest::kTransformPoints, out);
+  appendString(target, out);
+  appendString(source, out);
+  append(time, out);
+  append(static_cast<std::uint64_t>(points.size()), out);
+  std::size_t offset = out->size();
+  out->resize(offset + 3 * sizeof(double) * points.size());
+  for (const Vector3& point : points) {
+    const double values[3] = {point.x(), point.y(), point.z()};
+    std::memcpy(out->data() + offset, values, sizeof(values));
+    offset += sizeof(values);
+  }
+  endMessage(begin, out);
+}
+
+// Throws the exception of a failed reply.
+void throwStatus(TransformStatus status, const std::vector<char>& payload) {
+  std::string message;
+  try {
+    PayloadReader reader(payload.data(), payload.size());
+    message = reader.readString();
+  } catch (const BadRequest&) {
+    message = "Malformed error reply.";
+  }
+  switch (status) {
+    case TransformStatus::kOutOfRange:
+      throw std::out_of_range(message);
+    case TransformStatus::kInvalidArgument:
+      throw std::invalid_argument(message);
+    default:
+      throw std::runtime_error(message);
+  }
+}
+
+std::vector<Vector3> readPoints(const std::vector<char>& payload) {
+  PayloadReader reader(payload.data(), payload.size());
+  const std::uint64_t count = reader.read<std::uint64_t>();
+  if (count != reader.remaining() / (3 * sizeof(double)) ||
+      reader.remaining() % (3 * sizeof(double)) != 0) {
+    throw std::runtime_error("Malformed points reply.");
+  }
+  std::vector<Vector3> res(static_cast<std::size_t>(count));
+  for (Vector3& point : res) {
+    double values[3];
+    std::memcpy(values, reader.bytes(sizeof(values)), sizeof(values));
+    point = Vector3(values[0], values[1], values[2]);
+  }
+  return res;
+}
+
+void closeFd(int fd) {
+  if (fd >= 0) {
+    ::close(fd);
+  }
+}
+
+// Bytes of requests the server holds for a connection before it stops
+// reading from it: kReadSize, or the whole first request when larger, so
+// that a client which does not read its replies cannot make it buffer more.
+std::size_t inputLimit(const std::vector<char>& input) {
+  std::uint32_t size = 0;
+  if (input.size() >= sizeof(size)) {
+    std::memcpy(&size, input.data(), sizeof(size));
+  }
+  return std::max(kReadSize, sizeof(size) + size);
+}
+
+// Reads what the socket holds into 'input' up to inputLimit(), and sets
+// 'shut_down' when the client shut down its writes. Returns false when the
+// connection failed or the first request is larger than kMaxPayloadSize,
+// which is checked as soon as its size arrives.
+bool receiveRequests(int fd, std::vector<char>* input, bool* shut_down) {
+  for (;;) {
+    const std::size_t limit = inputLimit(*input);
+    if (limit > sizeof(std::uint32_t) + TransformServer::kMaxPayloadSize) {
+      return false;
+    }
+    const std::size_t size = input->size();
+    if (size >= limit) {
+      return true;
+    }
+    const std::size_t wanted = std::min(kReadSize, limit - size);
+    input->resize(size + wanted);
+    const ssize_t count = ::recv(fd, input->data() + size, wanted, 0);
+    input->resize(count > 0 ? size + static_cast<std::size_t>(count) : size);
+    if (count == 0) {
+      *shut_down = true;
+      return true;
+    }
+    if (count < 0) {
+      return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+    }
+  }
+}
+
+// Sends what the socket takes of 'output' from 'sent' on. Returns false
+// when the connection failed.
+bool sendReplies(int fd, const std::vector<char>& output, std::size_t* sent) {
+  while (*sent < output.size()) {
+    const ssize_t count = ::send(fd, output.data() + *sent,
+                                 output.size() - *sent, MSG_NOSIGNAL);
+    if (count < 0) {
+      return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+    }
+    *sent += static_cast<std::size_t>(count);
+  }
+  return true;
+}
+}  // namespace
+
+const int LatencyHistogram::kNumBuckets;
+
+LatencyHistogram::LatencyHistogram() {
+  std::fill(buckets_, buckets_ + kNumBuckets, 0);
+}
+
+void LatencyHistogram::record(double seconds) {
+  const double nanoseconds = seconds * 1e9;
+  int bucket = 0;
+  if (nanoseconds >= 2.) {
+    bucket = std::min(std::ilogb(nanoseconds), kNumBuckets - 1);
+  }
+  ++buckets_[bucket];
+}
+
+std::uint64_t LatencyHistogram::count() const {
+  std::uint64_t res = 0;
+  for (std::uint64_t bucket : buckets_) {
+    res += bucket;
+  }
+  return res;
+}
+
+std::uint64_t LatencyHistogram::bucketCount(int bucket) const {
+  if (bucket < 0 || bucket >= kNumBuckets) {
+    throw std::out_of_range("Index to access a bucket is out of range.");
+  }
+  return buckets_[bucket];
+}
+
+double LatencyHistogram::BucketLimit(int bucket) {
+  if (bucket < 0 || bucket >= kNumBuckets) {
+    throw std::out_of_range("Index to access a bucket is out of range.");
+  }
+  if (bucket == kNumBuckets - 1) {
+    return std::numeric_limits<double>::infinity();
+  }
+  return std::ldexp(1e-9, bucket + 1);
+}
+
+double LatencyHistogram::quantile(double q) const {
+  const std::uint64_t total = count();
+  if (total == 0) {
+    return 0.;
+  }
+  const double rank = std::ceil(q * static_cast<double>(total));
+  std::uint64_t cumulative = 0;
+  for (int i = 0; i < kNumBuckets; ++i) {
+    cumulative += buckets_[i];
+    if (cumulative > 0 && static_cast<double>(cumulative) >= rank) {
+      return BucketLimit(i);
+    }
+  }
+  return BucketLimit(kNumBuckets - 1);
+}
+
+const std::uint32_t TransformServer::kMaxPayloadSize;
+
+struct TransformServer::Connection {
+  int fd;
+  // Bytes received and not handled yet.
+  std::vector<char> input;
+  // Replies not sent yet, from 'sent' on.
+  std::vector<char> output;
+  std::size_t sent;
+  // Whether the client shut down its writes.
+  bool shut_down;
+};
+
+TransformServer::TransformServer(const std::string& path,
+                                 double cache_seconds)
+    : path_(path), listen_fd_(-1), tree_(cache_seconds) {
+  sockaddr_un address;
+  std::memset(&address, 0, sizeof(address));
+  address.sun_family = AF_UNIX;
+  if (path.empty() || path.size() >= sizeof(address.sun_path)) {
+    throw std::invalid_argument("Invalid socket path '" + path + "'.");
+  }
+  std::memcpy(address.sun_path, path.data(), path.size());
+
+  if (::pipe2(wake_fds_, O_CLOEXEC) != 0) {
+    throw systemError("Cannot create a pipe");
+  }
+  listen_fd_ = ::socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+  ::unlink(path.c_str());
+  if (listen_fd_ < 0 ||
+      ::bind(listen_fd_, reinterpret_cast<const sockaddr*>(&address),
+             sizeof(address)) != 0 ||
+      ::listen(listen_fd_, SOMAXCONN) != 0) {
+    const std::runtime_error error =
+        systemError("Cannot listen on '" + path + "'");
+    closeFd(listen_fd_);
+    closeFd(wake_fds_[0]);
+    closeFd(wake_fds_[1]);
+    throw error;
+  }
+  thread_ = std::thread(&TransformServer::serve, this);
+}
+
+TransformServer::~TransformServer() {
+  const char stop = 0;
+  while (::write(wake_fds_[1], &stop, 1) < 0 && errno == EINTR) {
+  }
+  thread_.join();
+  ::close(listen_fd_);
+  ::close(wake_fds_[0]);
+  ::close(wake_fds_[1]);
+  ::unlink(path_.c_str());
+}
+
+void TransformServer::set(const std::string& parent, const std::string& child,
+                          double time, const Isometry& pose) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  tree_.set(parent, child, time, pose);
+}
+
+void TransformServer::setStatic(const std::string& parent,
+                                const std::string& child,
+                                const Isometry& pose) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  tree_.setStatic(parent, child, pose);
+}
+
+LatencyHistogram TransformServer::latency() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return latency_;
+}
+
+void TransformServer::serve() {
+  std::vector<Connection> connections;
+  std::vector<pollfd> fds;
+  // Connections are not accepted until then after accept errors.
+  Clock::time_point accept_resume = Clock::now();
+  for (;;) {
+    int timeout = -1;
+    const Clock::time_point now = Clock::now();
+    const bool accepting = now >= accept_resume;
+    if (!accepting) {
+      timeout = static_cast<int>(
+          std::chrono::duration_cast<std::chrono::milliseconds>(
+              accept_resume - now).count() + 1);
+    }
+    // poll() ignores negative descriptors.
+    fds.assign({pollfd{wake_fds_[0], POLLIN, 0},
+                pollfd{accepting ? listen_fd_ : -1, POLLIN, 0}});
+    for (const Connection& connection : connections) {
+      short events = 0;
+      if (!connection.shut_down &&
+          connection.input.size() < inputLimit(connection.input)) {
+        events |= POLLIN;
+      }
+      if (connection.sent < connection.output.size()) {
+        events |= POLLOUT;
+      }
+      fds.push_back(pollfd{connection.fd, events, 0});
+    }
+    if (::poll(fds.data(), fds.size(), timeout) < 0) {
+      if (errno != EINTR) {
+        std::this_thread::sleep_for(kErrorBackoff);
+      }
+      continue;
+    }
+    if (fds[0].revents != 0) {
+      break;
+    }
+    if (fds[1].revents != 0) {
+      for (;;) {
+        const int fd = ::accept4(listen_fd_, nullptr, nullptr,
+                                 SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) {
+          if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR &&
+              errno != ECONNABORTED) {
+            accept_resume = Clock::now() + kErrorBackoff;
+          }
+          break;
+        }
+        connections.push_back(Connection{fd, {}, {}, 0, false});
+      }
+    }
+
+    // Only the connections polled so far have events.
+    for (std::size_t i = 2; i < fds.size(); ++i) {
+      if (fds[i].revents == 0) {
+        continue;
+      }
+      Connection& connection = connections[i - 2];
+      bool open = connection.shut_down ||
+                  receiveRequests(connection.fd, &connection.input,
+                                  &connection.shut_down);
+      open = open && sendReplies(connection.fd, connection.output,
+                                 &connection.sent);
+      if (open && connection.sent == connection.output.size()) {
+        // Handles all complete requests, whose replies go out at once.
+        open = handleRequests(&connection) &&
+               sendReplies(connection.fd, connection.output, &connection.sent);
+      }
+      // Requests still held are handled once the replies before them are
+      // sent, and only then the connection of a client which shut down its
+      // writes closes.
+      if (connection.shut_down &&
+          connection.sent == connection.output.size()) {
+        open = false;
+      }
+      if (!open) {
+        ::close(connection.fd);
+        connection.fd = -1;
+      }
+    }
+    connections.erase(
+        std::remove_if(connections.begin(), connections.end(),
+                       [](const Connection& c) { return c.fd < 0; }),
+        connections.end());
+  }
+
+  for (const Connection& connection : connections) {
+    ::close(connection.fd);
+  }
+}
+
+bool TransformServer::handleRequests(Connection* connection) {
+  std::vector<char>& input = connection->input;
+  const Clock::time_point received = Clock::now();
+  connection->output.clear();
+  connection->sent = 0;
+  std::size_t begin = 0;
+  std::vector<double> latencies;
+  bool res = true;
+  while (input.size() - begin >= sizeof(std::uint32_t)) {
+    std::uint32_t size;
+    std::memcpy(&size, input.data() + begin, sizeof(size));
+    if (size > kMaxPayloadSize) {
+      res = false;
+      break;
+    }
+    if (input.size() - begin - sizeof(size) < size) {
+      break;
+    }
+    handle(input.data() + begin + sizeof(size), size, &connection->output);
+    begin += sizeof(size) + size;
+    latencies.push_back(
+        std::chrono::duration<double>(Clock::now() - received).count());
+  }
+  input.erase(input.begin(), input.begin() + begin);
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (double latency : latencies) {
+    latency_.record(latency);
+  }
+  return res;
+}
+
+void TransformServer::handle(const char* payload, std::size_t size,
+                             std::vector<char>* reply) {
+  const std::size_t begin = beginMessage(reply);
+  append(TransformStatus::kOk, reply);
+  TransformStatus status = TransformStatus::kOk;
+  std::string message;
+  try {
+    PayloadReader reader(payload, size);
+    switch (static_cast<TransformRequest>(reader.read<std::uint32_t>())) {
+      case TransformRequest::kTransformPoints: {
+        const std::string target = reader.readString();
+        const std::string source = reader.readString();
+        const double time = reader.read<double>();
+        const std::uint64_t count = reader.read<std::uint64_t>();
+        const std::size_t point_size = 3 * sizeof(double);
+        if (count != reader.remaining() / point_size ||
+            reader.remaining() % point_size != 0) {
+          throw BadRequest("The point count does not match the payload.");
+        }
+        Isometry pose;
+        {
+          std::lock_guard<std::mutex> lock(mutex_);
+          pose = tree_.lookup(target, source, time);
+        }
+        double coefficients[kPoseScalars];
+        BinaryTraits<Isometry>::Write(pose, coefficients);
+        const double* t = coefficients;
+        const double* r = coefficients + 3;
+        append(count, reply);
+        std::size_t out = reply->size();
+        reply->resize(out + reader.remaining());
+        for (std::uint64_t i = 0; i < count; ++i) {
+          double p[3];
+          std::memcpy(p, reader.bytes(point_size), point_size);
+          const double q[3] = {
+              r[0] * p[0] + r[1] * p[1] + r[2] * p[2] + t[0],
+              r[3] * p[0] + r[4] * p[1] + r[5] * p[2] + t[1],
+              r[6] * p[0] + r[7] * p[1] + r[8] * p[2] + t[2],
+          };
+          std::memcpy(reply->data() + out, q, point_size);
+          out += point_size;
+        }
+        break;
+      }
+      case TransformRequest::kSetTransform: {
+        const std::string parent = reader.readString();
+        const std::string child = reader.readString();
+        const bool is_static = reader.read<std::uint32_t>() != 0;
+        const double time = reader.read<double>();
+        const Isometry pose = reader.readPose();
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (is_static) {
+          tree_.setStatic(parent, child, pose);
+        } else {
+          tree_.set(parent, child, time, pose);
+        }
+        break;
+      }
+      case TransformRequest::kLatency: {
+        const LatencyHistogram histogram = latency();
+        for (int i = 0; i < LatencyHistogram::kNumBuckets; ++i) {
+          append(histogram.bucketCount(i), reply);
+        }
+        break;
+      }
+      default:
+        throw BadRequest("Unknown request type.");
+    }
+    if (reader.remaining() != 0) {
+      throw BadRequest("Unexpected bytes at the end of the request.");
+    }
+  } catch (const BadRequest& e) {
+    status = TransformStatus::kBadRequest;
+    message = e.what();
+  } catch (const std::out_of_range& e) {
+    status = TransformStatus::kOutOfRange;
+    message = e.what();
+  } catch (const std::invalid_argument& e) {
+    status = TransformStatus::kInvalidArgument;
+    message = e.what();
+  }
+  if (status != TransformStatus::kOk) {
+    reply->resize(begin + sizeof(std::uint32_t));
+    append(status, reply);
+    appendString(message, reply);
+  }
+  endMessage(begin, reply);
+}
+
+TransformClient::TransformClient(const std::string& path) : fd_(-1) {
+  sockaddr_un address;
+  std::memset(&address, 0, sizeof(address));
+  address.sun_family = AF_UNIX;
+  if (path.empty() || path.size() >= sizeof(address.sun_path)) {
+    throw std::runtime_error("Invalid socket path '" + path + "'.");
+  }
+  std::memcpy(address.sun_path, path.data(), path.size());
+  fd_ = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if (fd_ < 0 ||
+      ::connect(fd_, reinterpret_cast<const sockaddr*>(&address),
+                sizeof(address)) != 0) {
+    const std::runtime_error error =
+        systemError("Cannot connect to '" + path + "'");
+    closeFd(fd_);
+    throw error;
+  }
+}
+
+TransformClient::~TransformClient() { ::close(fd_); }
+
+std::vector<Vector3> TransformClient::transformPoints(
+    const std::string& target, const std::string& source, double time,
+    const std::vector<Vector3>& points) {
+  std::vector<char> request;
+  appendPointsRequest(target, source, time, points, &request);
+  return readPoints(call(request));
+}
+
+std::vector<std::vector<Vector3>> TransformClient::transformPoints(
+    const std::vector<Query>& queries) {
+  std::vector<char> request;
+  for (const Query& query : queries) {
+    appendPointsRequest(query.target, query.source, query.time, query.points,
+                        &request);
+  }
+  std::vector<std::vector<Vector3>> res;
+  res.reserve(queries.size());
+  TransformStatus first_error = TransformStatus::kOk;
+  std::vector<char> error;
+  std::vector<char> payload;
+  // Replies are read while sending as soon as they arrive, since the server
+  // stops reading requests while its replies are not read. The server has
+  // each reply whole once it starts sending it, so reading one blocks
+  // briefly.
+  std::size_t sent = 0;
+  while (res.size() < queries.size()) {
+    if (sent < request.size()) {
+      pollfd fd{fd_, POLLIN | POLLOUT, 0};
+      if (::poll(&fd, 1, -1) < 0) {
+        if (errno == EINTR) {
+          continue;
+        }
+        throw systemError("Cannot poll the transform server");
+      }
+      if ((fd.revents & POLLIN) == 0) {
+        const ssize_t count =
+            ::send(fd_, request.data() + sent, request.size() - sent,
+                   MSG_NOSIGNAL | MSG_DONTWAIT);
+        if (count < 0) {
+          if (errno == EINTR || errno == EAGAIN || errno == EWOULDBLOCK) {
+            continue;
+          }
+          throw systemError("Cannot send to the transform server");
+        }
+        sent += static_cast<std::size_t>(count);
+        continue;
+      }
+    }
+    const TransformStatus status = receive(&payload);
+    if (status == TransformStatus::kOk) {
+      res.push_back(readPoints(payload));
+    } else {
+      res.emplace_back();
+      if (first_error == TransformStatus::kOk) {
+        first_error = status;
+        error.swap(payload);
+      }
+    }
+  }
+  if (first_error != TransformStatus::kOk) {
+    throwStatus(first_error, error);
+  }
+  return res;
+}
+
+void TransformClient::set(const std::string& parent, const std::string& child,
+                          double time, const Isometry& pose) {
+  std::vector<char> request;
+  appendTransformRequest(parent, child, false, time, pose, &request);
+  call(request);
+}
+
+void TransformClient::setStatic(const std::string& parent,
+                                const std::string& child,
+                                const Isometry& pose) {
+  std::vector<char> request;
+  appendTransformRequest(parent, child, true, 0., pose, &request);
+  call(request);
+}
+
+LatencyHistogram TransformClient::latency() {
+  std::vector<char> request;
+  const std::size_t begin = beginMessage(&request);
+  append(TransformRequest::kLatency, &request);
+  endMessage(begin, &request);
+  const std::vector<char> payload = call(request);
+  if (payload.size() != sizeof(LatencyHistogram::buckets_)) {
+    throw std::runtime_error("Malformed latency reply.");
+  }
+  LatencyHistogram res;
+  std::memcpy(res.buckets_, payload.data(), payload.size());
+  return res;
+}
+
+std::vector<char> TransformClient::call(const std::vector<char>& request) {
+  send(request);
+  std::vector<char> res;
+  const TransformStatus status = receive(&res);
+  if (status != TransformStatus::kOk) {
+    throwStatus(status, res);
+  }
+  return res;
+}
+
+void TransformClient::send(const std::vector<char>& data) {
+  std::size_t sent = 0;
+  while (sent < data.size()) {
+    const ssize_t count =
+        ::send(fd_, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+    if (count < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      throw systemError("Cannot send to the transform server");
+    }
+    sent += static_cast<std::size_t>(count);
+  }
+}
+
+TransformStatus TransformClient::receive(std::vector<char>* payload) {
+  // Reads exactly 'size' bytes.
+  auto read = [this](char* data, std::size_t size) {
+    while (size > 0) {
+      const ssize_t count = ::recv(fd_, data, size, 0);
+      if (count < 0 && errno == EINTR) {
+        continue;
+      }
+      if (count < 0) {
+        throw systemError("Cannot receive from the transform server");
+      }
+      if (count == 0) {
+        throw std::runtime_error("The transform server closed the connection.");
+      }
+      data += count;
+      size -= static_cast<std::size_t>(count);
+    }
+  };
+  std::uint32_t size;
+  read(reinterpret_cast<char*>(&size), sizeof(size));
+  if (size < sizeof(TransformStatus)) {
+    throw std::runtime_error("Malformed reply.");
+  }
+  TransformStatus status;
+  read(reinterpret_cast<char*>(&status), sizeof(status));
+  payload->resize(size - sizeof(status));
+  read(payload->data(), payload->size());
+  return status;
+}
+
+}  // namespace math
+}  // namespace ekumen
@@ -0,0 +1,299 @@
+#include "transform_table.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include "binary_io.h"
+#include "isometry.h"
+
+namespace ekumen {
+namespace math {
+namespace {
+constexpr char kMagic[8] = {'E', 'K', 'M', 'A', 'T', 'F', 'T', 'B'};
+constexpr std::uint32_t kVersion = 1;
+constexpr int kScalars = BinaryTraits<Isometry>::kScalars;
+constexpr std::size_t kNameSize = TransformTableWriter::kMaxNameSize + 1;
+
+// Reads retried this many times in a row yield the processor.
+constexpr unsigned int kSpinsBeforeYield = 64;
+
+// Atomics are shared between processes, which needs them to be lock-free.
+static_assert(ATOMIC_LLONG_LOCK_FREE == 2,
+              "64-bit atomics must be lock-free to be shared.");
+
+// Layout of the shared memory: a header followed by 'capacity' entries, each
+// on its own cache lines so that updates do not slow readers of the others.
+struct alignas(64) Header {
+  char magic[8];
+  // Stored last on creation, so readers never see a partial header.
+  std::atomic<std::uint32_t> version;
+  std::uint32_t entry_size;
+  std::uint64_t capacity;
+  // Number of published entries. Stored after the entry is filled in.
+  std::atomic<std::uint64_t> size;
+};
+
+struct alignas(64) Entry {
+  // Null-terminated name, immutable once published.
+  char name[kNameSize];
+  // Odd while the writer updates the scalars. Half of it counts updates.
+  std::atomic<std::uint64_t> sequence;
+  // Bits of the doubles of the pose, in the BinaryTraits<Isometry> layout.
+  // They are atomics so that reading them during an update is no data race.
+  std::atomic<std::uint64_t> scalars[kScalars];
+};
+
+std::size_t segmentSize(std::size_t capacity) {
+  return sizeof(Header) + capacity * sizeof(Entry);
+}
+
+std::runtime_error systemError(const std::string& message,
+                               const std::string& name) {
+  return std::runtime_error(message + " '" + name + "': " +
+                            std::strerror(errno));
+}
+
+const Header* header(const void* data) {
+  return static_cast<const Header*>(data);
+}
+
+Header* header(void* data) { return static_cast<Header*>(data); }
+
+const Entry* entry(const void* data, std::size_t index) {
+  return reinterpret_cast<const Entry*>(
+             static_cast<const unsigned char*>(data) + sizeof(Header)) +
+         index;
+}
+
+Entry* entry(void* data, std::size_t index) {
+  return reinterpret_cast<Entry*>(static_cast<unsigned char*>(data) +
+                                  sizeof(Header)) +
+         index;
+}
+
+// Updates an entry under its sequence lock.
+void writeEntry(const Isometry& pose, Entry* entry) {
+  double values[kScalars];
+  BinaryTraits<Isometry>::Write(pose, values);
+  const std::uint64_t sequence =
+      entry->sequence.load(std::memory_order_relaxed);
+  entry->sequence.store(sequence + 1, std::memory_order_relaxed);
+  // Orders the odd sequence before the scalars.
+  std::atomic_thread_fence(std::memory_order_release);
+  for (int i = 0; i < kScalars; ++i) {
+    std::uint64_t bits;
+    std::memcpy(&bits, &values[i], sizeof(bits));
+    entry->scalars[i].store(bits, std::memory_order_relaxed);
+  }
+  entry->sequence.store(sequence + 2, std::memory_order_release);
+}
+
+// Copies an entry once no update overlaps the copy, and returns the
+// sequence it had.
+std::uint64_t readEntry(const Entry& entry, Isometry* pose) {
+  double values[kScalars];
+  std::uint64_t sequence;
+  for (unsigned int spins = 1;; ++spins) {
+    sequence = entry.sequence.load(std::memory_order_acquire);
+    if ((sequence & 1) == 0) {
+      for (int i = 0; i < kScalars; ++i) {
+        const std::uint64_t bits =
+            entry.scalars[i].load(std::memory_order_relaxed);
+        std::memcpy(&values[i], &bits, sizeof(bits));
+      }
+      // Orders the scalars before the second sequence load.
+      std::atomic_thread_fence(std::memory_order_acquire);
+      if (entry.sequence.load(std::memory_order_relaxed) == sequence) {
+        break;
+      }
+    }
+    if (spins % kSpinsBeforeYield == 0) {
+      std::this_thread::yield();
+    }
+  }
+  *pose = BinaryTraits<Isometry>::Read(values);
+  return sequence;
+}
+}  // namespace
+
+const std::size_t TransformTableWriter::kMaxNameSize;
+
+TransformTableWriter::TransformTableWriter(const std::string& name,
+                                           std::size_t capacity)
+    : data_(nullptr), size_(segmentSize(capacity)) {
+  if (capacity == 0) {
+    throw std::invalid_argument("The table capacity must be positive.");
+  }
+  // Readers of a previous table keep it, and new readers find this one.
+  Unlink(name);
+  const int fd =
+      ::shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, 0644);
+  if (fd < 0) {
+    throw systemError("Cannot create", name);
+  }
+  if (::ftruncate(fd, static_cast<off_t>(size_)) != 0) {
+    const std::runtime_error error = systemError("Cannot resize", name);
+    ::close(fd);
+    ::shm_unlink(name.c_str());
+    throw error;
+  }
+  void* data =
+      ::mmap(nullptr, size_, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  ::close(fd);
+  if (data == MAP_FAILED) {
+    const std::runtime_error error = systemError("Cannot map", name);
+    ::shm_unlink(name.c_str());
+    throw error;
+  }
+  data_ = data;
+
+  // The memory is zero-filled, the entries only need constructing.
+  Header* table = new (data_) Header;
+  for (std::size_t i = 0; i < capacity; ++i) {
+    new (entry(data_, i)) Entry;
+  }
+  std::memcpy(table->magic, kMagic, sizeof(kMagic));
+  table->entry_size = sizeof(Entry);
+  table->capacity = capacity;
+  table->size.store(0, std::memory_order_relaxed);
+  table->version.store(kVersion, std::memory_order_release);
+}
+
+TransformTableWriter::~TransformTableWriter() { ::munmap(data_, size_); }
+
+void TransformTableWriter::set(const std::string& frame,
+                               const Isometry& pose) {
+  const auto it = indices_.find(frame);
+  if (it != indices_.end()) {
+    writeEntry(pose, entry(data_, it->second));
+    return;
+  }
+
+  if (frame.empty() || frame.size() > kMaxNameSize) {
+    throw std::length_error("Frame names must have 1 to 63 bytes.");
+  }
+  if (indices_.size() == capacity()) {
+    throw std::length_error("The transform table is full.");
+  }
+  const std::size_t index = indices_.size();
+  Entry* added = entry(data_, index);
+  std::memcpy(added->name, frame.data(), frame.size());
+  writeEntry(pose, added);
+  header(data_)->size.store(index + 1, std::memory_order_release);
+  indices_.emplace(frame, index);
+}
+
+std::size_t TransformTableWriter::size() const { return indices_.size(); }
+
+std::size_t TransformTableWriter::capacity() const {
+  return static_cast<std::size_t>(header(data_)->capacity);
+}
+
+void TransformTableWriter::Unlink(const std::string& name) {
+  ::shm_unlink(name.c_str());
+}
+
+TransformTableReader::TransformTableReader(const std::string& name)
+    : data_(nullptr), size_(0), capacity_(0) {
+  const int fd = ::shm_open(name.c_str(), O_RDONLY | O_CLOEXEC, 0);
+  if (fd < 0) {
+    throw systemError("Cannot open", name);
+  }
+  struct stat status;
+  if (::fstat(fd, &status) != 0) {
+    const std::runtime_error error = systemError("Cannot stat", name);
+    ::close(fd);
+    throw error;
+  }
+  size_ = static_cast<std::size_t>(status.st_size);
+  if (size_ < sizeof(Header)) {
+    ::close(fd);
+    throw std::runtime_error("'" + name + "' is not a transform table.");
+  }
+  void* data = ::mmap(nullptr, size_, PROT_READ, MAP_SHARED, fd, 0);
+  ::close(fd);
+  if (data == MAP_FAILED) {
+    throw systemError("Cannot map", name);
+  }
+  data_ = data;
+
+  const Header* table = header(data_);
+  if (table->version.load(std::memory_order_acquire) != kVersion ||
+      std::memcmp(table->magic, kMagic, sizeof(kMagic)) != 0 ||
+      table->entry_size != sizeof(Entry) ||
+      table->capacity > (size_ - sizeof(Header)) / sizeof(Entry)) {
+    ::munmap(data, size_);
+    throw std::runtime_error("'" + name + "' is not a transform table.");
+  }
+  capacity_ = static_cast<std::size_t>(table->capacity);
+}
+
+TransformTableReader::~TransformTableReader() {
+  ::munmap(const_cast<void*>(data_), size_);
+}
+
+std::size_t TransformTableReader::size() const {
+  // A writer that crashed or is corrupt may store any size.
+  return static_cast<std::size_t>(std::min<std::uint64_t>(
+      header(data_)->size.load(std::memory_order_acquire), capacity_));
+}
+
+bool TransformTableReader::find(const std::string& frame,
+                                std::size_t* index) const {
+  if (frame.size() > TransformTableWriter::kMaxNameSize) {
+    return false;
+  }
+  const std::size_t count = size();
+  for (std::size_t i = 0; i < count; ++i) {
+    const char* name = entry(data_, i)->name;
+    if (name[frame.size()] == '\0' &&
+        std::memcmp(name, frame.data(), frame.size()) == 0) {
+      *index = i;
+      return true;
+    }
+  }
+  return false;
+}
+
+std::string TransformTableReader::frameName(std::size_t index) const {
+  assertValidIndex(index);
+  const char* name = entry(data_, index)->name;
+  return std::string(name,
+                     ::strnlen(name, TransformTableWriter::kMaxNameSize));
+}
+
+std::uint64_t TransformTableReader::read(std::size_t index,
+                                         Isometry* pose) const {
+  assertValidIndex(index);
+  return readEntry(*entry(data_, index), pose) / 2;
+}
+
+Isometry TransformTableReader::get(const std::string& frame) const {
+  std::size_t index;
+  if (!find(frame, &index)) {
+    throw std::out_of_range("Unknown frame '" + frame + "'.");
+  }
+  Isometry res;
+  read(index, &res);
+  return res;
+}
+
+void TransformTableReader::assertValidIndex(std::size_t index) const {
+  if (index >= size()) {
+    throw std::out_of_range("Index to access a frame is out of range.");
+  }
+}
+
+}  // namespace math
+}  // namespace ekumen
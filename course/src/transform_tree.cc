@@ -0,0 +1,183 @@
+#include "transform_tree.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "isometry.h"
+#include "lie_group.h"
+#include "matrix3.h"
+#include "vector3.h"
+
+namespace ekumen {
+namespace math {
+namespace {
+void assertValidNames(const std::string& parent, const std::string& child) {
+  if (parent.empty() || child.empty()) {
+    throw std::invalid_argument("Frame names must not be empty.");
+  }
+  if (parent == child) {
+    throw std::invalid_argument("Frame '" + child +
+                                "' cannot be its own parent.");
+  }
+}
+}  // namespace
+
+TransformTree::TransformTree(double cache_seconds)
+    : cache_seconds_(cache_seconds) {
+  if (!(cache_seconds > 0.)) {
+    throw std::invalid_argument("The cache duration must be positive.");
+  }
+}
+
+void TransformTree::set(const std::string& parent, const std::string& child,
+                        double time, const Isometry& pose) {
+  if (!std::isfinite(time)) {
+    throw std::invalid_argument("Transform times must be finite.");
+  }
+  Frame* frame = link(parent, child);
+  if (frame->is_static) {
+    throw std::invalid_argument("Frame '" + child +
+                                "' has a static transform.");
+  }
+
+  std::deque<Sample>& samples = frame->samples;
+  if (samples.empty() || samples.back().time < time) {
+    samples.push_back(Sample{time, pose});
+  } else {
+    const auto it = std::lower_bound(
+        samples.begin(), samples.end(), time,
+        [](const Sample& sample, double t) { return sample.time < t; });
+    if (it->time == time) {
+      it->pose = pose;
+    } else {
+      samples.insert(it, Sample{time, pose});
+    }
+  }
+  while (samples.front().time < samples.back().time - cache_seconds_) {
+    samples.pop_front();
+  }
+}
+
+void TransformTree::setStatic(const std::string& parent,
+                              const std::string& child,
+                              const Isometry& pose) {
+  Frame* frame = link(parent, child);
+  if (!frame->samples.empty() && !frame->is_static) {
+    throw std::invalid_argument("Frame '" + child +
+                                "' has a time-stamped transform.");
+  }
+  frame->is_static = true;
+  frame->samples.assign(1, Sample{0., pose});
+}
+
+bool TransformTree::hasFrame(const std::string& frame) const {
+  return frames_.count(frame) != 0;
+}
+
+Isometry TransformTree::lookup(const std::string& target,
+                               const std::string& source, double time) const {
+  for (const std::string* name : {&target, &source}) {
+    if (!hasFrame(*name)) {
+      throw std::out_of_range("Unknown frame '" + *name + "'.");
+    }
+  }
+
+  // Finds the closest common ancestor first, so that only the links below
+  // it need a pose at 'time'.
+  std::vector<const std::string*> source_path{&source};
+  for (;;) {
+    const std::string& parent = frames_.at(*source_path.back()).parent;
+    if (parent.empty()) {
+      break;
+    }
+    source_path.push_back(&parent);
+  }
+  std::vector<const std::string*> target_path{&target};
+  std::vector<const std::string*>::iterator common;
+  for (;;) {
+    common = std::find_if(
+        source_path.begin(), source_path.end(),
+        [&](const std::string* name) { return *name == *target_path.back(); });
+    if (common != source_path.end()) {
+      break;
+    }
+    const std::string& parent = frames_.at(*target_path.back()).parent;
+    if (parent.empty()) {
+      throw std::out_of_range("Frames '" + target + "' and '" + source +
+                              "' are not connected.");
+    }
+    target_path.push_back(&parent);
+  }
+
+  // Poses of 'source' and 'target' in the common ancestor.
+  Isometry source_pose;
+  for (auto it = source_path.begin(); it != common; ++it) {
+    source_pose = poseAt(**it, frames_.at(**it), time) * source_pose;
+  }
+  Isometry target_pose;
+  for (std::size_t i = 0; i + 1 < target_path.size(); ++i) {
+    const std::string& name = *target_path[i];
+    target_pose = poseAt(name, frames_.at(name), time) * target_pose;
+  }
+  return target_pose.inverse() * source_pose;
+}
+
+TransformTree::Frame* TransformTree::link(const std::string& parent,
+                                          const std::string& child) {
+  assertValidNames(parent, child);
+  const auto it = frames_.find(child);
+  if (it != frames_.end() && !it->second.parent.empty()) {
+    if (it->second.parent != parent) {
+      throw std::invalid_argument("Frame '" + child + "' already has parent '" +
+                                  it->second.parent + "'.");
+    }
+    return &it->second;
+  }
+  // 'child' is a root or a new frame, and becomes a child of 'parent'
+  // unless 'parent' descends from it.
+  for (auto ancestor = frames_.find(parent); ancestor != frames_.end();
+       ancestor = frames_.find(ancestor->second.parent)) {
+    if (ancestor->first == child) {
+      throw std::invalid_argument("Linking '" + child + "' to '" + parent +
+                                  "' would close a loop.");
+    }
+  }
+  const Frame root{std::string(), false, std::deque<Sample>()};
+  frames_.emplace(parent, root);
+  Frame& frame = frames_.emplace(child, root).first->second;
+  frame.parent = parent;
+  return &frame;
+}
+
+Isometry TransformTree::poseAt(const std::string& name, const Frame& frame,
+                               double time) const {
+  const std::deque<Sample>& samples = frame.samples;
+  if (frame.is_static) {
+    return samples.front().pose;
+  }
+  if (!(time >= samples.front().time && time <= samples.back().time)) {
+    throw std::out_of_range("No transform from '" + name + "' to '" +
+                            frame.parent + "' at time " +
+                            std::to_string(time) + ".");
+  }
+  const auto next = std::upper_bound(
+      samples.begin(), samples.end(), time,
+      [](double t, const Sample& sample) { return t < sample.time; });
+  const Sample& before = *(next - 1);
+  if (before.time == time) {
+    return before.pose;
+  }
+  const double alpha = (time - before.time) / (next->time - before.time);
+  const Matrix3& rotation = before.pose.rotation();
+  const Vector3 omega =
+      SO3::Log(rotation.transpose().product(next->pose.rotation()));
+  return Isometry(before.pose.translation() +
+                      alpha * (next->pose.translation() -
+                               before.pose.translation()),
+                  rotation.product(SO3::Exp(alpha * omega)));
+}
+
+}  // namespace math
+}  // namespace ekumen
@@ -0,0 +1,326 @@
+#include "triangle_mesh.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+#include "aabb.h"
+#include "bvh.h"
+#include "isometry.h"
+#include "matrix3.h"
+#include "vector3.h"
+
+namespace ekumen {
+namespace math {
+namespace {
+// Point with inline arithmetic, for the per-triangle tests.
+struct Point3 {
+  Point3 operator+(const Point3& obj) const {
+    return Point3{x + obj.x, y + obj.y, z + obj.z};
+  }
+  Point3 operator-(const Point3& obj) const {
+    return Point3{x - obj.x, y - obj.y, z - obj.z};
+  }
+  Point3 operator*(double scale) const {
+    return Point3{x * scale, y * scale, z * scale};
+  }
+  double dot(const Point3& obj) const {
+    return x * obj.x + y * obj.y + z * obj.z;
+  }
+  Point3 cross(const Point3& obj) const {
+    return Point3{y * obj.z - z * obj.y, z * obj.x - x * obj.z,
+                  x * obj.y - y * obj.x};
+  }
+  Point3 abs() const {
+    return Point3{std::abs(x), std::abs(y), std::abs(z)};
+  }
+
+  double x;
+  double y;
+  double z;
+};
+
+Point3 toPoint(const Vector3& vector) {
+  return Point3{vector.x(), vector.y(), vector.z()};
+}
+
+Point3 loadPoint(const std::vector<double>& coordinates,
+                 std::uint32_t index) {
+  return Point3{coordinates[3 * index], coordinates[3 * index + 1],
+                coordinates[3 * index + 2]};
+}
+
+Vector3 toVector(const Point3& point) {
+  return Vector3(point.x, point.y, point.z);
+}
+
+// Distance along the ray to a double-sided triangle, or a negative value
+// when the ray misses it (Möller-Trumbore).
+double intersect(const Point3& origin, const Point3& direction,
+                 const Point3& a, const Point3& b, const Point3& c) {
+  const Point3 ab = b - a;
+  const Point3 ac = c - a;
+  const Point3 p = direction.cross(ac);
+  const double determinant = ab.dot(p);
+  if (determinant == 0.) {
+    return -1.;
+  }
+  const double inverse = 1. / determinant;
+  const Point3 s = origin - a;
+  const double u = s.dot(p) * inverse;
+  if (u < 0. || u > 1.) {
+    return -1.;
+  }
+  const Point3 q = s.cross(ab);
+  const double v = direction.dot(q) * inverse;
+  if (v < 0. || u + v > 1.) {
+    return -1.;
+  }
+  return ac.dot(q) * inverse;
+}
+
+// Point of a triangle nearest to 'p', from the Voronoi region of 'p'.
+Point3 closestOnTriangle(const Point3& p, const Point3& a, const Point3& b,
+                         const Point3& c) {
+  const Point3 ab = b - a;
+  const Point3 ac = c - a;
+  const Point3 ap = p - a;
+  const double d1 = ab.dot(ap);
+  const double d2 = ac.dot(ap);
+  if (d1 <= 0. && d2 <= 0.) {
+    return a;
+  }
+  const Point3 bp = p - b;
+  const double d3 = ab.dot(bp);
+  const double d4 = ac.dot(bp);
+  if (d3 >= 0. && d4 <= d3) {
+    return b;
+  }
+  const double vc = d1 * d4 - d3 * d2;
+  if (vc <= 0. && d1 >= 0. && d3 <= 0.) {
+    return a + ab * (d1 / (d1 - d3));
+  }
+  const Point3 cp = p - c;
+  const double d5 = ab.dot(cp);
+  const double d6 = ac.dot(cp);
+  if (d6 >= 0. && d5 <= d6) {
+    return c;
+  }
+  const double vb = d5 * d2 - d1 * d6;
+  if (vb <= 0. && d2 >= 0. && d6 <= 0.) {
+    return a + ac * (d2 / (d2 - d6));
+  }
+  const double va = d3 * d6 - d5 * d4;
+  if (va <= 0. && d4 - d3 >= 0. && d5 - d6 >= 0.) {
+    return b + (c - b) * ((d4 - d3) / ((d4 - d3) + (d5 - d6)));
+  }
+  const double scale = 1. / (va + vb + vc);
+  return a + ab * (vb * scale) + ac * (vc * scale);
+}
+
+// Whether the projections of a triangle and of a box with half extents
+// 'half' at the origin onto 'axis' are disjoint.
+bool separates(const Point3& axis, const Point3& a, const Point3& b,
+               const Point3& c, const Point3& half) {
+  const double pa = axis.dot(a);
+  const double pb = axis.dot(b);
+  const double pc = axis.dot(c);
+  const double radius = half.dot(axis.abs());
+  return std::min({pa, pb, pc}) > radius || std::max({pa, pb, pc}) < -radius;
+}
+
+// Separating axis test of a triangle and a box centered at the origin: the
+// box normals, the triangle normal and the nine edge cross products.
+bool overlapsBox(const Point3& a, const Point3& b, const Point3& c,
+                 const Point3& half) {
+  const Point3 kAxes[3] = {Point3{1., 0., 0.}, Point3{0., 1., 0.},
+                           Point3{0., 0., 1.}};
+  const Point3 edges[3] = {b - a, c - b, a - c};
+  for (const Point3& axis : kAxes) {
+    if (separates(axis, a, b, c, half)) {
+      return false;
+    }
+  }
+  if (separates(edges[0].cross(edges[1]), a, b, c, half)) {
+    return false;
+  }
+  for (const Point3& axis : kAxes) {
+    for (const Point3& edge : edges) {
+      if (separates(axis.cross(edge), a, b, c, half)) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+}  // namespace
+
+TriangleMesh::TriangleMesh(const std::vector<Vector3>& vertices,
+                           const std::vector<Triangle>& triangles,
+                           int num_threads)
+    : triangles_(triangles) {
+  for (const Triangle& triangle : triangles_) {
+    for (const std::uint32_t vertex : triangle) {
+      if (vertex >= vertices.size()) {
+        throw std::invalid_argument("Triangle vertex out of range.");
+      }
+    }
+  }
+  vertices_.reserve(3 * vertices.size());
+  for (const Vector3& vertex : vertices) {
+    vertices_.push_back(vertex.x());
+    vertices_.push_back(vertex.y());
+    vertices_.push_back(vertex.z());
+  }
+  bvh_ = Bvh(triangleBoxes(), num_threads);
+}
+
+std::size_t TriangleMesh::numVertices() const { return vertices_.size() / 3; }
+
+std::size_t TriangleMesh::numTriangles() const { return triangles_.size(); }
+
+Vector3 TriangleMesh::vertex(std::size_t index) const {
+  return Vector3(vertices_[3 * index], vertices_[3 * index + 1],
+                 vertices_[3 * index + 2]);
+}
+
+const TriangleMesh::Triangle& TriangleMesh::triangle(std::size_t index) const {
+  return triangles_[index];
+}
+
+const Bvh& TriangleMesh::bvh() const { return bvh_; }
+
+void TriangleMesh::setVertices(const std::vector<Vector3>& vertices) {
+  if (vertices.size() != numVertices()) {
+    throw std::invalid_argument("Mesh vertices must keep their number.");
+  }
+  for (std::size_t i = 0; i < vertices.size(); ++i) {
+    vertices_[3 * i] = vertices[i].x();
+    vertices_[3 * i + 1] = vertices[i].y();
+    vertices_[3 * i + 2] = vertices[i].z();
+  }
+  bvh_.refit(triangleBoxes());
+}
+
+bool TriangleMesh::raycast(const Isometry& pose, const Vector3& origin,
+                           const Vector3& direction, double max_distance,
+                           RayHit* hit) const {
+  const double length = direction.norm();
+  if (!(length > 0.)) {
+    throw std::invalid_argument("Ray direction must not be zero.");
+  }
+  // Isometries keep distances, so the ray is cast in the local frame.
+  const Isometry inverse = pose.inverse();
+  const Vector3 local_origin = inverse * origin;
+  const Vector3 local_direction =
+      inverse.rotation().product((1. / length) * direction);
+  const Point3 start = toPoint(local_origin);
+  const Point3 along = toPoint(local_direction);
+  std::size_t nearest = triangles_.size();
+  bvh_.raycast(local_origin, local_direction, max_distance,
+               [&](std::uint32_t index, double* distance) {
+                 const Triangle& triangle = triangles_[index];
+                 const double t = intersect(
+                     start, along, loadPoint(vertices_, triangle[0]),
+                     loadPoint(vertices_, triangle[1]),
+                     loadPoint(vertices_, triangle[2]));
+                 if (t >= 0. && t <= *distance) {
+                   *distance = t;
+                   nearest = index;
+                 }
+               });
+  if (nearest == triangles_.size()) {
+    return false;
+  }
+  const Triangle& triangle = triangles_[nearest];
+  const Point3 a = loadPoint(vertices_, triangle[0]);
+  const Point3 b = loadPoint(vertices_, triangle[1]);
+  const Point3 c = loadPoint(vertices_, triangle[2]);
+  Point3 normal = (b - a).cross(c - a);
+  if (normal.dot(along) > 0.) {
+    normal = normal * -1.;
+  }
+  normal = normal * (1. / std::sqrt(normal.dot(normal)));
+  const double distance = intersect(start, along, a, b, c);
+  hit->distance = distance;
+  hit->triangle = nearest;
+  hit->point = pose * toVector(start + along * distance);
+  hit->normal = pose.rotation().product(toVector(normal));
+  return true;
+}
+
+std::vector<std::size_t> TriangleMesh::overlapping(const Isometry& pose,
+                                                   const Aabb& box) const {
+  std::vector<std::size_t> res;
+  if (box.empty()) {
+    return res;
+  }
+  // Candidates from the box that contains 'box' in the local frame, tested
+  // exactly in the frame of 'box'.
+  const Isometry inverse = pose.inverse();
+  const Isometry to_box =
+      Isometry::FromTranslation(-1. * box.center()).compose(pose);
+  const Point3 half = toPoint(box.halfExtents());
+  bvh_.overlapping(box.transformed(inverse), [&](std::uint32_t index) {
+    const Triangle& triangle = triangles_[index];
+    const Point3 a = toPoint(to_box * vertex(triangle[0]));
+    const Point3 b = toPoint(to_box * vertex(triangle[1]));
+    const Point3 c = toPoint(to_box * vertex(triangle[2]));
+    if (overlapsBox(a, b, c, half)) {
+      res.push_back(index);
+    }
+  });
+  std::sort(res.begin(), res.end());
+  return res;
+}
+
+bool TriangleMesh::closestPoint(const Isometry& pose, const Vector3& point,
+                                double max_distance, MeshPoint* res) const {
+  if (!(max_distance >= 0.)) {
+    return false;
+  }
+  const Point3 query = toPoint(pose.inverse() * point);
+  std::size_t nearest = triangles_.size();
+  Point3 nearest_point{0., 0., 0.};
+  double squared_distance = max_distance * max_distance;
+  bvh_.nearest(toVector(query), squared_distance,
+               [&](std::uint32_t index, double* bound) {
+                 const Triangle& triangle = triangles_[index];
+                 const Point3 candidate = closestOnTriangle(
+                     query, loadPoint(vertices_, triangle[0]),
+                     loadPoint(vertices_, triangle[1]),
+                     loadPoint(vertices_, triangle[2]));
+                 const Point3 gap = candidate - query;
+                 const double distance = gap.dot(gap);
+                 if (distance <= *bound) {
+                   *bound = distance;
+                   squared_distance = distance;
+                   nearest = index;
+                   nearest_point = candidate;
+                 }
+               });
+  if (nearest == triangles_.size()) {
+    return false;
+  }
+  res->distance = std::sqrt(squared_distance);
+  res->triangle = nearest;
+  res->point = pose * toVector(nearest_point);
+  return true;
+}
+
+std::vector<Aabb> TriangleMesh::triangleBoxes() const {
+  std::vector<Aabb> res;
+  res.reserve(triangles_.size());
+  for (const Triangle& triangle : triangles_) {
+    Aabb box;
+    for (const std::uint32_t vertex : triangle) {
+      box.extend(this->vertex(vertex));
+    }
+    res.push_back(box);
+  }
+  return res;
+}
+
+}  // namespace math
+}  // namespace ekumen
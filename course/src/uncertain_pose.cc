@@ -0,0 +1,95 @@
+#include "uncertain_pose.h"
+#include <stdexcept>
+#include <vector>
+#include "isometry.h"
+#include "matrix.h"
+#include "matrix3.h"
+#include "vector3.h"
+
+namespace ekumen {
+namespace math {
+namespace {
+Matrix3d hat(const Vector3& v) {
+  return Matrix3d({0., -v.z(), v.y(), v.z(), 0., -v.x(), -v.y(), v.x(), 0.});
+}
+
+// Computes Ad * cov * Ad^T for Ad = [[R, [t]x * R], [0, R]]. The adjoint
+// factors as the shear [[I, [t]x], [0, I]] times diag(R, R), so every 3x3
+// block is rotated first and the result is then sheared. Only the upper
+// blocks are computed; the lower one is mirrored to keep 'res' symmetric.
+void transformCovariance(const Matrix3d& rotation, const Vector3& translation,
+                         const Matrix6& cov, Matrix6* res) {
+  const Matrix3d rotation_t = rotation.transpose();
+  const Matrix3d a = rotation * cov.block<3, 3>(0, 0) * rotation_t;
+  const Matrix3d b = rotation * cov.block<3, 3>(0, 3) * rotation_t;
+  const Matrix3d d = rotation * cov.block<3, 3>(3, 3) * rotation_t;
+
+  const Matrix3d t = hat(translation);
+  const Matrix3d td = t * d;
+  const Matrix3d tb = t * b.transpose();
+  const Matrix3d top_right = b + td;
+  res->setBlock<3, 3>(0, 0, a + tb + tb.transpose() + td * t.transpose());
+  res->setBlock<3, 3>(0, 3, top_right);
+  res->setBlock<3, 3>(3, 0, top_right.transpose());
+  res->setBlock<3, 3>(3, 3, d);
+}
+
+// Composes 'a' and 'b' into the output pose and covariance.
+void composeInto(const UncertainPose& a, const UncertainPose& b,
+                 Isometry* pose, Matrix6* covariance) {
+  // Ad(B^-1) has rotation R_B^T and translation -R_B^T * t_B.
+  const Matrix3d rotation_t = ToMatrix(b.pose().rotation()).transpose();
+  const Vector3 translation =
+      b.pose().rotation().transpose().product(b.pose().translation()) * (-1.);
+  transformCovariance(rotation_t, translation, a.covariance(), covariance);
+  *covariance += b.covariance();
+  *pose = a.pose() * b.pose();
+}
+}  // namespace
+
+UncertainPose::UncertainPose(const Isometry& pose, const Matrix6& covariance)
+    : pose_(pose), covariance_(covariance) {}
+
+const Isometry& UncertainPose::pose() const { return pose_; }
+const Matrix6& UncertainPose::covariance() const { return covariance_; }
+
+UncertainPose UncertainPose::operator*(const UncertainPose& obj) const {
+  UncertainPose res;
+  composeInto(*this, obj, &res.pose_, &res.covariance_);
+  return res;
+}
+
+std::ostream& operator<<(std::ostream& os, const UncertainPose& obj) {
+  os << "[P: " << obj.pose() << ", C: " << obj.covariance() << "]";
+  return os;
+}
+
+UncertainPose UncertainPose::compose(const UncertainPose& obj) const {
+  return *this * obj;
+}
+
+UncertainPose UncertainPose::inverse() const {
+  UncertainPose res;
+  transformCovariance(ToMatrix(pose_.rotation()), pose_.translation(),
+                      covariance_, &res.covariance_);
+  res.pose_ = pose_.inverse();
+  return res;
+}
+
+void UncertainPose::ComposeTrajectory(const UncertainPose& origin,
+                                      const std::vector<UncertainPose>& steps,
+                                      std::vector<UncertainPose>* res) {
+  if (res == nullptr) {
+    throw std::invalid_argument("Null output trajectory.");
+  }
+  res->resize(steps.size());
+  const UncertainPose* previous = &origin;
+  for (std::size_t i = 0; i < steps.size(); ++i) {
+    UncertainPose& current = (*res)[i];
+    composeInto(*previous, steps[i], &current.pose_, &current.covariance_);
+    previous = &current;
+  }
+}
+
+}  // namespace math
+}  // namespace ekumen
@@ -3,6 +3,7 @@
 #include <iostream>
 #include <stdexcept>
 #include "double_util.h"
+#include "text_format.h"
 
 namespace ekumen {
 namespace math {
@@ -17,43 +18,34 @@ const Vector3 Vector3::kZero = Vector3(0, 0, 0);
 const int Vector3::kComparisonUlps = 5;
 
 Vector3::Vector3(const double& x, const double& y, const double& z)
-    : elem_{new double[kVectorSize]} {
-  elem_[0] = x;
-  elem_[1] = y;
-  elem_[2] = z;
-}
+    : elem_{x, y, z} {}
 
 Vector3::Vector3(const Vector3& obj) : Vector3(obj.x(), obj.y(), obj.z()) {}
 
-Vector3::Vector3(Vector3&& obj) : elem_{obj.elem_} { obj.elem_ = nullptr; }
+Vector3::Vector3(Vector3&& obj) : Vector3(obj.x(), obj.y(), obj.z()) {}
 
 Vector3::Vector3(std::initializer_list<double> vector) {
   if (vector.size() != kVectorSize) {
     throw std::invalid_argument("Invalid vector size.");
   }
-  elem_ = new double[kVectorSize];
   for (auto i = 0; i < kVectorSize; ++i) {
     elem_[i] = vector.begin()[i];
   }
 }
 
-Vector3::~Vector3() { delete[] elem_; }
+Vector3::~Vector3() {}
 
 Vector3& Vector3::operator=(const Vector3& obj) {
   for (auto i = 0; i < kVectorSize; ++i) {
-    elem_[i] = obj[i];
+    elem_[i] = obj.elem_[i];
   }
   return *this;
 }
 
 Vector3& Vector3::operator=(Vector3&& obj) {
-  if (this == &obj) {
-    return *this;
+  for (auto i = 0; i < kVectorSize; ++i) {
+    elem_[i] = obj.elem_[i];
   }
-
-  delete[] elem_;
-  elem_ = obj.elem_;
-  obj.elem_ = nullptr;
   return *this;
 }
 
@@ -104,6 +96,12 @@ double& Vector3::operator[](int index) {
 }
 
 std::ostream& operator<<(std::ostream& os, const Vector3& obj) {
+  if (TextFormat::UsesDefaultFormat(os)) {
+    char buffer[TextFormat::kMaxVector3Size];
+    os.write(buffer, TextFormat::Format(obj, buffer, sizeof(buffer),
+                                        static_cast<int>(os.precision())));
+    return os;
+  }
   os << "(x: " << obj.x() << ", y: " << obj.y() << ", z: " << obj.z() << ")";
   return os;
 }
@@ -113,7 +111,7 @@ double Vector3::norm() const { return std::sqrt(dot(*this)); }
 double Vector3::dot(const Vector3& obj) const {
   double result = 0;
   for (auto i = 0; i < kVectorSize; ++i) {
-    result += elem_[i] * obj[i];
+    result += elem_[i] * obj.elem_[i];
   }
   return result;
 }
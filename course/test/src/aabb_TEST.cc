@@ -0,0 +1,92 @@
+#include "aabb.h"
+#include "isometry.h"
+#include "vector3.h"
+
+#include <cmath>
+#include <random>
+#include <sstream>
+
+#include "gtest/gtest.h"
+
+namespace ekumen {
+namespace math {
+namespace test {
+namespace {
+constexpr double kTolerance{1e-12};
+}  // namespace
+
+GTEST_TEST(AabbTest, ExtendAndMeasure) {
+  Aabb box;
+  EXPECT_TRUE(box.empty());
+  EXPECT_EQ(box.surfaceArea(), 0.);
+  box.extend(Vector3(1., 2., 3.));
+  EXPECT_FALSE(box.empty());
+  EXPECT_EQ(box.surfaceArea(), 0.);
+  box.extend(Vector3(-1., 0., 4.));
+  EXPECT_EQ(box.min, Vector3(-1., 0., 3.));
+  EXPECT_EQ(box.max, Vector3(1., 2., 4.));
+  EXPECT_EQ(box.center(), Vector3(0., 1., 3.5));
+  EXPECT_EQ(box.halfExtents(), Vector3(1., 1., 0.5));
+  EXPECT_NEAR(box.surfaceArea(), 2. * (4. + 2. + 2.), kTolerance);
+
+  Aabb other(Vector3(5., 5., 5.), Vector3(6., 6., 6.));
+  other.extend(Aabb());
+  EXPECT_EQ(other.min, Vector3(5., 5., 5.));
+  other.extend(box);
+  EXPECT_EQ(other.min, Vector3(-1., 0., 3.));
+  EXPECT_EQ(other.max, Vector3(6., 6., 6.));
+
+  std::stringstream ss;
+  ss << Aabb(Vector3::kZero, Vector3(1., 1., 1.));
+  EXPECT_EQ(ss.str(), "[min: (x: 0, y: 0, z: 0), max: (x: 1, y: 1, z: 1)]");
+}
+
+GTEST_TEST(AabbTest, Queries) {
+  const Aabb box(Vector3::kZero, Vector3(1., 1., 1.));
+  EXPECT_TRUE(box.contains(Vector3(0.5, 1., 0.)));
+  EXPECT_FALSE(box.contains(Vector3(0.5, 1.1, 0.)));
+  EXPECT_FALSE(box.contains(Vector3(std::nan(""), 0.5, 0.5)));
+  EXPECT_TRUE(box.overlaps(Aabb(Vector3(1., 1., 1.), Vector3(2., 2., 2.))));
+  EXPECT_FALSE(box.overlaps(Aabb(Vector3(1., 1.5, 1.), Vector3(2., 2., 2.))));
+  EXPECT_FALSE(box.overlaps(Aabb()));
+  EXPECT_EQ(box.squaredDistance(Vector3(0.5, 0.5, 0.5)), 0.);
+  EXPECT_NEAR(box.squaredDistance(Vector3(2., -1., 0.5)), 2., kTolerance);
+}
+
+GTEST_TEST(AabbTest, Transformed) {
+  const Aabb box(Vector3(-1., -2., -3.), Vector3(1., 2., 3.));
+  const Isometry pose = Isometry::FromTranslation(Vector3(1., 2., 3.)) *
+                        Isometry::RotateAround(Vector3::kUnitZ, M_PI / 2.);
+  const Aabb moved = box.transformed(pose);
+  EXPECT_NEAR(moved.min.x(), -1., kTolerance);
+  EXPECT_NEAR(moved.min.y(), 1., kTolerance);
+  EXPECT_NEAR(moved.min.z(), 0., kTolerance);
+  EXPECT_NEAR(moved.max.x(), 3., kTolerance);
+  EXPECT_NEAR(moved.max.y(), 3., kTolerance);
+  EXPECT_NEAR(moved.max.z(), 6., kTolerance);
+  EXPECT_TRUE(Aabb().transformed(pose).empty());
+
+  // The transformed box contains the transformed corners of the box.
+  std::mt19937 generator(7);
+  std::uniform_real_distribution<double> angles(-M_PI, M_PI);
+  for (int i = 0; i < 100; ++i) {
+    const Isometry rotation = Isometry::FromEulerAngles(
+        angles(generator), angles(generator), angles(generator));
+    const Aabb rotated = box.transformed(rotation);
+    for (int corner = 0; corner < 8; ++corner) {
+      const Vector3 point(corner & 1 ? box.max.x() : box.min.x(),
+                          corner & 2 ? box.max.y() : box.min.y(),
+                          corner & 4 ? box.max.z() : box.min.z());
+      EXPECT_LT(rotated.squaredDistance(rotation * point), kTolerance);
+    }
+  }
+}
+
+}  // namespace test
+}  // namespace math
+}  // namespace ekumen
+
+int main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,143 @@
+#include "async_io.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace ekumen {
+namespace math {
+namespace test {
+namespace {
+// Creates an empty temporary file and removes it when going out of scope.
+class TemporaryFile {
+ public:
+  TemporaryFile() {
+    char path[] = "/tmp/async_io_TEST_XXXXXX";
+    fd_ = ::mkstemp(path);
+    if (fd_ < 0) {
+      throw std::runtime_error("Cannot create a temporary file.");
+    }
+    path_ = path;
+  }
+  ~TemporaryFile() {
+    ::close(fd_);
+    std::remove(path_.c_str());
+  }
+
+  int fd() const { return fd_; }
+
+ private:
+  int fd_;
+  std::string path_;
+};
+
+// The backends that work on this system.
+std::vector<AsyncIoBackend> availableBackends() {
+  std::vector<AsyncIoBackend> res{AsyncIoBackend::kThreads};
+  if (AsyncIo::IoUringAvailable()) {
+    res.push_back(AsyncIoBackend::kIoUring);
+  }
+  return res;
+}
+}  // namespace
+
+GTEST_TEST(AsyncIoTest, AlignedBuffer) {
+  AlignedBuffer buffer(10000);
+  EXPECT_EQ(buffer.size(), 10000u);
+  EXPECT_EQ(reinterpret_cast<std::uintptr_t>(buffer.data()) %
+                AlignedBuffer::kAlignment,
+            0u);
+  buffer.data()[9999] = 7;
+
+  AlignedBuffer moved(std::move(buffer));
+  EXPECT_EQ(buffer.data(), nullptr);
+  EXPECT_EQ(buffer.size(), 0u);
+  EXPECT_EQ(moved.data()[9999], 7);
+  buffer = std::move(moved);
+  EXPECT_EQ(buffer.size(), 10000u);
+  EXPECT_EQ(AlignedBuffer().data(), nullptr);
+}
+
+GTEST_TEST(AsyncIoTest, WritesAndReadsBack) {
+  const std::size_t kBlock = 8192;
+  const unsigned int kBlocks = 16;
+  for (AsyncIoBackend backend : availableBackends()) {
+    const TemporaryFile file;
+    AsyncIo io(kBlocks, backend);
+    EXPECT_EQ(io.backend(), backend);
+
+    std::vector<AlignedBuffer> buffers;
+    for (unsigned int i = 0; i < kBlocks; ++i) {
+      buffers.emplace_back(kBlock);
+      std::memset(buffers[i].data(), 'a' + i, kBlock);
+      io.SubmitWrite(file.fd(), buffers[i].data(), kBlock, i * kBlock, i);
+    }
+    EXPECT_EQ(io.pending(), kBlocks);
+    EXPECT_THROW(io.SubmitWrite(file.fd(), buffers[0].data(), 1, 0, 0),
+                 std::length_error);
+    std::vector<bool> seen(kBlocks, false);
+    for (unsigned int i = 0; i < kBlocks; ++i) {
+      const AsyncIoCompletion completion = io.Wait();
+      ASSERT_LT(completion.tag, kBlocks);
+      EXPECT_FALSE(seen[completion.tag]);
+      seen[completion.tag] = true;
+      EXPECT_EQ(completion.result, static_cast<std::int64_t>(kBlock));
+    }
+    EXPECT_EQ(io.pending(), 0u);
+    EXPECT_THROW(io.Wait(), std::logic_error);
+
+    // Reads back in reverse order, past the end of the file for the last.
+    for (unsigned int i = 0; i < kBlocks; ++i) {
+      std::memset(buffers[i].data(), 0, kBlock);
+      io.SubmitRead(file.fd(), buffers[i].data(), kBlock,
+                    (kBlocks - 1 - i) * kBlock + kBlock / 2, i);
+    }
+    for (unsigned int i = 0; i < kBlocks; ++i) {
+      const AsyncIoCompletion completion = io.Wait();
+      const unsigned int block = kBlocks - 1 - completion.tag;
+      const unsigned char* data = buffers[completion.tag].data();
+      if (block == kBlocks - 1) {
+        EXPECT_EQ(completion.result, static_cast<std::int64_t>(kBlock / 2));
+      } else {
+        ASSERT_EQ(completion.result, static_cast<std::int64_t>(kBlock));
+        EXPECT_EQ(data[kBlock - 1], 'a' + block + 1);
+      }
+      EXPECT_EQ(data[0], 'a' + block);
+    }
+  }
+}
+
+GTEST_TEST(AsyncIoTest, Errors) {
+  EXPECT_THROW(AsyncIo(0), std::invalid_argument);
+  for (AsyncIoBackend backend : availableBackends()) {
+    AsyncIo io(1, backend);
+    char byte;
+    io.SubmitRead(-1, &byte, 1, 0, 42);
+    const AsyncIoCompletion completion = io.Wait();
+    EXPECT_EQ(completion.tag, 42u);
+    EXPECT_EQ(completion.result, -EBADF);
+  }
+  if (!AsyncIo::IoUringAvailable()) {
+    EXPECT_THROW(AsyncIo(1, AsyncIoBackend::kIoUring), std::runtime_error);
+  }
+  EXPECT_NE(AsyncIo(1).backend(), AsyncIoBackend::kAuto);
+}
+
+}  // namespace test
+}  // namespace math
+}  // namespace ekumen
+
+int main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
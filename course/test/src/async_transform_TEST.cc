@@ -0,0 +1,158 @@
+#include "async_transform.h"
+#include "async_io.h"
+#include "binary_io.h"
+#include "isometry.h"
+#include "matrix3.h"
+#include "vector3.h"
+
+#include <unistd.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace ekumen {
+namespace math {
+namespace test {
+namespace {
+constexpr double kTolerance{1e-12};
+
+// Creates an empty temporary file and removes it when going out of scope.
+class TemporaryFile {
+ public:
+  TemporaryFile() {
+    char path[] = "/tmp/async_transform_TEST_XXXXXX";
+    const int fd = ::mkstemp(path);
+    if (fd < 0) {
+      throw std::runtime_error("Cannot create a temporary file.");
+    }
+    ::close(fd);
+    path_ = path;
+  }
+  ~TemporaryFile() { std::remove(path_.c_str()); }
+
+  const std::string& path() const { return path_; }
+
+ private:
+  std::string path_;
+};
+
+Isometry makePose() {
+  return Isometry::FromTranslation(Vector3(-1., 0.5, 3.)) *
+         Isometry::RotateAround(Vector3(1., 2., 3.), 1.2);
+}
+
+std::vector<AsyncIoBackend> availableBackends() {
+  std::vector<AsyncIoBackend> res{AsyncIoBackend::kThreads};
+  if (AsyncIo::IoUringAvailable()) {
+    res.push_back(AsyncIoBackend::kIoUring);
+  }
+  return res;
+}
+}  // namespace
+
+GTEST_TEST(AsyncTransformTest, Points) {
+  const Isometry pose = makePose();
+  std::vector<Vector3> points;
+  for (int i = 0; i < 10007; ++i) {
+    points.emplace_back(0.5 * i, -i, 1e-4 * i * i);
+  }
+  const TemporaryFile input;
+  const TemporaryFile output;
+  BinaryWriter::Write(points, input.path());
+
+  for (AsyncIoBackend backend : availableBackends()) {
+    AsyncTransform::Options options;
+    // 1000 points per buffer, so the last chunk is partial.
+    options.buffer_size = 1000 * 24 + 5;
+    options.num_buffers = 3;
+    options.num_threads = 2;
+    options.backend = backend;
+    const BatchTransformStats stats =
+        AsyncTransform::Run(pose, input.path(), output.path(), options);
+    EXPECT_EQ(stats.elements, points.size());
+    EXPECT_EQ(stats.batches, 11u);
+
+    const BinaryFile file(output.path());
+    const BinaryView<Vector3> view = file.view<Vector3>();
+    ASSERT_EQ(view.size(), points.size());
+    for (std::size_t i = 0; i < points.size(); ++i) {
+      const Vector3 expected = pose * points[i];
+      ASSERT_NEAR(view[i].x(), expected.x(), kTolerance * (1 + i));
+      ASSERT_NEAR(view[i].y(), expected.y(), kTolerance * (1 + i));
+      ASSERT_NEAR(view[i].z(), expected.z(), kTolerance * (1 + i));
+    }
+  }
+}
+
+GTEST_TEST(AsyncTransformTest, Poses) {
+  const Isometry pose = makePose();
+  std::vector<Isometry> poses;
+  for (int i = 0; i < 500; ++i) {
+    poses.push_back(Isometry::FromTranslation(Vector3(i, 1., -i)) *
+                    Isometry::RotateAround(Vector3::kUnitY, 0.01 * i));
+  }
+  const TemporaryFile input;
+  const TemporaryFile output;
+  BinaryWriter::Write(poses, input.path());
+
+  AsyncTransform::Options options;
+  options.buffer_size = 4096;
+  AsyncTransform::Run(pose, input.path(), output.path(), options);
+  const BinaryFile file(output.path());
+  const BinaryView<Isometry> view = file.view<Isometry>();
+  ASSERT_EQ(view.size(), poses.size());
+  for (std::size_t i = 0; i < poses.size(); ++i) {
+    EXPECT_EQ(view[i], pose * poses[i]);
+  }
+
+  // Empty arrays only get a header.
+  BinaryWriter::Write(std::vector<Isometry>(), input.path());
+  EXPECT_EQ(AsyncTransform::Run(pose, input.path(), output.path()).elements,
+            0u);
+  EXPECT_TRUE(BinaryFile(output.path()).view<Isometry>().empty());
+}
+
+GTEST_TEST(AsyncTransformTest, Errors) {
+  const TemporaryFile input;
+  const TemporaryFile output;
+  EXPECT_THROW(
+      AsyncTransform::Run(Isometry(), "/nonexistent/input", output.path()),
+      std::runtime_error);
+
+  BinaryWriter::Write(std::vector<Matrix3>{Matrix3::kIdentity}, input.path());
+  EXPECT_THROW(AsyncTransform::Run(Isometry(), input.path(), output.path()),
+               std::runtime_error);
+
+  BinaryWriter::Write(std::vector<Vector3>(10), input.path());
+  {
+    std::ofstream os(input.path(), std::ios::binary | std::ios::app);
+    os.put(0);
+  }
+  EXPECT_THROW(AsyncTransform::Run(Isometry(), input.path(), output.path()),
+               std::runtime_error);
+
+  BinaryWriter::Write(std::vector<Vector3>(10), input.path());
+  EXPECT_THROW(
+      AsyncTransform::Run(Isometry(), input.path(), "/nonexistent/output"),
+      std::runtime_error);
+  AsyncTransform::Options options;
+  options.num_buffers = 0;
+  EXPECT_THROW(
+      AsyncTransform::Run(Isometry(), input.path(), output.path(), options),
+      std::invalid_argument);
+}
+
+}  // namespace test
+}  // namespace math
+}  // namespace ekumen
+
+int main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,103 @@
+#include "autodiff.h"
+#include "isometry.h"
+#include "lie_group.h"
+#include "matrix3.h"
+#include "vector3.h"
+
+#include <cmath>
+
+#include "gtest/gtest.h"
+
+namespace ekumen {
+namespace math {
+namespace test {
+namespace {
+constexpr double kTolerance{1e-10};
+
+// f(x, y) = (x * y, sin(x) + y).
+struct SimpleFunctor {
+  template <typename T>
+  void operator()(const T* x, T* y) const {
+    using std::sin;
+    y[0] = x[0] * x[1];
+    y[1] = sin(x[0]) + x[1];
+  }
+};
+
+const Isometry kPoseA{Vector3(1., -2., 0.5), SO3::Exp(Vector3(0.3, -0.2, 0.9))};
+const Isometry kPoseB{Vector3(-0.4, 0.8, 2.), SO3::Exp(Vector3(-1.1, 0.4, 0.2))};
+}  // namespace
+
+GTEST_TEST(AutoDiffTest, Evaluate) {
+  const double x[2] = {0.5, 2.};
+  double value[2];
+  double jacobian[4];
+  AutoDiff::Evaluate<2, 2>(SimpleFunctor(), x, value, jacobian);
+  EXPECT_NEAR(value[0], 1., kTolerance);
+  EXPECT_NEAR(value[1], std::sin(0.5) + 2., kTolerance);
+  EXPECT_NEAR(jacobian[0], 2., kTolerance);
+  EXPECT_NEAR(jacobian[1], 0.5, kTolerance);
+  EXPECT_NEAR(jacobian[2], std::cos(0.5), kTolerance);
+  EXPECT_NEAR(jacobian[3], 1., kTolerance);
+}
+
+GTEST_TEST(AutoDiffTest, GenericKernelsMatchGeometryTypes) {
+  for (const Vector3& w : {Vector3(0.3, -0.2, 0.9), Vector3(1e-5, 0., 2e-5),
+                           Vector3(0., 0., 3.1)}) {
+    const double omega[3] = {w.x(), w.y(), w.z()};
+    double rotation[9];
+    RotationVectorToMatrix(omega, rotation);
+    const Matrix3 expected = SO3::Exp(w);
+    for (int i = 0; i < 9; ++i) {
+      EXPECT_NEAR(rotation[i], expected[i / 3][i % 3], kTolerance);
+    }
+    double omega_res[3];
+    MatrixToRotationVector(rotation, omega_res);
+    for (int i = 0; i < 3; ++i) {
+      EXPECT_NEAR(omega_res[i], w[i], 1e-9);
+    }
+  }
+}
+
+GTEST_TEST(AutoDiffTest, TransformJacobian) {
+  const Vector3 point(0.7, -1.3, 2.2);
+  const Matrix36 jacobian = AutoDiff::TransformJacobian(kPoseA, point);
+  // Analytic Jacobian: [R, -R * [p]x].
+  Matrix36 expected;
+  expected.setBlock(0, 0, kPoseA.rotation());
+  expected.setBlock(0, 3,
+                    kPoseA.rotation().product(SO3::Hat(point)) * (-1.));
+  for (int i = 0; i < 3; ++i) {
+    for (int j = 0; j < 6; ++j) {
+      EXPECT_NEAR(jacobian(i, j), expected(i, j), kTolerance);
+    }
+  }
+}
+
+GTEST_TEST(AutoDiffTest, ComposeJacobians) {
+  Matrix6 jacobian_a;
+  Matrix6 jacobian_b;
+  AutoDiff::ComposeJacobians(kPoseA, kPoseB, &jacobian_a, &jacobian_b);
+  // Analytic Jacobians: J_a = [Rb^T, -Rb^T * [tb]x; 0, Rb^T], J_b = I.
+  const Matrix3 rb_t = kPoseB.rotation().transpose();
+  Matrix6 expected_a;
+  expected_a.setBlock(0, 0, rb_t);
+  expected_a.setBlock(0, 3,
+                      rb_t.product(SO3::Hat(kPoseB.translation())) * (-1.));
+  expected_a.setBlock(3, 3, rb_t);
+  for (int i = 0; i < 6; ++i) {
+    for (int j = 0; j < 6; ++j) {
+      EXPECT_NEAR(jacobian_a(i, j), expected_a(i, j), kTolerance);
+      EXPECT_NEAR(jacobian_b(i, j), i == j ? 1. : 0., kTolerance);
+    }
+  }
+}
+
+}  // namespace test
+}  // namespace math
+}  // namespace ekumen
+
+int main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
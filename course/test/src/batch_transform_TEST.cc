@@ -0,0 +1,208 @@
+#include "batch_transform.h"
+#include "binary_io.h"
+#include "isometry.h"
+#include "matrix3.h"
+#include "text_format.h"
+#include "text_parser.h"
+#include "vector3.h"
+
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace ekumen {
+namespace math {
+namespace test {
+namespace {
+constexpr double kTolerance{1e-12};
+
+// Not a global constant: it depends on constants of other translation units.
+Isometry makePose() {
+  return Isometry::FromTranslation(Vector3(1., -2., 0.5)) *
+         Isometry::FromEulerAngles(0.1, -0.7, 2.);
+}
+
+std::vector<Vector3> makePoints(std::size_t size) {
+  std::vector<Vector3> res;
+  for (std::size_t i = 0; i < size; ++i) {
+    res.emplace_back(0.25 * i, 3. - i, 1e-3 * i * i);
+  }
+  return res;
+}
+
+// Reads back a binary array from a stream.
+template <typename T>
+std::vector<T> readBinary(std::istream* is) {
+  BinaryReader reader(is);
+  std::vector<T> res(reader.header().count);
+  EXPECT_EQ(reader.Read(res.data(), res.size()), res.size());
+  return res;
+}
+}  // namespace
+
+GTEST_TEST(BatchTransformTest, TextPoints) {
+  const Isometry pose = makePose();
+  const std::vector<Vector3> points = makePoints(1000);
+  std::stringstream input;
+  TextFormat::WriteLines(points, TextFormat::kRoundTrip, &input);
+  // Empty lines are skipped.
+  input << "\n";
+
+  BatchTransform::Options options;
+  options.batch_size = 64;
+  options.num_threads = 3;
+  std::stringstream output;
+  const BatchTransformStats stats =
+      BatchTransform::Run(pose, options, &input, &output);
+  EXPECT_EQ(stats.elements, points.size());
+  EXPECT_EQ(stats.batches, 16u);
+  EXPECT_GE(stats.total_seconds, 0.);
+
+  std::vector<Vector3> res;
+  TextParser::ParseLines(&output, &res);
+  ASSERT_EQ(res.size(), points.size());
+  for (std::size_t i = 0; i < points.size(); ++i) {
+    // Round-trip precision makes the text output exact.
+    const Vector3 expected = pose * points[i];
+    EXPECT_EQ(res[i].x(), expected.x());
+    EXPECT_EQ(res[i].y(), expected.y());
+    EXPECT_EQ(res[i].z(), expected.z());
+  }
+}
+
+GTEST_TEST(BatchTransformTest, BinaryPoses) {
+  const Isometry pose = makePose();
+  std::vector<Isometry> poses;
+  for (int i = 0; i < 100; ++i) {
+    poses.push_back(Isometry::FromTranslation(Vector3(i, 0., -i)) *
+                    Isometry::RotateAround(Vector3(1., i, 2.), 0.01 * i));
+  }
+  std::stringstream input;
+  BinaryWriter::Write(poses, &input);
+
+  BatchTransform::Options options;
+  options.input_format = StreamFormat::kBinary;
+  options.output_format = StreamFormat::kBinary;
+  options.batch_size = 7;
+  std::stringstream output;
+  EXPECT_EQ(BatchTransform::Run(pose, options, &input, &output).elements,
+            poses.size());
+
+  const std::vector<Isometry> res = readBinary<Isometry>(&output);
+  ASSERT_EQ(res.size(), poses.size());
+  for (std::size_t i = 0; i < poses.size(); ++i) {
+    EXPECT_EQ(res[i], pose * poses[i]);
+  }
+}
+
+GTEST_TEST(BatchTransformTest, FormatConversions) {
+  const Isometry pose = makePose();
+  const std::vector<Vector3> points = makePoints(50);
+  BatchTransform::Options options;
+  options.batch_size = 16;
+
+  // Text to binary completes the header once the count is known.
+  std::stringstream text;
+  TextFormat::WriteLines(points, TextFormat::kRoundTrip, &text);
+  options.output_format = StreamFormat::kBinary;
+  std::stringstream binary;
+  BatchTransform::Run(Isometry(), options, &text, &binary);
+  const std::vector<Vector3> res = readBinary<Vector3>(&binary);
+  ASSERT_EQ(res.size(), points.size());
+  for (std::size_t i = 0; i < points.size(); ++i) {
+    EXPECT_EQ(res[i], points[i]);
+  }
+
+  // Binary to text with the identity only changes the encoding.
+  binary.clear();
+  binary.seekg(0);
+  options.input_format = StreamFormat::kBinary;
+  options.output_format = StreamFormat::kText;
+  std::stringstream back;
+  BatchTransform::Run(Isometry(), options, &binary, &back);
+  EXPECT_EQ(back.str(), text.str());
+
+  // Empty input.
+  std::stringstream empty;
+  std::stringstream none;
+  options.input_format = StreamFormat::kText;
+  options.precision = TextFormat::kStreamPrecision;
+  const BatchTransformStats stats =
+      BatchTransform::Run(pose, options, &empty, &none);
+  EXPECT_EQ(stats.elements, 0u);
+  EXPECT_EQ(stats.batches, 0u);
+  EXPECT_TRUE(none.str().empty());
+}
+
+GTEST_TEST(BatchTransformTest, TextPosesWithStreamPrecision) {
+  const Isometry pose = makePose();
+  std::stringstream input;
+  input << Isometry::FromTranslation(Vector3(1., 2., 3.)) << "\n"
+        << Isometry::RotateAround(Vector3::kUnitZ, 0.5) << "\n";
+  BatchTransform::Options options;
+  options.kind = ElementKind::kPose;
+  options.precision = TextFormat::kStreamPrecision;
+  std::stringstream output;
+  BatchTransform::Run(pose, options, &input, &output);
+
+  std::vector<Isometry> res;
+  TextParser::ParseLines(&output, &res);
+  ASSERT_EQ(res.size(), 2u);
+  const Vector3 expected = pose * Vector3(1., 2., 3.);
+  EXPECT_NEAR(res[0].translation().x(), expected.x(), 1e-5);
+  EXPECT_NEAR(res[0].translation().y(), expected.y(), 1e-5);
+  EXPECT_NEAR(res[0].translation().z(), expected.z(), 1e-5);
+  EXPECT_NEAR(res[1].translation().z(), pose.translation().z(), kTolerance);
+}
+
+GTEST_TEST(BatchTransformTest, Errors) {
+  const Isometry pose = makePose();
+  BatchTransform::Options options;
+  options.batch_size = 2;
+  std::stringstream output;
+
+  std::stringstream malformed("(x: 1, y: 2, z: 3)\n\n(x: 1, y: 2 z: 3)\n");
+  try {
+    BatchTransform::Run(pose, options, &malformed, &output);
+    FAIL() << "Malformed input was accepted.";
+  } catch (const std::invalid_argument& e) {
+    EXPECT_NE(std::string(e.what()).find("Line 3, offset 11"),
+              std::string::npos)
+        << e.what();
+  }
+
+  // Binary input must hold points or poses.
+  std::stringstream matrices;
+  BinaryWriter::Write(std::vector<Matrix3>{Matrix3::kIdentity}, &matrices);
+  options.input_format = StreamFormat::kBinary;
+  EXPECT_THROW(BatchTransform::Run(pose, options, &matrices, &output),
+               std::runtime_error);
+
+  std::stringstream truncated;
+  BinaryWriter::Write(makePoints(10), &truncated);
+  const std::string bytes = truncated.str();
+  std::stringstream partial(bytes.substr(0, bytes.size() - 1));
+  EXPECT_THROW(BatchTransform::Run(pose, options, &partial, &output),
+               std::runtime_error);
+
+  std::stringstream input;
+  options.batch_size = 0;
+  EXPECT_THROW(BatchTransform::Run(pose, options, &input, &output),
+               std::invalid_argument);
+  options.batch_size = 1;
+  options.precision = 18;
+  EXPECT_THROW(BatchTransform::Run(pose, options, &input, &output),
+               std::invalid_argument);
+}
+
+}  // namespace test
+}  // namespace math
+}  // namespace ekumen
+
+int main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
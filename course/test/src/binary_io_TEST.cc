@@ -0,0 +1,208 @@
+#include "binary_io.h"
+#include "isometry.h"
+#include "matrix3.h"
+#include "vector3.h"
+
+#include <unistd.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace ekumen {
+namespace math {
+namespace test {
+namespace {
+// Creates an empty temporary file and removes it when going out of scope.
+class TemporaryFile {
+ public:
+  TemporaryFile() {
+    char path[] = "/tmp/binary_io_TEST_XXXXXX";
+    const int fd = ::mkstemp(path);
+    if (fd < 0) {
+      throw std::runtime_error("Cannot create a temporary file.");
+    }
+    ::close(fd);
+    path_ = path;
+  }
+  ~TemporaryFile() { std::remove(path_.c_str()); }
+
+  const std::string& path() const { return path_; }
+
+ private:
+  std::string path_;
+};
+
+void writeBytes(const std::string& path, const std::string& bytes) {
+  std::ofstream os(path, std::ios::binary | std::ios::trunc);
+  os.write(bytes.data(), bytes.size());
+}
+}  // namespace
+
+GTEST_TEST(BinaryIoTest, Vector3RoundTrip) {
+  std::vector<Vector3> points;
+  for (int i = 0; i < 1000; ++i) {
+    points.emplace_back(i, -0.5 * i, 1e-3 * i * i);
+  }
+  const TemporaryFile file;
+  BinaryWriter::Write(points, file.path());
+
+  const BinaryFile binary(file.path());
+  EXPECT_EQ(binary.header().type, BinaryType::kVector3);
+  EXPECT_EQ(binary.header().scalar_width, sizeof(double));
+  EXPECT_EQ(binary.header().count, points.size());
+  const BinaryView<Vector3> view = binary.view<Vector3>();
+  ASSERT_EQ(view.size(), points.size());
+  for (std::size_t i = 0; i < points.size(); ++i) {
+    EXPECT_EQ(view[i], points[i]);
+  }
+  // The view reads the mapped doubles in place.
+  EXPECT_EQ(view.data()[3 * 7 + 1], points[7].y());
+  EXPECT_THROW(view.at(points.size()), std::out_of_range);
+  EXPECT_THROW(binary.view<Isometry>(), std::runtime_error);
+}
+
+GTEST_TEST(BinaryIoTest, Matrix3AndIsometryRoundTrip) {
+  const std::vector<Matrix3> matrices = {
+      Matrix3::kIdentity, Matrix3({1., 2., 3., 4., 5., 6., 7., 8., 9.})};
+  const std::vector<Isometry> poses = {
+      Isometry::FromTranslation({1., 2., 3.}),
+      Isometry::RotateAround(Vector3::kUnitZ, 0.3) *
+          Isometry::FromTranslation({-1., 0.5, 2.})};
+
+  const TemporaryFile matrix_file;
+  BinaryWriter::Write(matrices, matrix_file.path());
+  const BinaryView<Matrix3> matrix_view =
+      BinaryFile(matrix_file.path()).view<Matrix3>();
+  EXPECT_EQ(matrix_view.size(), matrices.size());
+
+  const TemporaryFile pose_file;
+  BinaryWriter::Write(poses, pose_file.path());
+  const BinaryFile pose_binary(pose_file.path());
+  const BinaryView<Isometry> pose_view = pose_binary.view<Isometry>();
+  ASSERT_EQ(pose_view.size(), poses.size());
+  for (std::size_t i = 0; i < poses.size(); ++i) {
+    EXPECT_EQ(pose_view[i], poses[i]);
+  }
+
+  const BinaryFile matrix_binary(matrix_file.path());
+  for (std::size_t i = 0; i < matrices.size(); ++i) {
+    EXPECT_EQ(matrix_binary.view<Matrix3>()[i], matrices[i]);
+  }
+}
+
+GTEST_TEST(BinaryIoTest, LittleEndianLayout) {
+  std::ostringstream os;
+  BinaryWriter::Write(std::vector<Vector3>{Vector3(1., 2., 3.)}, &os);
+  const std::string bytes = os.str();
+  ASSERT_EQ(bytes.size(), BinaryHeader::kSize + 3 * sizeof(double));
+  EXPECT_EQ(bytes.substr(0, 4), "EKMA");
+  EXPECT_EQ(bytes[4], 1);
+  EXPECT_EQ(bytes[5], 0);
+  EXPECT_EQ(bytes[6], static_cast<char>(BinaryType::kVector3));
+  EXPECT_EQ(bytes[7], 8);
+  EXPECT_EQ(bytes[8], 1);
+  for (int i = 9; i < 16; ++i) {
+    EXPECT_EQ(bytes[i], 0);
+  }
+  // 1.0 is 0x3ff0000000000000.
+  EXPECT_EQ(static_cast<unsigned char>(bytes[16 + 7]), 0x3f);
+  EXPECT_EQ(static_cast<unsigned char>(bytes[16 + 6]), 0xf0);
+}
+
+GTEST_TEST(BinaryIoTest, EmptyArray) {
+  const TemporaryFile file;
+  BinaryWriter::Write(std::vector<Isometry>(), file.path());
+  const BinaryFile binary(file.path());
+  EXPECT_TRUE(binary.view<Isometry>().empty());
+}
+
+GTEST_TEST(BinaryIoTest, MalformedFilesThrow) {
+  const TemporaryFile file;
+  EXPECT_THROW(BinaryFile(file.path()), std::runtime_error);
+  EXPECT_THROW(BinaryFile(file.path() + "_missing"), std::runtime_error);
+
+  std::ostringstream os;
+  BinaryWriter::Write(std::vector<Vector3>{Vector3(1., 2., 3.)}, &os);
+  const std::string bytes = os.str();
+
+  writeBytes(file.path(), bytes.substr(0, bytes.size() - 1));
+  EXPECT_THROW(BinaryFile(file.path()), std::runtime_error);
+
+  std::string bad_magic = bytes;
+  bad_magic[0] = 'X';
+  writeBytes(file.path(), bad_magic);
+  EXPECT_THROW(BinaryFile(file.path()), std::runtime_error);
+
+  std::string bad_version = bytes;
+  bad_version[4] = 2;
+  writeBytes(file.path(), bad_version);
+  EXPECT_THROW(BinaryFile(file.path()), std::runtime_error);
+
+  std::string bad_count = bytes;
+  bad_count[15] = 0x10;
+  writeBytes(file.path(), bad_count);
+  EXPECT_THROW(BinaryFile(file.path()), std::runtime_error);
+
+  writeBytes(file.path(), bytes);
+  EXPECT_NO_THROW(BinaryFile(file.path()));
+}
+
+GTEST_TEST(BinaryIoTest, StreamReader) {
+  std::vector<Isometry> poses;
+  for (int i = 0; i < 600; ++i) {
+    poses.push_back(Isometry::FromTranslation(Vector3(i, -i, 0.5 * i)) *
+                    Isometry::RotateAround(Vector3::kUnitZ, 0.01 * i));
+  }
+  std::stringstream stream;
+  BinaryWriter::WriteHeader<Isometry>(poses.size(), &stream);
+  BinaryWriter::WriteElements(poses.data(), 100, &stream);
+  BinaryWriter::WriteElements(poses.data() + 100, poses.size() - 100, &stream);
+
+  BinaryReader reader(&stream);
+  EXPECT_EQ(reader.header().type, BinaryType::kIsometry);
+  EXPECT_EQ(reader.header().count, poses.size());
+  EXPECT_THROW(reader.Read(static_cast<Vector3*>(nullptr), 1),
+               std::runtime_error);
+  std::vector<Isometry> res(poses.size() + 1);
+  EXPECT_EQ(reader.Read(res.data(), 257), 257u);
+  EXPECT_EQ(reader.Read(res.data() + 257, res.size() - 257),
+            poses.size() - 257);
+  EXPECT_EQ(reader.Read(res.data(), res.size()), 0u);
+  for (std::size_t i = 0; i < poses.size(); ++i) {
+    EXPECT_EQ(res[i], poses[i]);
+  }
+
+  std::stringstream header("EKMA");
+  EXPECT_THROW(BinaryReader reader(&header), std::runtime_error);
+  std::stringstream truncated(stream.str().substr(0, 100));
+  BinaryReader partial(&truncated);
+  EXPECT_THROW(partial.Read(res.data(), res.size()), std::runtime_error);
+}
+
+GTEST_TEST(BinaryIoTest, MappedFileMove) {
+  const TemporaryFile file;
+  writeBytes(file.path(), "abc");
+  MappedFile mapped(file.path());
+  ASSERT_EQ(mapped.size(), 3u);
+  const MappedFile moved(std::move(mapped));
+  EXPECT_EQ(mapped.size(), 0u);
+  EXPECT_EQ(mapped.data(), nullptr);
+  EXPECT_EQ(std::string(reinterpret_cast<const char*>(moved.data()), 3),
+            "abc");
+}
+
+}  // namespace test
+}  // namespace math
+}  // namespace ekumen
+
+int main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
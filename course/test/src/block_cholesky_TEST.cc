@@ -0,0 +1,120 @@
+#include "block_cholesky.h"
+
+#include <cmath>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace ekumen {
+namespace math {
+namespace test {
+namespace {
+constexpr double kTolerance{1e-9};
+constexpr int kSize{BlockCholesky::kBlockSize};
+
+// Deterministic pseudo-random block.
+BlockCholesky::Block makeBlock(int seed) {
+  BlockCholesky::Block res;
+  for (int i = 0; i < kSize * kSize; ++i) {
+    res.data()[i] = std::sin(seed * 31.7 + i * 1.3);
+  }
+  return res;
+}
+
+// Dense symmetric matrix built from the same blocks as the sparse one.
+struct DenseMatrix {
+  explicit DenseMatrix(int blocks)
+      : size(kSize * blocks), values(size * size, 0.) {}
+
+  void add(int i, int j, const BlockCholesky::Block& block) {
+    for (int r = 0; r < kSize; ++r) {
+      for (int c = 0; c < kSize; ++c) {
+        values[(kSize * i + r) * size + kSize * j + c] += block(r, c);
+      }
+    }
+  }
+
+  int size;
+  std::vector<double> values;
+};
+}  // namespace
+
+GTEST_TEST(BlockCholeskyTest, SolvesSparseSystem) {
+  // A ring of blocks with a few chords: needs fill-in.
+  const int kBlocks = 12;
+  std::vector<std::pair<int, int>> pattern;
+  for (int i = 0; i < kBlocks; ++i) {
+    pattern.push_back(std::make_pair(i, (i + 1) % kBlocks));
+  }
+  pattern.push_back(std::make_pair(0, 6));
+  pattern.push_back(std::make_pair(9, 3));
+
+  BlockCholesky solver;
+  solver.Analyze(kBlocks, pattern);
+  EXPECT_EQ(solver.numBlocks(), kBlocks);
+  EXPECT_GE(solver.numFactorBlocks(), pattern.size());
+
+  for (int round = 0; round < 2; ++round) {
+    solver.SetZero();
+    DenseMatrix dense(kBlocks);
+    for (std::size_t k = 0; k < pattern.size(); ++k) {
+      const BlockCholesky::Block block = makeBlock(k + 100 * round);
+      const BlockCholesky::Block transposed = block.transpose();
+      solver.AddToOffDiagonal(pattern[k].first, pattern[k].second, block);
+      dense.add(pattern[k].first, pattern[k].second, block);
+      dense.add(pattern[k].second, pattern[k].first, transposed);
+    }
+    // Diagonally dominant diagonal blocks make the matrix positive definite.
+    for (int i = 0; i < kBlocks; ++i) {
+      BlockCholesky::Block diagonal;
+      for (int r = 0; r < kSize; ++r) {
+        for (int c = 0; c < kSize; ++c) {
+          diagonal(r, c) = r == c ? 30. : 0.1;
+        }
+      }
+      solver.AddToDiagonal(i, diagonal);
+      dense.add(i, i, diagonal);
+    }
+    ASSERT_TRUE(solver.Factorize());
+
+    std::vector<double> rhs(dense.size);
+    for (int i = 0; i < dense.size; ++i) {
+      rhs[i] = std::cos(i * 0.7);
+    }
+    std::vector<double> x;
+    solver.Solve(rhs, &x);
+    ASSERT_EQ(static_cast<int>(x.size()), dense.size);
+    for (int i = 0; i < dense.size; ++i) {
+      double value = 0.;
+      for (int j = 0; j < dense.size; ++j) {
+        value += dense.values[i * dense.size + j] * x[j];
+      }
+      EXPECT_NEAR(value, rhs[i], kTolerance);
+    }
+  }
+}
+
+GTEST_TEST(BlockCholeskyTest, DetectsIndefiniteMatrix) {
+  BlockCholesky solver;
+  solver.Analyze(2, {std::make_pair(0, 1)});
+  solver.AddToDiagonal(0, BlockCholesky::Block::Identity());
+  EXPECT_FALSE(solver.Factorize());
+}
+
+GTEST_TEST(BlockCholeskyTest, RejectsBlocksOutsideThePattern) {
+  BlockCholesky solver;
+  solver.Analyze(3, {std::make_pair(0, 1)});
+  ASSERT_THROW(solver.AddToOffDiagonal(0, 2, BlockCholesky::Block::Identity()),
+               std::out_of_range);
+}
+
+}  // namespace test
+}  // namespace math
+}  // namespace ekumen
+
+int main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,116 @@
+#include "blocked_point_cloud.h"
+#include "isometry.h"
+#include "point_cloud.h"
+#include "vector3.h"
+
+#include <stdexcept>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace ekumen {
+namespace math {
+namespace test {
+namespace {
+constexpr double kTolerance{1e-12};
+
+std::vector<Vector3> makePoints(std::size_t count, double scale) {
+  std::vector<Vector3> res;
+  for (std::size_t i = 0; i < count; ++i) {
+    res.emplace_back(scale * i, 1. - 0.3 * i, 2. - scale * i * i);
+  }
+  return res;
+}
+
+void expectNear(const Vector3& a, const Vector3& b) {
+  EXPECT_NEAR(a.x(), b.x(), kTolerance);
+  EXPECT_NEAR(a.y(), b.y(), kTolerance);
+  EXPECT_NEAR(a.z(), b.z(), kTolerance);
+}
+}  // namespace
+
+GTEST_TEST(BlockedPointCloudTest, Layout) {
+  const std::vector<Vector3> points = makePoints(19, 0.1);
+  BlockedPointCloud cloud(points);
+  ASSERT_EQ(cloud.size(), 19u);
+  EXPECT_FALSE(cloud.empty());
+  EXPECT_EQ(cloud.numBlocks(), 3u);
+  for (std::size_t i = 0; i < points.size(); ++i) {
+    EXPECT_EQ(cloud.point(i), points[i]);
+  }
+  // Point 10 is lane 2 of block 1.
+  EXPECT_EQ(cloud.blocks()[1].x[2], points[10].x());
+  EXPECT_EQ(cloud.blocks()[1].z[2], points[10].z());
+  EXPECT_THROW(cloud.point(19), std::out_of_range);
+  EXPECT_THROW(cloud.setPoint(19, Vector3::kZero), std::out_of_range);
+
+  EXPECT_EQ(cloud.toPointCloud(), PointCloud(points));
+  EXPECT_EQ(BlockedPointCloud(PointCloud(points)), cloud);
+  cloud.setPoint(3, Vector3::kUnitX);
+  EXPECT_NE(cloud, BlockedPointCloud(points));
+
+  // Padding lanes are cleared when they become points.
+  cloud.transform(Isometry::FromTranslation(Vector3(1., 2., 3.)));
+  cloud.resize(17);
+  cloud.resize(24);
+  EXPECT_EQ(cloud.point(16), points[16] + Vector3(1., 2., 3.));
+  for (std::size_t i = 17; i < 24; ++i) {
+    EXPECT_EQ(cloud.point(i), Vector3::kZero);
+  }
+  cloud.push_back(Vector3::kUnitZ);
+  EXPECT_EQ(cloud.numBlocks(), 4u);
+  EXPECT_EQ(cloud.point(24), Vector3::kUnitZ);
+  cloud.clear();
+  EXPECT_TRUE(cloud.empty());
+  EXPECT_EQ(cloud.numBlocks(), 0u);
+}
+
+GTEST_TEST(BlockedPointCloudTest, Kernels) {
+  const Isometry pose = Isometry::FromTranslation(Vector3(1., -2., 3.)) *
+                        Isometry::RotateAround(Vector3(1., 1., 0.), 0.75);
+  const std::vector<Vector3> a = makePoints(21, 0.1);
+  const std::vector<Vector3> b = makePoints(21, -0.7);
+  BlockedPointCloud cloud_a(a);
+  const BlockedPointCloud cloud_b(b);
+
+  std::vector<double> dots;
+  cloud_a.dot(cloud_b, &dots);
+  std::vector<double> norms;
+  cloud_b.norm(&norms);
+  ASSERT_EQ(dots.size(), a.size());
+  ASSERT_EQ(norms.size(), b.size());
+  for (std::size_t i = 0; i < a.size(); ++i) {
+    EXPECT_NEAR(dots[i], a[i].dot(b[i]), kTolerance);
+    EXPECT_NEAR(norms[i], b[i].norm(), kTolerance);
+  }
+
+  BlockedPointCloud crosses;
+  cloud_a.cross(cloud_b, &crosses);
+  ASSERT_EQ(crosses.size(), a.size());
+  for (std::size_t i = 0; i < a.size(); ++i) {
+    expectNear(crosses.point(i), a[i].cross(b[i]));
+  }
+  // In place.
+  cloud_a.cross(cloud_b, &cloud_a);
+  EXPECT_EQ(cloud_a, crosses);
+
+  BlockedPointCloud moved(b);
+  moved.transform(pose);
+  for (std::size_t i = 0; i < b.size(); ++i) {
+    expectNear(moved.point(i), pose * b[i]);
+  }
+
+  EXPECT_THROW(cloud_a.dot(BlockedPointCloud(20), &dots),
+               std::invalid_argument);
+  EXPECT_THROW(cloud_a.cross(BlockedPointCloud(22), &crosses),
+               std::invalid_argument);
+}
+
+}  // namespace test
+}  // namespace math
+}  // namespace ekumen
+
+int main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,103 @@
+#include "aabb.h"
+#include "box_set.h"
+#include "isometry.h"
+#include "obb.h"
+#include "vector3.h"
+
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace ekumen {
+namespace math {
+namespace test {
+namespace {
+std::vector<Aabb> makeBoxes(std::size_t size) {
+  std::mt19937 generator(31);
+  std::uniform_real_distribution<double> positions(-50., 50.);
+  std::uniform_real_distribution<double> sizes(0., 5.);
+  std::vector<Aabb> res;
+  for (std::size_t i = 0; i < size; ++i) {
+    const Vector3 min(positions(generator), positions(generator),
+                      positions(generator));
+    res.emplace_back(min, min + Vector3(sizes(generator), sizes(generator),
+                                        sizes(generator)));
+  }
+  // Empty and NaN boxes.
+  res.emplace_back();
+  res.emplace_back(Vector3(std::nan(""), 0., 0.), Vector3(1., 1., 1.));
+  return res;
+}
+}  // namespace
+
+GTEST_TEST(BoxSetTest, Accessors) {
+  BoxSet set;
+  EXPECT_TRUE(set.empty());
+  const Aabb box(Vector3(1., 2., 3.), Vector3(4., 5., 6.));
+  set.push_back(box);
+  set.push_back(Aabb());
+  EXPECT_EQ(set.size(), 2u);
+  EXPECT_EQ(set.box(0).min, box.min);
+  EXPECT_EQ(set.box(0).max, box.max);
+  set.setBox(1, box);
+  EXPECT_EQ(set.box(1).max, box.max);
+  EXPECT_THROW(set.box(2), std::out_of_range);
+  EXPECT_THROW(set.setBox(2, box), std::out_of_range);
+  set.clear();
+  EXPECT_TRUE(set.empty());
+}
+
+GTEST_TEST(BoxSetTest, Overlapping) {
+  // Sizes around the block size, with a partial last block.
+  for (const std::size_t size : {0, 5, 512, 3001}) {
+    const std::vector<Aabb> boxes = makeBoxes(size);
+    const BoxSet set(boxes);
+    std::mt19937 generator(37);
+    std::uniform_real_distribution<double> positions(-50., 50.);
+    std::uniform_real_distribution<double> angles(-M_PI, M_PI);
+    std::vector<std::uint32_t> found;
+    for (int i = 0; i < 20; ++i) {
+      const Vector3 center(positions(generator), positions(generator),
+                           positions(generator));
+      const Aabb query(center - Vector3(8., 6., 4.),
+                       center + Vector3(8., 6., 4.));
+      std::vector<std::uint32_t> expected;
+      for (std::uint32_t j = 0; j < boxes.size(); ++j) {
+        if (boxes[j].overlaps(query)) {
+          expected.push_back(j);
+        }
+      }
+      set.overlapping(query, &found);
+      EXPECT_EQ(found, expected);
+
+      const Obb oriented = Obb::FromAabb(
+          Aabb(Vector3(-8., -6., -4.), Vector3(8., 6., 4.)),
+          Isometry::FromTranslation(center) *
+              Isometry::FromEulerAngles(angles(generator), angles(generator),
+                                        angles(generator)));
+      expected.clear();
+      for (std::uint32_t j = 0; j < boxes.size(); ++j) {
+        if (oriented.overlaps(Obb::FromAabb(boxes[j]))) {
+          expected.push_back(j);
+        }
+      }
+      set.overlapping(oriented, &found);
+      EXPECT_EQ(found, expected);
+    }
+    set.overlapping(Obb(), &found);
+    EXPECT_TRUE(found.empty());
+  }
+}
+
+}  // namespace test
+}  // namespace math
+}  // namespace ekumen
+
+int main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
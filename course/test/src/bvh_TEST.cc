@@ -0,0 +1,256 @@
+#include "aabb.h"
+#include "bvh.h"
+#include "vector3.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace ekumen {
+namespace math {
+namespace test {
+namespace {
+constexpr double kTolerance{1e-12};
+
+std::vector<Aabb> makeBoxes(std::size_t size, unsigned seed) {
+  std::mt19937 generator(seed);
+  std::uniform_real_distribution<double> positions(-100., 100.);
+  std::uniform_real_distribution<double> sizes(0., 2.);
+  std::vector<Aabb> res;
+  for (std::size_t i = 0; i < size; ++i) {
+    const Vector3 min(positions(generator), positions(generator),
+                      positions(generator));
+    res.emplace_back(
+        min, min + Vector3(sizes(generator), sizes(generator),
+                           sizes(generator)));
+  }
+  return res;
+}
+
+// Distance along a ray to a box, or infinity when the ray misses it.
+double rayDistance(const Aabb& box, const Vector3& origin,
+                   const Vector3& direction) {
+  double enter = 0.;
+  double exit = std::numeric_limits<double>::infinity();
+  for (int i = 0; i < 3; ++i) {
+    const double t0 = (box.min[i] - origin[i]) / direction[i];
+    const double t1 = (box.max[i] - origin[i]) / direction[i];
+    enter = std::max(enter, std::min(t0, t1));
+    exit = std::min(exit, std::max(t0, t1));
+  }
+  return enter <= exit ? enter : std::numeric_limits<double>::infinity();
+}
+
+// Checks that leaves hold every primitive once and that nodes contain the
+// boxes of their children and primitives.
+void expectValid(const Bvh& bvh, const std::vector<Aabb>& boxes) {
+  std::vector<int> seen(boxes.size(), 0);
+  const std::vector<BvhNode>& nodes = bvh.nodes();
+  const auto toAabb = [](const BvhNode& node) {
+    return Aabb(Vector3(node.min[0], node.min[1], node.min[2]),
+                Vector3(node.max[0], node.max[1], node.max[2]));
+  };
+  const auto encloses = [](const Aabb& outer, const Aabb& inner) {
+    return outer.contains(inner.min) && outer.contains(inner.max);
+  };
+  for (std::size_t i = 0; i < nodes.size(); ++i) {
+    const Aabb box = toAabb(nodes[i]);
+    if (nodes[i].isLeaf()) {
+      for (std::uint32_t j = 0; j < nodes[i].count; ++j) {
+        const std::uint32_t primitive =
+            bvh.primitives()[nodes[i].offset + j];
+        ++seen[primitive];
+        EXPECT_TRUE(encloses(box, boxes[primitive]));
+      }
+    } else {
+      ASSERT_LT(nodes[i].offset, nodes.size());
+      EXPECT_GT(nodes[i].offset, i + 1);
+      EXPECT_TRUE(encloses(box, toAabb(nodes[i + 1])));
+      EXPECT_TRUE(encloses(box, toAabb(nodes[nodes[i].offset])));
+    }
+  }
+  EXPECT_EQ(seen, std::vector<int>(boxes.size(), 1));
+}
+
+// Checks the queries of 'bvh' against a linear scan of 'boxes'.
+void expectQueries(const Bvh& bvh, const std::vector<Aabb>& boxes) {
+  std::mt19937 generator(17);
+  std::uniform_real_distribution<double> positions(-120., 120.);
+  std::uniform_real_distribution<double> directions(-1., 1.);
+  for (int i = 0; i < 50; ++i) {
+    const Vector3 center(positions(generator), positions(generator),
+                         positions(generator));
+    const Aabb query(center - Vector3(10., 10., 10.),
+                     center + Vector3(10., 10., 10.));
+    std::vector<std::uint32_t> expected;
+    for (std::uint32_t j = 0; j < boxes.size(); ++j) {
+      if (boxes[j].overlaps(query)) {
+        expected.push_back(j);
+      }
+    }
+    std::vector<std::uint32_t> found;
+    bvh.overlapping(query, [&](std::uint32_t primitive) {
+      if (boxes[primitive].overlaps(query)) {
+        found.push_back(primitive);
+      }
+    });
+    std::sort(found.begin(), found.end());
+    EXPECT_EQ(found, expected);
+
+    const Vector3 direction(directions(generator), directions(generator),
+                            directions(generator));
+    double expected_distance = std::numeric_limits<double>::infinity();
+    for (const Aabb& box : boxes) {
+      expected_distance =
+          std::min(expected_distance, rayDistance(box, center, direction));
+    }
+    double distance = std::numeric_limits<double>::infinity();
+    bvh.raycast(center, direction, distance,
+                [&](std::uint32_t primitive, double* max_distance) {
+                  const double t =
+                      rayDistance(boxes[primitive], center, direction);
+                  if (t < *max_distance) {
+                    *max_distance = t;
+                    distance = t;
+                  }
+                });
+    if (std::isinf(expected_distance)) {
+      EXPECT_TRUE(std::isinf(distance));
+    } else {
+      EXPECT_NEAR(distance, expected_distance, 1e-9);
+    }
+
+    double expected_squared = std::numeric_limits<double>::infinity();
+    for (const Aabb& box : boxes) {
+      expected_squared = std::min(expected_squared,
+                                  box.squaredDistance(center));
+    }
+    double squared = std::numeric_limits<double>::infinity();
+    int visited = 0;
+    bvh.nearest(center, squared,
+                [&](std::uint32_t primitive, double* bound) {
+                  ++visited;
+                  const double value =
+                      boxes[primitive].squaredDistance(center);
+                  if (value < *bound) {
+                    *bound = value;
+                    squared = value;
+                  }
+                });
+    EXPECT_NEAR(squared, expected_squared, kTolerance);
+    // Pruning leaves most primitives unvisited.
+    EXPECT_LT(visited, static_cast<int>(boxes.size()) / 10);
+  }
+}
+}  // namespace
+
+GTEST_TEST(BvhTest, Empty) {
+  const Bvh bvh(std::vector<Aabb>{});
+  EXPECT_TRUE(bvh.empty());
+  EXPECT_TRUE(bvh.nodes().empty());
+  EXPECT_TRUE(bvh.bounds().empty());
+  int calls = 0;
+  bvh.overlapping(Aabb(Vector3::kZero, Vector3(1., 1., 1.)),
+                  [&](std::uint32_t) { ++calls; });
+  bvh.raycast(Vector3::kZero, Vector3::kUnitX, 1.,
+              [&](std::uint32_t, double*) { ++calls; });
+  EXPECT_EQ(calls, 0);
+}
+
+GTEST_TEST(BvhTest, NanAndEmptyBoxes) {
+  const Aabb unit(Vector3::kZero, Vector3(1., 1., 1.));
+  const Aabb nan(Vector3(std::nan(""), 0., 0.), Vector3(1., 1., 1.));
+  EXPECT_THROW(Bvh({unit, nan}), std::invalid_argument);
+  Bvh bvh({unit, unit});
+  EXPECT_THROW(bvh.refit({unit, nan}), std::invalid_argument);
+  // Empty boxes, whose centroids are NaN, are binned with the others, which
+  // are all found.
+  std::vector<Aabb> boxes;
+  for (int i = 0; i < 100; ++i) {
+    boxes.push_back(i % 3 == 0 ? Aabb()
+                               : Aabb(Vector3(i, 0., 0.),
+                                      Vector3(i + 0.5, 1., 1.)));
+  }
+  const Bvh mixed(boxes);
+  EXPECT_EQ(mixed.size(), boxes.size());
+  std::vector<std::uint32_t> found;
+  mixed.overlapping(Aabb(Vector3(-1., -1., -1.), Vector3(200., 2., 2.)),
+                    [&](std::uint32_t index) { found.push_back(index); });
+  std::sort(found.begin(), found.end());
+  for (std::uint32_t i = 0; i < boxes.size(); ++i) {
+    EXPECT_TRUE(i % 3 == 0 ||
+                std::binary_search(found.begin(), found.end(), i));
+  }
+}
+
+GTEST_TEST(BvhTest, Structure) {
+  const std::vector<Aabb> boxes = makeBoxes(5000, 3);
+  const Bvh bvh(boxes, 1);
+  EXPECT_EQ(bvh.size(), boxes.size());
+  expectValid(bvh, boxes);
+  Aabb bounds;
+  for (const Aabb& box : boxes) {
+    bounds.extend(box);
+  }
+  EXPECT_EQ(bvh.bounds().min, bounds.min);
+  EXPECT_EQ(bvh.bounds().max, bounds.max);
+  // The heuristic keeps leaves small.
+  EXPECT_GT(bvh.nodes().size(), boxes.size() / 4);
+
+  // Coincident boxes still split, down to small leaves.
+  const std::vector<Aabb> same(100, Aabb(Vector3::kZero, Vector3::kZero));
+  const Bvh stacked(same);
+  expectValid(stacked, same);
+  for (const BvhNode& node : stacked.nodes()) {
+    EXPECT_LE(node.count, 4u);
+  }
+}
+
+GTEST_TEST(BvhTest, Queries) {
+  const std::vector<Aabb> boxes = makeBoxes(5000, 5);
+  expectQueries(Bvh(boxes, 1), boxes);
+}
+
+GTEST_TEST(BvhTest, ParallelBuild) {
+  const std::vector<Aabb> boxes = makeBoxes(70000, 9);
+  const Bvh serial(boxes, 1);
+  const Bvh parallel(boxes, 4);
+  expectValid(parallel, boxes);
+  EXPECT_EQ(parallel.primitives(), serial.primitives());
+  ASSERT_EQ(parallel.nodes().size(), serial.nodes().size());
+  for (std::size_t i = 0; i < serial.nodes().size(); ++i) {
+    EXPECT_EQ(parallel.nodes()[i].offset, serial.nodes()[i].offset);
+    EXPECT_EQ(parallel.nodes()[i].count, serial.nodes()[i].count);
+  }
+}
+
+GTEST_TEST(BvhTest, Refit) {
+  std::vector<Aabb> boxes = makeBoxes(5000, 13);
+  Bvh bvh(boxes);
+  std::mt19937 generator(19);
+  std::uniform_real_distribution<double> offsets(-5., 5.);
+  for (Aabb& box : boxes) {
+    const Vector3 offset(offsets(generator), offsets(generator),
+                         offsets(generator));
+    box = Aabb(box.min + offset, box.max + offset);
+  }
+  bvh.refit(boxes);
+  expectValid(bvh, boxes);
+  expectQueries(bvh, boxes);
+  EXPECT_THROW(bvh.refit(makeBoxes(10, 1)), std::invalid_argument);
+}
+
+}  // namespace test
+}  // namespace math
+}  // namespace ekumen
+
+int main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
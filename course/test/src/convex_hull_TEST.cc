@@ -0,0 +1,180 @@
+#include "convex_hull.h"
+#include "vector3.h"
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <random>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace ekumen {
+namespace math {
+namespace test {
+namespace {
+constexpr double kTolerance{1e-9};
+
+// Checks that every edge of the hull has its twin, that the mesh is a
+// sphere by Euler's formula, that no vertex is above a triangle and that
+// every point is inside.
+void expectValid(const ConvexHull& hull, const std::vector<Vector3>& points) {
+  std::map<std::pair<std::uint32_t, std::uint32_t>, int> edges;
+  for (const ConvexHull::Triangle& triangle : hull.triangles()) {
+    for (int k = 0; k < 3; ++k) {
+      ++edges[std::make_pair(triangle[k], triangle[(k + 1) % 3])];
+    }
+  }
+  for (const auto& edge : edges) {
+    EXPECT_EQ(edge.second, 1);
+    EXPECT_EQ(edges.count(std::make_pair(edge.first.second, edge.first.first)),
+              1u);
+  }
+  // Each edge is there in both directions.
+  EXPECT_EQ(hull.numVertices() + hull.numTriangles() - edges.size() / 2, 2u);
+  for (const ConvexHull::Triangle& triangle : hull.triangles()) {
+    for (std::size_t i = 0; i < hull.numVertices(); ++i) {
+      EXPECT_GE(Orient3d(hull.vertex(triangle[0]), hull.vertex(triangle[1]),
+                         hull.vertex(triangle[2]), hull.vertex(i)),
+                0.);
+    }
+  }
+  for (const Vector3& point : points) {
+    EXPECT_TRUE(hull.contains(point));
+  }
+  for (std::size_t i = 0; i < hull.numVertices(); ++i) {
+    EXPECT_EQ(hull.vertex(i), points[hull.indices()[i]]);
+  }
+}
+}  // namespace
+
+GTEST_TEST(ConvexHullTest, Orient3d) {
+  const Vector3 a(0., 0., 0.);
+  const Vector3 b(1., 0., 0.);
+  const Vector3 c(0., 1., 0.);
+  EXPECT_NEAR(Orient3d(a, b, c, Vector3(0., 0., -1.)), 1., kTolerance);
+  EXPECT_NEAR(Orient3d(a, b, c, Vector3(5., 7., 2.)), -2., kTolerance);
+  EXPECT_NEAR(Orient3d(a, c, b, Vector3(5., 7., 2.)), 2., kTolerance);
+
+  // Points on the plane z = x, whose differences round: the sign is 0, and
+  // follows a nudge of one ulp of 'd' off the plane.
+  std::mt19937 generator(61);
+  std::uniform_int_distribution<int> integers(-1000, 1000);
+  const auto next = [&integers, &generator]() -> double {
+    return integers(generator);
+  };
+  std::uniform_real_distribution<double> reals(-1e4, 1e4);
+  for (int i = 0; i < 1000; ++i) {
+    const double p[3][2] = {{1e6 + next(), next()},
+                            {1e6 + next(), next()},
+                            {1e6 + next(), next()}};
+    const Vector3 e(p[0][0], p[0][1], p[0][0]);
+    const Vector3 f(p[1][0], p[1][1], p[1][0]);
+    const Vector3 g(p[2][0], p[2][1], p[2][0]);
+    const double x = 1e6 + reals(generator);
+    const double y = reals(generator);
+    EXPECT_EQ(Orient3d(e, f, g, Vector3(x, y, x)), 0.);
+    // Twice the signed area of the triangle seen from above, exact.
+    const double area = (p[1][0] - p[0][0]) * (p[2][1] - p[0][1]) -
+                        (p[1][1] - p[0][1]) * (p[2][0] - p[0][0]);
+    const double above =
+        Orient3d(e, f, g, Vector3(x, y, std::nextafter(x, 2e6)));
+    if (area > 0.) {
+      EXPECT_LT(above, 0.);
+    } else if (area < 0.) {
+      EXPECT_GT(above, 0.);
+    } else {
+      EXPECT_EQ(above, 0.);
+    }
+  }
+}
+
+GTEST_TEST(ConvexHullTest, Degenerate) {
+  EXPECT_THROW(ConvexHull({Vector3::kZero, Vector3::kUnitX, Vector3::kUnitY}),
+               std::invalid_argument);
+  EXPECT_THROW(ConvexHull(std::vector<Vector3>(10, Vector3::kUnitX)),
+               std::invalid_argument);
+  std::vector<Vector3> line;
+  std::vector<Vector3> plane;
+  for (int i = 0; i < 20; ++i) {
+    line.emplace_back(i, 2 * i, 3 * i);
+    plane.emplace_back(0.1 * i, i % 7, 0.1 * i);
+  }
+  EXPECT_THROW(ConvexHull{line}, std::invalid_argument);
+  EXPECT_THROW(ConvexHull{plane}, std::invalid_argument);
+  const ConvexHull hull(
+      {Vector3::kZero, Vector3::kUnitX, Vector3::kUnitY, Vector3::kUnitZ});
+  EXPECT_THROW(hull.vertex(4), std::out_of_range);
+}
+
+GTEST_TEST(ConvexHullTest, Cube) {
+  // The corners of a cube among points inside it.
+  std::mt19937 generator(67);
+  std::uniform_real_distribution<double> inside(-0.99, 0.99);
+  std::vector<Vector3> points;
+  for (int i = 0; i < 500; ++i) {
+    points.emplace_back(inside(generator), inside(generator),
+                        inside(generator));
+    if (i % 60 == 0) {
+      const int corner = i / 60;
+      points.emplace_back(corner & 1 ? 1. : -1., corner & 2 ? 1. : -1.,
+                          corner & 4 ? 1. : -1.);
+    }
+  }
+  const ConvexHull hull(points);
+  EXPECT_EQ(hull.numVertices(), 8u);
+  EXPECT_EQ(hull.numTriangles(), 12u);
+  EXPECT_NEAR(hull.volume(), 8., kTolerance);
+  expectValid(hull, points);
+  EXPECT_FALSE(hull.contains(Vector3(1.001, 0., 0.)));
+  EXPECT_TRUE(hull.contains(Vector3(1., 1., 0.3)));
+}
+
+GTEST_TEST(ConvexHullTest, Lattice) {
+  // Many coplanar and collinear points on the faces of the hull.
+  std::vector<Vector3> points;
+  for (int i = 0; i < 10; ++i) {
+    for (int j = 0; j < 10; ++j) {
+      for (int k = 0; k < 10; ++k) {
+        points.emplace_back(0.1 * i, 0.1 * j, 0.1 * k);
+      }
+    }
+  }
+  const ConvexHull hull(points);
+  EXPECT_NEAR(hull.volume(), 0.729, kTolerance);
+  expectValid(hull, points);
+}
+
+GTEST_TEST(ConvexHullTest, Sphere) {
+  // Every point of a sphere is a vertex, and the hull is the same on any
+  // number of threads.
+  std::mt19937 generator(71);
+  std::normal_distribution<double> normal;
+  std::vector<Vector3> points;
+  for (int i = 0; i < 20000; ++i) {
+    Vector3 point(normal(generator), normal(generator), normal(generator));
+    points.push_back((1. / point.norm()) * point);
+  }
+  const ConvexHull hull(points, 1);
+  EXPECT_EQ(hull.numVertices(), points.size());
+  EXPECT_EQ(hull.numTriangles(), 2 * points.size() - 4);
+  EXPECT_NEAR(hull.volume(), 4. / 3. * M_PI, 1e-2);
+  const ConvexHull parallel(points, 4);
+  EXPECT_EQ(parallel.indices(), hull.indices());
+  EXPECT_EQ(parallel.triangles(), hull.triangles());
+
+  const std::vector<Vector3> few(points.begin(), points.begin() + 300);
+  expectValid(ConvexHull(few), few);
+}
+
+}  // namespace test
+}  // namespace math
+}  // namespace ekumen
+
+int main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
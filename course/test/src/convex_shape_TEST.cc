@@ -0,0 +1,69 @@
+#include "aabb.h"
+#include "convex_shape.h"
+#include "vector3.h"
+
+#include <cmath>
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace ekumen {
+namespace math {
+namespace test {
+
+GTEST_TEST(ConvexShapeTest, Factories) {
+  EXPECT_EQ(ConvexShape().type(), ConvexShape::Type::kSphere);
+  EXPECT_EQ(ConvexShape().radius(), 1.);
+  EXPECT_THROW(ConvexShape::Sphere(-1.), std::invalid_argument);
+  EXPECT_THROW(ConvexShape::Sphere(std::nan("")), std::invalid_argument);
+  EXPECT_THROW(ConvexShape::Box(Vector3(1., -1., 1.)), std::invalid_argument);
+  EXPECT_THROW(ConvexShape::Capsule(-1., 1.), std::invalid_argument);
+  EXPECT_THROW(ConvexShape::Capsule(1., -1.), std::invalid_argument);
+  EXPECT_THROW(ConvexShape::Hull({}), std::invalid_argument);
+
+  EXPECT_EQ(ConvexShape::Box(Vector3(1., 2., 3.)).type(),
+            ConvexShape::Type::kBox);
+  EXPECT_EQ(ConvexShape::Box(Vector3(1., 2., 3.)).radius(), 0.);
+  EXPECT_EQ(ConvexShape::Capsule(2., 0.5).type(),
+            ConvexShape::Type::kCapsule);
+  EXPECT_EQ(ConvexShape::Capsule(2., 0.5).radius(), 0.5);
+  EXPECT_EQ(ConvexShape::Hull({Vector3::kZero}).type(),
+            ConvexShape::Type::kHull);
+
+  std::ostringstream os;
+  os << ConvexShape::Capsule(2., 0.5);
+  EXPECT_EQ(os.str(), "Capsule(half_length: 2, radius: 0.5)");
+}
+
+GTEST_TEST(ConvexShapeTest, Support) {
+  const Vector3 direction(0.3, -2., 0.1);
+  EXPECT_EQ(ConvexShape::Sphere(2.).support(direction), Vector3::kZero);
+  EXPECT_EQ(ConvexShape::Box(Vector3(1., 2., 3.)).support(direction),
+            Vector3(1., -2., 3.));
+  EXPECT_EQ(ConvexShape::Capsule(2., 0.5).support(direction),
+            Vector3(0., 0., 2.));
+  EXPECT_EQ(ConvexShape::Capsule(2., 0.5).support(-1. * direction),
+            Vector3(0., 0., -2.));
+  const ConvexShape hull = ConvexShape::Hull(
+      {Vector3(1., 0., 0.), Vector3(0., -1., 0.), Vector3(0., 0., 1.),
+       Vector3(0.1, 0.1, 0.1)});
+  EXPECT_EQ(hull.support(direction), Vector3(0., -1., 0.));
+  EXPECT_EQ(hull.support(Vector3::kUnitX), Vector3(1., 0., 0.));
+
+  const Aabb bounds = ConvexShape::Capsule(2., 0.5).bounds();
+  EXPECT_EQ(bounds.min, Vector3(-0.5, -0.5, -2.5));
+  EXPECT_EQ(bounds.max, Vector3(0.5, 0.5, 2.5));
+  EXPECT_EQ(hull.bounds().min, Vector3(0., -1., 0.));
+  EXPECT_EQ(hull.bounds().max, Vector3(1., 0.1, 1.));
+}
+
+}  // namespace test
+}  // namespace math
+}  // namespace ekumen
+
+int main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,224 @@
+#include "convex_shape.h"
+#include "gjk.h"
+#include "isometry.h"
+#include "vector3.h"
+
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace ekumen {
+namespace math {
+namespace test {
+namespace {
+constexpr double kTolerance{1e-9};
+
+// Furthest extent of 'shape' at 'pose' along the unit 'direction'.
+double extent(const ConvexShape& shape, const Isometry& pose,
+              const Vector3& direction) {
+  const Vector3 local = pose.rotation().transpose().product(direction);
+  return direction.dot(pose * shape.support(local)) + shape.radius();
+}
+
+// Distance or minus the overlap of the shapes along 'normal', from A to B.
+double gapAlong(const ConvexShape& a, const Isometry& pose_a,
+                const ConvexShape& b, const Isometry& pose_b,
+                const Vector3& normal) {
+  return -extent(b, pose_b, -1. * normal) - extent(a, pose_a, normal);
+}
+
+void expectContact(const ConvexContact& contact, double distance,
+                   const Vector3& normal) {
+  EXPECT_NEAR(contact.distance, distance, kTolerance);
+  for (int i = 0; i < 3; ++i) {
+    EXPECT_NEAR(contact.normal[i], normal[i], kTolerance);
+  }
+}
+
+ConvexShape makeHull(std::mt19937* generator) {
+  std::uniform_real_distribution<double> coordinates(-1., 1.);
+  std::vector<Vector3> vertices;
+  for (int i = 0; i < 12; ++i) {
+    vertices.emplace_back(coordinates(*generator), coordinates(*generator),
+                          coordinates(*generator));
+  }
+  return ConvexShape::Hull(vertices);
+}
+
+Isometry makePose(std::mt19937* generator, double spread) {
+  std::uniform_real_distribution<double> positions(-spread, spread);
+  std::uniform_real_distribution<double> angles(-M_PI, M_PI);
+  return Isometry::FromTranslation(Vector3(positions(*generator),
+                                           positions(*generator),
+                                           positions(*generator))) *
+         Isometry::FromEulerAngles(angles(*generator), angles(*generator),
+                                   angles(*generator));
+}
+}  // namespace
+
+GTEST_TEST(GjkTest, Spheres) {
+  const ConvexShape a = ConvexShape::Sphere(1.);
+  const ConvexShape b = ConvexShape::Sphere(0.5);
+  const Isometry pose_a = Isometry::FromTranslation(Vector3(1., 2., 3.));
+  const Isometry apart = Isometry::FromTranslation(Vector3(1., 2., 6.));
+  ConvexContact contact;
+  EXPECT_NEAR(ConvexDistance(a, pose_a, b, apart, &contact), 1.5,
+              kTolerance);
+  expectContact(contact, 1.5, Vector3::kUnitZ);
+  EXPECT_EQ(contact.point_a, Vector3(1., 2., 4.));
+  EXPECT_EQ(contact.point_b, Vector3(1., 2., 5.5));
+  expectContact(ConvexPenetration(a, pose_a, b, apart), 1.5,
+                Vector3::kUnitZ);
+
+  // Overlapping by 0.5, and with coincident centers.
+  const Isometry close = Isometry::FromTranslation(Vector3(1., 3., 3.));
+  ConvexContact unchanged;
+  unchanged.distance = 7.;
+  EXPECT_EQ(ConvexDistance(a, pose_a, b, close, &unchanged), 0.);
+  EXPECT_EQ(unchanged.distance, 7.);
+  expectContact(ConvexPenetration(a, pose_a, b, close), -0.5,
+                Vector3::kUnitY);
+  EXPECT_NEAR(ConvexPenetration(a, pose_a, b, pose_a).distance, -1.5,
+              kTolerance);
+}
+
+GTEST_TEST(GjkTest, Boxes) {
+  const ConvexShape box = ConvexShape::Box(Vector3(1., 2., 3.));
+  const Isometry turned = Isometry::RotateAround(Vector3::kUnitZ, M_PI / 2.);
+  // The turned box spans [-2; 2] along x.
+  const Isometry apart =
+      Isometry::FromTranslation(Vector3(3.5, 0.5, 0.)) * turned;
+  ConvexContact contact;
+  EXPECT_NEAR(ConvexDistance(box, Isometry(), box, apart, &contact), 0.5,
+              kTolerance);
+  expectContact(contact, 0.5, Vector3::kUnitX);
+  EXPECT_NEAR(contact.point_a.x(), 1., kTolerance);
+  EXPECT_NEAR(contact.point_b.x(), 1.5, kTolerance);
+
+  const Isometry overlapping =
+      Isometry::FromTranslation(Vector3(2.8, 0.5, 0.)) * turned;
+  const ConvexContact deep =
+      ConvexPenetration(box, Isometry(), box, overlapping);
+  expectContact(deep, -0.2, Vector3::kUnitX);
+  EXPECT_NEAR(deep.point_a.x(), 1., kTolerance);
+  EXPECT_NEAR(deep.point_b.x(), 0.8, kTolerance);
+  // Swapped shapes give the opposite normal.
+  expectContact(ConvexPenetration(box, overlapping, box, Isometry()), -0.2,
+                -1. * Vector3::kUnitX);
+
+  // A hull of the corners of the box matches the box.
+  std::vector<Vector3> corners;
+  for (int i = 0; i < 8; ++i) {
+    corners.emplace_back(i & 1 ? 1. : -1., i & 2 ? 2. : -2., i & 4 ? 3. : -3.);
+  }
+  const ConvexShape hull = ConvexShape::Hull(corners);
+  EXPECT_NEAR(ConvexDistance(hull, Isometry(), box, apart), 0.5, kTolerance);
+  expectContact(ConvexPenetration(hull, Isometry(), box, overlapping), -0.2,
+                Vector3::kUnitX);
+}
+
+GTEST_TEST(GjkTest, Capsules) {
+  const ConvexShape capsule = ConvexShape::Capsule(2., 0.5);
+  // Parallel, side by side, and end to end.
+  const Isometry side = Isometry::FromTranslation(Vector3(3., 0., 1.));
+  EXPECT_NEAR(ConvexDistance(capsule, Isometry(), capsule, side), 2.,
+              kTolerance);
+  const Isometry end = Isometry::FromTranslation(Vector3(0., 0., 5.2));
+  EXPECT_NEAR(ConvexDistance(capsule, Isometry(), capsule, end), 0.2,
+              kTolerance);
+  // Crossing at right angles, 0.8 apart, so overlapping by 0.2.
+  const Isometry crossing = Isometry::FromTranslation(Vector3(0.8, 0., 0.)) *
+                            Isometry::RotateAround(Vector3::kUnitX, M_PI / 2.);
+  expectContact(ConvexPenetration(capsule, Isometry(), capsule, crossing),
+                -0.2, Vector3::kUnitX);
+  // Cores crossing, which only touch, so the depth is both radii.
+  const Isometry through = Isometry::RotateAround(Vector3::kUnitX, M_PI / 2.);
+  EXPECT_NEAR(ConvexPenetration(capsule, Isometry(), capsule, through).distance,
+              -1., kTolerance);
+  // Against a box face.
+  const ConvexShape box = ConvexShape::Box(Vector3(5., 5., 1.));
+  const Isometry above = Isometry::FromTranslation(Vector3(1., 1., 3.2));
+  expectContact(ConvexPenetration(box, Isometry(), capsule, above), -0.3,
+                Vector3::kUnitZ);
+}
+
+GTEST_TEST(GjkTest, RandomHulls) {
+  // The contact normal separates the shapes by the distance, and when they
+  // overlap no other direction separates them with less overlap.
+  std::mt19937 generator(53);
+  std::uniform_real_distribution<double> unit(-1., 1.);
+  int apart = 0;
+  int overlapping = 0;
+  for (int i = 0; i < 300; ++i) {
+    const ConvexShape a = makeHull(&generator);
+    const ConvexShape b = i % 3 == 0 ? ConvexShape::Capsule(0.5, 0.3)
+                                     : makeHull(&generator);
+    const Isometry pose_a = makePose(&generator, 1.5);
+    const Isometry pose_b = makePose(&generator, 1.5);
+    const ConvexContact contact = ConvexPenetration(a, pose_a, b, pose_b);
+    EXPECT_NEAR(contact.normal.norm(), 1., kTolerance);
+    EXPECT_NEAR(gapAlong(a, pose_a, b, pose_b, contact.normal),
+                contact.distance, 1e-7);
+    const Vector3 gap = contact.point_b - contact.point_a;
+    for (int k = 0; k < 3; ++k) {
+      EXPECT_NEAR(gap[k], contact.distance * contact.normal[k], 1e-7);
+    }
+    if (contact.distance > 0.) {
+      ++apart;
+      EXPECT_NEAR(ConvexDistance(a, pose_a, b, pose_b), contact.distance,
+                  kTolerance);
+      continue;
+    }
+    ++overlapping;
+    EXPECT_EQ(ConvexDistance(a, pose_a, b, pose_b), 0.);
+    for (int k = 0; k < 50; ++k) {
+      Vector3 direction(unit(generator), unit(generator), unit(generator));
+      direction = (1. / direction.norm()) * direction;
+      EXPECT_LE(gapAlong(a, pose_a, b, pose_b, direction),
+                contact.distance + 1e-7);
+    }
+  }
+  EXPECT_GT(apart, 50);
+  EXPECT_GT(overlapping, 50);
+}
+
+GTEST_TEST(GjkTest, WarmStart) {
+  // A box sliding past a hull: warm started queries agree with cold ones
+  // and take fewer iterations.
+  std::mt19937 generator(59);
+  const ConvexShape hull = makeHull(&generator);
+  const ConvexShape box = ConvexShape::Box(Vector3(0.5, 0.3, 0.2));
+  GjkCache cache;
+  EXPECT_EQ(cache.size, 0);
+  int cold_iterations = 0;
+  int warm_iterations = 0;
+  for (int frame = 0; frame < 200; ++frame) {
+    const Isometry pose =
+        Isometry::FromTranslation(Vector3(-2. + 0.02 * frame, 1.2, 0.1)) *
+        Isometry::RotateAround(Vector3(1., 2., 3.), 0.01 * frame);
+    const ConvexContact cold = ConvexPenetration(hull, Isometry(), box, pose);
+    const ConvexContact warm =
+        ConvexPenetration(hull, Isometry(), box, pose, &cache);
+    EXPECT_GT(cache.size, 0);
+    EXPECT_NEAR(warm.distance, cold.distance, 1e-7);
+    ConvexContact nearest;
+    if (ConvexDistance(hull, Isometry(), box, pose, &nearest, &cache) > 0.) {
+      EXPECT_NEAR(nearest.distance, cold.distance, kTolerance);
+      cold_iterations += cold.iterations;
+      warm_iterations += nearest.iterations;
+    }
+  }
+  EXPECT_GT(cold_iterations, 0);
+  EXPECT_LT(warm_iterations, cold_iterations);
+}
+
+}  // namespace test
+}  // namespace math
+}  // namespace ekumen
+
+int main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
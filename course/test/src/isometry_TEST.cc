@@ -7,7 +7,10 @@
 #include "vector3.h"
 
 #include <cmath>
+#include <cstddef>
 #include <sstream>
+#include <stdexcept>
+#include <vector>
 
 #include "gtest/gtest.h"
 
@@ -59,6 +62,64 @@ GTEST_TEST(IsometryTest, Serialize) {
             "[0.382683432, 0.923879533, 0], [0, 0, 1]]]");
 }
 
+GTEST_TEST(IsometryTest, IndexedTransforms) {
+  const Isometry pose = Isometry::FromTranslation(Vector3(1., -2., 0.5)) *
+                        Isometry::RotateAround(Vector3(1., 2., 3.), 0.7);
+  std::vector<double> cloud;
+  for (int i = 0; i < 100; ++i) {
+    cloud.insert(cloud.end(), {1. * i, -0.5 * i, 0.25 * i, -1.});
+  }
+  const ConstPointsView input(cloud.data(), 100, 4);
+  const std::vector<std::size_t> indices{99, 3, 50, 3, 0, 42};
+
+  // Every prefetch distance, including none and beyond the indices.
+  const std::vector<std::size_t> distances{0, 1, Isometry::kPrefetchDistance,
+                                           1000};
+  for (std::size_t distance : distances) {
+    std::vector<double> gathered(3 * indices.size());
+    pose.transformGather(input, indices, PointsView(gathered.data(), 6),
+                         distance);
+    for (std::size_t k = 0; k < indices.size(); ++k) {
+      const Vector3 expected = pose * Vector3(input[indices[k]]);
+      for (int j = 0; j < 3; ++j) {
+        EXPECT_NEAR(gathered[3 * k + j], expected[j], kTolerance);
+      }
+    }
+
+    std::vector<double> scattered(cloud);
+    const std::vector<std::size_t> unique{99, 3, 50, 0};
+    pose.transformScatter(ConstPointsView(cloud.data(), 4, 4), unique,
+                          PointsView(scattered.data(), 100, 4), distance);
+    for (std::size_t k = 0; k < unique.size(); ++k) {
+      EXPECT_EQ(Vector3(PointsView(scattered.data(), 100, 4)[unique[k]]),
+                pose * Vector3(input[k]));
+    }
+    EXPECT_EQ(Vector3(PointsView(scattered.data(), 100, 4)[1]),
+              Vector3(input[1]));
+
+    std::vector<double> updated(cloud);
+    const PointsView points(updated.data(), 100, 4);
+    pose.transform(points, indices, distance);
+    EXPECT_EQ(Vector3(points[99]), pose * Vector3(input[99]));
+    EXPECT_EQ(Vector3(points[3]), pose * (pose * Vector3(input[3])));
+    EXPECT_EQ(Vector3(points[4]), Vector3(input[4]));
+    EXPECT_EQ(updated[3], -1.);
+  }
+
+  std::vector<double> output(18);
+  EXPECT_THROW(pose.transformGather(input, indices,
+                                    PointsView(output.data(), 5)),
+               std::invalid_argument);
+  EXPECT_THROW(pose.transformGather(input, {0, 100},
+                                    PointsView(output.data(), 2)),
+               std::out_of_range);
+  EXPECT_THROW(pose.transformScatter(ConstPointsView(output.data(), 2), {0},
+                                     PointsView(cloud.data(), 100, 4)),
+               std::invalid_argument);
+  EXPECT_THROW(pose.transform(PointsView(output.data(), 6), {6}),
+               std::out_of_range);
+}
+
 }  // namespace test
 }  // namespace math
 }  // namespace ekumen
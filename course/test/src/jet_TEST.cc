@@ -0,0 +1,79 @@
+#include "jet.h"
+
+#include <cmath>
+
+#include "gtest/gtest.h"
+
+namespace ekumen {
+namespace math {
+namespace test {
+namespace {
+constexpr double kTolerance{1e-12};
+}  // namespace
+
+GTEST_TEST(JetTest, Constructors) {
+  const Jet<2> c(3.);
+  EXPECT_EQ(c.a, 3.);
+  EXPECT_EQ(c.v[0], 0.);
+  EXPECT_EQ(c.v[1], 0.);
+
+  const Jet<2> x(5., 1);
+  EXPECT_EQ(x.a, 5.);
+  EXPECT_EQ(x.v[0], 0.);
+  EXPECT_EQ(x.v[1], 1.);
+}
+
+GTEST_TEST(JetTest, Arithmetic) {
+  const Jet<2> x(2., 0);
+  const Jet<2> y(3., 1);
+
+  const Jet<2> f = x * y + 2. * x - y / x + 1.;
+  EXPECT_NEAR(f.a, 6. + 4. - 1.5 + 1., kTolerance);
+  // df/dx = y + 2 + y / x^2, df/dy = x - 1 / x.
+  EXPECT_NEAR(f.v[0], 3. + 2. + 3. / 4., kTolerance);
+  EXPECT_NEAR(f.v[1], 2. - 0.5, kTolerance);
+
+  const Jet<2> g = 1. / (x - y);
+  EXPECT_NEAR(g.a, -1., kTolerance);
+  EXPECT_NEAR(g.v[0], -1., kTolerance);
+  EXPECT_NEAR(g.v[1], 1., kTolerance);
+
+  Jet<2> h = -x;
+  h += y;
+  h *= x;
+  EXPECT_NEAR(h.a, 2., kTolerance);
+  // h = (y - x) * x: dh/dx = y - 2x, dh/dy = x.
+  EXPECT_NEAR(h.v[0], -1., kTolerance);
+  EXPECT_NEAR(h.v[1], 2., kTolerance);
+}
+
+GTEST_TEST(JetTest, ElementaryFunctions) {
+  const Jet<1> x(0.7, 0);
+  EXPECT_NEAR(sin(x).v[0], std::cos(0.7), kTolerance);
+  EXPECT_NEAR(cos(x).v[0], -std::sin(0.7), kTolerance);
+  EXPECT_NEAR(sqrt(x).v[0], 0.5 / std::sqrt(0.7), kTolerance);
+  EXPECT_NEAR(abs(-x).v[0], 1., kTolerance);
+
+  const Jet<2> y(1.5, 0);
+  const Jet<2> z(-0.5, 1);
+  const Jet<2> angle = atan2(y, z);
+  EXPECT_NEAR(angle.a, std::atan2(1.5, -0.5), kTolerance);
+  EXPECT_NEAR(angle.v[0], -0.5 / 2.5, kTolerance);
+  EXPECT_NEAR(angle.v[1], -1.5 / 2.5, kTolerance);
+}
+
+GTEST_TEST(JetTest, Comparisons) {
+  const Jet<1> x(1., 0);
+  EXPECT_TRUE(x < 2.);
+  EXPECT_TRUE(x > Jet<1>(0.));
+  EXPECT_FALSE(x < Jet<1>(0.5));
+}
+
+}  // namespace test
+}  // namespace math
+}  // namespace ekumen
+
+int main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
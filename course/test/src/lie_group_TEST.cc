@@ -0,0 +1,131 @@
+#include "lie_group.h"
+#include "isometry.h"
+#include "matrix.h"
+#include "matrix3.h"
+#include "vector3.h"
+
+#include <cmath>
+
+#include "gtest/gtest.h"
+
+namespace ekumen {
+namespace math {
+namespace test {
+namespace {
+constexpr double kTolerance{1e-12};
+
+void expectNear(const Vector3& a, const Vector3& b, const double& tolerance) {
+  for (int i = 0; i < 3; ++i) {
+    EXPECT_NEAR(a[i], b[i], tolerance);
+  }
+}
+
+void expectNear(const Matrix3& a, const Matrix3& b, const double& tolerance) {
+  for (int i = 0; i < 3; ++i) {
+    expectNear(a[i], b[i], tolerance);
+  }
+}
+}  // namespace
+
+GTEST_TEST(SO3Test, HatVee) {
+  const Vector3 w(1., 2., 3.);
+  const Vector3 v(-4., 5., 0.5);
+  expectNear(SO3::Hat(w).product(v), w.cross(v), kTolerance);
+  expectNear(SO3::Vee(SO3::Hat(w)), w, kTolerance);
+}
+
+GTEST_TEST(SO3Test, ExpMatchesRotateAround) {
+  const Vector3 axis = Vector3(1., -2., 0.5) / Vector3(1., -2., 0.5).norm();
+  const double angle = 1.3;
+  expectNear(SO3::Exp(axis * angle),
+             Isometry::RotateAround(axis, angle).rotation(), kTolerance);
+  expectNear(SO3::Exp(Vector3::kZero), Matrix3::kIdentity, kTolerance);
+}
+
+GTEST_TEST(SO3Test, LogInvertsExp) {
+  const Vector3 axis = Vector3(0.3, 0.4, -1.2) / Vector3(0.3, 0.4, -1.2).norm();
+  for (const double angle : {0., 1e-9, 1e-4, 0.1, 1., 2.5, 3., M_PI - 1e-6}) {
+    expectNear(SO3::Log(SO3::Exp(axis * angle)), axis * angle, 1e-9);
+  }
+  const Vector3 w = SO3::Log(SO3::Exp(Vector3::kUnitZ * M_PI));
+  EXPECT_NEAR(w.norm(), M_PI, kTolerance);
+  expectNear(SO3::Exp(w), SO3::Exp(Vector3::kUnitZ * M_PI), kTolerance);
+}
+
+GTEST_TEST(SO3Test, JacobiansAreConsistent) {
+  for (const Vector3& w :
+       {Vector3(0.2, -0.7, 1.1), Vector3(1e-7, 2e-7, -1e-7), Vector3::kZero}) {
+    expectNear(SO3::LeftJacobian(w).product(SO3::LeftJacobianInverse(w)),
+               Matrix3::kIdentity, 1e-10);
+    expectNear(SO3::RightJacobian(w).product(SO3::RightJacobianInverse(w)),
+               Matrix3::kIdentity, 1e-10);
+    // Jl(w) = R(w) * Jr(w).
+    expectNear(SO3::LeftJacobian(w),
+               SO3::Exp(w).product(SO3::RightJacobian(w)), 1e-10);
+  }
+}
+
+GTEST_TEST(SO3Test, RightJacobianFirstOrder) {
+  const Vector3 w(0.4, -0.3, 0.9);
+  const Vector3 d(1e-6, -2e-6, 1.5e-6);
+  const Matrix3 lhs = SO3::Exp(w + d);
+  const Matrix3 rhs =
+      SO3::Exp(w).product(SO3::Exp(SO3::RightJacobian(w).product(d)));
+  expectNear(lhs, rhs, 1e-11);
+}
+
+GTEST_TEST(SE3Test, ExpLogRoundTrip) {
+  const Vector3 rho(1., -2., 0.5);
+  const Vector3 omega(0.3, 0.1, -0.8);
+  const Isometry pose = SE3::Exp(rho, omega);
+  Vector3 rho_res;
+  Vector3 omega_res;
+  SE3::Log(pose, &rho_res, &omega_res);
+  expectNear(rho_res, rho, 1e-10);
+  expectNear(omega_res, omega, 1e-10);
+
+  const Isometry translation = SE3::Exp(rho, Vector3::kZero);
+  EXPECT_EQ(translation, Isometry::FromTranslation(rho));
+}
+
+GTEST_TEST(SE3Test, Adjoint) {
+  const Isometry pose = SE3::Exp(Vector3(0.5, -1., 2.), Vector3(0.2, 0.3, -0.4));
+  const Vector3 rho(0.1, 0.2, -0.3);
+  const Vector3 omega(-0.2, 0.1, 0.25);
+  const Vector6 mapped = SE3::Adjoint(pose) * Stack(rho, omega);
+  const Isometry lhs = pose * SE3::Exp(rho, omega);
+  const Isometry rhs = SE3::Exp(mapped.segment3(0), mapped.segment3(3)) * pose;
+  expectNear(lhs.translation(), rhs.translation(), 1e-12);
+  expectNear(lhs.rotation(), rhs.rotation(), 1e-12);
+}
+
+GTEST_TEST(SE3Test, JacobiansFirstOrder) {
+  const Vector6 d = Stack(Vector3(1e-6, -2e-6, 0.5e-6), Vector3(-1e-6, 1e-6, 2e-6));
+  for (const double scale : {1., 1e-3, 0.}) {
+    const Vector3 rho = Vector3(0.7, -0.4, 1.2) * (scale == 0. ? 1. : scale);
+    const Vector3 omega = Vector3(0.5, 0.3, -0.6) * scale;
+    const Isometry perturbed =
+        SE3::Exp(rho + d.segment3(0), omega + d.segment3(3));
+
+    const Vector6 left = SE3::LeftJacobian(rho, omega) * d;
+    const Isometry left_approx =
+        SE3::Exp(left.segment3(0), left.segment3(3)) * SE3::Exp(rho, omega);
+    expectNear(perturbed.translation(), left_approx.translation(), 1e-11);
+    expectNear(perturbed.rotation(), left_approx.rotation(), 1e-11);
+
+    const Vector6 right = SE3::RightJacobian(rho, omega) * d;
+    const Isometry right_approx =
+        SE3::Exp(rho, omega) * SE3::Exp(right.segment3(0), right.segment3(3));
+    expectNear(perturbed.translation(), right_approx.translation(), 1e-11);
+    expectNear(perturbed.rotation(), right_approx.rotation(), 1e-11);
+  }
+}
+
+}  // namespace test
+}  // namespace math
+}  // namespace ekumen
+
+int main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
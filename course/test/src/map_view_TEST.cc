@@ -0,0 +1,158 @@
+#include "map_view.h"
+#include "isometry.h"
+#include "matrix3.h"
+#include "vector3.h"
+
+#include <cmath>
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace ekumen {
+namespace math {
+namespace test {
+namespace {
+constexpr double kTolerance{1e-12};
+
+Isometry makePose() {
+  return Isometry::FromTranslation(Vector3(-1., 0.5, 3.)) *
+         Isometry::RotateAround(Vector3(1., 2., 3.), 1.2);
+}
+}  // namespace
+
+GTEST_TEST(MapViewTest, Vector3Map) {
+  double data[4] = {1., 2., 3., 4.};
+  Vector3Map map(data + 1);
+  EXPECT_EQ(map.data(), data + 1);
+  EXPECT_EQ(map, Vector3(2., 3., 4.));
+  EXPECT_EQ(map[2], 4.);
+  EXPECT_THROW(map[3], std::out_of_range);
+
+  // Arithmetic on both sides, with vectors and other maps.
+  const Vector3 v(1., 1., 2.);
+  EXPECT_EQ(map + v, Vector3(3., 4., 6.));
+  EXPECT_EQ(v + map, Vector3(3., 4., 6.));
+  EXPECT_EQ(map - map, Vector3::kZero);
+  EXPECT_EQ(map * v, Vector3(2., 3., 8.));
+  EXPECT_EQ(map / v, Vector3(2., 3., 2.));
+  EXPECT_EQ(2. * map, Vector3(4., 6., 8.));
+  EXPECT_EQ(map / 2., Vector3(1., 1.5, 2.));
+  EXPECT_EQ(map.dot(v), 13.);
+  EXPECT_EQ(v.dot(map), 13.);
+  EXPECT_EQ(map.cross(v), Vector3(2., 3., 4.).cross(v));
+  EXPECT_NEAR(map.norm(), std::sqrt(29.), kTolerance);
+  std::ostringstream os;
+  os << map;
+  EXPECT_EQ(os.str(), "(x: 2, y: 3, z: 4)");
+
+  // Writes go through to the buffer.
+  map += v;
+  EXPECT_EQ(data[3], 6.);
+  map *= 0.5;
+  map.x() = -1.;
+  EXPECT_EQ(Vector3(data[1], data[2], data[3]), Vector3(-1., 2., 3.));
+  EXPECT_EQ(data[0], 1.);
+
+  // Copies share the buffer, assignments copy values.
+  Vector3Map copy(map);
+  copy.y() = 7.;
+  EXPECT_EQ(data[2], 7.);
+  double other_data[3] = {0., 0., 0.};
+  Vector3Map other(other_data);
+  other = map;
+  EXPECT_EQ(Vector3(other_data[0], other_data[1], other_data[2]),
+            Vector3(-1., 7., 3.));
+  other.x() = 5.;
+  EXPECT_EQ(data[1], -1.);
+
+  const ConstVector3Map read_only = map;
+  EXPECT_EQ(read_only, Vector3(-1., 7., 3.));
+}
+
+GTEST_TEST(MapViewTest, Matrix3Map) {
+  double data[9] = {1., 2., 3., 0., 1., 4., 5., 6., 0.};
+  const Matrix3 matrix{1., 2., 3., 0., 1., 4., 5., 6., 0.};
+  Matrix3Map map(data);
+  EXPECT_EQ(map, matrix);
+  EXPECT_EQ(map.row(1), Vector3(0., 1., 4.));
+  EXPECT_EQ(map.col(1), Vector3(2., 1., 6.));
+  EXPECT_THROW(map[3], std::out_of_range);
+  EXPECT_NEAR(map.det(), matrix.det(), kTolerance);
+  EXPECT_EQ(map.inverse(), matrix.inverse());
+  EXPECT_EQ(map.transpose(), matrix.transpose());
+  EXPECT_EQ(map.product(matrix), matrix.product(matrix));
+  EXPECT_EQ(matrix.product(map), matrix.product(matrix));
+  EXPECT_EQ(map.product(Vector3(1., 2., 3.)),
+            matrix.product(Vector3(1., 2., 3.)));
+  EXPECT_EQ(map + map, 2. * matrix);
+  EXPECT_EQ(map * matrix, matrix * matrix);
+
+  // Rows are writable maps.
+  map[2][2] = 9.;
+  EXPECT_EQ(data[8], 9.);
+  map = Matrix3::kIdentity;
+  EXPECT_EQ(data[4], 1.);
+  EXPECT_EQ(data[5], 0.);
+
+  // Isometries take maps of their parts.
+  double pose[12] = {1., 2., 3., 0., -1., 0., 1., 0., 0., 0., 0., 1.};
+  const Isometry isometry(ConstVector3Map(pose), ConstMatrix3Map(pose + 3));
+  EXPECT_EQ(isometry * Vector3(1., 0., 0.), Vector3(1., 3., 3.));
+  EXPECT_EQ(isometry * Vector3Map(pose), Vector3(-1., 3., 6.));
+}
+
+GTEST_TEST(MapViewTest, PointsView) {
+  // xyzrgb records.
+  std::vector<double> records;
+  for (int i = 0; i < 5; ++i) {
+    records.insert(records.end(), {1. * i, 2. * i, 3. * i, 0.1, 0.2, 0.3});
+  }
+  const PointsView view(records.data(), 5, 6);
+  EXPECT_EQ(view.size(), 5u);
+  EXPECT_EQ(view.stride(), 6u);
+  EXPECT_EQ(view[3], Vector3(3., 6., 9.));
+  EXPECT_THROW(view.at(5), std::out_of_range);
+  EXPECT_THROW(PointsView(records.data(), 5, 2), std::invalid_argument);
+  int count = 0;
+  for (Vector3Map point : view) {
+    EXPECT_EQ(point, Vector3(count, 2. * count, 3. * count));
+    ++count;
+  }
+  EXPECT_EQ(count, 5);
+
+  const Isometry pose = makePose();
+  const std::vector<double> original = records;
+  pose.transform(view);
+  for (int i = 0; i < 5; ++i) {
+    const Vector3 expected = pose * Vector3(i, 2. * i, 3. * i);
+    for (int j = 0; j < 3; ++j) {
+      EXPECT_NEAR(records[6 * i + j], expected[j], kTolerance);
+    }
+    // Colors are untouched.
+    for (int j = 3; j < 6; ++j) {
+      EXPECT_EQ(records[6 * i + j], original[6 * i + j]);
+    }
+  }
+
+  // Packed output from strided input.
+  const ConstPointsView input(original.data(), 5, 6);
+  std::vector<double> output(15);
+  pose.transform(input, PointsView(output.data(), 5));
+  for (int i = 0; i < 5; ++i) {
+    EXPECT_EQ(ConstVector3Map(output.data() + 3 * i), view[i]);
+  }
+  EXPECT_THROW(pose.transform(input, PointsView(output.data(), 4)),
+               std::invalid_argument);
+  EXPECT_TRUE(ConstPointsView().empty());
+}
+
+}  // namespace test
+}  // namespace math
+}  // namespace ekumen
+
+int main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
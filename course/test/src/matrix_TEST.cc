@@ -0,0 +1,108 @@
+#include "matrix.h"
+#include "jet.h"
+#include "matrix3.h"
+#include "vector3.h"
+
+#include <sstream>
+#include <stdexcept>
+
+#include "gtest/gtest.h"
+
+namespace ekumen {
+namespace math {
+namespace test {
+namespace {
+constexpr double kTolerance{1e-12};
+}  // namespace
+
+GTEST_TEST(MatrixTest, Constructors) {
+  const Matrix<2, 3> zero;
+  for (int i = 0; i < 6; ++i) {
+    EXPECT_EQ(zero.data()[i], 0.);
+  }
+  const Matrix<2, 3> m{1., 2., 3., 4., 5., 6.};
+  EXPECT_EQ(m(1, 0), 4.);
+  EXPECT_EQ(m.at(0, 2), 3.);
+  EXPECT_EQ(Matrix3d::Identity(), ToMatrix(Matrix3::kIdentity));
+  ASSERT_THROW((Matrix<2, 2>{1., 2., 3.}), std::invalid_argument);
+  ASSERT_THROW(m.at(2, 0), std::out_of_range);
+}
+
+GTEST_TEST(MatrixTest, Operations) {
+  const Matrix<2, 2> a{1., 2., 3., 4.};
+  const Matrix<2, 2> b{5., 6., 7., 8.};
+  EXPECT_EQ(a + b, (Matrix<2, 2>{6., 8., 10., 12.}));
+  EXPECT_EQ(b - a, (Matrix<2, 2>{4., 4., 4., 4.}));
+  EXPECT_EQ(2. * a, (Matrix<2, 2>{2., 4., 6., 8.}));
+  EXPECT_EQ(a / 2., (Matrix<2, 2>{.5, 1., 1.5, 2.}));
+  EXPECT_EQ(-a, (Matrix<2, 2>{-1., -2., -3., -4.}));
+  EXPECT_EQ(a * b, (Matrix<2, 2>{19., 22., 43., 50.}));
+  EXPECT_EQ(a.transpose(), (Matrix<2, 2>{1., 3., 2., 4.}));
+  EXPECT_TRUE(a != b);
+}
+
+GTEST_TEST(MatrixTest, RectangularProducts) {
+  const Matrix<2, 3> a{1., 2., 3., 4., 5., 6.};
+  const Matrix<3, 1> v{1., 0., -1.};
+  EXPECT_EQ(a * v, (Matrix<2, 1>{-2., -2.}));
+  EXPECT_EQ(a * a.transpose(), (Matrix<2, 2>{14., 32., 32., 77.}));
+
+  // Larger than one multiplication panel.
+  Matrix<20, 20> big;
+  for (int i = 0; i < 20; ++i) {
+    for (int j = 0; j < 20; ++j) {
+      big(i, j) = i + 0.5 * j;
+    }
+  }
+  const Matrix<20, 20> product = big * Matrix<20, 20>::Identity();
+  EXPECT_EQ(product, big);
+}
+
+GTEST_TEST(MatrixTest, MatchesMatrix3) {
+  const Matrix3 m1{1., 2., 3., 4., 5., 6., 7., 8., 10.};
+  const Matrix3 m2{-1., 0.5, 2., 3., 1., -2., 0., 4., 1.};
+  const Vector3 v(1., -2., 3.);
+  EXPECT_EQ((ToMatrix(m1) * ToMatrix(m2)).block3(0, 0), m1.product(m2));
+  EXPECT_EQ((ToMatrix(m1) * ToMatrix(v)).segment3(0), m1.product(v));
+}
+
+GTEST_TEST(MatrixTest, Blocks) {
+  Matrix6 m;
+  m.setBlock(3, 0, Matrix3::kOnes);
+  m.setBlock<2, 2>(0, 4, Matrix<2, 2>{1., 2., 3., 4.});
+  EXPECT_EQ(m.block3(3, 0), Matrix3::kOnes);
+  EXPECT_EQ(m(1, 5), 4.);
+  EXPECT_EQ((m.block<2, 2>(0, 4)), (Matrix<2, 2>{1., 2., 3., 4.}));
+  ASSERT_THROW(m.block3(4, 4), std::out_of_range);
+
+  const Vector6 twist = Stack(Vector3(1., 2., 3.), Vector3(4., 5., 6.));
+  EXPECT_EQ(twist.segment3(3), Vector3(4., 5., 6.));
+}
+
+GTEST_TEST(MatrixTest, JetScalar) {
+  // d/dx of [x, 2; 3, x] * [1; x] = [2x + 2... ] evaluated at x = 2.
+  const Jet<1> x(2., 0);
+  const Matrix<2, 2, Jet<1>> a{x, Jet<1>(2.), Jet<1>(3.), x};
+  const Matrix<2, 1, Jet<1>> v{Jet<1>(1.), x};
+  const Matrix<2, 1, Jet<1>> res = a * v;
+  // res = [x + 2x, 3 + x^2].
+  EXPECT_NEAR(res(0, 0).a, 6., kTolerance);
+  EXPECT_NEAR(res(0, 0).v[0], 3., kTolerance);
+  EXPECT_NEAR(res(1, 0).a, 7., kTolerance);
+  EXPECT_NEAR(res(1, 0).v[0], 4., kTolerance);
+}
+
+GTEST_TEST(MatrixTest, Serialize) {
+  std::stringstream ss;
+  ss << Matrix<2, 2>{1., 0.5, 0., 1.};
+  EXPECT_EQ(ss.str(), "[[1, 0.5], [0, 1]]");
+}
+
+}  // namespace test
+}  // namespace math
+}  // namespace ekumen
+
+int main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
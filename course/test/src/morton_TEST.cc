@@ -0,0 +1,181 @@
+#include "morton.h"
+#include "point_cloud.h"
+#include "vector3.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <numeric>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace ekumen {
+namespace math {
+namespace test {
+namespace {
+PointCloud makeCloud(std::size_t size) {
+  std::mt19937 generator(3);
+  std::uniform_real_distribution<double> distribution(-100., 100.);
+  PointCloud res(size);
+  for (std::size_t i = 0; i < size; ++i) {
+    res.setPoint(i, Vector3(distribution(generator), distribution(generator),
+                            0.01 * distribution(generator)));
+  }
+  return res;
+}
+}  // namespace
+
+GTEST_TEST(MortonTest, EncodeDecode) {
+  EXPECT_EQ(MortonEncode(0, 0, 0), 0u);
+  EXPECT_EQ(MortonEncode(1, 0, 0), 1u);
+  EXPECT_EQ(MortonEncode(0, 1, 0), 2u);
+  EXPECT_EQ(MortonEncode(0, 0, 1), 4u);
+  EXPECT_EQ(MortonEncode(3, 0, 1), 0xdu);
+  const std::uint32_t kMax = (1u << kMortonBits) - 1;
+  EXPECT_EQ(MortonEncode(kMax, kMax, kMax), (std::uint64_t{1} << 63) - 1);
+  // Bits above the 21st are ignored.
+  EXPECT_EQ(MortonEncode(kMax + 2, 0, 0), 1u);
+
+  std::mt19937 generator(5);
+  std::uniform_int_distribution<std::uint32_t> distribution(0, kMax);
+  for (int i = 0; i < 1000; ++i) {
+    const std::uint32_t x = distribution(generator);
+    const std::uint32_t y = distribution(generator);
+    const std::uint32_t z = distribution(generator);
+    std::uint32_t dx, dy, dz;
+    MortonDecode(MortonEncode(x, y, z), &dx, &dy, &dz);
+    EXPECT_EQ(dx, x);
+    EXPECT_EQ(dy, y);
+    EXPECT_EQ(dz, z);
+  }
+}
+
+GTEST_TEST(MortonTest, Codes) {
+  const std::vector<Vector3> points{
+      Vector3(0., 0., 0.),
+      Vector3(1., 1., 1.),
+      Vector3(0.5, 0., 1.),
+      Vector3(-3., 2., std::nan("")),
+  };
+  std::vector<std::uint64_t> codes;
+  MortonCodes(PointCloud(points), Vector3::kZero, Vector3(1., 1., 1.), &codes);
+  const std::uint32_t kMax = (1u << kMortonBits) - 1;
+  ASSERT_EQ(codes.size(), 4u);
+  EXPECT_EQ(codes[0], 0u);
+  EXPECT_EQ(codes[1], MortonEncode(kMax, kMax, kMax));
+  EXPECT_EQ(codes[2], MortonEncode(1u << (kMortonBits - 1), 0, kMax));
+  EXPECT_EQ(codes[3], MortonEncode(0, kMax, 0));
+
+  // Flat boxes put every point in cell 0 of that axis.
+  MortonCodes(PointCloud(points), Vector3::kZero, Vector3(1., 0., 1.), &codes);
+  EXPECT_EQ(codes[1], MortonEncode(kMax, 0, kMax));
+  EXPECT_THROW(MortonCodes(PointCloud(points), Vector3::kUnitX, Vector3::kZero,
+                           &codes),
+               std::invalid_argument);
+}
+
+GTEST_TEST(MortonTest, RadixSort) {
+  std::mt19937_64 generator(11);
+  for (int num_bits : {1, 11, 20, 63, 64}) {
+    for (int num_threads : {1, 3}) {
+      const std::uint64_t mask =
+          num_bits == 64 ? ~std::uint64_t{0}
+                         : (std::uint64_t{1} << num_bits) - 1;
+      std::vector<std::uint64_t> keys(200000);
+      for (std::uint64_t& key : keys) {
+        key = generator() & mask;
+      }
+      std::vector<std::size_t> expected(keys.size());
+      std::iota(expected.begin(), expected.end(), std::size_t{0});
+      std::stable_sort(expected.begin(), expected.end(),
+                       [&keys](std::size_t a, std::size_t b) {
+                         return keys[a] < keys[b];
+                       });
+      const std::vector<std::uint64_t> original = keys;
+      EXPECT_EQ(RadixSort(&keys, num_bits, num_threads), expected);
+      ASSERT_TRUE(std::is_sorted(keys.begin(), keys.end()));
+      EXPECT_EQ(keys[0], original[expected[0]]);
+    }
+  }
+  // Passes over digits shared by all keys are skipped.
+  std::vector<std::uint64_t> keys{7, 1ull << 40 | 3, 5, 3, 1ull << 40 | 1};
+  EXPECT_EQ(RadixSort(&keys), std::vector<std::size_t>({3, 2, 0, 4, 1}));
+  keys.clear();
+  EXPECT_TRUE(RadixSort(&keys).empty());
+  EXPECT_THROW(RadixSort(&keys, 0), std::invalid_argument);
+  EXPECT_THROW(RadixSort(&keys, 65), std::invalid_argument);
+}
+
+GTEST_TEST(MortonTest, MortonSort) {
+  const PointCloud original = makeCloud(100000);
+  PointCloud cloud = original;
+  std::vector<int> ids(cloud.size());
+  std::iota(ids.begin(), ids.end(), 0);
+  const std::vector<std::size_t> order = MortonSort(&cloud, 2);
+  ApplyPermutation(order, &ids);
+  ASSERT_EQ(cloud.size(), original.size());
+  for (std::size_t i = 0; i < cloud.size(); ++i) {
+    EXPECT_EQ(cloud.point(i), original.point(ids[i]));
+  }
+
+  // Codes in the same box come out sorted.
+  Vector3 min(original.x()[0], original.y()[0], original.z()[0]);
+  Vector3 max = min;
+  for (std::size_t i = 0; i < original.size(); ++i) {
+    for (int axis = 0; axis < 3; ++axis) {
+      const double value = original.point(i)[axis];
+      min[axis] = std::min(min[axis], value);
+      max[axis] = std::max(max[axis], value);
+    }
+  }
+  std::vector<std::uint64_t> codes;
+  MortonCodes(cloud, min, max, &codes);
+  EXPECT_TRUE(std::is_sorted(codes.begin(), codes.end()));
+
+  // Consecutive points are much closer than in the input order.
+  double input_gaps = 0.;
+  double sorted_gaps = 0.;
+  for (std::size_t i = 1; i < cloud.size(); ++i) {
+    input_gaps += (original.point(i) - original.point(i - 1)).norm();
+    sorted_gaps += (cloud.point(i) - cloud.point(i - 1)).norm();
+  }
+  EXPECT_LT(sorted_gaps, 0.05 * input_gaps);
+
+  PointCloud empty;
+  EXPECT_TRUE(MortonSort(&empty).empty());
+  std::vector<int> values(3);
+  EXPECT_THROW(ApplyPermutation(order, &values), std::invalid_argument);
+}
+
+GTEST_TEST(MortonTest, MortonSortNonFinite) {
+  // Non-finite coordinates go to the boundary cells without stretching the
+  // box of the finite ones, which keep the order they have on their own.
+  PointCloud finite = makeCloud(10000);
+  PointCloud cloud = finite;
+  const double inf = std::numeric_limits<double>::infinity();
+  cloud.push_back(Vector3(inf, 0., 0.));
+  cloud.push_back(Vector3(0., -inf, 0.));
+  cloud.push_back(Vector3(0., 0., std::nan("")));
+  const std::vector<std::size_t> finite_order = MortonSort(&finite, 2);
+  const std::vector<std::size_t> order = MortonSort(&cloud, 2);
+  std::vector<std::size_t> kept;
+  for (const std::size_t index : order) {
+    if (index < finite.size()) {
+      kept.push_back(index);
+    }
+  }
+  EXPECT_EQ(kept, finite_order);
+}
+
+}  // namespace test
+}  // namespace math
+}  // namespace ekumen
+
+int main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
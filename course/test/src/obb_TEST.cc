@@ -0,0 +1,189 @@
+#include "aabb.h"
+#include "isometry.h"
+#include "matrix3.h"
+#include "obb.h"
+#include "point_cloud.h"
+#include "vector3.h"
+
+#include <cmath>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace ekumen {
+namespace math {
+namespace test {
+namespace {
+constexpr double kTolerance{1e-12};
+
+Isometry makePose() {
+  return Isometry::FromTranslation(Vector3(1., -2., 0.5)) *
+         Isometry::FromEulerAngles(0.4, -0.3, 1.2);
+}
+
+// Corner 'index' of 'box', with bit i selecting the side along axis i.
+Vector3 corner(const Obb& box, int index) {
+  Vector3 local;
+  for (int i = 0; i < 3; ++i) {
+    local[i] = index & (1 << i) ? box.half_extents[i] : -box.half_extents[i];
+  }
+  return box.center + box.axes.product(local);
+}
+}  // namespace
+
+GTEST_TEST(ObbTest, FromAabb) {
+  EXPECT_TRUE(Obb().empty());
+  EXPECT_EQ(Obb().volume(), 0.);
+  EXPECT_TRUE(Obb().bounds().empty());
+  EXPECT_TRUE(Obb::FromAabb(Aabb()).empty());
+
+  const Aabb box(Vector3(-1., -2., -3.), Vector3(1., 2., 3.));
+  const Obb aligned = Obb::FromAabb(box);
+  EXPECT_FALSE(aligned.empty());
+  EXPECT_NEAR(aligned.volume(), 48., kTolerance);
+  EXPECT_EQ(aligned.bounds().min, box.min);
+  EXPECT_EQ(aligned.bounds().max, box.max);
+
+  // Bounds agree with Aabb::transformed() and contain the corners.
+  const Isometry pose = makePose();
+  const Obb placed = Obb::FromAabb(box, pose);
+  const Aabb bounds = placed.bounds();
+  const Aabb expected = box.transformed(pose);
+  for (int i = 0; i < 3; ++i) {
+    EXPECT_NEAR(bounds.min[i], expected.min[i], kTolerance);
+    EXPECT_NEAR(bounds.max[i], expected.max[i], kTolerance);
+  }
+  for (int i = 0; i < 8; ++i) {
+    EXPECT_LT(bounds.squaredDistance(corner(placed, i)), kTolerance);
+  }
+
+  EXPECT_TRUE(placed.contains(pose * Vector3(0.9, -1.9, 2.9)));
+  EXPECT_FALSE(placed.contains(pose * Vector3(1.1, 0., 0.)));
+  const Obb moved = aligned.transformed(pose);
+  EXPECT_TRUE(moved.contains(pose * Vector3(0.9, -1.9, 2.9)));
+  EXPECT_FALSE(moved.contains(pose * Vector3(0., 0., 3.1)));
+}
+
+GTEST_TEST(ObbTest, Overlaps) {
+  const Obb unit = Obb::FromAabb(Aabb(Vector3(-1., -1., -1.),
+                                      Vector3(1., 1., 1.)));
+  EXPECT_TRUE(unit.overlaps(unit));
+  EXPECT_FALSE(unit.overlaps(Obb()));
+  // Touching faces overlap.
+  EXPECT_TRUE(unit.overlaps(unit.transformed(
+      Isometry::FromTranslation(Vector3(2., 0., 0.)))));
+  EXPECT_FALSE(unit.overlaps(unit.transformed(
+      Isometry::FromTranslation(Vector3(2.01, 0., 0.)))));
+  // A cube turned by 45 degrees reaches sqrt(2) along x.
+  const Isometry turned = Isometry::RotateAround(Vector3::kUnitZ, M_PI / 4.);
+  EXPECT_TRUE(unit.overlaps(unit.transformed(
+      Isometry::FromTranslation(Vector3(2.4, 0., 0.)) * turned)));
+  EXPECT_FALSE(unit.overlaps(unit.transformed(
+      Isometry::FromTranslation(Vector3(2.5, 0., 0.)) * turned)));
+
+  // Crossing rods, each turned around its length, are separated along the
+  // cross product of their lengths, the z axis, or meet at the crossing.
+  const Obb rod(Vector3::kZero, Matrix3::kIdentity, Vector3(5., 0.1, 0.1));
+  const Isometry twist = Isometry::RotateAround(Vector3::kUnitX, M_PI / 4.);
+  const Obb first =
+      rod.transformed(Isometry::RotateAround(Vector3::kUnitZ, M_PI / 4.) *
+                      twist);
+  const Obb above =
+      rod.transformed(Isometry::FromTranslation(Vector3(0., 0., 0.3)) *
+                      Isometry::RotateAround(Vector3::kUnitZ, -M_PI / 4.) *
+                      twist);
+  const Obb close =
+      rod.transformed(Isometry::FromTranslation(Vector3(0., 0., 0.25)) *
+                      Isometry::RotateAround(Vector3::kUnitZ, -M_PI / 4.) *
+                      twist);
+  EXPECT_FALSE(first.overlaps(above));
+  EXPECT_FALSE(above.overlaps(first));
+  EXPECT_TRUE(first.overlaps(close));
+  EXPECT_TRUE(first.contains(Vector3(0., 0., 0.12)));
+  EXPECT_TRUE(close.contains(Vector3(0., 0., 0.12)));
+
+  // Random boxes: symmetric, overlapping when one holds a corner of the
+  // other, and apart when their bounds are.
+  std::mt19937 generator(23);
+  std::uniform_real_distribution<double> positions(-3., 3.);
+  std::uniform_real_distribution<double> angles(-M_PI, M_PI);
+  std::uniform_real_distribution<double> sizes(0.1, 2.);
+  const auto randomBox = [&]() {
+    const Isometry pose =
+        Isometry::FromTranslation(Vector3(positions(generator),
+                                          positions(generator),
+                                          positions(generator))) *
+        Isometry::FromEulerAngles(angles(generator), angles(generator),
+                                  angles(generator));
+    return Obb(pose.translation(), pose.rotation(),
+               Vector3(sizes(generator), sizes(generator), sizes(generator)));
+  };
+  int overlapping = 0;
+  for (int i = 0; i < 2000; ++i) {
+    const Obb a = randomBox();
+    const Obb b = randomBox();
+    const bool overlap = a.overlaps(b);
+    EXPECT_EQ(overlap, b.overlaps(a));
+    overlapping += overlap;
+    if (!a.bounds().overlaps(b.bounds())) {
+      EXPECT_FALSE(overlap);
+    }
+    for (int k = 0; k < 8; ++k) {
+      if (a.contains(corner(b, k)) || b.contains(corner(a, k))) {
+        EXPECT_TRUE(overlap);
+      }
+    }
+  }
+  EXPECT_GT(overlapping, 200);
+  EXPECT_LT(overlapping, 1800);
+}
+
+GTEST_TEST(ObbTest, Fit) {
+  EXPECT_THROW(Obb::Fit(PointCloud()), std::invalid_argument);
+  const Obb single = Obb::Fit(PointCloud({Vector3(1., 2., 3.)}));
+  EXPECT_EQ(single.volume(), 0.);
+  EXPECT_EQ(single.center, Vector3(1., 2., 3.));
+
+  // Points filling a thin rotated slab, with its corners.
+  const Isometry pose = makePose();
+  const Obb truth(pose.translation(), pose.rotation(),
+                  Vector3(10., 2., 0.5));
+  std::mt19937 generator(29);
+  std::uniform_real_distribution<double> unit(-1., 1.);
+  PointCloud points;
+  for (int i = 0; i < 5000; ++i) {
+    points.push_back(truth.center +
+                     truth.axes.product(Vector3(10. * unit(generator),
+                                                2. * unit(generator),
+                                                0.5 * unit(generator))));
+  }
+  for (int i = 0; i < 8; ++i) {
+    points.push_back(corner(truth, i));
+  }
+  const Obb fit = Obb::Fit(points);
+  EXPECT_NEAR(fit.axes.det(), 1., 1e-9);
+  const Matrix3 gram = fit.axes.transpose().product(fit.axes);
+  for (int i = 0; i < 3; ++i) {
+    for (int j = 0; j < 3; ++j) {
+      EXPECT_NEAR(gram[i][j], i == j ? 1. : 0., 1e-9);
+    }
+  }
+  EXPECT_LT(fit.volume(), 1.05 * truth.volume());
+  EXPECT_LT((fit.center - truth.center).norm(), 1e-6);
+  Obb grown = fit;
+  grown.half_extents = fit.half_extents + Vector3(1e-9, 1e-9, 1e-9);
+  for (std::size_t i = 0; i < points.size(); ++i) {
+    EXPECT_TRUE(grown.contains(points.point(i)));
+  }
+}
+
+}  // namespace test
+}  // namespace math
+}  // namespace ekumen
+
+int main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
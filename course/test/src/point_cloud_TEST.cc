@@ -0,0 +1,71 @@
+#include "point_cloud.h"
+#include "isometry.h"
+#include "matrix3.h"
+#include "vector3.h"
+
+#include <stdexcept>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace ekumen {
+namespace math {
+namespace test {
+namespace {
+constexpr double kTolerance{1e-12};
+}  // namespace
+
+GTEST_TEST(PointCloudTest, PointCloudFullTests) {
+  const std::vector<Vector3> points{Vector3(1., 2., 3.), Vector3(-4., 5., 6.),
+                                    Vector3(0., 0., -1.)};
+  PointCloud cloud(points);
+  ASSERT_EQ(cloud.size(), points.size());
+  EXPECT_FALSE(cloud.empty());
+  for (std::size_t i = 0; i < points.size(); ++i) {
+    EXPECT_EQ(cloud.point(i), points[i]);
+    EXPECT_EQ(cloud.x()[i], points[i].x());
+    EXPECT_EQ(cloud.y()[i], points[i].y());
+    EXPECT_EQ(cloud.z()[i], points[i].z());
+  }
+  EXPECT_THROW(cloud.point(3), std::out_of_range);
+  EXPECT_THROW(cloud.setPoint(3, Vector3::kZero), std::out_of_range);
+
+  cloud.setPoint(1, Vector3::kUnitX);
+  EXPECT_EQ(cloud.point(1), Vector3::kUnitX);
+  EXPECT_NE(cloud, PointCloud(points));
+
+  PointCloud other(2);
+  EXPECT_EQ(other.point(1), Vector3::kZero);
+  other.append(cloud);
+  ASSERT_EQ(other.size(), 5u);
+  EXPECT_EQ(other.point(4), points[2]);
+  other.clear();
+  EXPECT_TRUE(other.empty());
+}
+
+GTEST_TEST(PointCloudTest, Transform) {
+  const Isometry pose =
+      Isometry::FromTranslation(Vector3(1., -2., 3.)) *
+      Isometry::RotateAround(Vector3(1., 1., 0.), 0.75);
+  std::vector<Vector3> points;
+  for (int i = 0; i < 100; ++i) {
+    points.emplace_back(0.1 * i, -0.3 * i, 2. - i);
+  }
+  PointCloud cloud(points);
+  cloud.transform(pose);
+  for (std::size_t i = 0; i < points.size(); ++i) {
+    const Vector3 expected = pose * points[i];
+    EXPECT_NEAR(cloud.x()[i], expected.x(), kTolerance * 100);
+    EXPECT_NEAR(cloud.y()[i], expected.y(), kTolerance * 100);
+    EXPECT_NEAR(cloud.z()[i], expected.z(), kTolerance * 100);
+  }
+}
+
+}  // namespace test
+}  // namespace math
+}  // namespace ekumen
+
+int main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,222 @@
+#include "point_cloud_io.h"
+#include "point_cloud.h"
+#include "vector3.h"
+
+#include <unistd.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <stdexcept>
+#include <string>
+
+#include "gtest/gtest.h"
+
+namespace ekumen {
+namespace math {
+namespace test {
+namespace {
+// Creates an empty temporary file and removes it when going out of scope.
+class TemporaryFile {
+ public:
+  TemporaryFile() {
+    char path[] = "/tmp/point_cloud_io_TEST_XXXXXX";
+    const int fd = ::mkstemp(path);
+    if (fd < 0) {
+      throw std::runtime_error("Cannot create a temporary file.");
+    }
+    ::close(fd);
+    path_ = path;
+  }
+  ~TemporaryFile() { std::remove(path_.c_str()); }
+
+  const std::string& path() const { return path_; }
+
+ private:
+  std::string path_;
+};
+
+PointCloud makeCloud(std::size_t size) {
+  PointCloud cloud;
+  for (std::size_t i = 0; i < size; ++i) {
+    cloud.push_back(Vector3(0.1 * i, -1. / (i + 1), 1e-7 * i * i));
+  }
+  return cloud;
+}
+
+// Point clouds compare with a tolerance, but files must read back exactly.
+void expectIdentical(const PointCloud& lhs, const PointCloud& rhs) {
+  ASSERT_EQ(lhs.size(), rhs.size());
+  for (std::size_t i = 0; i < lhs.size(); ++i) {
+    ASSERT_EQ(lhs.x()[i], rhs.x()[i]);
+    ASSERT_EQ(lhs.y()[i], rhs.y()[i]);
+    ASSERT_EQ(lhs.z()[i], rhs.z()[i]);
+  }
+}
+
+// Returns the message of the exception thrown by parsing 'text'.
+std::string plyError(const std::string& text) {
+  try {
+    PointCloudIo::ParsePly(text.data(), text.data() + text.size());
+  } catch (const std::runtime_error& e) {
+    return e.what();
+  }
+  return "";
+}
+
+std::string xyzError(const std::string& text) {
+  try {
+    PointCloudIo::ParseXyz(text.data(), text.data() + text.size());
+  } catch (const std::runtime_error& e) {
+    return e.what();
+  }
+  return "";
+}
+}  // namespace
+
+GTEST_TEST(PointCloudIoTest, RoundTrips) {
+  const PointCloud cloud = makeCloud(1000);
+  const TemporaryFile file;
+
+  PointCloudIo::WriteXyz(cloud, file.path());
+  expectIdentical(PointCloudIo::ReadXyz(file.path()), cloud);
+
+  for (PlyFormat format : {PlyFormat::kAscii, PlyFormat::kBinaryLittleEndian,
+                           PlyFormat::kBinaryBigEndian}) {
+    PointCloudIo::WritePly(cloud, file.path(), format);
+    expectIdentical(PointCloudIo::ReadPly(file.path()), cloud);
+  }
+
+  PointCloudIo::WritePly(PointCloud(), file.path());
+  EXPECT_TRUE(PointCloudIo::ReadPly(file.path()).empty());
+  PointCloudIo::WriteXyz(PointCloud(), file.path());
+  EXPECT_TRUE(PointCloudIo::ReadXyz(file.path()).empty());
+}
+
+GTEST_TEST(PointCloudIoTest, ParallelAsciiMatchesSingleThread) {
+  // Large enough to be split in several chunks.
+  const PointCloud cloud = makeCloud(200000);
+  const TemporaryFile file;
+  PointCloudIo::Options single;
+  single.num_threads = 1;
+  PointCloudIo::Options parallel;
+  parallel.num_threads = 4;
+
+  PointCloudIo::WriteXyz(cloud, file.path());
+  expectIdentical(PointCloudIo::ReadXyz(file.path(), parallel), cloud);
+  expectIdentical(PointCloudIo::ReadXyz(file.path(), single), cloud);
+
+  PointCloudIo::WritePly(cloud, file.path(), PlyFormat::kAscii);
+  expectIdentical(PointCloudIo::ReadPly(file.path(), parallel), cloud);
+  PointCloudIo::WritePly(cloud, file.path(), PlyFormat::kBinaryBigEndian);
+  expectIdentical(PointCloudIo::ReadPly(file.path(), parallel), cloud);
+}
+
+GTEST_TEST(PointCloudIoTest, XyzCommentsAndColumns) {
+  const std::string text =
+      "# exported cloud\n"
+      "\n"
+      "1 2 3\r\n"
+      "  -4\t5.5   6e1 255 0 0\n"
+      "   \n"
+      "7 8 9";
+  const PointCloud cloud =
+      PointCloudIo::ParseXyz(text.data(), text.data() + text.size());
+  ASSERT_EQ(cloud.size(), 3u);
+  EXPECT_EQ(cloud.point(0), Vector3(1., 2., 3.));
+  EXPECT_EQ(cloud.point(1), Vector3(-4., 5.5, 60.));
+  EXPECT_EQ(cloud.point(2), Vector3(7., 8., 9.));
+}
+
+GTEST_TEST(PointCloudIoTest, PlyPropertiesAndElements) {
+  const std::string ascii =
+      "ply\n"
+      "format ascii 1.0\n"
+      "comment made by hand\n"
+      "element vertex 2\n"
+      "property uchar red\n"
+      "property float z\n"
+      "property float y\n"
+      "property int x\n"
+      "element face 1\n"
+      "property list uchar int vertex_indices\n"
+      "end_header\n"
+      "255 0.5 1.5 -3\n"
+      "0 2 -1 4\n"
+      "3 0 1 1\n";
+  const PointCloud cloud =
+      PointCloudIo::ParsePly(ascii.data(), ascii.data() + ascii.size());
+  ASSERT_EQ(cloud.size(), 2u);
+  EXPECT_EQ(cloud.point(0), Vector3(-3., 1.5, 0.5));
+  EXPECT_EQ(cloud.point(1), Vector3(4., -1., 2.));
+
+  std::string binary =
+      "ply\r\n"
+      "format binary_big_endian 1.0\r\n"
+      "element vertex 1\r\n"
+      "property short x\r\n"
+      "property uchar alpha\r\n"
+      "property float y\r\n"
+      "property ushort z\r\n"
+      "end_header\r\n";
+  // x = -2, alpha = 7, y = 0.25, z = 513.
+  const unsigned char bytes[] = {0xff, 0xfe, 0x07, 0x3e, 0x80,
+                                 0x00, 0x00, 0x02, 0x01};
+  binary.append(reinterpret_cast<const char*>(bytes), sizeof(bytes));
+  const PointCloud point =
+      PointCloudIo::ParsePly(binary.data(), binary.data() + binary.size());
+  ASSERT_EQ(point.size(), 1u);
+  EXPECT_EQ(point.point(0), Vector3(-2., 0.25, 513.));
+}
+
+GTEST_TEST(PointCloudIoTest, MalformedFiles) {
+  const std::string header =
+      "ply\nformat ascii 1.0\nelement vertex 2\nproperty float x\n"
+      "property float y\nproperty float z\nend_header\n";
+  EXPECT_NE(plyError("plx\n").find("offset 0"), std::string::npos);
+  EXPECT_NE(plyError("ply\nformat ascii 1.0\n").find("end_header"),
+            std::string::npos);
+  EXPECT_NE(plyError("ply\nformat ascii 1.0\nelement face 1\nend_header\n")
+                .find("vertex"),
+            std::string::npos);
+  EXPECT_NE(plyError("ply\nformat ascii 1.0\nelement vertex 1\n"
+                     "property list uchar int x\nend_header\n")
+                .find("List"),
+            std::string::npos);
+  EXPECT_NE(plyError("ply\nformat ascii 1.0\nelement vertex 1\n"
+                     "property float x\nend_header\n0\n")
+                .find("x, y and z"),
+            std::string::npos);
+  EXPECT_NE(plyError(header + "1 2 3\n").find("Truncated"), std::string::npos);
+  // The error points at the 'a' of the second line.
+  const std::string offset = std::to_string(header.size() + 8);
+  EXPECT_NE(plyError(header + "1 2 3\n1 a 3\n").find("offset " + offset),
+            std::string::npos);
+  EXPECT_NE(plyError("ply\nformat binary_little_endian 1.0\n"
+                     "element vertex 2\nproperty double x\nproperty double y\n"
+                     "property double z\nend_header\n" +
+                     std::string(47, '\0'))
+                .find("Truncated"),
+            std::string::npos);
+
+  EXPECT_NE(plyError("").find("Missing header"), std::string::npos);
+  EXPECT_THROW(PointCloudIo::ParsePly(nullptr, nullptr), std::runtime_error);
+  const TemporaryFile empty;
+  EXPECT_THROW(PointCloudIo::ReadPly(empty.path()), std::runtime_error);
+  EXPECT_TRUE(PointCloudIo::ReadXyz(empty.path()).empty());
+
+  EXPECT_NE(xyzError("1 2 3\n4 5\n").find("offset 9"), std::string::npos);
+  EXPECT_NE(xyzError("1 2 3x\n").find("offset 5"), std::string::npos);
+  EXPECT_THROW(PointCloudIo::ReadXyz("/nonexistent/cloud.xyz"),
+               std::runtime_error);
+  EXPECT_THROW(PointCloudIo::WriteXyz(PointCloud(), "/nonexistent/cloud.xyz"),
+               std::runtime_error);
+}
+
+}  // namespace test
+}  // namespace math
+}  // namespace ekumen
+
+int main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
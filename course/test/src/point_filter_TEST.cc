@@ -0,0 +1,191 @@
+#include "point_filter.h"
+#include "isometry.h"
+#include "point_cloud.h"
+#include "vector3.h"
+
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace ekumen {
+namespace math {
+namespace test {
+namespace {
+constexpr double kTolerance{1e-12};
+
+Isometry makePose() {
+  return Isometry::FromTranslation(Vector3(1., -2., 0.5)) *
+         Isometry::RotateAround(Vector3(1., 2., 3.), 0.7);
+}
+
+PointCloud makeCloud(std::size_t size) {
+  std::mt19937 generator(7);
+  std::uniform_real_distribution<double> distribution(-10., 10.);
+  PointCloud res(size);
+  for (std::size_t i = 0; i < size; ++i) {
+    res.setPoint(i, Vector3(distribution(generator), distribution(generator),
+                            distribution(generator)));
+  }
+  return res;
+}
+
+PointFilter makeFilter() {
+  PointFilter res;
+  res.box_min = Vector3(-6., -8., -5.);
+  res.box_max = Vector3(7., 4., 9.);
+  res.sphere_center = Vector3(1., 0., 1.);
+  res.sphere_radius = 9.;
+  res.min_range = 2.;
+  res.max_range = 12.;
+  return res;
+}
+
+// Filters with separate passes over the points.
+std::vector<Vector3> filterNaive(const Isometry& pose,
+                                 const PointFilter& filter,
+                                 const PointCloud& input) {
+  std::vector<Vector3> res;
+  for (std::size_t i = 0; i < input.size(); ++i) {
+    const Vector3 p = input.point(i);
+    const Vector3 q = pose * p;
+    bool keep = p.norm() >= filter.min_range && p.norm() <= filter.max_range &&
+                (q - filter.sphere_center).norm() <= filter.sphere_radius &&
+                (filter.mask == nullptr || filter.mask[i] != 0);
+    for (int j = 0; j < 3; ++j) {
+      keep = keep && q[j] >= filter.box_min[j] && q[j] <= filter.box_max[j];
+    }
+    if (keep) {
+      res.push_back(q);
+    }
+  }
+  return res;
+}
+
+void expectNear(const PointCloud& cloud, const std::vector<Vector3>& points) {
+  ASSERT_EQ(cloud.size(), points.size());
+  for (std::size_t i = 0; i < points.size(); ++i) {
+    for (int j = 0; j < 3; ++j) {
+      EXPECT_NEAR(cloud.point(i)[j], points[i][j], kTolerance);
+    }
+  }
+}
+}  // namespace
+
+GTEST_TEST(PointFilterTest, DefaultFilter) {
+  PointCloud input = makeCloud(21);
+  input.setPoint(3, Vector3(std::numeric_limits<double>::quiet_NaN(), 0., 0.));
+  input.setPoint(20,
+                 Vector3(0., std::numeric_limits<double>::infinity(), 0.));
+  PointCloud output;
+  EXPECT_EQ(FilterTransform::Run(makePose(), PointFilter(), input, &output),
+            19u);
+  EXPECT_EQ(output.point(3), makePose() * input.point(4));
+  EXPECT_EQ(output.point(18), makePose() * input.point(19));
+}
+
+GTEST_TEST(PointFilterTest, FusedPredicates) {
+  const Isometry pose = makePose();
+  const PointCloud input = makeCloud(1003);
+  std::vector<std::uint8_t> mask(input.size());
+  for (std::size_t i = 0; i < mask.size(); ++i) {
+    mask[i] = i % 3 == 0 ? 0 : static_cast<std::uint8_t>(i);
+  }
+  PointFilter filter = makeFilter();
+  for (const std::uint8_t* flags : {static_cast<std::uint8_t*>(nullptr),
+                                    mask.data()}) {
+    filter.mask = flags;
+    const std::vector<Vector3> expected = filterNaive(pose, filter, input);
+    ASSERT_GT(expected.size(), 10u);
+    ASSERT_LT(expected.size(), input.size() / 2);
+
+    PointCloud output(5);
+    EXPECT_EQ(FilterTransform::Run(pose, filter, input, &output),
+              expected.size());
+    expectNear(output, expected);
+
+    // The portable kernel keeps the same points as the AVX-512 one, which
+    // Run() takes where the CPU has it.
+    PointCloud portable;
+    FilterTransform::Run(
+        pose, filter, [](double, double, double) { return true; }, input,
+        &portable);
+    EXPECT_EQ(portable, output);
+
+    // In place.
+    PointCloud cloud = input;
+    FilterTransform::Run(pose, filter, cloud, &cloud);
+    EXPECT_EQ(cloud, output);
+  }
+}
+
+GTEST_TEST(PointFilterTest, CustomPredicate) {
+  const Isometry pose = makePose();
+  const PointCloud input = makeCloud(100);
+  PointCloud output;
+  const std::size_t count = FilterTransform::Run(
+      pose, PointFilter(), [](double x, double y, double) { return x > y; },
+      input, &output);
+  std::vector<Vector3> expected;
+  for (std::size_t i = 0; i < input.size(); ++i) {
+    const Vector3 q = pose * input.point(i);
+    if (q.x() > q.y()) {
+      expected.push_back(q);
+    }
+  }
+  EXPECT_EQ(count, expected.size());
+  expectNear(output, expected);
+
+  PointCloud cloud = input;
+  FilterTransform::Run(
+      pose, PointFilter(), [](double x, double y, double) { return x > y; },
+      cloud, &cloud);
+  EXPECT_EQ(cloud, output);
+}
+
+GTEST_TEST(PointFilterTest, Errors) {
+  const PointCloud input = makeCloud(4);
+  PointCloud output;
+  EXPECT_THROW(FilterTransform::Run(makePose(), PointFilter(), input, nullptr),
+               std::invalid_argument);
+  PointFilter filter;
+  filter.box_min = Vector3(0., 1., 0.);
+  filter.box_max = Vector3(1., 0., 1.);
+  EXPECT_THROW(FilterTransform::Run(makePose(), filter, input, &output),
+               std::invalid_argument);
+  filter = PointFilter();
+  filter.sphere_radius = -1.;
+  EXPECT_THROW(FilterTransform::Run(makePose(), filter, input, &output),
+               std::invalid_argument);
+  filter = PointFilter();
+  filter.min_range = 3.;
+  filter.max_range = 2.;
+  EXPECT_THROW(FilterTransform::Run(makePose(), filter, input, &output),
+               std::invalid_argument);
+  filter.max_range = std::numeric_limits<double>::quiet_NaN();
+  EXPECT_THROW(
+      FilterTransform::Run(
+          makePose(), filter, [](double, double, double) { return true; },
+          input, &output),
+      std::invalid_argument);
+
+  // Empty inputs.
+  output = input;
+  EXPECT_EQ(FilterTransform::Run(makePose(), PointFilter(), PointCloud(),
+                                 &output),
+            0u);
+  EXPECT_TRUE(output.empty());
+}
+
+}  // namespace test
+}  // namespace math
+}  // namespace ekumen
+
+int main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
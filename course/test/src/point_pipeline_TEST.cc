@@ -0,0 +1,137 @@
+#include "point_pipeline.h"
+#include "isometry.h"
+#include "map_view.h"
+#include "point_cloud.h"
+#include "vector3.h"
+
+#include <cstddef>
+#include <stdexcept>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace ekumen {
+namespace math {
+namespace test {
+namespace {
+constexpr double kTolerance{1e-12};
+
+Isometry makePose(double angle) {
+  return Isometry::FromTranslation(Vector3(1., -2., 0.5)) *
+         Isometry::RotateAround(Vector3(1., 2., 3.), angle);
+}
+
+std::vector<Vector3> makePoints(std::size_t count) {
+  std::vector<Vector3> res;
+  for (std::size_t i = 0; i < count; ++i) {
+    res.emplace_back(0.5 * i, -1. * i, 1e-3 * i);
+  }
+  return res;
+}
+
+bool farX(double x, double, double) { return x > 40.; }
+
+void expectNear(const std::vector<Vector3>& a, const std::vector<Vector3>& b) {
+  ASSERT_EQ(a.size(), b.size());
+  for (std::size_t i = 0; i < a.size(); ++i) {
+    for (int j = 0; j < 3; ++j) {
+      EXPECT_NEAR(a[i][j], b[i][j], kTolerance);
+    }
+  }
+}
+}  // namespace
+
+GTEST_TEST(PointPipelineTest, Stages) {
+  const Isometry pose = makePose(0.7);
+  const std::vector<Vector3> points = makePoints(100);
+  std::vector<Vector3> expected;
+  for (const Vector3& point : points) {
+    const Vector3 q = pose * point;
+    if (q.x() > 40.) {
+      expected.push_back(q);
+    }
+  }
+  ASSERT_GT(expected.size(), 10u);
+  ASSERT_LT(expected.size(), 90u);
+  std::vector<Vector3> expected_strided;
+  for (std::size_t i = 0; i < expected.size(); i += 3) {
+    expected_strided.push_back(expected[i]);
+  }
+
+  expectNear((points | transformed(pose) | filtered(farX)).toVector(),
+             expected);
+  expectNear((points | transformed(pose) | filtered(farX) | strided(3))
+                 .toVector(),
+             expected_strided);
+  EXPECT_EQ((points | strided(1)).toVector(), points);
+  EXPECT_EQ((points | strided(7)).count(), 15u);
+  const auto far = [](double, double y, double) { return y < -90.; };
+  EXPECT_EQ((points | filtered(far)).count(), 9u);
+  EXPECT_THROW(strided(0), std::invalid_argument);
+}
+
+GTEST_TEST(PointPipelineTest, Sources) {
+  const Isometry pose = makePose(-1.2);
+  const std::vector<Vector3> points = makePoints(20);
+  const std::vector<Vector3> expected =
+      (points | transformed(pose) | strided(2)).toVector();
+  ASSERT_EQ(expected.size(), 10u);
+
+  const PointCloud cloud(points);
+  expectNear((cloud | transformed(pose) | strided(2)).toVector(), expected);
+  EXPECT_EQ((cloud | transformed(pose) | strided(2)).toCloud(),
+            PointCloud(expected));
+
+  // Interleaved xyzw records.
+  std::vector<double> records;
+  for (const Vector3& point : points) {
+    records.insert(records.end(), {point.x(), point.y(), point.z(), -1.});
+  }
+  const PointsView view(records.data(), points.size(), 4);
+  expectNear((view | transformed(pose) | strided(2)).toVector(), expected);
+
+  // Sinks see points in order.
+  std::vector<double> xs;
+  (ConstPointsView(view) | strided(5)).forEach(
+      [&xs](double x, double, double) { xs.push_back(x); });
+  EXPECT_EQ(xs, std::vector<double>({0., 2.5, 5., 7.5}));
+}
+
+GTEST_TEST(PointPipelineTest, Laziness) {
+  const std::vector<Vector3> points = makePoints(10);
+  int calls = 0;
+  const auto pipeline = points | filtered([&calls](double, double, double) {
+                          ++calls;
+                          return true;
+                        });
+  EXPECT_EQ(calls, 0);
+  EXPECT_EQ(pipeline.count(), 10u);
+  EXPECT_EQ(calls, 10);
+  // Each sink runs the pipeline again.
+  EXPECT_EQ(pipeline.toVector(), points);
+  EXPECT_EQ(calls, 20);
+}
+
+GTEST_TEST(PointPipelineTest, ComposedTransforms) {
+  const Isometry a = makePose(0.3);
+  const Isometry b = makePose(-0.9);
+  const std::vector<Vector3> points = makePoints(10);
+  const auto pipeline = points | transformed(a) | transformed(b);
+  // A single stage with the composed transform.
+  const PointPipeline<VectorPointSource, TransformedStage>& single = pipeline;
+  EXPECT_EQ(single.stage().pose(), b * a);
+  std::vector<Vector3> expected;
+  for (const Vector3& point : points) {
+    expected.push_back(b * (a * point));
+  }
+  expectNear(pipeline.toVector(), expected);
+}
+
+}  // namespace test
+}  // namespace math
+}  // namespace ekumen
+
+int main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,135 @@
+#include "pose_graph.h"
+#include "isometry.h"
+#include "lie_group.h"
+#include "vector3.h"
+
+#include <cmath>
+#include <stdexcept>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace ekumen {
+namespace math {
+namespace test {
+namespace {
+constexpr double kTolerance{1e-6};
+
+// Returns poses along a helix.
+std::vector<Isometry> makeTrajectory(int size) {
+  std::vector<Isometry> res;
+  for (int i = 0; i < size; ++i) {
+    const double angle = 0.1 * i;
+    res.push_back(SE3::Exp(Vector3(std::cos(angle), std::sin(angle), 0.01 * i),
+                           Vector3(0.02 * std::sin(angle), 0.01, angle)));
+  }
+  return res;
+}
+
+// Deterministic perturbation of a pose.
+Isometry perturb(const Isometry& pose, int seed) {
+  const double s = std::sin(seed * 12.9898) * 0.05;
+  const double c = std::cos(seed * 78.233) * 0.05;
+  return pose * SE3::Exp(Vector3(s, c, -s), Vector3(c, -s, s));
+}
+
+// Builds a graph with odometry edges and loop closures from ground truth,
+// starting from perturbed node estimates.
+PoseGraph makeGraph(const std::vector<Isometry>& truth, int loop_stride) {
+  PoseGraph graph;
+  for (std::size_t i = 0; i < truth.size(); ++i) {
+    graph.AddNode(i == 0 ? truth[0] : perturb(truth[i], i));
+  }
+  const PoseGraph::Information information =
+      PoseGraph::DiagonalInformation(100., 400.);
+  for (std::size_t i = 1; i < truth.size(); ++i) {
+    graph.AddEdge(i - 1, i, truth[i - 1].inverse() * truth[i], information);
+    if (i >= static_cast<std::size_t>(loop_stride)) {
+      const std::size_t j = i - loop_stride;
+      graph.AddEdge(j, i, truth[j].inverse() * truth[i], information);
+    }
+  }
+  return graph;
+}
+
+void expectNear(const Isometry& a, const Isometry& b) {
+  for (int i = 0; i < 3; ++i) {
+    EXPECT_NEAR(a.translation()[i], b.translation()[i], kTolerance);
+    for (int j = 0; j < 3; ++j) {
+      EXPECT_NEAR(a.rotation()[i][j], b.rotation()[i][j], kTolerance);
+    }
+  }
+}
+}  // namespace
+
+GTEST_TEST(PoseGraphTest, Accessors) {
+  PoseGraph graph;
+  EXPECT_EQ(graph.AddNode(Isometry()), 0);
+  EXPECT_EQ(graph.AddNode(Isometry::FromTranslation({1., 0., 0.})), 1);
+  graph.AddEdge(0, 1, Isometry::FromTranslation({1., 0., 0.}),
+                PoseGraph::DiagonalInformation(1., 1.));
+  EXPECT_EQ(graph.numNodes(), 2);
+  EXPECT_EQ(graph.numEdges(), 1);
+  EXPECT_EQ(graph.node(1).translation(), Vector3(1., 0., 0.));
+  EXPECT_NEAR(graph.error(), 0., kTolerance);
+  ASSERT_THROW(graph.AddEdge(0, 2, Isometry(),
+                             PoseGraph::DiagonalInformation(1., 1.)),
+               std::out_of_range);
+}
+
+GTEST_TEST(PoseGraphTest, RecoversGroundTruth) {
+  const std::vector<Isometry> truth = makeTrajectory(50);
+  PoseGraph graph = makeGraph(truth, 7);
+  EXPECT_GT(graph.error(), 1.);
+
+  PoseGraph::Options options;
+  options.num_threads = 1;
+  const PoseGraph::Summary summary = graph.Optimize(options);
+  EXPECT_GT(summary.initial_error, 1.);
+  EXPECT_LT(summary.final_error, 1e-12);
+  EXPECT_LE(summary.iterations, 10);
+  for (std::size_t i = 0; i < truth.size(); ++i) {
+    expectNear(graph.node(i), truth[i]);
+  }
+}
+
+GTEST_TEST(PoseGraphTest, FixedNodeIsKept) {
+  const std::vector<Isometry> truth = makeTrajectory(20);
+  PoseGraph graph = makeGraph(truth, 5);
+  const Isometry anchor = graph.node(10);
+  graph.SetFixed(10, true);
+  graph.Optimize();
+  expectNear(graph.node(10), anchor);
+  EXPECT_LT(graph.error(), 1e-12);
+}
+
+GTEST_TEST(PoseGraphTest, UnconstrainedNodeThrows) {
+  PoseGraph graph;
+  graph.AddNode(Isometry());
+  graph.AddNode(Isometry());
+  ASSERT_THROW(graph.Optimize(), std::runtime_error);
+}
+
+GTEST_TEST(PoseGraphTest, MultithreadedMatchesSingleThreaded) {
+  const std::vector<Isometry> truth = makeTrajectory(500);
+  PoseGraph single = makeGraph(truth, 20);
+  PoseGraph multi = makeGraph(truth, 20);
+  PoseGraph::Options options;
+  options.num_threads = 1;
+  single.Optimize(options);
+  options.num_threads = 4;
+  multi.Optimize(options);
+  for (std::size_t i = 0; i < truth.size(); i += 37) {
+    expectNear(multi.node(i), single.node(i));
+    expectNear(multi.node(i), truth[i]);
+  }
+}
+
+}  // namespace test
+}  // namespace math
+}  // namespace ekumen
+
+int main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,269 @@
+#include "aabb.h"
+#include "isometry.h"
+#include "ray_batch.h"
+#include "triangle_mesh.h"
+#include "vector3.h"
+
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace ekumen {
+namespace math {
+namespace test {
+namespace {
+constexpr double kTolerance{1e-12};
+
+Isometry makePose() {
+  return Isometry::FromTranslation(Vector3(1., -2., 0.5)) *
+         Isometry::FromEulerAngles(0.4, -0.3, 1.2);
+}
+
+// Rays from random origins in [-5; 5]^3 along random directions, not unit.
+RayBatch makeRays(std::size_t size) {
+  std::mt19937 generator(41);
+  std::uniform_real_distribution<double> positions(-5., 5.);
+  std::uniform_real_distribution<double> directions(-2., 2.);
+  RayBatch res;
+  for (std::size_t i = 0; i < size; ++i) {
+    res.push_back(Vector3(positions(generator), positions(generator),
+                          positions(generator)),
+                  Vector3(directions(generator), directions(generator),
+                          directions(generator)));
+  }
+  return res;
+}
+}  // namespace
+
+GTEST_TEST(RayBatchTest, Accessors) {
+  RayBatch rays;
+  EXPECT_TRUE(rays.empty());
+  rays.push_back(Vector3(1., 2., 3.), Vector3(0., 0., 2.));
+  EXPECT_EQ(rays.size(), 1u);
+  EXPECT_EQ(rays.origin(0), Vector3(1., 2., 3.));
+  EXPECT_EQ(rays.direction(0), Vector3(0., 0., 2.));
+  EXPECT_EQ(rays.pointAt(0, 1.5), Vector3(1., 2., 6.));
+  rays.setRay(0, Vector3::kZero, Vector3::kUnitX);
+  EXPECT_EQ(rays.origin(0), Vector3::kZero);
+  EXPECT_THROW(rays.origin(1), std::out_of_range);
+  EXPECT_THROW(rays.setRay(1, Vector3::kZero, Vector3::kUnitX),
+               std::out_of_range);
+
+  // Directions only turn.
+  const Isometry pose = makePose();
+  rays.transform(pose);
+  EXPECT_EQ(rays.origin(0), pose.translation());
+  EXPECT_EQ(rays.direction(0), pose.rotation().product(Vector3::kUnitX));
+
+  rays.resize(3);
+  EXPECT_EQ(rays.size(), 3u);
+  rays.clear();
+  EXPECT_TRUE(rays.empty());
+
+  const RayHits hits(4, 10.);
+  EXPECT_EQ(hits.distances, std::vector<double>(4, 10.));
+  EXPECT_EQ(hits.ids, std::vector<std::uint32_t>(4, RayHits::kNoHit));
+  RayHits wrong(2);
+  EXPECT_THROW(CastPlane(pose, Vector3::kUnitZ, 0., 0, makeRays(3), &wrong),
+               std::invalid_argument);
+  EXPECT_THROW(CastBox(pose, Aabb(), 0, makeRays(3), nullptr),
+               std::invalid_argument);
+}
+
+GTEST_TEST(RayBatchTest, CastPlane) {
+  RayBatch rays;
+  rays.push_back(Vector3(0., 0., 5.), Vector3(0., 0., -2.));
+  rays.push_back(Vector3(0., 0., -5.), Vector3(0., 0., 1.));
+  // Away from the plane, along it and short of it.
+  rays.push_back(Vector3(0., 0., 5.), Vector3(0., 0., 1.));
+  rays.push_back(Vector3(0., 0., 5.), Vector3(1., 0., 0.));
+  rays.push_back(Vector3(0., 0., 50.), Vector3(0., 0., -1.));
+  RayHits hits(rays.size(), 20.);
+  CastPlane(Isometry(), Vector3::kUnitZ, 1., 7, rays, &hits);
+  EXPECT_NEAR(hits.distances[0], 2., kTolerance);
+  EXPECT_NEAR(hits.distances[1], 6., kTolerance);
+  EXPECT_EQ(hits.ids, std::vector<std::uint32_t>({7, 7, RayHits::kNoHit,
+                                                  RayHits::kNoHit,
+                                                  RayHits::kNoHit}));
+  EXPECT_EQ(hits.distances[4], 20.);
+
+  // A nearer plane takes over, a farther one does not.
+  CastPlane(Isometry(), Vector3::kUnitZ, 3., 8, rays, &hits);
+  CastPlane(Isometry(), Vector3::kUnitZ, -3., 9, rays, &hits);
+  EXPECT_NEAR(hits.distances[0], 1., kTolerance);
+  EXPECT_EQ(hits.ids[0], 8u);
+  EXPECT_NEAR(hits.distances[1], 2., kTolerance);
+  EXPECT_EQ(hits.ids[1], 9u);
+
+  // Rays against a placed plane land on it.
+  const Isometry pose = makePose();
+  const RayBatch random = makeRays(1000);
+  RayHits placed(random.size());
+  CastPlane(pose, Vector3(0., 0., 2.), 1., 3, random, &placed);
+  const Vector3 normal = pose.rotation().product(Vector3::kUnitZ);
+  for (std::size_t i = 0; i < random.size(); ++i) {
+    const double height =
+        normal.dot(random.origin(i) - pose.translation()) - 0.5;
+    const bool expected = height * normal.dot(random.direction(i)) < 0.;
+    ASSERT_EQ(placed.ids[i] == 3u, expected);
+    if (expected) {
+      const Vector3 local =
+          pose.inverse() * random.pointAt(i, placed.distances[i]);
+      EXPECT_NEAR(local.z(), 0.5, 1e-9);
+    }
+  }
+}
+
+GTEST_TEST(RayBatchTest, CastBox) {
+  const Aabb box(Vector3(-1., -2., -3.), Vector3(1., 2., 3.));
+  RayBatch rays;
+  rays.push_back(Vector3(-5., 0., 0.), Vector3(2., 0., 0.));
+  // Inside, past and missing the box.
+  rays.push_back(Vector3(0., 0., 0.), Vector3(1., 1., 1.));
+  rays.push_back(Vector3(5., 0., 0.), Vector3(1., 0., 0.));
+  rays.push_back(Vector3(-5., 3., 0.), Vector3(1., 0., 0.));
+  RayHits hits(rays.size());
+  CastBox(Isometry(), box, 4, rays, &hits);
+  EXPECT_NEAR(hits.distances[0], 2., kTolerance);
+  EXPECT_EQ(hits.distances[1], 0.);
+  EXPECT_EQ(hits.ids, std::vector<std::uint32_t>({4, 4, RayHits::kNoHit,
+                                                  RayHits::kNoHit}));
+  RayHits none(rays.size());
+  CastBox(Isometry(), Aabb(), 4, rays, &none);
+  EXPECT_EQ(none.ids, std::vector<std::uint32_t>(4, RayHits::kNoHit));
+
+  // Random rays against a placed box hit it on a face, and a ray that
+  // misses it misses a slightly smaller box too.
+  const Isometry pose = makePose();
+  const Isometry inverse = pose.inverse();
+  const RayBatch random = makeRays(3000);
+  RayHits placed(random.size());
+  CastBox(pose, box, 1, random, &placed);
+  const Aabb inner(box.min + Vector3(0.01, 0.01, 0.01),
+                   box.max - Vector3(0.01, 0.01, 0.01));
+  int hit = 0;
+  for (std::size_t i = 0; i < random.size(); ++i) {
+    const Vector3 origin = inverse * random.origin(i);
+    const Vector3 direction =
+        inverse.rotation().product(random.direction(i));
+    if (placed.ids[i] == RayHits::kNoHit) {
+      EXPECT_TRUE(std::isinf(placed.distances[i]));
+      for (int k = 0; k <= 1000; ++k) {
+        ASSERT_FALSE(inner.contains(origin + (0.01 * k) * direction));
+      }
+      continue;
+    }
+    ++hit;
+    const Vector3 point = inverse * random.pointAt(i, placed.distances[i]);
+    const Aabb grown(box.min - Vector3(1e-9, 1e-9, 1e-9),
+                     box.max + Vector3(1e-9, 1e-9, 1e-9));
+    EXPECT_TRUE(grown.contains(point));
+    if (!box.contains(origin)) {
+      EXPECT_FALSE(inner.contains(point));
+      EXPECT_FALSE(
+          inner.contains(origin + (0.99 * placed.distances[i]) * direction));
+    }
+  }
+  EXPECT_GT(hit, 100);
+}
+
+GTEST_TEST(RayBatchTest, CastTriangles) {
+  // Random triangles, tested against TriangleMesh::raycast() with sizes
+  // around the block size. Its distances are in world units.
+  std::mt19937 generator(43);
+  std::uniform_real_distribution<double> positions(-3., 3.);
+  std::vector<Vector3> vertices;
+  std::vector<TriangleMesh::Triangle> triangles;
+  for (std::uint32_t i = 0; i < 40; ++i) {
+    for (int k = 0; k < 3; ++k) {
+      vertices.emplace_back(positions(generator), positions(generator),
+                            positions(generator));
+    }
+    triangles.push_back({{3 * i, 3 * i + 1, 3 * i + 2}});
+  }
+  const TriangleMesh mesh(vertices, triangles);
+  const Isometry pose = makePose();
+  for (const std::size_t size : {0, 7, 256, 700}) {
+    const RayBatch rays = makeRays(size);
+    RayHits hits(size, 10.);
+    CastTriangles(pose, mesh, rays, &hits);
+    int hit = 0;
+    for (std::size_t i = 0; i < size; ++i) {
+      const double length = rays.direction(i).norm();
+      RayHit expected;
+      if (!mesh.raycast(pose, rays.origin(i), rays.direction(i),
+                        10. * length, &expected)) {
+        EXPECT_EQ(hits.ids[i], RayHits::kNoHit);
+        EXPECT_EQ(hits.distances[i], 10.);
+        continue;
+      }
+      ++hit;
+      EXPECT_EQ(hits.ids[i], expected.triangle);
+      EXPECT_NEAR(hits.distances[i] * length, expected.distance, 1e-9);
+    }
+    if (size > 100) {
+      EXPECT_GT(hit, 20);
+    }
+  }
+}
+
+GTEST_TEST(RayBatchTest, CastTrianglesScan) {
+  // A scan of neighbouring rays against many small triangles, whose packets
+  // share the traversal of a deep hierarchy while some of their rays miss.
+  std::mt19937 generator(44);
+  std::uniform_real_distribution<double> centers(-4., 4.);
+  std::uniform_real_distribution<double> corners(-0.3, 0.3);
+  std::vector<Vector3> vertices;
+  std::vector<TriangleMesh::Triangle> triangles;
+  for (std::uint32_t i = 0; i < 500; ++i) {
+    const Vector3 center(centers(generator), centers(generator),
+                         0.25 * centers(generator));
+    for (int k = 0; k < 3; ++k) {
+      vertices.push_back(center + Vector3(corners(generator),
+                                          corners(generator),
+                                          corners(generator)));
+    }
+    triangles.push_back({{3 * i, 3 * i + 1, 3 * i + 2}});
+  }
+  const TriangleMesh mesh(vertices, triangles);
+  const Isometry pose = makePose();
+  RayBatch rays;
+  for (int j = 0; j < 40; ++j) {
+    for (int i = 0; i < 40; ++i) {
+      rays.push_back(pose * Vector3(0., 0., 6.),
+                     pose.rotation().product(
+                         Vector3(0.05 * i - 1., 0.05 * j - 1., -1.)));
+    }
+  }
+  RayHits hits(rays.size(), 20.);
+  CastTriangles(pose, mesh, rays, &hits);
+  int hit = 0;
+  for (std::size_t i = 0; i < rays.size(); ++i) {
+    const double length = rays.direction(i).norm();
+    RayHit expected;
+    if (!mesh.raycast(pose, rays.origin(i), rays.direction(i), 20. * length,
+                      &expected)) {
+      EXPECT_EQ(hits.ids[i], RayHits::kNoHit);
+      EXPECT_EQ(hits.distances[i], 20.);
+      continue;
+    }
+    ++hit;
+    EXPECT_EQ(hits.ids[i], expected.triangle);
+    EXPECT_NEAR(hits.distances[i] * length, expected.distance, 1e-9);
+  }
+  EXPECT_GT(hit, 100);
+  EXPECT_LT(hit, 1500);
+}
+
+}  // namespace test
+}  // namespace math
+}  // namespace ekumen
+
+int main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,159 @@
+#include "aabb.h"
+#include "isometry.h"
+#include "sweep_and_prune.h"
+#include "vector3.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace ekumen {
+namespace math {
+namespace test {
+namespace {
+using Pair = SweepAndPrune::Pair;
+
+// Pairs of bodies whose bounds overlap, tested one by one.
+std::vector<Pair> bruteForcePairs(const SweepAndPrune& bodies) {
+  std::vector<Pair> res;
+  for (std::uint32_t i = 0; i < bodies.size(); ++i) {
+    for (std::uint32_t j = i + 1; j < bodies.size(); ++j) {
+      const Aabb a = bodies.bounds(i);
+      const Aabb b = bodies.bounds(j);
+      if (!a.empty() && !b.empty() && a.overlaps(b)) {
+        res.emplace_back(i, j);
+      }
+    }
+  }
+  return res;
+}
+
+std::vector<Pair> sortedPairs(SweepAndPrune* bodies) {
+  std::vector<Pair> res;
+  bodies->findPairs(&res);
+  std::sort(res.begin(), res.end());
+  return res;
+}
+}  // namespace
+
+GTEST_TEST(SweepAndPruneTest, Accessors) {
+  SweepAndPrune bodies;
+  EXPECT_TRUE(bodies.empty());
+  const Aabb box(Vector3(-1., -1., -1.), Vector3(1., 1., 1.));
+  EXPECT_EQ(bodies.add(box, Isometry()), 0u);
+  EXPECT_EQ(bodies.add(box, Isometry::FromTranslation(Vector3(5., 0., 0.))),
+            1u);
+  EXPECT_EQ(bodies.size(), 2u);
+  EXPECT_EQ(bodies.bounds(1).min, Vector3(4., -1., -1.));
+
+  const Isometry pose = Isometry::FromTranslation(Vector3(1., 2., 3.)) *
+                        Isometry::RotateAround(Vector3::kUnitZ, 0.5);
+  bodies.setPose(0, pose);
+  EXPECT_EQ(bodies.bounds(0).min, box.transformed(pose).min);
+  EXPECT_EQ(bodies.bounds(0).max, box.transformed(pose).max);
+  EXPECT_THROW(bodies.setPose(2, pose), std::out_of_range);
+  EXPECT_THROW(bodies.bounds(2), std::out_of_range);
+  EXPECT_THROW(bodies.setPoses({pose}), std::invalid_argument);
+
+  // Non-finite bounds are rejected and leave the bodies unchanged.
+  const double inf = std::numeric_limits<double>::infinity();
+  const Isometry nan_pose =
+      Isometry::FromTranslation(Vector3(std::nan(""), 0., 0.));
+  EXPECT_THROW(bodies.setPose(0, nan_pose), std::invalid_argument);
+  EXPECT_EQ(bodies.bounds(0).min, box.transformed(pose).min);
+  EXPECT_THROW(bodies.add(Aabb(Vector3::kZero, Vector3(inf, 1., 1.)),
+                          Isometry()),
+               std::invalid_argument);
+  EXPECT_THROW(bodies.add(box, nan_pose), std::invalid_argument);
+  EXPECT_EQ(bodies.size(), 2u);
+  EXPECT_EQ(bodies.add(Aabb(), nan_pose), 2u);
+  bodies.clear();
+  EXPECT_TRUE(bodies.empty());
+  std::vector<Pair> pairs = {Pair(0, 1)};
+  bodies.findPairs(&pairs);
+  EXPECT_TRUE(pairs.empty());
+}
+
+GTEST_TEST(SweepAndPruneTest, TouchingAndEmpty) {
+  SweepAndPrune bodies;
+  const Aabb box(Vector3(0., 0., 0.), Vector3(1., 1., 1.));
+  bodies.add(box, Isometry());
+  // Touching along x, then along y, then apart.
+  bodies.add(box, Isometry::FromTranslation(Vector3(1., 0., 0.)));
+  bodies.add(box, Isometry::FromTranslation(Vector3(0., 1., 0.)));
+  bodies.add(box, Isometry::FromTranslation(Vector3(0., 0., 1.01)));
+  bodies.add(Aabb(), Isometry());
+  EXPECT_TRUE(bodies.bounds(4).empty());
+  EXPECT_EQ(sortedPairs(&bodies),
+            std::vector<Pair>({Pair(0, 1), Pair(0, 2), Pair(1, 2)}));
+}
+
+GTEST_TEST(SweepAndPruneTest, MovingBodies) {
+  // Bodies drifting and turning over frames, against the brute force pairs.
+  std::mt19937 generator(47);
+  std::uniform_real_distribution<double> positions(-20., 20.);
+  std::uniform_real_distribution<double> sizes(0.2, 2.);
+  std::uniform_real_distribution<double> steps(-0.3, 0.3);
+  std::uniform_real_distribution<double> angles(-M_PI, M_PI);
+  SweepAndPrune bodies;
+  std::vector<Vector3> centers;
+  std::vector<Vector3> velocities;
+  std::vector<double> headings;
+  for (int i = 0; i < 400; ++i) {
+    const Vector3 half(sizes(generator), sizes(generator), sizes(generator));
+    centers.emplace_back(positions(generator), positions(generator),
+                         positions(generator));
+    velocities.emplace_back(steps(generator), steps(generator),
+                            steps(generator));
+    headings.push_back(angles(generator));
+    bodies.add(Aabb(-1. * half, half),
+               Isometry::FromTranslation(centers.back()));
+  }
+  std::vector<Isometry> poses(centers.size());
+  std::size_t total = 0;
+  for (int frame = 0; frame < 30; ++frame) {
+    for (std::size_t i = 0; i < centers.size(); ++i) {
+      centers[i] = centers[i] + velocities[i];
+      headings[i] += 0.05;
+      poses[i] = Isometry::FromTranslation(centers[i]) *
+                 Isometry::FromEulerAngles(headings[i], 0.3, 0.);
+    }
+    bodies.setPoses(poses);
+    const std::vector<Pair> pairs = sortedPairs(&bodies);
+    EXPECT_EQ(pairs, bruteForcePairs(bodies));
+    total += pairs.size();
+  }
+  EXPECT_GT(total, 100u);
+}
+
+GTEST_TEST(SweepAndPruneTest, SwitchesAxis) {
+  // A row of boxes along z, spread little along x.
+  SweepAndPrune bodies;
+  const Aabb box(Vector3(-0.6, -0.6, -0.6), Vector3(0.6, 0.6, 0.6));
+  for (int i = 0; i < 50; ++i) {
+    bodies.add(box, Isometry::FromTranslation(Vector3(0.01 * (i % 3), 0.,
+                                                      static_cast<double>(i))));
+  }
+  std::vector<Pair> expected;
+  for (std::uint32_t i = 0; i + 1 < 50; ++i) {
+    expected.emplace_back(i, i + 1);
+  }
+  EXPECT_EQ(sortedPairs(&bodies), expected);
+  EXPECT_EQ(bodies.axis(), 2);
+  EXPECT_EQ(sortedPairs(&bodies), expected);
+}
+
+}  // namespace test
+}  // namespace math
+}  // namespace ekumen
+
+int main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
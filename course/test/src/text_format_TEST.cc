@@ -0,0 +1,201 @@
+#include "text_format.h"
+#include "isometry.h"
+#include "matrix3.h"
+#include "vector3.h"
+
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <limits>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace ekumen {
+namespace math {
+namespace test {
+namespace {
+const Vector3 kPoint(1. / 3., -2.5e-7, 12345678.9);
+const Isometry kPose{Isometry::RotateAround(Vector3(1., 2., -1.), 0.7) *
+                     Isometry::FromTranslation(kPoint)};
+
+template <typename T>
+std::string format(const T& obj, int precision) {
+  char buffer[TextFormat::kMaxIsometrySize];
+  const std::size_t length =
+      TextFormat::Format(obj, buffer, sizeof(buffer), precision);
+  EXPECT_EQ(length, std::string(buffer).size());
+  return std::string(buffer, length);
+}
+
+template <typename T>
+std::string stream(const T& obj) {
+  std::ostringstream os;
+  os << obj;
+  return os.str();
+}
+}  // namespace
+
+GTEST_TEST(TextFormatTest, MatchesStreamFormat) {
+  EXPECT_EQ(format(kPoint, TextFormat::kStreamPrecision),
+            "(x: 0.333333, y: -2.5e-07, z: 1.23457e+07)");
+  EXPECT_EQ(format(Matrix3::kIdentity, TextFormat::kMatrixPrecision),
+            "[[1, 0, 0], [0, 1, 0], [0, 0, 1]]");
+  EXPECT_EQ(format(Isometry::RotateAround(Vector3::kUnitZ, M_PI / 8.),
+                   TextFormat::kStreamPrecision),
+            "[T: (x: 0, y: 0, z: 0), R:[[0.923879533, -0.382683432, 0], "
+            "[0.382683432, 0.923879533, 0], [0, 0, 1]]]");
+}
+
+GTEST_TEST(TextFormatTest, OperatorsUseStreamPrecision) {
+  std::ostringstream os;
+  os << std::setprecision(3) << kPoint;
+  EXPECT_EQ(os.str(), format(kPoint, 3));
+
+  // Non-default flags take the stream path.
+  std::ostringstream fixed;
+  fixed << std::fixed << std::setprecision(2) << Vector3(1., 2.5, -3.);
+  EXPECT_EQ(fixed.str(), "(x: 1.00, y: 2.50, z: -3.00)");
+  std::ostringstream fixed_pose;
+  fixed_pose << std::fixed << std::setprecision(1)
+             << Isometry::FromTranslation({1., 2., 3.});
+  EXPECT_EQ(fixed_pose.str(),
+            "[T: (x: 1.0, y: 2.0, z: 3.0), R:[[1, 0, 0], [0, 1, 0], [0, 0, "
+            "1]]]");
+
+  EXPECT_EQ(stream(kPose), format(kPose, TextFormat::kStreamPrecision));
+  EXPECT_EQ(stream(kPose.rotation()),
+            format(kPose.rotation(), TextFormat::kMatrixPrecision));
+}
+
+GTEST_TEST(TextFormatTest, MatchesPrintf) {
+  std::mt19937_64 generator(42);
+  std::uniform_real_distribution<double> mantissa(-10., 10.);
+  std::uniform_int_distribution<int> exponent(-40, 40);
+  std::vector<double> values = {0.5,   2.5,  0.25, 9.9999995, 999999.5, 1e-5,
+                                1e-4,  1e15, 1e16, 1e17,      -0.,      0.,
+                                1e300, 5e-324, 1e-310, 0.1, 0.3, 123456.,
+                                1234567.};
+  values.push_back(std::numeric_limits<double>::infinity());
+  for (int i = 0; i < 20000; ++i) {
+    values.push_back(mantissa(generator) * std::pow(10., exponent(generator)));
+  }
+  for (const double value : values) {
+    for (int precision = 0; precision <= TextFormat::kMaxPrecision;
+         ++precision) {
+      char expected[64];
+      std::snprintf(expected, sizeof(expected), "%.*g", precision, value);
+      char buffer[TextFormat::kMaxScalarSize];
+      TextFormat::Format(value, buffer, sizeof(buffer), precision);
+      ASSERT_EQ(std::string(buffer), std::string(expected))
+          << "precision " << precision;
+    }
+  }
+}
+
+GTEST_TEST(TextFormatTest, RoundTrip) {
+  std::mt19937_64 generator(7);
+  std::uniform_int_distribution<std::uint64_t> bits;
+  std::vector<double> values = {0.1,
+                                1. / 3.,
+                                -2.5e-7,
+                                1e300,
+                                -0.,
+                                5e-324,
+                                M_PI,
+                                123456789012345678.,
+                                std::ldexp(1., 52),
+                                std::ldexp(1., -3),
+                                std::numeric_limits<double>::max()};
+  for (int i = 0; i < 20000; ++i) {
+    // Random mantissas over exponents around 1.
+    const std::uint64_t value_bits =
+        (bits(generator) & 0x800fffffffffffffull) |
+        (static_cast<std::uint64_t>(1023 - 60 + i % 160) << 52);
+    double value;
+    std::memcpy(&value, &value_bits, sizeof(value));
+    values.push_back(value);
+  }
+  for (const double value : values) {
+    char buffer[TextFormat::kMaxScalarSize];
+    TextFormat::Format(value, buffer, sizeof(buffer));
+    ASSERT_EQ(std::strtod(buffer, nullptr), value) << buffer;
+    // No shorter precision of those tried round-trips.
+    char shorter[64];
+    for (int digits = 15; digits < 17; ++digits) {
+      std::snprintf(shorter, sizeof(shorter), "%.*g", digits, value);
+      if (std::strtod(shorter, nullptr) == value) {
+        EXPECT_LE(std::string(buffer).size(), std::string(shorter).size());
+        break;
+      }
+    }
+  }
+  char buffer[TextFormat::kMaxScalarSize];
+  TextFormat::Format(0.1, buffer, sizeof(buffer));
+  EXPECT_EQ(std::string(buffer), "0.1");
+
+  const std::string text = format(kPose, TextFormat::kRoundTrip);
+  EXPECT_NE(text.find(", R:[["), std::string::npos);
+  const std::string translation = format(kPose.translation(), 17);
+  EXPECT_EQ(std::strtod(translation.c_str() + 4, nullptr),
+            kPose.translation().x());
+}
+
+GTEST_TEST(TextFormatTest, SmallBuffersThrow) {
+  char buffer[TextFormat::kMaxVector3Size];
+  const std::size_t length = TextFormat::Format(kPoint, buffer, sizeof(buffer));
+  EXPECT_NO_THROW(TextFormat::Format(kPoint, buffer, length + 1));
+  EXPECT_THROW(TextFormat::Format(kPoint, buffer, length), std::length_error);
+  EXPECT_THROW(TextFormat::Format(kPoint, buffer, 0), std::length_error);
+  EXPECT_THROW(TextFormat::Format(kPoint, buffer, sizeof(buffer), 18),
+               std::invalid_argument);
+}
+
+GTEST_TEST(TextFormatTest, MaxSizesFit) {
+  const double worst = -std::numeric_limits<double>::denorm_min() * 3.;
+  const Vector3 v(worst, -1.2345678901234567e-308, worst);
+  const Matrix3 m(v, v, v);
+  const Isometry pose(v, m);
+  char buffer[TextFormat::kMaxIsometrySize];
+  EXPECT_LT(TextFormat::Format(v, buffer, TextFormat::kMaxVector3Size,
+                               TextFormat::kMaxPrecision),
+            TextFormat::kMaxVector3Size);
+  EXPECT_LT(TextFormat::Format(m, buffer, TextFormat::kMaxMatrix3Size,
+                               TextFormat::kMaxPrecision),
+            TextFormat::kMaxMatrix3Size);
+  EXPECT_LT(TextFormat::Format(pose, buffer, TextFormat::kMaxIsometrySize,
+                               TextFormat::kRoundTrip),
+            TextFormat::kMaxIsometrySize);
+}
+
+GTEST_TEST(TextFormatTest, WriteLines) {
+  std::vector<Isometry> poses;
+  std::ostringstream expected;
+  for (int i = 0; i < 500; ++i) {
+    poses.push_back(Isometry::RotateAround(Vector3::kUnitX, 0.01 * i) *
+                    Isometry::FromTranslation({0.1 * i, 1., -2.}));
+    expected << poses.back() << "\n";
+  }
+  std::ostringstream os;
+  TextFormat::WriteLines(poses, TextFormat::kStreamPrecision, &os);
+  EXPECT_EQ(os.str(), expected.str());
+
+  std::ostringstream empty;
+  TextFormat::WriteLines(std::vector<Vector3>(), 6, &empty);
+  EXPECT_TRUE(empty.str().empty());
+}
+
+}  // namespace test
+}  // namespace math
+}  // namespace ekumen
+
+int main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,242 @@
+#include "text_parser.h"
+#include "isometry.h"
+#include "matrix3.h"
+#include "text_format.h"
+#include "vector3.h"
+
+#include <clocale>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace ekumen {
+namespace math {
+namespace test {
+namespace {
+ParseStatus parseNumber(const std::string& text, double* res) {
+  return TextParser::Parse(text.data(), text.data() + text.size(), res);
+}
+}  // namespace
+
+GTEST_TEST(TextParserTest, Numbers) {
+  double value;
+  for (const char* text :
+       {"0", "-0", "1", "+2.5", "-2.5e-07", "1.23457e+07", "0.923879533",
+        "1e22", "1e23", "123456789012345678", "0.000000000000000000001234",
+        "1.7976931348623157e308", "4.9406564584124654e-324", "1e-400",
+        "1234567890123456789012345", "3.", ".5"}) {
+    const ParseStatus status = parseNumber(text, &value);
+    ASSERT_TRUE(status.ok()) << text;
+    EXPECT_EQ(status.offset, std::strlen(text));
+    EXPECT_EQ(value, std::strtod(text, nullptr)) << text;
+  }
+  EXPECT_TRUE(std::signbit((parseNumber("-0", &value), value)));
+
+  ASSERT_TRUE(parseNumber("-inf", &value).ok());
+  EXPECT_EQ(value, -std::numeric_limits<double>::infinity());
+  ASSERT_TRUE(parseNumber("nan", &value).ok());
+  EXPECT_TRUE(std::isnan(value));
+
+  // Parsing stops at the first character that is not part of the number.
+  const ParseStatus prefix = parseNumber("12.5, 3", &value);
+  ASSERT_TRUE(prefix.ok());
+  EXPECT_EQ(prefix.offset, 4u);
+  EXPECT_EQ(value, 12.5);
+
+  const ParseStatus empty = parseNumber("", &value);
+  EXPECT_FALSE(empty.ok());
+  EXPECT_EQ(empty.offset, 0u);
+  const ParseStatus no_digits = parseNumber("-x", &value);
+  EXPECT_FALSE(no_digits.ok());
+  EXPECT_EQ(no_digits.offset, 1u);
+  const ParseStatus no_exponent = parseNumber("1e+", &value);
+  EXPECT_FALSE(no_exponent.ok());
+  EXPECT_EQ(no_exponent.offset, 3u);
+}
+
+GTEST_TEST(TextParserTest, NumbersMatchStrtod) {
+  std::mt19937_64 generator(3);
+  std::uniform_real_distribution<double> mantissa(-10., 10.);
+  std::uniform_int_distribution<int> exponent(-30, 30);
+  for (int i = 0; i < 20000; ++i) {
+    const double expected =
+        mantissa(generator) * std::pow(10., exponent(generator));
+    for (const int precision : {6, 9, 17}) {
+      char text[64];
+      std::snprintf(text, sizeof(text), "%.*g", precision, expected);
+      double value;
+      ASSERT_TRUE(parseNumber(text, &value).ok()) << text;
+      ASSERT_EQ(value, std::strtod(text, nullptr)) << text;
+    }
+  }
+}
+
+GTEST_TEST(TextParserTest, IgnoresGlobalLocale) {
+  // Numbers off the exact fast paths, parsed and formatted through the C
+  // library, under a global locale with a decimal comma when there is one.
+  const char* const texts[] = {"1.5e300", "0.12345678901234567890123",
+                               "4.9406564584124654e-324"};
+  std::vector<double> expected;
+  for (const char* text : texts) {
+    expected.push_back(std::strtod(text, nullptr));
+  }
+  std::string locale = "C";
+  for (const char* name : {"de_DE.UTF-8", "de_DE.utf8", "fr_FR.UTF-8",
+                           "ru_RU.UTF-8", "de_DE", "fr_FR"}) {
+    if (std::setlocale(LC_NUMERIC, name) != nullptr) {
+      locale = name;
+      break;
+    }
+  }
+  for (std::size_t i = 0; i < expected.size(); ++i) {
+    double value;
+    const ParseStatus status = parseNumber(texts[i], &value);
+    ASSERT_TRUE(status.ok()) << locale << " " << texts[i];
+    EXPECT_EQ(status.offset, std::strlen(texts[i]));
+    EXPECT_EQ(value, expected[i]) << locale << " " << texts[i];
+    char text[TextFormat::kMaxScalarSize];
+    TextFormat::Format(expected[i], text, sizeof(text));
+    EXPECT_EQ(std::strchr(text, ','), nullptr) << locale << " " << text;
+    ASSERT_TRUE(parseNumber(text, &value).ok()) << locale << " " << text;
+    EXPECT_EQ(value, expected[i]) << locale << " " << text;
+  }
+  std::setlocale(LC_NUMERIC, "C");
+}
+
+GTEST_TEST(TextParserTest, ParsesStreamFormat) {
+  const Isometry pose = Isometry::RotateAround(Vector3(1., 2., -1.), 0.7) *
+                        Isometry::FromTranslation({0.25, -3., 1e-9});
+  std::ostringstream os;
+  os << pose;
+  const Isometry parsed = TextParser::Parse<Isometry>(os.str());
+  // The stream writes 6 digits for the translation and 9 for the rotation.
+  for (int i = 0; i < 3; ++i) {
+    EXPECT_NEAR(parsed.translation()[i], pose.translation()[i], 1e-5);
+    for (int j = 0; j < 3; ++j) {
+      EXPECT_NEAR(parsed.rotation()[i][j], pose.rotation()[i][j], 1e-9);
+    }
+  }
+
+  EXPECT_EQ(TextParser::Parse<Vector3>("(x: 1, y: -2.5, z: 3e+10)"),
+            Vector3(1., -2.5, 3e10));
+  EXPECT_EQ(TextParser::Parse<Matrix3>("[[1, 0, 0], [0, 1, 0], [0, 0, 1]]"),
+            Matrix3::kIdentity);
+}
+
+GTEST_TEST(TextParserTest, RoundTripsTextFormat) {
+  const Isometry pose = Isometry::RotateAround(Vector3(0.3, -1., 2.), 2.1) *
+                        Isometry::FromTranslation({1. / 3., M_PI, -1e-12});
+  char buffer[TextFormat::kMaxIsometrySize];
+  const std::size_t length = TextFormat::Format(
+      pose, buffer, sizeof(buffer), TextFormat::kRoundTrip);
+  Isometry parsed;
+  const ParseStatus status =
+      TextParser::Parse(buffer, buffer + length, &parsed);
+  ASSERT_TRUE(status.ok());
+  EXPECT_EQ(status.offset, length);
+  for (int i = 0; i < 3; ++i) {
+    EXPECT_EQ(parsed.translation()[i], pose.translation()[i]);
+    for (int j = 0; j < 3; ++j) {
+      EXPECT_EQ(parsed.rotation()[i][j], pose.rotation()[i][j]);
+    }
+  }
+}
+
+GTEST_TEST(TextParserTest, ErrorsHaveOffsets) {
+  const std::string text = "(x: 1, y: 2,z: 3)";
+  Vector3 vector(7., 8., 9.);
+  const ParseStatus status =
+      TextParser::Parse(text.data(), text.data() + text.size(), &vector);
+  EXPECT_FALSE(status.ok());
+  EXPECT_EQ(status.offset, 12u);
+  // The output is left untouched.
+  EXPECT_EQ(vector, Vector3(7., 8., 9.));
+
+  // Input is never read past its end.
+  const std::string truncated = "(x: 1, y: 2, z: 3)";
+  const ParseStatus short_status = TextParser::Parse(
+      truncated.data(), truncated.data() + truncated.size() - 1, &vector);
+  EXPECT_FALSE(short_status.ok());
+  EXPECT_EQ(short_status.offset, truncated.size() - 1);
+
+  EXPECT_THROW(TextParser::Parse<Vector3>("(x: 1, y: 2, z: 3) "),
+               std::invalid_argument);
+  EXPECT_THROW(TextParser::Parse<Matrix3>("[[1, 0, 0], [0, 1, 0]]"),
+               std::invalid_argument);
+  try {
+    TextParser::Parse<Isometry>("[T: (x: 0, y: 0, z: 0), R:[[1, 0, 0]]]");
+    FAIL();
+  } catch (const std::invalid_argument& error) {
+    EXPECT_NE(std::string(error.what()).find("offset 36"), std::string::npos)
+        << error.what();
+  }
+}
+
+GTEST_TEST(TextParserTest, LineReader) {
+  std::string text;
+  for (int i = 0; i < 1000; ++i) {
+    text += std::string(i % 37, 'a' + i % 26) + (i % 3 == 0 ? "\r\n" : "\n");
+  }
+  text += "last";
+  std::istringstream is(text);
+  // A tiny buffer forces refills and growth.
+  LineReader reader(&is, 8);
+  const char* begin;
+  const char* end;
+  for (int i = 0; i < 1000; ++i) {
+    ASSERT_TRUE(reader.Next(&begin, &end));
+    EXPECT_EQ(std::string(begin, end), std::string(i % 37, 'a' + i % 26));
+  }
+  ASSERT_TRUE(reader.Next(&begin, &end));
+  EXPECT_EQ(std::string(begin, end), "last");
+  EXPECT_FALSE(reader.Next(&begin, &end));
+  EXPECT_EQ(reader.lineNumber(), 1001u);
+
+  std::istringstream empty("");
+  LineReader empty_reader(&empty);
+  EXPECT_FALSE(empty_reader.Next(&begin, &end));
+}
+
+GTEST_TEST(TextParserTest, ParseLines) {
+  std::vector<Isometry> poses;
+  for (int i = 0; i < 2000; ++i) {
+    poses.push_back(Isometry::RotateAround(Vector3::kUnitZ, 0.001 * i) *
+                    Isometry::FromTranslation({0.5 * i, 1., -2.}));
+  }
+  std::ostringstream os;
+  TextFormat::WriteLines(poses, TextFormat::kRoundTrip, &os);
+  std::istringstream is(os.str() + "\n");
+  std::vector<Isometry> parsed;
+  TextParser::ParseLines(&is, &parsed);
+  ASSERT_EQ(parsed.size(), poses.size());
+  for (std::size_t i = 0; i < poses.size(); ++i) {
+    EXPECT_EQ(parsed[i], poses[i]);
+  }
+
+  std::istringstream bad("(x: 1, y: 2, z: 3)\n(x: 1, y: 2, z 3)\n");
+  std::vector<Vector3> vectors;
+  try {
+    TextParser::ParseLines(&bad, &vectors);
+    FAIL();
+  } catch (const std::invalid_argument& error) {
+    EXPECT_NE(std::string(error.what()).find("Line 2, offset 14"),
+              std::string::npos)
+        << error.what();
+  }
+}
+
+}  // namespace test
+}  // namespace math
+}  // namespace ekumen
+
+int main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
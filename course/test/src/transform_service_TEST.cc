@@ -0,0 +1,296 @@
+#include "transform_service.h"
+#include "isometry.h"
+#include "vector3.h"
+
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace ekumen {
+namespace math {
+namespace test {
+namespace {
+constexpr double kTolerance{1e-12};
+
+std::string socketPath() {
+  return "/tmp/transform_service_TEST_" + std::to_string(::getpid());
+}
+
+Isometry makePose(double x, double angle) {
+  return Isometry::FromTranslation(Vector3(x, 1., -2.)) *
+         Isometry::RotateAround(Vector3(1., 2., 3.), angle);
+}
+
+void expectNear(const Vector3& a, const Vector3& b) {
+  EXPECT_NEAR(a.x(), b.x(), kTolerance);
+  EXPECT_NEAR(a.y(), b.y(), kTolerance);
+  EXPECT_NEAR(a.z(), b.z(), kTolerance);
+}
+
+std::vector<Vector3> makePoints(std::size_t count) {
+  std::vector<Vector3> res;
+  for (std::size_t i = 0; i < count; ++i) {
+    res.emplace_back(0.5 * i, -1. * i, 1e-3 * i);
+  }
+  return res;
+}
+
+// Connects a raw socket to the server, to send malformed messages.
+int connectRaw(const std::string& path) {
+  sockaddr_un address;
+  std::memset(&address, 0, sizeof(address));
+  address.sun_family = AF_UNIX;
+  std::memcpy(address.sun_path, path.data(), path.size());
+  const int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+  if (fd < 0 || ::connect(fd, reinterpret_cast<const sockaddr*>(&address),
+                          sizeof(address)) != 0) {
+    throw std::runtime_error("Cannot connect.");
+  }
+  return fd;
+}
+}  // namespace
+
+GTEST_TEST(TransformServiceTest, LatencyHistogram) {
+  LatencyHistogram histogram;
+  EXPECT_EQ(histogram.count(), 0u);
+  EXPECT_EQ(histogram.quantile(0.5), 0.);
+  histogram.record(0.);
+  histogram.record(3e-9);
+  for (int i = 0; i < 98; ++i) {
+    histogram.record(1e-6);
+  }
+  EXPECT_EQ(histogram.count(), 100u);
+  EXPECT_EQ(histogram.bucketCount(0), 1u);
+  EXPECT_EQ(histogram.bucketCount(1), 1u);
+  // 1000 ns is in [512, 1024).
+  EXPECT_EQ(histogram.bucketCount(9), 98u);
+  EXPECT_DOUBLE_EQ(histogram.quantile(0.01), 2e-9);
+  EXPECT_DOUBLE_EQ(histogram.quantile(0.5), 1024e-9);
+  EXPECT_DOUBLE_EQ(LatencyHistogram::BucketLimit(9), 1024e-9);
+  EXPECT_THROW(histogram.bucketCount(LatencyHistogram::kNumBuckets),
+               std::out_of_range);
+}
+
+GTEST_TEST(TransformServiceTest, Queries) {
+  const std::string path = socketPath();
+  TransformServer server(path);
+  server.setStatic("base", "camera", makePose(0.5, 0.3));
+  TransformClient client(path);
+  client.set("map", "base", 0., makePose(0., 0.));
+  client.set("map", "base", 2., makePose(2., 0.));
+
+  const std::vector<Vector3> points = makePoints(1000);
+  const std::vector<Vector3> res =
+      client.transformPoints("map", "camera", 1., points);
+  ASSERT_EQ(res.size(), points.size());
+  const Isometry pose = makePose(1., 0.) * makePose(0.5, 0.3);
+  for (std::size_t i = 0; i < points.size(); ++i) {
+    expectNear(res[i], pose * points[i]);
+  }
+  EXPECT_TRUE(client.transformPoints("camera", "map", 0., {}).empty());
+
+  // Batched queries, one of which fails.
+  std::vector<TransformClient::Query> queries{
+      {"camera", "base", 5., makePoints(3)},
+      {"map", "camera", 1., makePoints(2)},
+      {"gps", "camera", 1., makePoints(1)},
+      {"map", "camera", 10., makePoints(1)},
+  };
+  EXPECT_THROW(client.transformPoints(queries), std::out_of_range);
+  queries.resize(2);
+  const std::vector<std::vector<Vector3>> batch =
+      client.transformPoints(queries);
+  ASSERT_EQ(batch.size(), 2u);
+  ASSERT_EQ(batch[0].size(), 3u);
+  expectNear(batch[0][2], makePose(0.5, 0.3).inverse() * makePoints(3)[2]);
+  ASSERT_EQ(batch[1].size(), 2u);
+  expectNear(batch[1][1], pose * makePoints(2)[1]);
+
+  EXPECT_THROW(client.set("base", "map", 0., Isometry()),
+               std::invalid_argument);
+  EXPECT_THROW(client.setStatic("map", "base", Isometry()),
+               std::invalid_argument);
+  // 12 requests so far, and the latency request is counted once replied.
+  const LatencyHistogram latency = client.latency();
+  EXPECT_EQ(latency.count(), 12u);
+  EXPECT_EQ(server.latency().count(), 13u);
+}
+
+GTEST_TEST(TransformServiceTest, ConcurrentClients) {
+  const std::string path = socketPath();
+  TransformServer server(path);
+  server.set("map", "base", 0., makePose(1., 0.5));
+  const std::vector<Vector3> points = makePoints(100000);
+
+  std::vector<std::thread> threads;
+  std::vector<int> passed(4, 0);
+  for (std::size_t i = 0; i < passed.size(); ++i) {
+    threads.emplace_back([&, i]() {
+      TransformClient client(path);
+      bool ok = true;
+      for (int j = 0; j < 3; ++j) {
+        const std::vector<Vector3> res =
+            client.transformPoints("base", "map", 0., points);
+        ok = ok && res.size() == points.size() &&
+             res.back() == makePose(1., 0.5).inverse() * points.back();
+      }
+      passed[i] = ok ? 1 : 0;
+    });
+  }
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+  for (int ok : passed) {
+    EXPECT_EQ(ok, 1);
+  }
+}
+
+GTEST_TEST(TransformServiceTest, LargeBatch) {
+  // Requests and replies far larger than the socket buffers, which neither
+  // end can send whole before the other reads.
+  const std::string path = socketPath();
+  TransformServer server(path);
+  server.set("map", "base", 0., makePose(1., 0.5));
+  TransformClient client(path);
+  const std::vector<TransformClient::Query> queries(
+      60, TransformClient::Query{"base", "map", 0., makePoints(20000)});
+  const std::vector<std::vector<Vector3>> res =
+      client.transformPoints(queries);
+  ASSERT_EQ(res.size(), queries.size());
+  for (const std::vector<Vector3>& points : res) {
+    ASSERT_EQ(points.size(), 20000u);
+    expectNear(points.back(),
+               makePose(1., 0.5).inverse() * makePoints(20000).back());
+  }
+  EXPECT_EQ(client.latency().count(), 60u);
+}
+
+GTEST_TEST(TransformServiceTest, ShutDownWrites) {
+  // Requests sent before shutting down writes are all replied.
+  const std::string path = socketPath();
+  TransformServer server(path);
+  const int fd = connectRaw(path);
+  const std::uint32_t requests[6] = {4, 3, 4, 3, 4, 3};
+  ASSERT_EQ(::send(fd, requests, sizeof(requests), 0),
+            static_cast<ssize_t>(sizeof(requests)));
+  ASSERT_EQ(::shutdown(fd, SHUT_WR), 0);
+  const std::size_t reply_size = 2 * sizeof(std::uint32_t) +
+                                 LatencyHistogram::kNumBuckets *
+                                     sizeof(std::uint64_t);
+  std::vector<char> replies(3 * reply_size);
+  ASSERT_EQ(::recv(fd, replies.data(), replies.size(), MSG_WAITALL),
+            static_cast<ssize_t>(replies.size()));
+  char byte;
+  EXPECT_EQ(::recv(fd, &byte, 1, 0), 0);
+  ::close(fd);
+  EXPECT_EQ(server.latency().count(), 3u);
+}
+
+GTEST_TEST(TransformServiceTest, MalformedRequests) {
+  const std::string path = socketPath();
+  TransformServer server(path);
+  const int fd = connectRaw(path);
+
+  // An unknown request type gets an error reply.
+  const std::uint32_t request[2] = {4, 99};
+  ASSERT_EQ(::send(fd, request, sizeof(request), 0),
+            static_cast<ssize_t>(sizeof(request)));
+  std::uint32_t reply[2];
+  ASSERT_EQ(::recv(fd, reply, sizeof(reply), MSG_WAITALL),
+            static_cast<ssize_t>(sizeof(reply)));
+  EXPECT_EQ(reply[1],
+            static_cast<std::uint32_t>(TransformStatus::kBadRequest));
+  std::vector<char> message(reply[0] - sizeof(reply[1]));
+  ASSERT_EQ(::recv(fd, message.data(), message.size(), MSG_WAITALL),
+            static_cast<ssize_t>(message.size()));
+
+  // Oversized messages drop the connection.
+  const std::uint32_t size = TransformServer::kMaxPayloadSize + 1;
+  ASSERT_EQ(::send(fd, &size, sizeof(size), 0),
+            static_cast<ssize_t>(sizeof(size)));
+  char byte;
+  EXPECT_EQ(::recv(fd, &byte, 1, 0), 0);
+  ::close(fd);
+
+  // The server keeps serving other clients.
+  TransformClient client(path);
+  EXPECT_EQ(client.latency().count(), 1u);
+}
+
+GTEST_TEST(TransformServiceTest, AcceptErrorsBackOff) {
+  // A server without file descriptors left fails to accept a pending
+  // connection, which keeps the listening socket readable. It must not
+  // spin on it: the child process reports its CPU time.
+  const std::string path = socketPath();
+  int ready[2];
+  ASSERT_EQ(::pipe(ready), 0);
+  const pid_t pid = ::fork();
+  ASSERT_GE(pid, 0);
+  if (pid == 0) {
+    ::close(ready[0]);
+    TransformServer server(path);
+    // The lowest free descriptor becomes the limit, so none is left.
+    const int free_fd = ::dup(0);
+    ::close(free_fd);
+    rlimit limit;
+    ::getrlimit(RLIMIT_NOFILE, &limit);
+    limit.rlim_cur = static_cast<rlim_t>(free_fd);
+    ::setrlimit(RLIMIT_NOFILE, &limit);
+    const char byte = 0;
+    if (::write(ready[1], &byte, 1) != 1) {
+      ::_exit(2);
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(500));
+    rusage usage;
+    ::getrusage(RUSAGE_SELF, &usage);
+    const double seconds = usage.ru_utime.tv_sec + usage.ru_stime.tv_sec +
+                           1e-6 * (usage.ru_utime.tv_usec +
+                                   usage.ru_stime.tv_usec);
+    ::_exit(seconds < 0.2 ? 0 : 1);
+  }
+  ::close(ready[1]);
+  char byte;
+  ASSERT_EQ(::read(ready[0], &byte, 1), 1);
+  ::close(ready[0]);
+  const int fd = connectRaw(path);
+  int status = 0;
+  ASSERT_EQ(::waitpid(pid, &status, 0), pid);
+  ::close(fd);
+  ASSERT_TRUE(WIFEXITED(status));
+  EXPECT_EQ(WEXITSTATUS(status), 0);
+}
+
+GTEST_TEST(TransformServiceTest, Lifetime) {
+  const std::string path = socketPath();
+  {
+    TransformServer server(path);
+    EXPECT_EQ(::access(path.c_str(), F_OK), 0);
+  }
+  EXPECT_NE(::access(path.c_str(), F_OK), 0);
+  EXPECT_THROW(TransformClient client(path), std::runtime_error);
+  EXPECT_THROW(TransformServer server(std::string(200, 'a')),
+               std::invalid_argument);
+  EXPECT_THROW(TransformServer server("/nonexistent/socket"),
+               std::runtime_error);
+}
+
+}  // namespace test
+}  // namespace math
+}  // namespace ekumen
+
+int main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,246 @@
+#include "transform_table.h"
+#include "isometry.h"
+#include "vector3.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace ekumen {
+namespace math {
+namespace test {
+namespace {
+// Exit codes of reader processes.
+constexpr int kReaderPassed = 0;
+constexpr int kReaderTornRead = 1;
+constexpr int kReaderVersionWentBack = 2;
+constexpr int kReaderTimedOut = 3;
+constexpr int kReaderFailed = 4;
+
+// Shared memory names are global, so they include the process id.
+std::string tableName(const std::string& suffix) {
+  return "/transform_table_TEST_" + std::to_string(::getpid()) + "_" + suffix;
+}
+
+// Unlinks a table when going out of scope.
+class TableGuard {
+ public:
+  explicit TableGuard(const std::string& name) : name_(name) {}
+  ~TableGuard() { TransformTableWriter::Unlink(name_); }
+
+ private:
+  std::string name_;
+};
+
+// Update 'k' of the stress test. Every scalar depends on 'k', so that a read
+// that mixes two updates is detected.
+Isometry makeUpdate(int k) {
+  return Isometry(Vector3(k, 2. * k, -k),
+                  Isometry::RotateAround(Vector3::kUnitZ, 1e-3 * k).rotation());
+}
+
+// Reads 'frame' until it holds update 'last', checking every read.
+int runReader(const std::string& name, const std::string& frame, int last) {
+  try {
+    const TransformTableReader reader(name);
+    const auto deadline =
+        std::chrono::steady_clock::now() + std::chrono::seconds(60);
+    std::size_t index;
+    while (!reader.find(frame, &index)) {
+      if (std::chrono::steady_clock::now() > deadline) {
+        return kReaderTimedOut;
+      }
+    }
+    std::uint64_t previous_version = 0;
+    for (;;) {
+      Isometry pose;
+      const std::uint64_t version = reader.read(index, &pose);
+      const int k = static_cast<int>(pose.translation().x());
+      if (pose != makeUpdate(k) || pose.translation().y() != 2. * k ||
+          pose.translation().z() != -k) {
+        return kReaderTornRead;
+      }
+      if (version < previous_version) {
+        return kReaderVersionWentBack;
+      }
+      previous_version = version;
+      if (k == last) {
+        return kReaderPassed;
+      }
+      if (std::chrono::steady_clock::now() > deadline) {
+        return kReaderTimedOut;
+      }
+    }
+  } catch (...) {
+    return kReaderFailed;
+  }
+}
+}  // namespace
+
+GTEST_TEST(TransformTableTest, WriteAndRead) {
+  const std::string name = tableName("basic");
+  const TableGuard guard(name);
+  TransformTableWriter writer(name, 3);
+  EXPECT_EQ(writer.capacity(), 3u);
+  EXPECT_EQ(writer.size(), 0u);
+
+  const TransformTableReader reader(name);
+  EXPECT_EQ(reader.size(), 0u);
+  std::size_t index;
+  EXPECT_FALSE(reader.find("base_link", &index));
+  EXPECT_THROW(reader.get("base_link"), std::out_of_range);
+
+  const Isometry base = Isometry::FromTranslation(Vector3(1., 2., 3.));
+  const Isometry camera = Isometry::RotateAround(Vector3(1., 1., 0.), 0.3);
+  writer.set("base_link", base);
+  writer.set("camera", camera);
+  EXPECT_EQ(writer.size(), 2u);
+  ASSERT_EQ(reader.size(), 2u);
+  ASSERT_TRUE(reader.find("camera", &index));
+  EXPECT_EQ(index, 1u);
+  EXPECT_EQ(reader.frameName(index), "camera");
+  EXPECT_FALSE(reader.find("cam", &index));
+  EXPECT_FALSE(reader.find("camera_link", &index));
+  EXPECT_EQ(reader.get("base_link"), base);
+  EXPECT_EQ(reader.get("camera"), camera);
+
+  Isometry pose;
+  EXPECT_EQ(reader.read(0, &pose), 1u);
+  writer.set("base_link", camera);
+  writer.set("base_link", base * camera);
+  EXPECT_EQ(reader.read(0, &pose), 3u);
+  EXPECT_EQ(pose, base * camera);
+  EXPECT_EQ(writer.size(), 2u);
+  EXPECT_THROW(reader.read(2, &pose), std::out_of_range);
+  EXPECT_THROW(reader.frameName(2), std::out_of_range);
+
+  // Readers opened later see the same table.
+  const TransformTableReader late(name);
+  EXPECT_EQ(late.get("camera"), camera);
+}
+
+GTEST_TEST(TransformTableTest, Errors) {
+  const std::string name = tableName("errors");
+  const TableGuard guard(name);
+  EXPECT_THROW(TransformTableReader reader(name), std::runtime_error);
+  EXPECT_THROW(TransformTableWriter writer(name, 0), std::invalid_argument);
+
+  {
+    TransformTableWriter writer(name, 1);
+    EXPECT_THROW(writer.set("", Isometry()), std::length_error);
+    EXPECT_THROW(writer.set(std::string(64, 'a'), Isometry()),
+                 std::length_error);
+    writer.set(std::string(63, 'a'), Isometry());
+    EXPECT_THROW(writer.set("other", Isometry()), std::length_error);
+    const TransformTableReader reader(name);
+    std::size_t index;
+    EXPECT_TRUE(reader.find(std::string(63, 'a'), &index));
+    EXPECT_FALSE(reader.find(std::string(64, 'a'), &index));
+  }
+
+  // Other shared memory objects are rejected.
+  TransformTableWriter::Unlink(name);
+  const int fd = ::shm_open(name.c_str(), O_RDWR | O_CREAT, 0600);
+  ASSERT_GE(fd, 0);
+  ASSERT_EQ(::ftruncate(fd, 4096), 0);
+  ::close(fd);
+  EXPECT_THROW(TransformTableReader reader(name), std::runtime_error);
+}
+
+GTEST_TEST(TransformTableTest, CorruptTable) {
+  // A writer that stores a size above the capacity and a name without its
+  // null character cannot make readers leave the mapping.
+  const std::string name = tableName("corrupt");
+  const TableGuard guard(name);
+  TransformTableWriter writer(name, 4);
+  writer.set("base", Isometry());
+  writer.set("camera", Isometry());
+  const TransformTableReader reader(name);
+
+  const int fd = ::shm_open(name.c_str(), O_RDWR, 0);
+  ASSERT_GE(fd, 0);
+  struct stat status;
+  ASSERT_EQ(::fstat(fd, &status), 0);
+  const std::size_t size = static_cast<std::size_t>(status.st_size);
+  void* data = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  ::close(fd);
+  ASSERT_NE(data, MAP_FAILED);
+  char* bytes = static_cast<char*>(data);
+  // The size is the 64-bit 2 in the header, after the capacity 4.
+  std::size_t offset = 8;
+  std::uint64_t value = 0;
+  for (; offset < 64; offset += 8) {
+    std::memcpy(&value, bytes + offset, sizeof(value));
+    if (value == 2) {
+      break;
+    }
+  }
+  ASSERT_LT(offset, 64u);
+  value = 1000000;
+  std::memcpy(bytes + offset, &value, sizeof(value));
+  char* camera = static_cast<char*>(::memmem(bytes, size, "camera", 6));
+  ASSERT_NE(camera, nullptr);
+  std::memset(camera, 'x', TransformTableWriter::kMaxNameSize + 1);
+
+  EXPECT_EQ(reader.size(), 4u);
+  std::size_t index;
+  EXPECT_FALSE(reader.find("missing", &index));
+  EXPECT_EQ(reader.frameName(1),
+            std::string(TransformTableWriter::kMaxNameSize, 'x'));
+  Isometry pose;
+  EXPECT_THROW(reader.read(4, &pose), std::out_of_range);
+  ::munmap(data, size);
+}
+
+// Runs reader processes against a writer that keeps updating two frames,
+// and checks that no reader ever sees a partial update.
+GTEST_TEST(TransformTableTest, ConcurrentProcesses) {
+  const int kReaders = 4;
+  const int kUpdates = 200000;
+  const std::string name = tableName("processes");
+  const TableGuard guard(name);
+  TransformTableWriter writer(name, 2);
+  writer.set("odom", Isometry());
+
+  std::vector<pid_t> readers;
+  for (int i = 0; i < kReaders; ++i) {
+    const pid_t pid = ::fork();
+    ASSERT_GE(pid, 0);
+    if (pid == 0) {
+      ::_exit(runReader(name, i % 2 == 0 ? "odom" : "map", kUpdates - 1));
+    }
+    readers.push_back(pid);
+  }
+
+  for (int k = 0; k < kUpdates; ++k) {
+    writer.set("odom", makeUpdate(k));
+    writer.set("map", makeUpdate(k));
+  }
+
+  for (pid_t pid : readers) {
+    int status;
+    ASSERT_EQ(::waitpid(pid, &status, 0), pid);
+    ASSERT_TRUE(WIFEXITED(status));
+    EXPECT_EQ(WEXITSTATUS(status), kReaderPassed);
+  }
+}
+
+}  // namespace test
+}  // namespace math
+}  // namespace ekumen
+
+int main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,123 @@
+#include "transform_tree.h"
+#include "isometry.h"
+#include "vector3.h"
+
+#include <limits>
+#include <stdexcept>
+
+#include "gtest/gtest.h"
+
+namespace ekumen {
+namespace math {
+namespace test {
+namespace {
+constexpr double kTolerance{1e-12};
+
+void expectNear(const Isometry& a, const Isometry& b) {
+  for (int i = 0; i < 3; ++i) {
+    EXPECT_NEAR(a.translation()[i], b.translation()[i], kTolerance);
+    for (int j = 0; j < 3; ++j) {
+      EXPECT_NEAR(a.rotation()[i][j], b.rotation()[i][j], kTolerance);
+    }
+  }
+}
+
+Isometry makePose(double x, double y, double z, double angle) {
+  return Isometry::FromTranslation(Vector3(x, y, z)) *
+         Isometry::RotateAround(Vector3(1., 2., 3.), angle);
+}
+}  // namespace
+
+GTEST_TEST(TransformTreeTest, Lookup) {
+  // map -> odom -> base -> {camera, lidar}, and map -> landmark.
+  const Isometry odom = makePose(1., 2., 0., 0.1);
+  const Isometry base = makePose(-3., 0.5, 0., 0.7);
+  const Isometry camera = makePose(0.2, 0., 1., -1.2);
+  const Isometry lidar = makePose(0., 0.1, 1.5, 2.);
+  const Isometry landmark = makePose(10., -4., 2., 0.3);
+  TransformTree tree;
+  tree.set("map", "odom", 1., odom);
+  tree.set("odom", "base", 1., base);
+  tree.setStatic("base", "camera", camera);
+  tree.setStatic("base", "lidar", lidar);
+  tree.set("map", "landmark", 1., landmark);
+  EXPECT_TRUE(tree.hasFrame("map"));
+  EXPECT_TRUE(tree.hasFrame("lidar"));
+  EXPECT_FALSE(tree.hasFrame("gps"));
+
+  expectNear(tree.lookup("map", "map", 1.), Isometry());
+  expectNear(tree.lookup("map", "camera", 1.), odom * base * camera);
+  expectNear(tree.lookup("camera", "map", 1.),
+             (odom * base * camera).inverse());
+  expectNear(tree.lookup("camera", "lidar", 1.), camera.inverse() * lidar);
+  expectNear(tree.lookup("landmark", "lidar", 1.),
+             landmark.inverse() * odom * base * lidar);
+  expectNear(tree.lookup("base", "camera", 123.), camera);
+
+  const Vector3 point(1., -2., 0.5);
+  const Vector3 in_map = tree.lookup("map", "camera", 1.) * point;
+  EXPECT_EQ(tree.lookup("camera", "map", 1.) * in_map, point);
+}
+
+GTEST_TEST(TransformTreeTest, Interpolation) {
+  TransformTree tree;
+  tree.set("world", "robot", 2., makePose(2., 4., 0., 1.));
+  tree.set("world", "robot", 0., makePose(0., 0., 0., 0.));
+  tree.set("world", "robot", 4., makePose(0., 0., 0., 0.));
+  expectNear(tree.lookup("world", "robot", 0.), makePose(0., 0., 0., 0.));
+  expectNear(tree.lookup("world", "robot", 2.), makePose(2., 4., 0., 1.));
+  expectNear(tree.lookup("world", "robot", 0.5),
+             makePose(0.5, 1., 0., 0.25));
+  expectNear(tree.lookup("world", "robot", 3.5), makePose(0.5, 1., 0., 0.25));
+
+  // A sample at the time of another replaces it.
+  tree.set("world", "robot", 2., makePose(4., 4., 0., 0.));
+  expectNear(tree.lookup("world", "robot", 1.), makePose(2., 2., 0., 0.));
+
+  EXPECT_THROW(tree.lookup("world", "robot", -0.1), std::out_of_range);
+  EXPECT_THROW(tree.lookup("world", "robot", 4.1), std::out_of_range);
+}
+
+GTEST_TEST(TransformTreeTest, Cache) {
+  TransformTree tree(1.5);
+  for (int i = 0; i < 10; ++i) {
+    tree.set("world", "robot", i, makePose(i, 0., 0., 0.));
+  }
+  // Samples older than 9 - 1.5 seconds are dropped.
+  expectNear(tree.lookup("world", "robot", 8.5), makePose(8.5, 0., 0., 0.));
+  EXPECT_THROW(tree.lookup("world", "robot", 7.9), std::out_of_range);
+  EXPECT_THROW(TransformTree(0.), std::invalid_argument);
+}
+
+GTEST_TEST(TransformTreeTest, Errors) {
+  TransformTree tree;
+  tree.set("a", "b", 0., Isometry());
+  tree.set("b", "c", 0., Isometry());
+  tree.setStatic("x", "y", Isometry());
+  EXPECT_THROW(tree.set("c", "a", 0., Isometry()), std::invalid_argument);
+  EXPECT_THROW(tree.set("b", "b", 0., Isometry()), std::invalid_argument);
+  EXPECT_THROW(tree.set("x", "c", 0., Isometry()), std::invalid_argument);
+  EXPECT_THROW(tree.set("", "d", 0., Isometry()), std::invalid_argument);
+  EXPECT_THROW(tree.set("a", "d", std::numeric_limits<double>::quiet_NaN(),
+                        Isometry()),
+               std::invalid_argument);
+  EXPECT_THROW(tree.set("x", "y", 0., Isometry()), std::invalid_argument);
+  EXPECT_THROW(tree.setStatic("a", "b", Isometry()), std::invalid_argument);
+  EXPECT_FALSE(tree.hasFrame("d"));
+
+  EXPECT_THROW(tree.lookup("a", "d", 0.), std::out_of_range);
+  EXPECT_THROW(tree.lookup("c", "y", 0.), std::out_of_range);
+
+  // Roots can become children.
+  tree.setStatic("y", "a", Isometry());
+  expectNear(tree.lookup("x", "c", 0.), Isometry());
+}
+
+}  // namespace test
+}  // namespace math
+}  // namespace ekumen
+
+int main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,177 @@
+#include "aabb.h"
+#include "isometry.h"
+#include "triangle_mesh.h"
+#include "vector3.h"
+
+#include <cmath>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace ekumen {
+namespace math {
+namespace test {
+namespace {
+constexpr double kTolerance{1e-12};
+
+// Vertices of a grid of unit cells on z = height, 'size' cells per side.
+std::vector<Vector3> makeGridVertices(std::uint32_t size, double height) {
+  std::vector<Vector3> res;
+  for (std::uint32_t j = 0; j <= size; ++j) {
+    for (std::uint32_t i = 0; i <= size; ++i) {
+      res.emplace_back(i, j, height);
+    }
+  }
+  return res;
+}
+
+// Two triangles per cell, split along the diagonal from (i, j) to
+// (i + 1, j + 1). Cell (i, j) holds triangles 2 * (j * size + i) and the
+// next one.
+TriangleMesh makeGrid(std::uint32_t size, double height = 0.) {
+  std::vector<TriangleMesh::Triangle> triangles;
+  for (std::uint32_t j = 0; j < size; ++j) {
+    for (std::uint32_t i = 0; i < size; ++i) {
+      const std::uint32_t corner = j * (size + 1) + i;
+      triangles.push_back({{corner, corner + 1, corner + size + 2}});
+      triangles.push_back({{corner, corner + size + 2, corner + size + 1}});
+    }
+  }
+  return TriangleMesh(makeGridVertices(size, height), triangles);
+}
+
+Isometry makePose() {
+  return Isometry::FromTranslation(Vector3(1., 2., 3.)) *
+         Isometry::FromEulerAngles(0.3, -0.2, 1.1);
+}
+
+void expectNear(const Vector3& actual, const Vector3& expected) {
+  EXPECT_NEAR(actual.x(), expected.x(), kTolerance);
+  EXPECT_NEAR(actual.y(), expected.y(), kTolerance);
+  EXPECT_NEAR(actual.z(), expected.z(), kTolerance);
+}
+}  // namespace
+
+GTEST_TEST(TriangleMeshTest, Construction) {
+  const TriangleMesh mesh = makeGrid(10);
+  EXPECT_EQ(mesh.numVertices(), 121u);
+  EXPECT_EQ(mesh.numTriangles(), 200u);
+  EXPECT_EQ(mesh.vertex(12), Vector3(1., 1., 0.));
+  EXPECT_EQ(mesh.bvh().size(), 200u);
+  EXPECT_EQ(mesh.bvh().bounds().max, Vector3(10., 10., 0.));
+  EXPECT_THROW(TriangleMesh(makeGridVertices(1, 0.), {{{0, 1, 4}}}),
+               std::invalid_argument);
+}
+
+GTEST_TEST(TriangleMeshTest, Raycast) {
+  const TriangleMesh mesh = makeGrid(100);
+  const Isometry pose = makePose();
+  RayHit hit;
+  // Straight down onto cell (20, 30), below its diagonal.
+  const Vector3 target(20.75, 30.25, 0.);
+  const Vector3 origin = pose * (target + Vector3(0., 0., 5.));
+  const Vector3 down = pose.rotation().product(Vector3(0., 0., -2.));
+  ASSERT_TRUE(mesh.raycast(pose, origin, down, 10., &hit));
+  EXPECT_NEAR(hit.distance, 5., kTolerance);
+  EXPECT_EQ(hit.triangle, 2u * (30 * 100 + 20));
+  expectNear(hit.point, pose * target);
+  expectNear(hit.normal, pose.rotation().product(Vector3::kUnitZ));
+
+  // From below, the normal faces the other way.
+  const Vector3 below = pose * (target - Vector3(0., 0., 5.));
+  ASSERT_TRUE(mesh.raycast(pose, below, -1. * down, 10., &hit));
+  expectNear(hit.normal, pose.rotation().product(-1. * Vector3::kUnitZ));
+
+  // Slanted rays find the first cell they cross.
+  const Vector3 slanted = pose.rotation().product(Vector3(1., 0., -1.));
+  ASSERT_TRUE(mesh.raycast(pose, origin, slanted, 100., &hit));
+  EXPECT_NEAR(hit.distance, 5. * std::sqrt(2.), kTolerance);
+  expectNear(hit.point, pose * Vector3(25.75, 30.25, 0.));
+
+  EXPECT_FALSE(mesh.raycast(pose, origin, down, 4.9, &hit));
+  EXPECT_FALSE(mesh.raycast(pose, origin, -1. * down, 100., &hit));
+  EXPECT_FALSE(mesh.raycast(
+      pose, pose * Vector3(-5., 50., 5.), down, 100., &hit));
+  EXPECT_THROW(mesh.raycast(pose, origin, Vector3::kZero, 1., &hit),
+               std::invalid_argument);
+}
+
+GTEST_TEST(TriangleMeshTest, Overlapping) {
+  const TriangleMesh mesh = makeGrid(100);
+  const Isometry pose = Isometry::FromTranslation(Vector3(0., 0., 1.));
+  // Across the diagonal of cell (5, 7), then below it only.
+  EXPECT_EQ(mesh.overlapping(pose, Aabb(Vector3(5.4, 7.4, 0.9),
+                                        Vector3(5.6, 7.6, 1.1))),
+            std::vector<std::size_t>({1410, 1411}));
+  EXPECT_EQ(mesh.overlapping(pose, Aabb(Vector3(5.7, 7.1, 0.9),
+                                        Vector3(5.9, 7.3, 1.1))),
+            std::vector<std::size_t>({1410}));
+  // Above the plane and outside the grid.
+  EXPECT_TRUE(mesh.overlapping(pose, Aabb(Vector3(5.1, 7.1, 1.1),
+                                          Vector3(5.9, 7.9, 2.)))
+                  .empty());
+  EXPECT_TRUE(mesh.overlapping(pose, Aabb(Vector3(-2., -2., 0.),
+                                          Vector3(-1., -1., 2.)))
+                  .empty());
+  EXPECT_TRUE(mesh.overlapping(pose, Aabb()).empty());
+
+  // Tilted meshes find the triangles around the box.
+  const Isometry tilted = Isometry::RotateAround(Vector3::kUnitX, M_PI / 4.);
+  const double y = 50. / std::sqrt(2.);
+  const std::vector<std::size_t> found = mesh.overlapping(
+      tilted, Aabb(Vector3(10.1, y - 0.1, y - 0.1),
+                   Vector3(10.9, y + 0.1, y + 0.1)));
+  EXPECT_FALSE(found.empty());
+  for (const std::size_t triangle : found) {
+    EXPECT_GE(triangle, 2u * (49 * 100 + 10));
+    EXPECT_LE(triangle, 2u * (50 * 100 + 10) + 1);
+  }
+}
+
+GTEST_TEST(TriangleMeshTest, ClosestPoint) {
+  const TriangleMesh mesh = makeGrid(100);
+  const Isometry pose = makePose();
+  MeshPoint nearest;
+  ASSERT_TRUE(mesh.closestPoint(pose, pose * Vector3(40.3, 60.6, 2.), 5.,
+                                &nearest));
+  EXPECT_NEAR(nearest.distance, 2., kTolerance);
+  EXPECT_EQ(nearest.triangle, 2u * (60 * 100 + 40) + 1);
+  expectNear(nearest.point, pose * Vector3(40.3, 60.6, 0.));
+
+  // Beyond the corner of the grid.
+  ASSERT_TRUE(mesh.closestPoint(pose, pose * Vector3(103., 104., 0.), 10.,
+                                &nearest));
+  EXPECT_NEAR(nearest.distance, 5., kTolerance);
+  expectNear(nearest.point, pose * Vector3(100., 100., 0.));
+
+  EXPECT_FALSE(mesh.closestPoint(pose, pose * Vector3(40.3, 60.6, 2.), 1.9,
+                                 &nearest));
+  // A negative limit is not the same as a positive one.
+  EXPECT_FALSE(mesh.closestPoint(pose, pose * Vector3(40.3, 60.6, 2.), -5.,
+                                 &nearest));
+}
+
+GTEST_TEST(TriangleMeshTest, SetVertices) {
+  TriangleMesh mesh = makeGrid(50);
+  mesh.setVertices(makeGridVertices(50, -3.));
+  const Isometry pose = makePose();
+  RayHit hit;
+  ASSERT_TRUE(mesh.raycast(pose, pose * Vector3(10.5, 10.2, 1.),
+                           pose.rotation().product(Vector3(0., 0., -1.)), 10.,
+                           &hit));
+  EXPECT_NEAR(hit.distance, 4., kTolerance);
+  EXPECT_EQ(mesh.bvh().bounds().min, Vector3(0., 0., -3.));
+  EXPECT_THROW(mesh.setVertices(makeGridVertices(2, 0.)),
+               std::invalid_argument);
+}
+
+}  // namespace test
+}  // namespace math
+}  // namespace ekumen
+
+int main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
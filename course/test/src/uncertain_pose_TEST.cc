@@ -0,0 +1,137 @@
+#include "uncertain_pose.h"
+#include "isometry.h"
+#include "lie_group.h"
+#include "matrix.h"
+#include "vector3.h"
+
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace ekumen {
+namespace math {
+namespace test {
+namespace {
+constexpr double kTolerance{1e-12};
+
+void expectNear(const Matrix6& a, const Matrix6& b, const double& tolerance) {
+  for (int i = 0; i < 6; ++i) {
+    for (int j = 0; j < 6; ++j) {
+      EXPECT_NEAR(a(i, j), b(i, j), tolerance);
+    }
+  }
+}
+
+// Builds a symmetric positive definite covariance.
+Matrix6 makeCovariance(const double& scale) {
+  Matrix6 factor;
+  for (int i = 0; i < 6; ++i) {
+    for (int j = 0; j <= i; ++j) {
+      factor(i, j) = scale * (i == j ? 1. + 0.1 * i : 0.05 * (i - j));
+    }
+  }
+  return factor * factor.transpose();
+}
+
+// Returns the local tangent vector from 'a' to 'b'.
+Vector6 localDifference(const Isometry& a, const Isometry& b) {
+  Vector3 rho;
+  Vector3 omega;
+  SE3::Log(a.inverse() * b, &rho, &omega);
+  return Stack(rho, omega);
+}
+}  // namespace
+
+GTEST_TEST(UncertainPoseTest, Accessors) {
+  const Isometry pose = Isometry::FromTranslation({1., 2., 3.});
+  const Matrix6 covariance = makeCovariance(1.);
+  const UncertainPose uncertain(pose, covariance);
+  EXPECT_EQ(uncertain.pose(), pose);
+  EXPECT_EQ(uncertain.covariance(), covariance);
+  EXPECT_EQ(UncertainPose().covariance(), Matrix6::Zero());
+}
+
+GTEST_TEST(UncertainPoseTest, ComposeMatchesAdjoint) {
+  const Isometry a = SE3::Exp(Vector3(1., -0.5, 2.), Vector3(0.2, -0.1, 0.4));
+  const Isometry b = SE3::Exp(Vector3(-0.3, 2., 0.7), Vector3(-0.5, 0.3, 0.1));
+  const UncertainPose ua(a, makeCovariance(1.));
+  const UncertainPose ub(b, makeCovariance(0.5));
+
+  const UncertainPose uc = ua * ub;
+  const Matrix6 adjoint = SE3::Adjoint(b.inverse());
+  EXPECT_EQ(uc.pose(), a * b);
+  expectNear(uc.covariance(),
+             adjoint * ua.covariance() * adjoint.transpose() + ub.covariance(),
+             kTolerance);
+  EXPECT_EQ(uc.covariance(), uc.covariance().transpose());
+  EXPECT_EQ(ua.compose(ub).covariance(), uc.covariance());
+}
+
+GTEST_TEST(UncertainPoseTest, InverseMatchesAdjoint) {
+  const Isometry a = SE3::Exp(Vector3(1., -0.5, 2.), Vector3(0.2, -0.1, 0.4));
+  const UncertainPose ua(a, makeCovariance(1.));
+  const UncertainPose inverse = ua.inverse();
+  const Matrix6 adjoint = SE3::Adjoint(a);
+  EXPECT_EQ(inverse.pose(), a.inverse());
+  expectNear(inverse.covariance(),
+             adjoint * ua.covariance() * adjoint.transpose(), kTolerance);
+  expectNear(inverse.inverse().covariance(), ua.covariance(), 1e-11);
+}
+
+GTEST_TEST(UncertainPoseTest, PropagationIsFirstOrder) {
+  // A rank-one covariance e * e^T must map to f * f^T, where f is the
+  // perturbation of the result caused by a perturbation e of the input.
+  const Isometry a = SE3::Exp(Vector3(1., -0.5, 2.), Vector3(0.2, -0.1, 0.4));
+  const Isometry b = SE3::Exp(Vector3(-0.3, 2., 0.7), Vector3(-0.5, 0.3, 0.1));
+  const Vector6 e = Stack(Vector3(0.3, -0.2, 0.1), Vector3(0.1, 0.4, -0.2));
+  const double epsilon = 1e-7;
+  const Isometry a_perturbed =
+      a * SE3::Exp(e.segment3(0) * epsilon, e.segment3(3) * epsilon);
+
+  const UncertainPose composed =
+      UncertainPose(a, e * e.transpose()) * UncertainPose(b);
+  const Vector6 f = localDifference(a * b, a_perturbed * b) / epsilon;
+  expectNear(composed.covariance(), f * f.transpose(), 1e-6);
+
+  const UncertainPose inverse = UncertainPose(a, e * e.transpose()).inverse();
+  const Vector6 g =
+      localDifference(a.inverse(), a_perturbed.inverse()) / epsilon;
+  expectNear(inverse.covariance(), g * g.transpose(), 1e-6);
+}
+
+GTEST_TEST(UncertainPoseTest, ComposeTrajectory) {
+  const UncertainPose origin(Isometry::FromTranslation({1., 0., 0.}),
+                             makeCovariance(0.1));
+  std::vector<UncertainPose> steps;
+  for (int i = 0; i < 50; ++i) {
+    steps.emplace_back(SE3::Exp(Vector3(1., 0.1 * i, 0.), Vector3(0., 0., 0.1)),
+                       makeCovariance(0.01 * (1 + i % 3)));
+  }
+  std::vector<UncertainPose> trajectory;
+  UncertainPose::ComposeTrajectory(origin, steps, &trajectory);
+  ASSERT_EQ(trajectory.size(), steps.size());
+
+  UncertainPose expected = origin;
+  for (std::size_t i = 0; i < steps.size(); ++i) {
+    expected = expected * steps[i];
+    EXPECT_EQ(trajectory[i].pose(), expected.pose());
+    EXPECT_EQ(trajectory[i].covariance(), expected.covariance());
+  }
+  // The uncertainty grows along the trajectory.
+  EXPECT_GT(trajectory.back().covariance()(0, 0),
+            trajectory.front().covariance()(0, 0));
+
+  UncertainPose::ComposeTrajectory(origin, {}, &trajectory);
+  EXPECT_TRUE(trajectory.empty());
+  EXPECT_THROW(UncertainPose::ComposeTrajectory(origin, steps, nullptr),
+               std::invalid_argument);
+}
+
+}  // namespace test
+}  // namespace math
+}  // namespace ekumen
+
+int main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}